@@ -0,0 +1,37 @@
+#include "alloc_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Count operator new calls, including those made inside the Pangolin
+// libraries. Codec libraries which call malloc directly are not counted.
+// These live in their own translation unit so that they aren't inlined
+// into callers, where the compiler would pair malloc with delete.
+namespace {
+std::atomic<size_t> num_allocations(0);
+}
+
+size_t NumAllocations()
+{
+    return num_allocations.load();
+}
+
+void* operator new(std::size_t size)
+{
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    if(void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <cstddef>
+
+// Number of operator new calls made by this process so far
+size_t NumAllocations();
@@ -0,0 +1,416 @@
+#include <pangolin/image/image_io.h>
+#include <pangolin/utils/argagg.hpp>
+#include <pangolin/utils/memstreambuf.h>
+#include <pangolin/utils/picojson.h>
+
+#include "alloc_counter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Read only streambuf over a block of memory, with seeking for loaders which need it
+struct MemoryReadBuf : public std::streambuf
+{
+    MemoryReadBuf(const unsigned char* data, size_t size)
+    {
+        char* p = (char*)data;
+        setg(p, p, p + size);
+    }
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode) override
+    {
+        char* base = dir == std::ios_base::beg ? eback() : (dir == std::ios_base::cur ? gptr() : egptr());
+        if(off < eback() - base || off > egptr() - base) {
+            return pos_type(off_type(-1));
+        }
+        setg(eback(), base + off, egptr());
+        return pos_type(gptr() - eback());
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+    {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
+struct Codec
+{
+    std::string name;
+    pangolin::ImageFileType type;
+    float quality;
+};
+
+struct CorpusImage
+{
+    std::string kind;
+    pangolin::TypedImage image;
+};
+
+struct Result
+{
+    std::string kind;
+    size_t w, h;
+    std::string format;
+    Codec codec;
+    size_t raw_bytes;
+    size_t encoded_bytes;
+    double encode_mbps;
+    double decode_mbps;
+    size_t encode_allocations;
+    size_t decode_allocations;
+    bool exact;
+};
+
+// Smooth shading with hard edged shapes and a little sensor noise, in [0,1]
+void NaturalRgb(size_t w, size_t h, std::mt19937& rng, std::vector<float>& rgb)
+{
+    std::normal_distribution<float> noise(0.0f, 0.008f);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+    struct Shape { float cx, cy, r; float c[3]; };
+    std::vector<Shape> shapes(12);
+    for(auto& s : shapes) {
+        s = {uniform(rng)*w, uniform(rng)*h, (0.05f + 0.15f*uniform(rng)) * h, {uniform(rng), uniform(rng), uniform(rng)}};
+    }
+
+    rgb.resize(w*h*3);
+    for(size_t y=0; y < h; ++y) {
+        for(size_t x=0; x < w; ++x) {
+            const float u = float(x) / w, v = float(y) / h;
+            float c[3] = {
+                0.5f + 0.3f*std::sin(3.1f*u + 1.3f*v) + 0.1f*std::sin(17.0f*u*v),
+                0.4f + 0.3f*std::cos(2.3f*v - 0.7f*u),
+                0.3f + 0.4f*u*v
+            };
+            for(const auto& s : shapes) {
+                const float dx = x - s.cx, dy = y - s.cy;
+                if(dx*dx + dy*dy < s.r*s.r) {
+                    const float shade = 1.0f - 0.3f * std::sqrt(dx*dx + dy*dy) / s.r;
+                    for(int k=0; k < 3; ++k) c[k] = s.c[k] * shade;
+                }
+            }
+            for(int k=0; k < 3; ++k) {
+                rgb[3*(y*w+x)+k] = std::min(1.0f, std::max(0.0f, c[k] + noise(rng)));
+            }
+        }
+    }
+}
+
+pangolin::TypedImage MakeImage(const std::string& kind, size_t w, size_t h)
+{
+    std::mt19937 rng(42);
+
+    if(kind == "natural" || kind == "bayer") {
+        std::vector<float> rgb;
+        NaturalRgb(w, h, rng, rgb);
+        if(kind == "natural") {
+            pangolin::TypedImage img(w, h, pangolin::PixelFormatFromString("RGB24"));
+            for(size_t y=0; y < h; ++y) {
+                for(size_t x=0; x < w*3; ++x) {
+                    img.RowPtr(y)[x] = (unsigned char)(255.0f * rgb[y*w*3 + x] + 0.5f);
+                }
+            }
+            return img;
+        }
+
+        // 12 bit RGGB mosaic, as from a raw sensor
+        pangolin::TypedImage img(w, h, pangolin::PixelFormatFromString("GRAY16LE"));
+        for(size_t y=0; y < h; ++y) {
+            uint16_t* row = (uint16_t*)img.RowPtr(y);
+            for(size_t x=0; x < w; ++x) {
+                const int channel = (y % 2) + (x % 2);
+                row[x] = (uint16_t)(4095.0f * rgb[3*(y*w+x) + channel] + 0.5f);
+            }
+        }
+        return img;
+    }
+
+    if(kind == "depth") {
+        // Millimetres to a floor, a back wall and some boxes, with noise and dropouts
+        std::normal_distribution<float> noise(0.0f, 2.0f);
+        std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+        struct Box { size_t x0, y0, x1, y1; float z; };
+        std::vector<Box> boxes(6);
+        for(auto& b : boxes) {
+            const size_t bx = size_t(uniform(rng) * w * 0.8), by = size_t(uniform(rng) * h * 0.8);
+            b = {bx, by, bx + size_t((0.05f + 0.15f*uniform(rng)) * w), by + size_t((0.05f + 0.15f*uniform(rng)) * h), 800.0f + 2000.0f * uniform(rng)};
+        }
+
+        pangolin::TypedImage img(w, h, pangolin::PixelFormatFromString("GRAY16LE"));
+        for(size_t y=0; y < h; ++y) {
+            uint16_t* row = (uint16_t*)img.RowPtr(y);
+            for(size_t x=0; x < w; ++x) {
+                const float v = float(y) / h;
+                float z = v > 0.6f ? 6000.0f / (1.0f + 8.0f * (v - 0.6f)) : 6000.0f;
+                for(const auto& b : boxes) {
+                    if(b.x0 <= x && x < b.x1 && b.y0 <= y && y < b.y1) z = std::min(z, b.z + 0.2f * (x - b.x0));
+                }
+                row[x] = uniform(rng) < 0.01f ? 0 : (uint16_t)(z + noise(rng));
+            }
+        }
+        return img;
+    }
+
+    pangolin::TypedImage img(w, h, pangolin::PixelFormatFromString("RGB24"));
+    if(kind == "noise") {
+        std::uniform_int_distribution<int> byte(0, 255);
+        for(size_t y=0; y < h; ++y) {
+            for(size_t x=0; x < w*3; ++x) img.RowPtr(y)[x] = (unsigned char)byte(rng);
+        }
+    }else if(kind == "flat") {
+        for(size_t y=0; y < h; ++y) std::memset(img.RowPtr(y), 128, w*3);
+    }else{
+        throw std::runtime_error("Unknown corpus image kind '" + kind + "'");
+    }
+    return img;
+}
+
+bool Equal(const pangolin::TypedImage& a, const pangolin::TypedImage& b)
+{
+    if(a.w != b.w || a.h != b.h || a.fmt.bpp != b.fmt.bpp) return false;
+    const size_t row_bytes = a.w * a.fmt.bpp / 8;
+    for(size_t y=0; y < a.h; ++y) {
+        if(std::memcmp(a.RowPtr(y), b.RowPtr(y), row_bytes)) return false;
+    }
+    return true;
+}
+
+// Run f until min_seconds have passed (and at least min_reps times) and
+// return the median duration of one call in seconds.
+template<typename F>
+double TimeMedian(double min_seconds, size_t min_reps, F f)
+{
+    std::vector<double> times;
+    const auto start = Clock::now();
+    while(times.size() < min_reps || std::chrono::duration<double>(Clock::now() - start).count() < min_seconds) {
+        const auto t0 = Clock::now();
+        f();
+        times.push_back(std::chrono::duration<double>(Clock::now() - t0).count());
+    }
+    std::nth_element(times.begin(), times.begin() + times.size()/2, times.end());
+    return times[times.size()/2];
+}
+
+template<typename F>
+size_t CountAllocations(F f)
+{
+    const size_t before = NumAllocations();
+    f();
+    return NumAllocations() - before;
+}
+
+// Returns false if the codec doesn't support this image (or wasn't built)
+bool Run(const CorpusImage& c, const Codec& codec, double min_seconds, Result& r)
+{
+    const pangolin::TypedImage& img = c.image;
+    pangolin::memstreambuf encoded(img.SizeBytes());
+    std::ostream out(&encoded);
+
+    auto encode = [&](){
+        encoded.clear();
+        pangolin::SaveImage(img, img.fmt, out, codec.type, true, codec.quality);
+    };
+    auto decode = [&](){
+        MemoryReadBuf buf(encoded.data(), encoded.size());
+        std::istream in(&buf);
+        return pangolin::LoadImage(in, codec.type);
+    };
+
+    pangolin::TypedImage decoded;
+    try {
+        // First calls also warm up the output buffer and any codec state
+        encode();
+        decoded = decode();
+    }catch(const std::exception&) {
+        return false;
+    }
+
+    const size_t raw_bytes = img.w * img.h * img.fmt.bpp / 8;
+    const double mb = raw_bytes / 1.0e6;
+    r = {c.kind, img.w, img.h, img.fmt.format, codec, raw_bytes, encoded.size(), 0.0, 0.0, 0, 0, Equal(img, decoded)};
+    r.encode_allocations = CountAllocations(encode);
+    r.decode_allocations = CountAllocations(decode);
+    r.encode_mbps = mb / TimeMedian(min_seconds, 3, encode);
+    r.decode_mbps = mb / TimeMedian(min_seconds, 3, decode);
+    return true;
+}
+
+std::vector<std::string> Split(const std::string& s)
+{
+    std::vector<std::string> parts;
+    std::stringstream ss(s);
+    for(std::string part; std::getline(ss, part, ',');) {
+        if(!part.empty()) parts.push_back(part);
+    }
+    return parts;
+}
+
+void PrintTable(const std::vector<Result>& results)
+{
+    std::cout << std::left << std::setw(8) << "image" << std::setw(11) << "size" << std::setw(9) << "format"
+              << std::setw(9) << "codec" << std::right << std::setw(8) << "quality" << std::setw(10) << "ratio"
+              << std::setw(10) << "enc MB/s" << std::setw(10) << "dec MB/s" << std::setw(8) << "enc new"
+              << std::setw(8) << "dec new" << "  exact\n";
+    for(const auto& r : results) {
+        std::cout << std::left << std::setw(8) << r.kind << std::setw(11) << (std::to_string(r.w) + "x" + std::to_string(r.h))
+                  << std::setw(9) << r.format << std::setw(9) << r.codec.name << std::right << std::setw(8) << (int)r.codec.quality
+                  << std::fixed << std::setprecision(2) << std::setw(10) << double(r.raw_bytes) / r.encoded_bytes
+                  << std::setprecision(1) << std::setw(10) << r.encode_mbps << std::setw(10) << r.decode_mbps
+                  << std::setw(8) << r.encode_allocations << std::setw(8) << r.decode_allocations
+                  << "  " << (r.exact ? "yes" : "no") << "\n";
+    }
+}
+
+void PrintCsv(const std::vector<Result>& results)
+{
+    std::cout << "image,width,height,format,codec,quality,raw_bytes,encoded_bytes,ratio,encode_mbps,decode_mbps,encode_allocations,decode_allocations,exact\n";
+    for(const auto& r : results) {
+        std::cout << r.kind << "," << r.w << "," << r.h << "," << r.format << "," << r.codec.name << "," << (int)r.codec.quality << ","
+                  << r.raw_bytes << "," << r.encoded_bytes << "," << double(r.raw_bytes) / r.encoded_bytes << ","
+                  << r.encode_mbps << "," << r.decode_mbps << "," << r.encode_allocations << "," << r.decode_allocations << ","
+                  << (r.exact ? 1 : 0) << "\n";
+    }
+}
+
+void PrintJson(const std::vector<Result>& results, double min_seconds)
+{
+    picojson::value json(picojson::object_type, true);
+    json["benchmark"] = "ImageCodecBench";
+    json["min_seconds"] = min_seconds;
+    json["timestamp"] = (int64_t)std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    picojson::value& rows = json["results"];
+    rows = picojson::value(picojson::array_type, true);
+    for(const auto& r : results) {
+        picojson::value row(picojson::object_type, true);
+        row["image"] = r.kind;
+        row["width"] = (int64_t)r.w;
+        row["height"] = (int64_t)r.h;
+        row["format"] = r.format;
+        row["codec"] = r.codec.name;
+        row["quality"] = (double)r.codec.quality;
+        row["raw_bytes"] = (int64_t)r.raw_bytes;
+        row["encoded_bytes"] = (int64_t)r.encoded_bytes;
+        row["ratio"] = double(r.raw_bytes) / r.encoded_bytes;
+        row["encode_mbps"] = r.encode_mbps;
+        row["decode_mbps"] = r.decode_mbps;
+        row["encode_allocations"] = (int64_t)r.encode_allocations;
+        row["decode_allocations"] = (int64_t)r.decode_allocations;
+        row["exact"] = r.exact;
+        rows.push_back(row);
+    }
+    std::cout << json.serialize(true);
+}
+
+}
+
+int main( int argc, char* argv[] )
+{
+    argagg::parser argparser = {{
+        { "help", {"-h", "--help"}, "shows this help! duh!", 0},
+        { "images", {"-i", "--images"}, "comma separated corpus images: natural,depth,bayer,noise,flat (default: all)", 1},
+        { "sizes", {"-s", "--sizes"}, "comma separated WxH resolutions (default: 320x240,640x480,1920x1080)", 1},
+        { "codecs", {"-c", "--codecs"}, "comma separated codecs: ppm,png,jpg,zstd,lz4,p12b (default: all)", 1},
+        { "time", {"-t", "--time"}, "minimum seconds to time each encode and decode (default: 0.2)", 1},
+        { "format", {"-f", "--format"}, "output as table, csv or json (default: table)", 1},
+    }};
+
+    argagg::parser_results args = argparser.parse(argc, argv);
+    if( args["help"] || !args.pos.empty() ){
+        std::cerr << "Usage:\n";
+        std::cerr << "  ImageCodecBench [options]\n\n";
+        std::cerr << "Encodes and decodes a generated reference corpus with each image codec,\n";
+        std::cerr << "reporting median throughput in MB/s of raw image data, compression ratio,\n";
+        std::cerr << "operator new calls per encode and decode, and whether decoding is exact.\n";
+        std::cerr << "Combinations which a codec doesn't support, or wasn't built with, are skipped.\n\n";
+        std::cerr << "Options:\n";
+        std::cerr << argparser << std::endl;
+        return 0;
+    }
+
+    const std::vector<std::string> kinds = Split(args["images"].as<std::string>("natural,depth,bayer,noise,flat"));
+    const std::vector<std::string> sizes = Split(args["sizes"].as<std::string>("320x240,640x480,1920x1080"));
+    const std::vector<std::string> codec_names = Split(args["codecs"].as<std::string>("ppm,png,jpg,zstd,lz4,p12b"));
+    const double min_seconds = args["time"].as<double>(0.2);
+    const std::string format = args["format"].as<std::string>("table");
+    if(format != "table" && format != "csv" && format != "json") {
+        std::cerr << "Unknown format '" << format << "', expected table, csv or json" << std::endl;
+        return 1;
+    }
+
+    // PNG maps quality to zlib levels 1, 6 and 9. zstd and lz4 take their
+    // compression level and acceleration directly.
+    const std::vector<Codec> all_codecs = {
+        {"ppm", pangolin::ImageFileTypePpm, 100.0f},
+        {"png", pangolin::ImageFileTypePng, 12.0f},
+        {"png", pangolin::ImageFileTypePng, 67.0f},
+        {"png", pangolin::ImageFileTypePng, 100.0f},
+        {"jpg", pangolin::ImageFileTypeJpg, 75.0f},
+        {"jpg", pangolin::ImageFileTypeJpg, 95.0f},
+        {"zstd", pangolin::ImageFileTypeZstd, 1.0f},
+        {"zstd", pangolin::ImageFileTypeZstd, 3.0f},
+        {"zstd", pangolin::ImageFileTypeZstd, 9.0f},
+        {"lz4", pangolin::ImageFileTypeLz4, 1.0f},
+        {"lz4", pangolin::ImageFileTypeLz4, 8.0f},
+        {"p12b", pangolin::ImageFileTypeP12b, 100.0f},
+    };
+
+    std::vector<Codec> codecs;
+    for(const auto& name : codec_names) {
+        const size_t n = codecs.size();
+        std::copy_if(all_codecs.begin(), all_codecs.end(), std::back_inserter(codecs), [&](const Codec& c){ return c.name == name; });
+        if(codecs.size() == n) {
+            std::cerr << "Unknown codec '" << name << "'" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Result> results;
+    for(const auto& size : sizes) {
+        size_t w = 0, h = 0;
+        char x = 0;
+        std::istringstream ss(size);
+        if(!(ss >> w >> x >> h) || x != 'x' || !w || !h) {
+            std::cerr << "Invalid size '" << size << "', expected WxH" << std::endl;
+            return 1;
+        }
+
+        for(const auto& kind : kinds) {
+            CorpusImage c;
+            try {
+                c = {kind, MakeImage(kind, w, h)};
+            }catch(const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+            for(const auto& codec : codecs) {
+                Result r;
+                if(Run(c, codec, min_seconds, r)) {
+                    results.push_back(r);
+                    if(format != "table") std::cerr << "." << std::flush;
+                }
+            }
+        }
+    }
+    if(format != "table") std::cerr << std::endl;
+
+    if(format == "csv") {
+        PrintCsv(results);
+    }else if(format == "json") {
+        PrintJson(results, min_seconds);
+    }else{
+        PrintTable(results);
+    }
+
+    return 0;
+}
@@ -0,0 +1,158 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove, Richard Newcombe
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <pangolin/platform.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace pangolin
+{
+
+enum class LogLevel { Debug, Info, Warn, Error };
+
+/// Logging backend for code on grab, encode and write paths, where printing
+/// directly would stall the pipeline it is reporting on.
+///
+/// Messages are formatted by the caller into a slot of a fixed-size lock-free
+/// ring and written out by a background thread. Logging never blocks or
+/// performs I/O on the calling thread; if the ring is full the message is
+/// dropped and counted instead.
+class PANGOLIN_EXPORT AsyncLog
+{
+public:
+    /// Longest message kept, including terminator. Longer messages are truncated.
+    static constexpr size_t MessageBytes = 256;
+
+    using Sink = std::function<void(LogLevel, const char*)>;
+
+    struct Stats
+    {
+        uint64_t written;
+        uint64_t dropped;
+        uint64_t suppressed;
+    };
+
+    /// Process-wide log used by the pango_log_* macros
+    static AsyncLog& I();
+
+    /// \param capacity number of messages the ring holds (rounded up to a power of two)
+    explicit AsyncLog(size_t capacity = 4096);
+    ~AsyncLog();
+
+    AsyncLog(const AsyncLog&) = delete;
+    AsyncLog& operator=(const AsyncLog&) = delete;
+
+    /// Format and enqueue a message. Returns false if it was dropped.
+    bool Log(LogLevel level, const char* fmt, ...);
+
+    /// As Log(), noting that \param suppressed similar messages were skipped
+    /// by a rate limiter since the last one was let through.
+    bool LogSuppressed(LogLevel level, uint32_t suppressed, const char* fmt, ...);
+
+    bool LogV(LogLevel level, uint32_t suppressed, const char* fmt, va_list args);
+
+    /// Block until every message enqueued before this call has been written.
+    void Flush();
+
+    /// Replace where messages are written. By default Debug and Info go to
+    /// stdout and Warn and Error to stderr. Called from the logging thread.
+    void SetSink(Sink sink);
+
+    /// Count messages skipped by a rate limiter, for Stats()
+    void AddSuppressed(uint32_t n);
+
+    Stats GetStats() const;
+
+private:
+    struct Slot;
+
+    void Run();
+    void Write(LogLevel level, const char* msg);
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueue_pos;
+    alignas(64) size_t dequeue_pos;
+
+    std::atomic<uint64_t> written;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> suppressed;
+
+    std::atomic<bool> quit;
+    std::atomic<bool> sleeping;
+    std::mutex wake_mutex;
+    std::condition_variable wake_cv;
+    std::condition_variable flushed_cv;
+
+    std::mutex sink_mutex;
+    Sink sink;
+
+    std::thread thread;
+};
+
+/// Lets at most one message through per interval for a single call site and
+/// counts the ones it holds back. Lock-free; use through pango_log_limited.
+class PANGOLIN_EXPORT LogRateLimiter
+{
+public:
+    explicit LogRateLimiter(int64_t interval_ms);
+
+    /// Returns true if the caller should log now, setting \param suppressed
+    /// to the number of calls held back since the last one allowed.
+    bool Allow(uint32_t& suppressed);
+
+private:
+    const int64_t interval_us;
+    std::atomic<int64_t> next_us;
+    std::atomic<uint32_t> held;
+};
+
+}
+
+/// Log a printf-style message without blocking, e.g.
+/// pango_log_async(pangolin::LogLevel::Warn, "Dropped frame %d\n", n);
+#define pango_log_async(level, ...) pangolin::AsyncLog::I().Log(level, __VA_ARGS__)
+
+/// As pango_log_async, but at most once every interval_ms for this call site.
+/// The next message let through notes how many were suppressed.
+#define pango_log_limited(level, interval_ms, ...) \
+    do { \
+        static pangolin::LogRateLimiter pango_log_limiter_(interval_ms); \
+        uint32_t pango_log_suppressed_ = 0; \
+        if(pango_log_limiter_.Allow(pango_log_suppressed_)) { \
+            pangolin::AsyncLog::I().LogSuppressed(level, pango_log_suppressed_, __VA_ARGS__); \
+        } \
+    } while(0)
@@ -87,6 +87,18 @@ enum class SortMethod {
 PANGOLIN_EXPORT
 bool FilesMatchingWildcard(const std::string& wildcard_file_path, std::vector<std::string>& file_vec, SortMethod sort_method = SortMethod::STANDARD);
 
+// As FilesMatchingWildcard, but when every match lies in one directory the
+// sorted list is also saved as a manifest file in 'cache_dir'. Later calls
+// reuse that manifest for as long as the directory's modification time is
+// unchanged, rather than listing the directory again.
+PANGOLIN_EXPORT
+bool FilesMatchingWildcardCached(const std::string& wildcard_file_path, std::vector<std::string>& file_vec, SortMethod sort_method, const std::string& cache_dir);
+
+// Per-user cache directory: $PANGOLIN_CACHE_DIR if set, otherwise
+// $XDG_CACHE_HOME/pangolin or ~/.cache/pangolin. It is not created.
+PANGOLIN_EXPORT
+std::string DefaultCacheDir();
+
 PANGOLIN_EXPORT
 std::string MakeUniqueFilename(const std::string& filename);
 
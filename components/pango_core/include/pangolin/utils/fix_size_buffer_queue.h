@@ -27,6 +27,8 @@
 
 #pragma once
 
+#include <pangolin/utils/async_log.h>
+
 #include <condition_variable>
 #include <list>
 #include <mutex>
@@ -90,7 +92,7 @@ public:
                 // Queue not yet initialized.
                 throw std::runtime_error("Queue not yet initialised.");
             } else {
-                std::cerr << "Out of free buffers." << std::endl;
+                pango_log_limited(LogLevel::Warn, 1000, "FixSizeBuffersQueue: Out of free buffers.\n");
                 // No free buffers return oldest among the valid buffers.
                 BufPType bp = std::move(validBuffers.front());
                 validBuffers.pop_front();
@@ -0,0 +1,167 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove, Richard Newcombe
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <pangolin/platform.h>
+#include <pangolin/utils/picojson.h>
+
+#include <cstdint>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pangolin
+{
+
+struct PANGOLIN_EXPORT JsonReaderException : std::runtime_error
+{
+    JsonReaderException(const std::string& what, size_t offset)
+        : std::runtime_error("JSON: " + what + " at offset " + std::to_string(offset)), offset(offset)
+    {
+    }
+
+    size_t offset;
+};
+
+/// Pull reader over a JSON document in memory, for inputs which are large or
+/// read often enough that building a picojson tree is too costly.
+///
+/// The caller walks the document in order, converting only the values it
+/// needs. Skipped values are stepped over with a vectorised scan for
+/// structural characters and allocate nothing. Errors throw JsonReaderException.
+///
+///   JsonReader r(text);
+///   r.BeginObject();
+///   std::string key;
+///   while(r.NextKey(key)) {
+///       if(key == "time_us") t = r.ReadInt();
+///       else r.Skip();
+///   }
+class PANGOLIN_EXPORT JsonReader
+{
+public:
+    enum class Type { Null, Bool, Number, String, Array, Object, End };
+
+    JsonReader(const char* begin, const char* end);
+
+    /// \param json must outlive the reader
+    explicit JsonReader(const std::string& json);
+    JsonReader(std::string&&) = delete;
+
+    /// Type of the next value, or End if the input is exhausted or the
+    /// enclosing array or object has ended.
+    Type Peek();
+
+    void ReadNull();
+    bool ReadBool();
+
+    /// Integers written with a fraction or exponent are truncated, as by
+    /// picojson. Values outside the return type's range fail.
+    int64_t ReadInt();
+    uint64_t ReadUInt();
+    double ReadDouble();
+    std::string ReadString();
+
+    /// As ReadString(), reusing \param str's storage
+    void ReadString(std::string& str);
+
+    /// Enter an object. Iterate with NextKey().
+    void BeginObject();
+
+    /// Read the next key of the current object into \param key, leaving the
+    /// reader at its value. Returns false, leaving the object, at its end.
+    bool NextKey(std::string& key);
+
+    /// Enter an array. Call NextElement() before each element.
+    void BeginArray();
+
+    /// Returns true if another element follows, or false, leaving the
+    /// array, at its end.
+    bool NextElement();
+
+    /// Step over the next value, including any nested values.
+    void Skip();
+
+    /// Text of the next value, which is consumed
+    std::string_view RawValue();
+
+    /// Build a picojson tree for the next value, for callers which need one
+    picojson::value ReadValue();
+
+    /// Append every element of the array which follows to \param out
+    template<typename T>
+    void ReadArray(std::vector<T>& out);
+
+    /// Offset of the read position from the start of the input
+    size_t Offset() const { return size_t(p - begin); }
+
+    /// True once only whitespace remains
+    bool AtEnd();
+
+private:
+    void SkipSpace();
+    char Expect(char c);
+    void SkipString();
+    void SkipScalar();
+    [[noreturn]] void Fail(const std::string& what) const;
+
+    template<typename T> T ReadOne();
+
+    const char* begin;
+    const char* p;
+    const char* end;
+
+    // Per nesting level, whether the next element is the first
+    std::vector<bool> first;
+};
+
+/// Read one JSON value from \param is into \param text, stopping just after
+/// it so that binary data following can be read. Returns false on end of
+/// stream or malformed nesting.
+PANGOLIN_EXPORT
+bool ReadJsonText(std::istream& is, std::string& text);
+
+template<> inline int64_t JsonReader::ReadOne<int64_t>() { return ReadInt(); }
+template<> inline uint64_t JsonReader::ReadOne<uint64_t>() { return ReadUInt(); }
+template<> inline double JsonReader::ReadOne<double>() { return ReadDouble(); }
+template<> inline float JsonReader::ReadOne<float>() { return (float)ReadDouble(); }
+template<> inline bool JsonReader::ReadOne<bool>() { return ReadBool(); }
+template<> inline std::string JsonReader::ReadOne<std::string>() { return ReadString(); }
+
+template<typename T>
+void JsonReader::ReadArray(std::vector<T>& out)
+{
+    BeginArray();
+    while(NextElement()) {
+        out.push_back(ReadOne<T>());
+    }
+}
+
+}
@@ -0,0 +1,168 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove, Richard Newcombe
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <pangolin/platform.h>
+#include <pangolin/utils/thread_policy.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+namespace pangolin
+{
+
+/// Process-wide pool of worker threads with one task deque per worker.
+///
+/// Workers take their own newest task first and otherwise steal the oldest
+/// task from another worker or from the queue fed by non-worker threads.
+/// Workers waiting on a TaskGroup run queued tasks while they wait, so
+/// tasks may themselves spawn and wait on nested groups without deadlock.
+/// Other threads block instead, so they never pick up unrelated work.
+class PANGOLIN_EXPORT TaskScheduler
+{
+public:
+    using Task = std::function<void()>;
+
+    /// Shared scheduler. Its worker count defaults to the number of hardware
+    /// threads less one (for the thread which waits), overridden by the
+    /// PANGOLIN_WORKERS environment variable.
+    static TaskScheduler& I();
+
+    explicit TaskScheduler(size_t num_workers, const ThreadPolicy& worker_policy = ThreadPolicy());
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    /// Restart with \param num_workers threads, each applying \param worker_policy.
+    /// Queued tasks are kept, or run on the calling thread if there are to be
+    /// no workers. Other threads may keep spawning and waiting meanwhile.
+    /// Must not be called from a task.
+    void Configure(size_t num_workers, const ThreadPolicy& worker_policy = ThreadPolicy());
+
+    size_t NumWorkers() const;
+
+    /// Queue \param task to run on some worker. With no workers it runs immediately.
+    void Spawn(Task task);
+
+    /// Run one queued task on the calling thread. Returns false if none was found.
+    bool TryRunOne();
+
+    /// True if the calling thread is one of this scheduler's workers
+    bool OnWorkerThread() const;
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    // Replace the (joined) workers, keeping their queued tasks
+    void Start(size_t num_workers, const ThreadPolicy& worker_policy);
+    void Join();
+    void Run(size_t index, ThreadPolicy policy);
+    bool Take(size_t index, Task& task);
+
+    // Held exclusively only whilst Start() replaces the workers
+    mutable std::shared_mutex workers_mutex;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex injected_mutex;
+    std::deque<Task> injected;
+
+    std::atomic<size_t> queued;
+    std::atomic<bool> quit;
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_cv;
+
+    std::mutex configure_mutex;
+};
+
+/// A set of tasks which can be waited on together, optionally followed by a
+/// continuation once they have all finished. The first exception thrown by a
+/// task is rethrown from Wait().
+class PANGOLIN_EXPORT TaskGroup
+{
+public:
+    explicit TaskGroup(TaskScheduler& scheduler = TaskScheduler::I());
+
+    /// Waits for outstanding tasks, discarding any exception
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void Run(TaskScheduler::Task task);
+
+    /// Run \param continuation once every task run so far has finished (or
+    /// straight away if none are outstanding). Wait() includes it, and it may
+    /// add further tasks to the group.
+    void Then(TaskScheduler::Task continuation);
+
+    /// Block until all tasks and continuations have finished. On a worker
+    /// thread, queued tasks are run meanwhile.
+    void Wait();
+
+private:
+    void Execute(const TaskScheduler::Task& task);
+    void Finish();
+    void WaitNoThrow();
+
+    TaskScheduler& scheduler;
+    std::mutex mutex;
+    std::condition_variable finished_cv;
+    size_t pending;
+    TaskScheduler::Task continuation;
+    std::exception_ptr error;
+};
+
+/// Call \param body(b, e) over subranges [b,e) covering [begin,end) in
+/// parallel, with subranges no smaller than \param grain (except the last).
+/// Returns once all subranges are done; rethrows the first exception.
+PANGOLIN_EXPORT
+void ParallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t,size_t)>& body,
+                 TaskScheduler& scheduler = TaskScheduler::I());
+
+/// ParallelFor over image rows [0,height) in bands of at least \param min_rows.
+inline void ParallelForRows(size_t height, size_t min_rows, const std::function<void(size_t,size_t)>& body,
+                            TaskScheduler& scheduler = TaskScheduler::I())
+{
+    ParallelFor(0, height, min_rows, body, scheduler);
+}
+
+}
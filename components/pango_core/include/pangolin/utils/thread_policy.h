@@ -0,0 +1,84 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove, Richard Newcombe
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <pangolin/platform.h>
+#include <pangolin/utils/params.h>
+
+#include <string>
+#include <vector>
+
+namespace pangolin
+{
+
+/// Name, CPU affinity and scheduling policy for a thread started by Pangolin,
+/// such as a ThreadVideo grab thread or a recording writer or encoder.
+struct PANGOLIN_EXPORT ThreadPolicy
+{
+    enum class Scheduler { Default, Fifo, RoundRobin, Batch, Idle };
+
+    /// Thread name shown by debuggers and top (truncated to 15 characters on Linux)
+    std::string name;
+
+    /// CPUs the thread may run on. Empty for no restriction.
+    std::vector<int> cpus;
+
+    Scheduler scheduler = Scheduler::Default;
+
+    /// Real-time priority (1-99) for Fifo and RoundRobin
+    int priority = 0;
+
+    bool IsDefault() const
+    {
+        return name.empty() && cpus.empty() && scheduler == Scheduler::Default;
+    }
+
+    /// Read policy from params "<prefix>name", "<prefix>cpu" and "<prefix>priority".
+    /// cpu is a '+' separated list of CPUs or ranges, e.g. "3" or "0+4-7".
+    /// priority is one of "fifo:N", "rr:N", "batch", "idle" or "default".
+    /// Throws std::invalid_argument for malformed values.
+    static ThreadPolicy FromParams(const Params& params, const std::string& prefix = "");
+};
+
+/// What ApplyThreadPolicy managed to set. error describes any part which failed.
+struct PANGOLIN_EXPORT ThreadPolicyResult
+{
+    bool name = false;
+    bool affinity = false;
+    bool scheduler = false;
+    std::string error;
+
+    std::string ToString() const;
+};
+
+/// Apply \param policy to the calling thread. Parts left at their defaults
+/// are untouched. If \param report, print which parts were applied or failed.
+PANGOLIN_EXPORT
+ThreadPolicyResult ApplyThreadPolicy(const ThreadPolicy& policy, bool report = true);
+
+}
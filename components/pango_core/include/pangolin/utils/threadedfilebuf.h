@@ -32,6 +32,7 @@
 #include <fstream>
 
 #include <pangolin/platform.h>
+#include <pangolin/utils/thread_policy.h>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -49,9 +50,10 @@ class PANGOLIN_EXPORT threadedfilebuf : public std::streambuf
 public:
     ~threadedfilebuf();
     threadedfilebuf();
-    threadedfilebuf(const std::string& filename, size_t buffer_size_bytes);
+    threadedfilebuf(const std::string& filename, size_t buffer_size_bytes, const ThreadPolicy& policy = ThreadPolicy());
     
-    void open(const std::string& filename, size_t buffer_size_bytes);
+    //! Open file for writing from a new thread, run with policy
+    void open(const std::string& filename, size_t buffer_size_bytes, const ThreadPolicy& policy = ThreadPolicy());
     void close();
     void force_close();
     
@@ -89,6 +91,7 @@ protected:
     std::condition_variable cond_queued;
     std::condition_variable cond_dequeued;
     std::thread write_thread;
+    ThreadPolicy thread_policy;
 
     bool should_run;
     bool is_pipe;
@@ -0,0 +1,243 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove, Richard Newcombe
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <pangolin/utils/async_log.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _ANDROID_
+#  include <android/log.h>
+#endif
+
+namespace pangolin
+{
+
+struct AsyncLog::Slot
+{
+    std::atomic<size_t> seq;
+    LogLevel level;
+    char msg[MessageBytes];
+};
+
+namespace
+{
+void DefaultSink(LogLevel level, const char* msg)
+{
+#ifdef _ANDROID_
+    const int prio = level == LogLevel::Debug ? ANDROID_LOG_DEBUG :
+                     level == LogLevel::Info  ? ANDROID_LOG_INFO  : ANDROID_LOG_ERROR;
+    __android_log_print(prio, "pango", "%s", msg);
+#else
+    std::fputs(msg, (level == LogLevel::Debug || level == LogLevel::Info) ? stdout : stderr);
+#endif
+}
+
+int64_t SteadyNowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}
+
+AsyncLog& AsyncLog::I()
+{
+    static AsyncLog instance;
+    return instance;
+}
+
+AsyncLog::AsyncLog(size_t capacity)
+    : enqueue_pos(0), dequeue_pos(0), written(0), dropped(0), suppressed(0),
+      quit(false), sleeping(false), sink(DefaultSink)
+{
+    size_t size = 2;
+    while(size < capacity) size <<= 1;
+    mask = size - 1;
+
+    slots.reset(new Slot[size]);
+    for(size_t i=0; i < size; ++i) {
+        slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    thread = std::thread(&AsyncLog::Run, this);
+}
+
+AsyncLog::~AsyncLog()
+{
+    quit = true;
+    wake_cv.notify_one();
+    if(thread.joinable()) thread.join();
+}
+
+bool AsyncLog::Log(LogLevel level, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    const bool ok = LogV(level, 0, fmt, args);
+    va_end(args);
+    return ok;
+}
+
+bool AsyncLog::LogSuppressed(LogLevel level, uint32_t num_suppressed, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    const bool ok = LogV(level, num_suppressed, fmt, args);
+    va_end(args);
+    return ok;
+}
+
+bool AsyncLog::LogV(LogLevel level, uint32_t num_suppressed, const char* fmt, va_list args)
+{
+    // Bounded multi-producer queue: each slot's sequence number says whether
+    // it is free for the producer at pos (seq == pos) or still holds an
+    // unread message from the previous lap (seq < pos).
+    size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+    while(true) {
+        slot = &slots[pos & mask];
+        const size_t seq = slot->seq.load(std::memory_order_acquire);
+        const intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if(dif == 0) {
+            if(enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        }else if(dif < 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }else{
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->level = level;
+    int len = std::vsnprintf(slot->msg, MessageBytes, fmt, args);
+    len = std::max(0, std::min(len, (int)MessageBytes - 1));
+    if(num_suppressed) {
+        const bool newline = len > 0 && slot->msg[len-1] == '\n';
+        if(newline) --len;
+        std::snprintf(slot->msg + len, MessageBytes - len, " [%u similar suppressed]%s",
+                      num_suppressed, newline ? "\n" : "");
+    }
+    slot->seq.store(pos + 1, std::memory_order_release);
+
+    if(sleeping.load(std::memory_order_relaxed)) {
+        wake_cv.notify_one();
+    }
+    return true;
+}
+
+void AsyncLog::Run()
+{
+    char msg[MessageBytes];
+
+    while(true) {
+        bool any = false;
+        while(true) {
+            Slot& slot = slots[dequeue_pos & mask];
+            if(slot.seq.load(std::memory_order_acquire) != dequeue_pos + 1) break;
+
+            // Copy out so the slot is free again before doing any I/O
+            const LogLevel level = slot.level;
+            std::memcpy(msg, slot.msg, MessageBytes);
+            slot.seq.store(dequeue_pos + mask + 1, std::memory_order_release);
+            ++dequeue_pos;
+
+            Write(level, msg);
+            written.fetch_add(1, std::memory_order_release);
+            any = true;
+        }
+
+        if(any) {
+            std::lock_guard<std::mutex> l(wake_mutex);
+            flushed_cv.notify_all();
+            continue;
+        }
+
+        if(quit) break;
+
+        // Producers only notify while we sleep, and we time out in case a
+        // notify slipped in before we started waiting.
+        std::unique_lock<std::mutex> l(wake_mutex);
+        sleeping = true;
+        wake_cv.wait_for(l, std::chrono::milliseconds(20));
+        sleeping = false;
+    }
+}
+
+void AsyncLog::Write(LogLevel level, const char* msg)
+{
+    std::lock_guard<std::mutex> l(sink_mutex);
+    if(sink) sink(level, msg);
+}
+
+void AsyncLog::Flush()
+{
+    // Every claimed slot will be written, including any still being filled.
+    const uint64_t target = enqueue_pos.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> l(wake_mutex);
+    while(written.load(std::memory_order_acquire) < target) {
+        wake_cv.notify_one();
+        flushed_cv.wait_for(l, std::chrono::milliseconds(5));
+    }
+}
+
+void AsyncLog::SetSink(Sink s)
+{
+    std::lock_guard<std::mutex> l(sink_mutex);
+    sink = s ? std::move(s) : Sink(DefaultSink);
+}
+
+void AsyncLog::AddSuppressed(uint32_t n)
+{
+    suppressed.fetch_add(n, std::memory_order_relaxed);
+}
+
+AsyncLog::Stats AsyncLog::GetStats() const
+{
+    return { written.load(), dropped.load(), suppressed.load() };
+}
+
+LogRateLimiter::LogRateLimiter(int64_t interval_ms)
+    : interval_us(interval_ms * 1000), next_us(0), held(0)
+{
+}
+
+bool LogRateLimiter::Allow(uint32_t& suppressed)
+{
+    const int64_t now = SteadyNowUs();
+    int64_t next = next_us.load(std::memory_order_relaxed);
+    if(now >= next && next_us.compare_exchange_strong(next, now + interval_us, std::memory_order_relaxed)) {
+        suppressed = held.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+    held.fetch_add(1, std::memory_order_relaxed);
+    AsyncLog::I().AddSuppressed(1);
+    return false;
+}
+
+}
@@ -0,0 +1,159 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove, Richard Newcombe
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <pangolin/utils/crc32c.h>
+
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#  include <nmmintrin.h>
+#  define PANGO_CRC32C_SSE42 __attribute__((target("sse4.2")))
+#elif defined(_MSC_VER) && defined(_M_X64)
+#  include <intrin.h>
+#  include <nmmintrin.h>
+#  define PANGO_CRC32C_SSE42
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#  include <arm_acle.h>
+#  define PANGO_CRC32C_ARMV8
+#endif
+
+namespace pangolin
+{
+
+namespace
+{
+
+// Slicing-by-8 tables for the reflected polynomial
+struct Crc32cTables
+{
+    Crc32cTables()
+    {
+        for(uint32_t i=0; i < 256; ++i) {
+            uint32_t c = i;
+            for(int k=0; k < 8; ++k) c = (c >> 1) ^ (0x82F63B78u & (0u - (c & 1u)));
+            t[0][i] = c;
+        }
+        for(uint32_t i=0; i < 256; ++i) {
+            for(int s=1; s < 8; ++s) t[s][i] = (t[s-1][i] >> 8) ^ t[0][t[s-1][i] & 0xff];
+        }
+    }
+    uint32_t t[8][256];
+};
+
+uint32_t Crc32cSoftware(uint32_t c, const uint8_t* p, size_t n)
+{
+    static const Crc32cTables tables;
+    const auto& t = tables.t;
+    while(n >= 8) {
+        uint32_t lo, hi;
+        std::memcpy(&lo, p, 4);
+        std::memcpy(&hi, p + 4, 4);
+        lo ^= c;
+        c = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+            t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+        p += 8;
+        n -= 8;
+    }
+    while(n--) c = (c >> 8) ^ t[0][(c ^ *p++) & 0xff];
+    return c;
+}
+
+#if defined(PANGO_CRC32C_SSE42)
+PANGO_CRC32C_SSE42
+uint32_t Crc32cHardware(uint32_t c, const uint8_t* p, size_t n)
+{
+#  if defined(__x86_64__) || defined(_M_X64)
+    uint64_t c64 = c;
+    while(n >= 8) {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        c64 = _mm_crc32_u64(c64, v);
+        p += 8;
+        n -= 8;
+    }
+    c = (uint32_t)c64;
+#  endif
+    while(n >= 4) {
+        uint32_t v;
+        std::memcpy(&v, p, 4);
+        c = _mm_crc32_u32(c, v);
+        p += 4;
+        n -= 4;
+    }
+    while(n--) c = _mm_crc32_u8(c, *p++);
+    return c;
+}
+
+bool HaveHardwareCrc32c()
+{
+#  ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#  else
+    return __builtin_cpu_supports("sse4.2");
+#  endif
+}
+#elif defined(PANGO_CRC32C_ARMV8)
+uint32_t Crc32cHardware(uint32_t c, const uint8_t* p, size_t n)
+{
+    while(n >= 8) {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        c = __crc32cd(c, v);
+        p += 8;
+        n -= 8;
+    }
+    while(n--) c = __crc32cb(c, *p++);
+    return c;
+}
+
+bool HaveHardwareCrc32c()
+{
+    return true;
+}
+#endif
+
+using Crc32cFunc = uint32_t(*)(uint32_t, const uint8_t*, size_t);
+
+Crc32cFunc SelectCrc32c()
+{
+#if defined(PANGO_CRC32C_SSE42) || defined(PANGO_CRC32C_ARMV8)
+    if(HaveHardwareCrc32c()) return &Crc32cHardware;
+#endif
+    return &Crc32cSoftware;
+}
+
+}
+
+uint32_t Crc32c(const void* data, size_t len, uint32_t crc)
+{
+    static const Crc32cFunc func = SelectCrc32c();
+    return ~func(~crc, static_cast<const uint8_t*>(data), len);
+}
+
+}
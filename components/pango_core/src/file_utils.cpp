@@ -28,6 +28,7 @@
 #include <pangolin/platform.h>
 
 #include <pangolin/utils/file_utils.h>
+#include <pangolin/utils/task_scheduler.h>
 
 #ifdef _WIN_
 #  ifndef WIN32_LEAN_AND_MEAN
@@ -68,6 +69,9 @@
 #endif // _WIN_
 
 #include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iterator>
 #include <sstream>
 #include <fstream>
 #include <list>
@@ -284,6 +288,27 @@ bool MatchesWildcard(const std::string& str, const std::string& wildcard)
     return !*psQuery && !*psWildcard;
 }
 
+std::string DefaultCacheDir()
+{
+    if(const char* dir = getenv("PANGOLIN_CACHE_DIR")) {
+        return dir;
+    }
+#ifdef _WIN_
+    if(const char* dir = getenv("LOCALAPPDATA")) {
+        return std::string(dir) + "\\pangolin";
+    }
+    return std::string();
+#else
+    if(const char* dir = getenv("XDG_CACHE_HOME")) {
+        return std::string(dir) + "/pangolin";
+    }
+    if(const char* home = getenv("HOME")) {
+        return std::string(home) + "/.cache/pangolin";
+    }
+    return std::string();
+#endif
+}
+
 std::string MakeUniqueFilename(const std::string& filename)
 {
     if( FileExists(filename) ) {
@@ -478,6 +503,11 @@ bool FilesMatchingWildcard(const std::string& wildcard, std::vector<std::string>
     return files.size() > 0;
 }
 
+bool FilesMatchingWildcardCached(const std::string& wildcard, std::vector<std::string>& file_vec, SortMethod sort_method, const std::string& /*cache_dir*/)
+{
+    return FilesMatchingWildcard(wildcard, file_vec, sort_method);
+}
+
 bool FileExists(const std::string& filename)
 {
     std::string search_filename = filename;
@@ -494,60 +524,253 @@ bool FileExists(const std::string& filename)
 
 #else // _WIN_
 
-bool FilesMatchingWildcard_(const std::string& in_wildcard, std::vector<std::string>& file_vec)
+namespace {
+
+// True unless the entry is known not to be a directory (or link to one)
+bool MaybeDirectory(const struct dirent* ent)
+{
+#ifdef DT_DIR
+    return ent->d_type == DT_DIR || ent->d_type == DT_LNK || ent->d_type == DT_UNKNOWN;
+#else
+    PANGOLIN_UNUSED(ent);
+    return true;
+#endif
+}
+
+// Append the matches of 'in_wildcard' to file_vec, unsorted. Subdirectories
+// which match a directory component are listed concurrently.
+void FilesMatchingWildcard_(const std::string& in_wildcard, std::vector<std::string>& file_vec)
 {
     const std::string wildcard = PathExpand(in_wildcard);
     const size_t first_wildcard = wildcard.find_first_of("?*");
-    if(first_wildcard != std::string::npos) {
-        const std::string root = PathParent(wildcard.substr(0,first_wildcard));
-        struct dirent **namelist;
-        int n = scandir(root.c_str(), &namelist, 0, alphasort);
-        if (n >= 0) {
-            const size_t next_slash = wildcard.find_first_of("/\\",first_wildcard+1);
-            std::string dir_wildcard, rest;
-            if(next_slash != std::string::npos) {
-                dir_wildcard = wildcard.substr(root.size()+1, next_slash-root.size()-1);
-                rest = wildcard.substr(next_slash);
-            }else{
-                dir_wildcard = wildcard.substr(root.size()+1);
-            }
+    if(first_wildcard == std::string::npos) {
+        if(FileExists(wildcard)) file_vec.push_back(wildcard);
+        return;
+    }
 
-            while(n--) {
-                const std::string file_name(namelist[n]->d_name);
-                if( file_name != "." && file_name != ".." && MatchesWildcard(file_name, dir_wildcard) ) {
-                    const std::string sub_wildcard = root + "/" + file_name + rest;
-                    FilesMatchingWildcard_(sub_wildcard, file_vec);
-                    if(dir_wildcard == "**") {
-                        const std::string sub_wildcard2 = root + "/" + file_name + "/**" + rest;
-                        FilesMatchingWildcard_(sub_wildcard2, file_vec);
-                    }
+    const std::string root = PathParent(wildcard.substr(0,first_wildcard));
+    const size_t next_slash = wildcard.find_first_of("/\\",first_wildcard+1);
+    std::string dir_wildcard, rest;
+    if(next_slash != std::string::npos) {
+        dir_wildcard = wildcard.substr(root.size()+1, next_slash-root.size()-1);
+        rest = wildcard.substr(next_slash);
+    }else{
+        dir_wildcard = wildcard.substr(root.size()+1);
+    }
+
+    DIR* dir = opendir(root.c_str());
+    if(!dir) return;
+
+    // Entries returned by readdir exist, so leaf matches need no stat.
+    std::vector<std::string> sub_wildcards;
+    std::string file_name;
+    while(const struct dirent* ent = readdir(dir)) {
+        file_name = ent->d_name;
+        if( file_name == "." || file_name == ".." || !MatchesWildcard(file_name, dir_wildcard) ) {
+            continue;
+        }
+        const std::string path = root + "/" + file_name;
+        if(rest.empty()) {
+            file_vec.push_back(path);
+        }else if(MaybeDirectory(ent)) {
+            sub_wildcards.push_back(path + rest);
+        }
+        if(dir_wildcard == "**" && MaybeDirectory(ent)) {
+            sub_wildcards.push_back(path + "/**" + rest);
+        }
+    }
+    closedir(dir);
+
+    if(sub_wildcards.size() == 1) {
+        FilesMatchingWildcard_(sub_wildcards[0], file_vec);
+    }else if(sub_wildcards.size() > 1) {
+        std::vector<std::vector<std::string>> sub_files(sub_wildcards.size());
+        TaskGroup group;
+        for(size_t i=0; i < sub_wildcards.size(); ++i) {
+            group.Run([&sub_wildcards, &sub_files, i](){
+                FilesMatchingWildcard_(sub_wildcards[i], sub_files[i]);
+            });
+        }
+        group.Wait();
+        for(auto& files : sub_files) {
+            file_vec.insert(file_vec.end(), std::make_move_iterator(files.begin()), std::make_move_iterator(files.end()));
+        }
+    }
+}
+
+// Sort contiguous blocks concurrently, then merge neighbouring blocks
+template<typename Compare>
+void ParallelSort(std::vector<std::string>& vec, Compare less)
+{
+    const size_t grain = 16384;
+    const size_t blocks = std::min(TaskScheduler::I().NumWorkers() + 1, (vec.size() + grain - 1) / grain);
+    if(blocks <= 1) {
+        std::sort(vec.begin(), vec.end(), less);
+        return;
+    }
+
+    std::vector<size_t> bounds(blocks+1);
+    for(size_t b=0; b <= blocks; ++b) bounds[b] = vec.size() * b / blocks;
+
+    ParallelFor(0, blocks, 1, [&](size_t b0, size_t b1){
+        for(size_t b=b0; b < b1; ++b) {
+            std::sort(vec.begin() + bounds[b], vec.begin() + bounds[b+1], less);
+        }
+    });
+
+    for(size_t width=1; width < blocks; width *= 2) {
+        ParallelFor(0, (blocks + 2*width - 1) / (2*width), 1, [&](size_t p0, size_t p1){
+            for(size_t p=p0; p < p1; ++p) {
+                const size_t lo = p * 2 * width;
+                const size_t mid = std::min(lo + width, blocks);
+                const size_t hi = std::min(lo + 2 * width, blocks);
+                if(mid < hi) {
+                    std::inplace_merge(vec.begin() + bounds[lo], vec.begin() + bounds[mid], vec.begin() + bounds[hi], less);
                 }
             }
+        });
+    }
+}
+
+void SortFiles(std::vector<std::string>& file_vec, SortMethod sort_method)
+{
+    switch (sort_method) {
+      case SortMethod::NATURAL:
+        ParallelSort(file_vec, [](const std::string& a, const std::string& b){
+            return SI::natural::compare<std::string>(a, b);
+        });
+        break;
+      case SortMethod::STANDARD:
+      default:
+        ParallelSort(file_vec, std::less<std::string>());
+    }
+}
+
+// Manifests are only worth keeping for large listings
+constexpr size_t kManifestMinFiles = 1024;
+const char* kManifestMagic = "pangolin_manifest 1";
+
+bool DirectoryModifiedTime(const std::string& dir, int64_t& mtime_ns)
+{
+    struct stat st;
+    if(stat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) return false;
+#ifdef __APPLE__
+    mtime_ns = int64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    mtime_ns = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    return true;
+}
+
+std::string ManifestPath(const std::string& cache_dir, const std::string& key)
+{
+    std::stringstream ss;
+    ss << cache_dir << "/manifest_" << std::hex << std::hash<std::string>()(key) << ".txt";
+    return ss.str();
+}
+
+bool ReadManifest(const std::string& filename, const std::string& key, int64_t mtime_ns, std::vector<std::string>& files)
+{
+    std::ifstream f(filename);
+    std::string line;
+    if(!std::getline(f, line) || line != kManifestMagic) return false;
+    if(!std::getline(f, line) || line != key) return false;
+    if(!std::getline(f, line) || line != std::to_string(mtime_ns)) return false;
+
+    while(std::getline(f, line)) {
+        files.push_back(line);
+    }
+    return !f.bad();
+}
+
+void WriteManifest(const std::string& cache_dir, const std::string& filename, const std::string& key, int64_t mtime_ns, const std::vector<std::string>& files)
+{
+    for(const auto& file : files) {
+        if(file.find('\n') != std::string::npos) return;
+    }
+
+    // Create cache_dir and any missing parents
+    for(size_t slash = cache_dir.find('/', 1); ; slash = cache_dir.find('/', slash+1)) {
+        mkdir(cache_dir.substr(0, slash).c_str(), 0755);
+        if(slash == std::string::npos) break;
+    }
+
+    // Write aside and rename so that readers never see a partial manifest
+    const std::string tmp = filename + "." + std::to_string(getpid());
+    {
+        std::ofstream f(tmp);
+        f << kManifestMagic << "\n" << key << "\n" << mtime_ns << "\n";
+        for(const auto& file : files) {
+            f << file << "\n";
+        }
+        if(!f.good()) {
+            f.close();
+            unlink(tmp.c_str());
+            return;
         }
-    } else if(FileExists(wildcard)) {
-        file_vec.push_back(wildcard);
     }
-    return file_vec.size() > 0;
+    if(rename(tmp.c_str(), filename.c_str()) != 0) {
+        unlink(tmp.c_str());
+    }
+}
+
 }
 
 bool FilesMatchingWildcard(const std::string& in_wildcard, std::vector<std::string>& file_vec, SortMethod sort_method)
 {
-    if (FilesMatchingWildcard_(in_wildcard, file_vec)) {
+    FilesMatchingWildcard_(in_wildcard, file_vec);
+    if (!file_vec.empty()) {
         // sort all file entries in file_vec to make sure anything that was
         // added is sorted in properly.
-        switch (sort_method) {
-          case SortMethod::NATURAL:
-            SI::natural::sort(file_vec.begin(), file_vec.end());
-            break;
-          case SortMethod::STANDARD:
-          default:
-            std::sort(file_vec.begin(), file_vec.end() );
-        }
+        SortFiles(file_vec, sort_method);
         return true;
     }
     return false;
 }
 
+bool FilesMatchingWildcardCached(const std::string& in_wildcard, std::vector<std::string>& file_vec, SortMethod sort_method, const std::string& cache_dir)
+{
+    const std::string wildcard = PathExpand(in_wildcard);
+    const size_t first_wildcard = wildcard.find_first_of("?*");
+    const size_t last_slash = wildcard.find_last_of("/\\");
+    const std::string dir = (last_slash == std::string::npos) ? std::string(".") : wildcard.substr(0, last_slash);
+
+    int64_t mtime_ns = 0;
+    const bool cacheable = !cache_dir.empty() && file_vec.empty() &&
+            first_wildcard != std::string::npos &&
+            (last_slash == std::string::npos || last_slash < first_wildcard) &&
+            DirectoryModifiedTime(dir, mtime_ns);
+
+    if(!cacheable) {
+        return FilesMatchingWildcard(wildcard, file_vec, sort_method);
+    }
+
+    const std::string key = wildcard + "\t" + std::to_string(int(sort_method));
+    const std::string manifest = ManifestPath(cache_dir, key);
+
+    if(ReadManifest(manifest, key, mtime_ns, file_vec)) {
+        return !file_vec.empty();
+    }
+    file_vec.clear();
+
+    if(!FilesMatchingWildcard(wildcard, file_vec, sort_method)) {
+        return false;
+    }
+
+    // A directory still being written to could change again within the
+    // resolution of its timestamp, so only record listings which have settled.
+    const int64_t settle_ns = int64_t(2) * 1000000000;
+    const int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    int64_t mtime_after_ns = 0;
+    if( file_vec.size() >= kManifestMinFiles && now_ns - mtime_ns > settle_ns &&
+        DirectoryModifiedTime(dir, mtime_after_ns) && mtime_after_ns == mtime_ns )
+    {
+        WriteManifest(cache_dir, manifest, key, mtime_ns, file_vec);
+    }
+    return true;
+}
+
 
 bool FileExists(const std::string& filename)
 {
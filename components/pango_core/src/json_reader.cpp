@@ -0,0 +1,551 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove, Richard Newcombe
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <pangolin/utils/json_reader.h>
+
+#include <cerrno>
+#include <charconv>
+#include <clocale>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#  include <emmintrin.h>
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  endif
+#  define PANGO_JSON_SSE2
+#endif
+
+namespace pangolin
+{
+
+namespace
+{
+
+inline bool IsSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+inline bool IsDelimiter(char c)
+{
+    return c == ',' || c == '}' || c == ']' || c == ':' || IsSpace(c);
+}
+
+// Parse a JSON number at p, returning one past its end, or nullptr if there
+// isn't one or it is out of range.
+const char* ParseDouble(const char* p, const char* end, double& v)
+{
+    // JSON has no leading '+', inf or nan
+    if(p == end || !(*p == '-' || (*p >= '0' && *p <= '9'))) return nullptr;
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    const auto r = std::from_chars(p, end, v);
+    return r.ec == std::errc() ? r.ptr : nullptr;
+#else
+    // Without floating point from_chars (libstdc++ before 11, libc++), use
+    // strtod on a NUL terminated copy with the locale's decimal point.
+    std::string num;
+    const char* q = p;
+    for(; q != end && ((*q >= '0' && *q <= '9') || *q == '-' || *q == '+' || *q == 'e' || *q == 'E' || *q == '.'); ++q) {
+        if(*q == '.') {
+            num += std::localeconv()->decimal_point;
+        }else{
+            num += *q;
+        }
+    }
+    char* stop = nullptr;
+    errno = 0;
+    v = std::strtod(num.c_str(), &stop);
+    if(errno == ERANGE || stop != num.c_str() + num.size()) return nullptr;
+    return q;
+#endif
+}
+
+#ifdef PANGO_JSON_SSE2
+inline int FirstSetBit(int mask)
+{
+#  ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward(&i, (unsigned long)mask);
+    return (int)i;
+#  else
+    return __builtin_ctz((unsigned)mask);
+#  endif
+}
+#endif
+
+// First '"' or '\' at or after p, or end. Used within strings.
+inline const char* FindQuoteOrEscape(const char* p, const char* end)
+{
+#ifdef PANGO_JSON_SSE2
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i escape = _mm_set1_epi8('\\');
+    for(; end - p >= 16; p += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, escape)));
+        if(mask) return p + FirstSetBit(mask);
+    }
+#endif
+    for(; p != end; ++p) {
+        if(*p == '"' || *p == '\\') return p;
+    }
+    return end;
+}
+
+// First '"', '{', '}', '[' or ']' at or after p, or end. Used between values.
+inline const char* FindStructural(const char* p, const char* end)
+{
+#ifdef PANGO_JSON_SSE2
+    // Setting bit 5 maps '[' onto '{' and ']' onto '}'
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i open = _mm_set1_epi8('{');
+    const __m128i close = _mm_set1_epi8('}');
+    const __m128i bit5 = _mm_set1_epi8(0x20);
+    for(; end - p >= 16; p += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i folded = _mm_or_si128(v, bit5);
+        const __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                             _mm_or_si128(_mm_cmpeq_epi8(folded, open), _mm_cmpeq_epi8(folded, close)));
+        const int mask = _mm_movemask_epi8(hits);
+        if(mask) return p + FirstSetBit(mask);
+    }
+#endif
+    for(; p != end; ++p) {
+        const char c = *p | 0x20;
+        if(*p == '"' || c == '{' || c == '}') return p;
+    }
+    return end;
+}
+
+void AppendUtf8(std::string& s, uint32_t cp)
+{
+    if(cp < 0x80) {
+        s += (char)cp;
+    }else if(cp < 0x800) {
+        s += (char)(0xC0 | (cp >> 6));
+        s += (char)(0x80 | (cp & 0x3F));
+    }else if(cp < 0x10000) {
+        s += (char)(0xE0 | (cp >> 12));
+        s += (char)(0x80 | ((cp >> 6) & 0x3F));
+        s += (char)(0x80 | (cp & 0x3F));
+    }else{
+        s += (char)(0xF0 | (cp >> 18));
+        s += (char)(0x80 | ((cp >> 12) & 0x3F));
+        s += (char)(0x80 | ((cp >> 6) & 0x3F));
+        s += (char)(0x80 | (cp & 0x3F));
+    }
+}
+
+}
+
+JsonReader::JsonReader(const char* begin, const char* end)
+    : begin(begin), p(begin), end(end)
+{
+}
+
+JsonReader::JsonReader(const std::string& json)
+    : JsonReader(json.data(), json.data() + json.size())
+{
+}
+
+void JsonReader::Fail(const std::string& what) const
+{
+    throw JsonReaderException(what, Offset());
+}
+
+void JsonReader::SkipSpace()
+{
+    while(p != end && IsSpace(*p)) ++p;
+}
+
+char JsonReader::Expect(char c)
+{
+    SkipSpace();
+    if(p == end || *p != c) Fail(std::string("expected '") + c + "'");
+    return *p++;
+}
+
+bool JsonReader::AtEnd()
+{
+    SkipSpace();
+    return p == end;
+}
+
+JsonReader::Type JsonReader::Peek()
+{
+    SkipSpace();
+    if(p == end) return Type::End;
+    switch(*p) {
+    case '{': return Type::Object;
+    case '[': return Type::Array;
+    case '"': return Type::String;
+    case 't': case 'f': return Type::Bool;
+    case 'n': return Type::Null;
+    case '}': case ']': return Type::End;
+    default:
+        if(*p == '-' || ('0' <= *p && *p <= '9')) return Type::Number;
+        Fail(std::string("unexpected '") + *p + "'");
+    }
+}
+
+void JsonReader::ReadNull()
+{
+    SkipSpace();
+    if(end - p < 4 || std::memcmp(p, "null", 4)) Fail("expected null");
+    p += 4;
+}
+
+bool JsonReader::ReadBool()
+{
+    SkipSpace();
+    if(end - p >= 4 && !std::memcmp(p, "true", 4)) { p += 4; return true; }
+    if(end - p >= 5 && !std::memcmp(p, "false", 5)) { p += 5; return false; }
+    Fail("expected boolean");
+}
+
+int64_t JsonReader::ReadInt()
+{
+    SkipSpace();
+    int64_t v = 0;
+    const auto r = std::from_chars(p, end, v);
+    if(r.ec == std::errc() && (r.ptr == end || IsDelimiter(*r.ptr))) {
+        p = r.ptr;
+        return v;
+    }
+
+    // Fraction or exponent: go via double like picojson, within [-2^63, 2^63)
+    const char* start = p;
+    const double d = ReadDouble();
+    if(!(d >= -9223372036854775808.0 && d < 9223372036854775808.0)) {
+        p = start;
+        Fail("integer out of range");
+    }
+    return (int64_t)d;
+}
+
+uint64_t JsonReader::ReadUInt()
+{
+    SkipSpace();
+    uint64_t v = 0;
+    const auto r = std::from_chars(p, end, v);
+    if(r.ec == std::errc() && (r.ptr == end || IsDelimiter(*r.ptr))) {
+        p = r.ptr;
+        return v;
+    }
+
+    // As ReadInt(), within [0, 2^64)
+    const char* start = p;
+    const double d = ReadDouble();
+    if(!(d >= 0.0 && d < 18446744073709551616.0)) {
+        p = start;
+        Fail("unsigned integer out of range");
+    }
+    return (uint64_t)d;
+}
+
+double JsonReader::ReadDouble()
+{
+    SkipSpace();
+    double v = 0.0;
+    const char* q = ParseDouble(p, end, v);
+    if(!q || (q != end && !IsDelimiter(*q))) Fail("expected number");
+    p = q;
+    return v;
+}
+
+void JsonReader::ReadString(std::string& str)
+{
+    str.clear();
+    Expect('"');
+    while(true) {
+        const char* q = FindQuoteOrEscape(p, end);
+        if(q == end) Fail("unterminated string");
+        str.append(p, q);
+        p = q + 1;
+        if(*q == '"') return;
+
+        // Escape sequence
+        if(p == end) Fail("unterminated string");
+        const char e = *p++;
+        switch(e) {
+        case '"':  str += '"'; break;
+        case '\\': str += '\\'; break;
+        case '/':  str += '/'; break;
+        case 'b':  str += '\b'; break;
+        case 'f':  str += '\f'; break;
+        case 'n':  str += '\n'; break;
+        case 'r':  str += '\r'; break;
+        case 't':  str += '\t'; break;
+        case 'u': {
+            auto hex4 = [&]() {
+                uint32_t cp = 0;
+                if(end - p < 4) Fail("bad unicode escape");
+                const auto r = std::from_chars(p, p + 4, cp, 16);
+                if(r.ptr != p + 4) Fail("bad unicode escape");
+                p += 4;
+                return cp;
+            };
+            uint32_t cp = hex4();
+            if(0xD800 <= cp && cp < 0xDC00 && end - p >= 2 && p[0] == '\\' && p[1] == 'u') {
+                p += 2;
+                const uint32_t lo = hex4();
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+            }
+            AppendUtf8(str, cp);
+            break;
+        }
+        default:
+            Fail("bad escape");
+        }
+    }
+}
+
+std::string JsonReader::ReadString()
+{
+    std::string s;
+    ReadString(s);
+    return s;
+}
+
+void JsonReader::BeginObject()
+{
+    Expect('{');
+    first.push_back(true);
+}
+
+bool JsonReader::NextKey(std::string& key)
+{
+    SkipSpace();
+    if(p != end && *p == '}') {
+        ++p;
+        first.pop_back();
+        return false;
+    }
+    if(first.empty()) Fail("not in an object");
+    if(!first.back()) Expect(',');
+    first.back() = false;
+    ReadString(key);
+    Expect(':');
+    return true;
+}
+
+void JsonReader::BeginArray()
+{
+    Expect('[');
+    first.push_back(true);
+}
+
+bool JsonReader::NextElement()
+{
+    SkipSpace();
+    if(p != end && *p == ']') {
+        ++p;
+        first.pop_back();
+        return false;
+    }
+    if(first.empty()) Fail("not in an array");
+    if(!first.back()) Expect(',');
+    first.back() = false;
+    return true;
+}
+
+void JsonReader::SkipString()
+{
+    ++p; // opening quote
+    while(true) {
+        const char* q = FindQuoteOrEscape(p, end);
+        if(q == end) Fail("unterminated string");
+        if(*q == '"') { p = q + 1; return; }
+        p = q + 2; // escaped character
+    }
+}
+
+void JsonReader::SkipScalar()
+{
+    while(p != end && !IsDelimiter(*p)) ++p;
+}
+
+void JsonReader::Skip()
+{
+    switch(Peek()) {
+    case Type::String:
+        SkipString();
+        return;
+    case Type::Object:
+    case Type::Array: {
+        // Only quotes and brackets matter when stepping over a container
+        size_t depth = 0;
+        while(true) {
+            p = FindStructural(p, end);
+            if(p == end) Fail("unterminated container");
+            const char c = *p;
+            if(c == '"') {
+                SkipString();
+            }else if((c | 0x20) == '{') {
+                ++depth; ++p;
+            }else{
+                ++p;
+                if(--depth == 0) return;
+            }
+        }
+    }
+    case Type::End:
+        Fail("expected value");
+    default:
+        SkipScalar();
+    }
+}
+
+std::string_view JsonReader::RawValue()
+{
+    SkipSpace();
+    const char* start = p;
+    Skip();
+    return std::string_view(start, size_t(p - start));
+}
+
+picojson::value JsonReader::ReadValue()
+{
+    picojson::value v;
+    switch(Peek()) {
+    case Type::Null:
+        ReadNull();
+        break;
+    case Type::Bool:
+        v = picojson::value(ReadBool());
+        break;
+    case Type::Number: {
+        const char* start = p;
+        SkipScalar();
+        const char* stop = p;
+        int64_t i = 0;
+        const auto r = std::from_chars(start, stop, i);
+        if(r.ec == std::errc() && r.ptr == stop) {
+            v = picojson::value(i);
+        }else{
+            p = start;
+            v = picojson::value(ReadDouble());
+        }
+        break;
+    }
+    case Type::String: {
+        // Construct directly from the input when there is nothing to unescape
+        const char* q = FindQuoteOrEscape(p + 1, end);
+        if(q != end && *q == '"') {
+            v = picojson::value(p + 1, size_t(q - p - 1));
+            p = q + 1;
+        }else{
+            v = picojson::value(ReadString());
+        }
+        break;
+    }
+    case Type::Array: {
+        picojson::value a(picojson::array_type, false);
+        picojson::array& arr = a.get<picojson::array>();
+        BeginArray();
+        while(NextElement()) {
+            arr.emplace_back();
+            picojson::value e = ReadValue();
+            arr.back().swap(e);
+        }
+        v.swap(a);
+        break;
+    }
+    case Type::Object: {
+        picojson::value o(picojson::object_type, false);
+        picojson::object& obj = o.get<picojson::object>();
+        std::string key;
+        BeginObject();
+        while(NextKey(key)) {
+            picojson::value e = ReadValue();
+            obj[key].swap(e);
+        }
+        v.swap(o);
+        break;
+    }
+    case Type::End:
+        Fail("expected value");
+    }
+    return v;
+}
+
+bool ReadJsonText(std::istream& is, std::string& text)
+{
+    text.clear();
+    std::streambuf* sb = is.rdbuf();
+    const int eof = std::char_traits<char>::eof();
+
+    int c = sb->sgetc();
+    while(c != eof && IsSpace((char)c)) c = sb->snextc();
+    if(c == eof) {
+        is.setstate(std::ios::eofbit | std::ios::failbit);
+        return false;
+    }
+
+    // Scalars end at the first delimiter, which is left in the stream
+    if(c != '{' && c != '[' && c != '"') {
+        while(c != eof && !IsDelimiter((char)c)) {
+            text += (char)c;
+            c = sb->snextc();
+        }
+        return !text.empty();
+    }
+
+    size_t depth = 0;
+    bool in_string = false;
+    bool escaped = false;
+    while(true) {
+        c = sb->sbumpc();
+        if(c == eof) {
+            is.setstate(std::ios::eofbit | std::ios::failbit);
+            return false;
+        }
+        const char ch = (char)c;
+        text += ch;
+
+        if(in_string) {
+            if(escaped) escaped = false;
+            else if(ch == '\\') escaped = true;
+            else if(ch == '"') {
+                in_string = false;
+                if(depth == 0) return true;
+            }
+        }else if(ch == '"') {
+            in_string = true;
+        }else if(ch == '{' || ch == '[') {
+            ++depth;
+        }else if(ch == '}' || ch == ']') {
+            if(depth == 0) return false;
+            if(--depth == 0) return true;
+        }
+    }
+}
+
+}
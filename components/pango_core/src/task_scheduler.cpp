@@ -0,0 +1,368 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove, Richard Newcombe
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <pangolin/utils/task_scheduler.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+namespace pangolin
+{
+
+namespace
+{
+const size_t not_a_worker = (size_t)-1;
+thread_local const TaskScheduler* tls_scheduler = nullptr;
+thread_local size_t tls_worker = not_a_worker;
+
+size_t DefaultNumWorkers()
+{
+    if(const char* env = std::getenv("PANGOLIN_WORKERS")) {
+        return (size_t)std::max(0L, std::strtol(env, nullptr, 10));
+    }
+    const size_t hw = std::thread::hardware_concurrency();
+    return std::max<size_t>(1, hw > 0 ? hw - 1 : 1);
+}
+}
+
+TaskScheduler& TaskScheduler::I()
+{
+    static TaskScheduler instance(DefaultNumWorkers(), [](){
+        ThreadPolicy policy;
+        policy.name = "pango_worker";
+        return policy;
+    }());
+    return instance;
+}
+
+TaskScheduler::TaskScheduler(size_t num_workers, const ThreadPolicy& worker_policy)
+    : queued(0), quit(false)
+{
+    Start(num_workers, worker_policy);
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    Join();
+    // Anyone still waiting on these would otherwise never return
+    Start(0, ThreadPolicy());
+    while(TryRunOne()) {}
+}
+
+void TaskScheduler::Configure(size_t num_workers, const ThreadPolicy& worker_policy)
+{
+    std::lock_guard<std::mutex> l(configure_mutex);
+    Join();
+    Start(num_workers, worker_policy);
+    if(num_workers == 0) {
+        while(TryRunOne()) {}
+    }
+}
+
+size_t TaskScheduler::NumWorkers() const
+{
+    std::shared_lock<std::shared_mutex> l(workers_mutex);
+    return workers.size();
+}
+
+void TaskScheduler::Start(size_t num_workers, const ThreadPolicy& worker_policy)
+{
+    // Workers steal from each other, so all must exist before any starts.
+    std::vector<std::unique_ptr<Worker>> started;
+    for(size_t i=0; i < num_workers; ++i) {
+        started.emplace_back(new Worker());
+    }
+
+    {
+        // Swap in one step so that Spawn() never sees an empty list in between
+        std::unique_lock<std::shared_mutex> lw(workers_mutex);
+        std::lock_guard<std::mutex> l(injected_mutex);
+        for(auto& w : workers) {
+            for(auto& t : w->tasks) injected.push_back(std::move(t));
+        }
+        workers.swap(started);
+        quit = false;
+    }
+
+    // Only Start() and Join() touch the threads, under configure_mutex
+    for(size_t i=0; i < num_workers; ++i) {
+        workers[i]->thread = std::thread(&TaskScheduler::Run, this, i, worker_policy);
+    }
+}
+
+void TaskScheduler::Join()
+{
+    {
+        std::lock_guard<std::mutex> l(sleep_mutex);
+        quit = true;
+    }
+    sleep_cv.notify_all();
+
+    // Workers may spawn and take tasks until they notice, so the list stays
+    // in place (and unlocked) until they have finished.
+    for(auto& w : workers) {
+        if(w->thread.joinable()) w->thread.join();
+    }
+}
+
+void TaskScheduler::Spawn(Task task)
+{
+    {
+        std::shared_lock<std::shared_mutex> lw(workers_mutex);
+        if(workers.empty()) {
+            lw.unlock();
+            task();
+            return;
+        }
+
+        // Count first so that a worker which sees the task never sees zero queued.
+        queued.fetch_add(1);
+        if(tls_scheduler == this) {
+            Worker& w = *workers[tls_worker];
+            std::lock_guard<std::mutex> l(w.mutex);
+            w.tasks.push_back(std::move(task));
+        }else{
+            std::lock_guard<std::mutex> l(injected_mutex);
+            injected.push_back(std::move(task));
+        }
+    }
+
+    { std::lock_guard<std::mutex> l(sleep_mutex); }
+    sleep_cv.notify_one();
+}
+
+bool TaskScheduler::Take(size_t index, Task& task)
+{
+    std::shared_lock<std::shared_mutex> lw(workers_mutex);
+
+    // Own tasks newest first, for locality with the task which spawned them
+    if(index != not_a_worker) {
+        Worker& w = *workers[index];
+        std::lock_guard<std::mutex> l(w.mutex);
+        if(!w.tasks.empty()) {
+            task = std::move(w.tasks.back());
+            w.tasks.pop_back();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> l(injected_mutex);
+        if(!injected.empty()) {
+            task = std::move(injected.front());
+            injected.pop_front();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // Steal the oldest, likely largest, task from another worker
+    const size_t n = workers.size();
+    const size_t start = (index == not_a_worker) ? 0 : index + 1;
+    for(size_t k=0; k < n; ++k) {
+        Worker& w = *workers[(start + k) % n];
+        std::lock_guard<std::mutex> l(w.mutex);
+        if(!w.tasks.empty()) {
+            task = std::move(w.tasks.front());
+            w.tasks.pop_front();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TaskScheduler::TryRunOne()
+{
+    Task task;
+    if(Take(tls_scheduler == this ? tls_worker : not_a_worker, task)) {
+        task();
+        return true;
+    }
+    return false;
+}
+
+bool TaskScheduler::OnWorkerThread() const
+{
+    return tls_scheduler == this;
+}
+
+void TaskScheduler::Run(size_t index, ThreadPolicy policy)
+{
+    ApplyThreadPolicy(policy, false);
+    tls_scheduler = this;
+    tls_worker = index;
+
+    Task task;
+    while(!quit) {
+        if(Take(index, task)) {
+            task();
+            task = nullptr;
+        }else{
+            std::unique_lock<std::mutex> l(sleep_mutex);
+            sleep_cv.wait(l, [&](){ return quit || queued > 0; });
+        }
+    }
+
+    tls_scheduler = nullptr;
+    tls_worker = not_a_worker;
+}
+
+TaskGroup::TaskGroup(TaskScheduler& scheduler)
+    : scheduler(scheduler), pending(0)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    WaitNoThrow();
+}
+
+void TaskGroup::Run(TaskScheduler::Task task)
+{
+    {
+        std::lock_guard<std::mutex> l(mutex);
+        ++pending;
+    }
+    scheduler.Spawn([this, task](){
+        Execute(task);
+        Finish();
+    });
+}
+
+void TaskGroup::Then(TaskScheduler::Task c)
+{
+    {
+        std::lock_guard<std::mutex> l(mutex);
+        if(pending > 0) {
+            if(continuation) {
+                TaskScheduler::Task prev = std::move(continuation);
+                continuation = [prev, c](){ prev(); c(); };
+            }else{
+                continuation = std::move(c);
+            }
+            return;
+        }
+        ++pending;
+    }
+    scheduler.Spawn([this, c](){
+        Execute(c);
+        Finish();
+    });
+}
+
+void TaskGroup::Execute(const TaskScheduler::Task& task)
+{
+    try {
+        task();
+    }catch(...) {
+        std::lock_guard<std::mutex> l(mutex);
+        if(!error) error = std::current_exception();
+    }
+}
+
+void TaskGroup::Finish()
+{
+    while(true) {
+        TaskScheduler::Task c;
+        {
+            std::lock_guard<std::mutex> l(mutex);
+            // The last task to finish runs the continuation in its place,
+            // so pending never reaches zero in between.
+            if(pending == 1 && continuation) {
+                c = std::move(continuation);
+                continuation = nullptr;
+            }else{
+                if(--pending == 0) finished_cv.notify_all();
+                return;
+            }
+        }
+        Execute(c);
+    }
+}
+
+void TaskGroup::WaitNoThrow()
+{
+    if(!scheduler.OnWorkerThread()) {
+        // Threads outside the pool (e.g. render or recording threads) may be
+        // latency sensitive, so leave unrelated tasks to the workers.
+        std::unique_lock<std::mutex> l(mutex);
+        finished_cv.wait(l, [&](){ return pending == 0; });
+        return;
+    }
+
+    while(true) {
+        {
+            std::lock_guard<std::mutex> l(mutex);
+            if(pending == 0) return;
+        }
+        if(scheduler.TryRunOne()) continue;
+
+        // Tasks of ours are running elsewhere. Poll in case new work arrives.
+        std::unique_lock<std::mutex> l(mutex);
+        finished_cv.wait_for(l, std::chrono::milliseconds(1), [&](){ return pending == 0; });
+    }
+}
+
+void TaskGroup::Wait()
+{
+    WaitNoThrow();
+    std::exception_ptr e;
+    {
+        std::lock_guard<std::mutex> l(mutex);
+        std::swap(e, error);
+    }
+    if(e) std::rethrow_exception(e);
+}
+
+void ParallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t,size_t)>& body, TaskScheduler& scheduler)
+{
+    if(end <= begin) return;
+    const size_t n = end - begin;
+    grain = std::max<size_t>(1, grain);
+
+    // A few chunks per thread balances uneven work without much overhead
+    const size_t max_chunks = 4 * (scheduler.NumWorkers() + 1);
+    const size_t num_chunks = std::min((n + grain - 1) / grain, max_chunks);
+    if(num_chunks <= 1) {
+        body(begin, end);
+        return;
+    }
+
+    const size_t chunk = std::max(grain, (n + num_chunks - 1) / num_chunks);
+    TaskGroup group(scheduler);
+    for(size_t b = begin + chunk; b < end; b += chunk) {
+        const size_t e = std::min(end, b + chunk);
+        group.Run([&body, b, e](){ body(b, e); });
+    }
+    body(begin, std::min(end, begin + chunk));
+    group.Wait();
+}
+
+}
@@ -0,0 +1,191 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove, Richard Newcombe
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <pangolin/utils/thread_policy.h>
+#include <pangolin/utils/log.h>
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(_LINUX_) || defined(_OSX_)
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+namespace pangolin
+{
+
+namespace
+{
+
+int ParseInt(const std::string& str, const std::string& what)
+{
+    size_t end = 0;
+    int val = 0;
+    try {
+        val = std::stoi(str, &end);
+    } catch (const std::exception&) {
+    }
+    if(str.empty() || end != str.size()) {
+        throw std::invalid_argument("ThreadPolicy: Bad " + what + " '" + str + "'");
+    }
+    return val;
+}
+
+std::vector<int> ParseCpus(const std::string& str)
+{
+    std::vector<int> cpus;
+    std::stringstream ss(str);
+    std::string item;
+    while(std::getline(ss, item, '+')) {
+        const size_t dash = item.find('-');
+        if(dash == std::string::npos) {
+            cpus.push_back(ParseInt(item, "cpu"));
+        }else{
+            const int first = ParseInt(item.substr(0, dash), "cpu");
+            const int last = ParseInt(item.substr(dash+1), "cpu");
+            if(last < first) {
+                throw std::invalid_argument("ThreadPolicy: Bad cpu range '" + item + "'");
+            }
+            for(int c=first; c <= last; ++c) cpus.push_back(c);
+        }
+    }
+    return cpus;
+}
+
+void ParsePriority(const std::string& str, ThreadPolicy& policy)
+{
+    const size_t colon = str.find(':');
+    const std::string kind = str.substr(0, colon);
+
+    if(kind == "fifo" || kind == "rr") {
+        policy.scheduler = (kind == "fifo") ? ThreadPolicy::Scheduler::Fifo : ThreadPolicy::Scheduler::RoundRobin;
+        policy.priority = (colon == std::string::npos) ? 1 : ParseInt(str.substr(colon+1), "priority");
+        if(policy.priority < 1 || policy.priority > 99) {
+            throw std::invalid_argument("ThreadPolicy: Real-time priority must be 1-99 in '" + str + "'");
+        }
+    }else if(colon != std::string::npos) {
+        throw std::invalid_argument("ThreadPolicy: Only fifo and rr take a priority in '" + str + "'");
+    }else if(kind == "batch") {
+        policy.scheduler = ThreadPolicy::Scheduler::Batch;
+    }else if(kind == "idle") {
+        policy.scheduler = ThreadPolicy::Scheduler::Idle;
+    }else if(kind == "default" || kind.empty()) {
+        policy.scheduler = ThreadPolicy::Scheduler::Default;
+    }else{
+        throw std::invalid_argument("ThreadPolicy: Unknown priority '" + str + "'");
+    }
+}
+
+}
+
+ThreadPolicy ThreadPolicy::FromParams(const Params& params, const std::string& prefix)
+{
+    ThreadPolicy policy;
+    policy.name = params.Get<std::string>(prefix + "name", "");
+    policy.cpus = ParseCpus(params.Get<std::string>(prefix + "cpu", ""));
+    ParsePriority(params.Get<std::string>(prefix + "priority", ""), policy);
+    return policy;
+}
+
+std::string ThreadPolicyResult::ToString() const
+{
+    std::string applied;
+    if(name) applied += " name";
+    if(affinity) applied += " affinity";
+    if(scheduler) applied += " scheduler";
+    std::string str = applied.empty() ? "nothing applied" : "applied" + applied;
+    if(!error.empty()) str += "; " + error;
+    return str;
+}
+
+ThreadPolicyResult ApplyThreadPolicy(const ThreadPolicy& policy, bool report)
+{
+    ThreadPolicyResult result;
+    if(policy.IsDefault()) return result;
+
+    auto fail = [&](const std::string& what, int err) {
+        if(!result.error.empty()) result.error += ", ";
+        result.error += what + " failed (" + std::strerror(err) + ")";
+    };
+
+#if defined(_LINUX_)
+    if(!policy.name.empty()) {
+        const int err = pthread_setname_np(pthread_self(), policy.name.substr(0,15).c_str());
+        if(err) fail("name", err); else result.name = true;
+    }
+
+    if(!policy.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for(int c : policy.cpus) {
+            if(0 <= c && c < CPU_SETSIZE) CPU_SET(c, &set);
+        }
+        const int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if(err) fail("affinity", err); else result.affinity = true;
+    }
+
+    if(policy.scheduler != ThreadPolicy::Scheduler::Default) {
+        int sched = SCHED_OTHER;
+        sched_param param = {};
+        switch(policy.scheduler) {
+        case ThreadPolicy::Scheduler::Fifo:       sched = SCHED_FIFO;  param.sched_priority = policy.priority; break;
+        case ThreadPolicy::Scheduler::RoundRobin: sched = SCHED_RR;    param.sched_priority = policy.priority; break;
+        case ThreadPolicy::Scheduler::Batch:      sched = SCHED_BATCH; break;
+        case ThreadPolicy::Scheduler::Idle:       sched = SCHED_IDLE;  break;
+        default: break;
+        }
+        const int err = pthread_setschedparam(pthread_self(), sched, &param);
+        if(err) fail("scheduler", err); else result.scheduler = true;
+    }
+#elif defined(_OSX_)
+    if(!policy.name.empty()) {
+        const int err = pthread_setname_np(policy.name.c_str());
+        if(err) fail("name", err); else result.name = true;
+    }
+    if(!policy.cpus.empty()) {
+        if(!result.error.empty()) result.error += ", ";
+        result.error += "affinity unsupported";
+    }
+    if(policy.scheduler == ThreadPolicy::Scheduler::Fifo || policy.scheduler == ThreadPolicy::Scheduler::RoundRobin) {
+        sched_param param = {};
+        param.sched_priority = policy.priority;
+        const int err = pthread_setschedparam(pthread_self(), policy.scheduler == ThreadPolicy::Scheduler::Fifo ? SCHED_FIFO : SCHED_RR, &param);
+        if(err) fail("scheduler", err); else result.scheduler = true;
+    }
+#else
+    result.error = "thread policies unsupported on this platform";
+#endif
+
+    if(report) {
+        pango_print_info("Thread '%s': %s\n", policy.name.c_str(), result.ToString().c_str());
+    }
+    return result;
+}
+
+}
@@ -79,15 +79,16 @@ threadedfilebuf::threadedfilebuf()
 {
 }
 
-threadedfilebuf::threadedfilebuf(const std::string& filename, size_t buffer_size_bytes )
+threadedfilebuf::threadedfilebuf(const std::string& filename, size_t buffer_size_bytes, const ThreadPolicy& policy )
     : mem_buffer(0), mem_size(0), mem_max_size(0), mem_start(0), mem_end(0), should_run(false), is_pipe(pangolin::IsPipe(filename))
 {
-    open(filename, buffer_size_bytes);
+    open(filename, buffer_size_bytes, policy);
 }
 
-void threadedfilebuf::open(const std::string& filename, size_t buffer_size_bytes)
+void threadedfilebuf::open(const std::string& filename, size_t buffer_size_bytes, const ThreadPolicy& policy)
 {
     is_pipe = pangolin::IsPipe(filename);
+    thread_policy = policy;
 
 #ifdef USE_POSIX_FILE_IO
     if (filenum != -1) {
@@ -264,6 +265,8 @@ std::streampos threadedfilebuf::seekoff(
 
 void threadedfilebuf::operator()()
 {
+    ApplyThreadPolicy(thread_policy);
+
     std::streamsize data_to_write = 0;
 
     while(true)
@@ -0,0 +1,94 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pangolin/utils/async_log.h>
+
+using namespace pangolin;
+
+TEST_CASE("AsyncLog writes messages in order from one thread")
+{
+    std::vector<std::string> lines;
+    AsyncLog log(16);
+    log.SetSink([&](LogLevel, const char* msg){ lines.push_back(msg); });
+
+    for(int i=0; i < 10; ++i) {
+        REQUIRE(log.Log(LogLevel::Info, "message %d\n", i));
+    }
+    log.Flush();
+
+    REQUIRE(lines.size() == 10);
+    for(int i=0; i < 10; ++i) {
+        REQUIRE(lines[i] == "message " + std::to_string(i) + "\n");
+    }
+    REQUIRE(log.GetStats().written == 10);
+    REQUIRE(log.GetStats().dropped == 0);
+}
+
+TEST_CASE("AsyncLog accepts messages from many threads")
+{
+    std::atomic<int> count(0);
+    AsyncLog log(64);
+    log.SetSink([&](LogLevel, const char*){ ++count; });
+
+    std::vector<std::thread> threads;
+    for(int t=0; t < 4; ++t) {
+        threads.emplace_back([&](){
+            for(int i=0; i < 1000; ++i) log.Log(LogLevel::Warn, "%d", i);
+        });
+    }
+    for(auto& t : threads) t.join();
+    log.Flush();
+
+    const AsyncLog::Stats stats = log.GetStats();
+    REQUIRE(stats.written + stats.dropped == 4000);
+    REQUIRE((int)stats.written == count);
+}
+
+TEST_CASE("AsyncLog drops rather than blocks when full")
+{
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    AsyncLog log(8);
+    log.SetSink([&](LogLevel, const char*){ released.wait(); });
+
+    // The logging thread may hold at most one message while blocked in the sink.
+    for(int i=0; i < 20; ++i) log.Log(LogLevel::Info, "%d", i);
+    const AsyncLog::Stats stats = log.GetStats();
+    REQUIRE(stats.dropped >= 11);
+    REQUIRE(stats.dropped <= 12);
+
+    release.set_value();
+    log.Flush();
+    REQUIRE(log.GetStats().written == 20 - log.GetStats().dropped);
+}
+
+TEST_CASE("AsyncLog notes suppressed messages")
+{
+    std::string line;
+    AsyncLog log(8);
+    log.SetSink([&](LogLevel, const char* msg){ line = msg; });
+    log.LogSuppressed(LogLevel::Warn, 3, "late by %dms\n", 5);
+    log.Flush();
+    REQUIRE(line == "late by 5ms [3 similar suppressed]\n");
+}
+
+TEST_CASE("LogRateLimiter lets one message through per interval")
+{
+    LogRateLimiter limiter(20);
+    uint32_t suppressed = 0;
+
+    REQUIRE(limiter.Allow(suppressed));
+    REQUIRE(suppressed == 0);
+    for(int i=0; i < 5; ++i) {
+        REQUIRE(!limiter.Allow(suppressed));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    REQUIRE(limiter.Allow(suppressed));
+    REQUIRE(suppressed == 5);
+}
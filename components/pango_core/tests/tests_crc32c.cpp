@@ -0,0 +1,54 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <pangolin/utils/crc32c.h>
+
+using namespace pangolin;
+
+namespace {
+
+uint32_t BitwiseCrc32c(const uint8_t* p, size_t n)
+{
+    uint32_t c = ~0u;
+    while(n--) {
+        c ^= *p++;
+        for(int k=0; k < 8; ++k) c = (c >> 1) ^ (0x82F63B78u & (0u - (c & 1u)));
+    }
+    return ~c;
+}
+
+}
+
+TEST_CASE("Crc32c matches reference values")
+{
+    const std::string check = "123456789";
+    REQUIRE(Crc32c(check.data(), check.size()) == 0xE3069283u);
+
+    // RFC 3720 test patterns
+    std::vector<uint8_t> bytes(32, 0x00);
+    REQUIRE(Crc32c(bytes.data(), bytes.size()) == 0x8A9136AAu);
+    std::fill(bytes.begin(), bytes.end(), 0xff);
+    REQUIRE(Crc32c(bytes.data(), bytes.size()) == 0x62A8AB43u);
+
+    REQUIRE(Crc32c(nullptr, 0) == 0u);
+}
+
+TEST_CASE("Crc32c agrees with a bitwise implementation at any alignment and split")
+{
+    std::vector<uint8_t> data(4099);
+    for(size_t i=0; i < data.size(); ++i) data[i] = uint8_t(i * 131 + (i >> 7));
+
+    for(size_t offset : {0, 1, 3, 7}) {
+        for(size_t len : {0, 1, 5, 8, 63, 4000}) {
+            const uint8_t* p = data.data() + offset;
+            const uint32_t expected = BitwiseCrc32c(p, len);
+            REQUIRE(Crc32c(p, len) == expected);
+
+            const size_t split = len / 3;
+            REQUIRE(Crc32c(p + split, len - split, Crc32c(p, split)) == expected);
+        }
+    }
+}
@@ -0,0 +1,127 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <pangolin/utils/json_reader.h>
+
+using namespace pangolin;
+
+TEST_CASE("JsonReader reads objects with typed values")
+{
+    const std::string json = R"({ "time_us": 1234567890123, "name": "cam\"0\"", "gain": 2.5,
+                                  "on": true, "none": null, "ids": [1, 2, 3] })";
+    JsonReader r(json);
+
+    int64_t time_us = 0;
+    std::string name;
+    double gain = 0.0;
+    bool on = false;
+    std::vector<int64_t> ids;
+
+    std::string key;
+    r.BeginObject();
+    while(r.NextKey(key)) {
+        if(key == "time_us") time_us = r.ReadInt();
+        else if(key == "name") name = r.ReadString();
+        else if(key == "gain") gain = r.ReadDouble();
+        else if(key == "on") on = r.ReadBool();
+        else if(key == "ids") r.ReadArray(ids);
+        else r.Skip();
+    }
+    REQUIRE(r.AtEnd());
+
+    REQUIRE(time_us == 1234567890123);
+    REQUIRE(name == "cam\"0\"");
+    REQUIRE(gain == 2.5);
+    REQUIRE(on);
+    REQUIRE(ids == std::vector<int64_t>({1,2,3}));
+}
+
+TEST_CASE("JsonReader skips nested values containing brackets in strings")
+{
+    const std::string json = R"([{"a": [1, {"b": "]}[{"}], "c": "\\\"}"}, 42, "long string padding past sixteen bytes"])";
+    JsonReader r(json);
+    r.BeginArray();
+    REQUIRE(r.NextElement());
+    const std::string_view raw = r.RawValue();
+    REQUIRE(raw.front() == '{');
+    REQUIRE(raw.back() == '}');
+    REQUIRE(r.NextElement());
+    REQUIRE(r.ReadInt() == 42);
+    REQUIRE(r.NextElement());
+    r.Skip();
+    REQUIRE(!r.NextElement());
+    REQUIRE(r.AtEnd());
+}
+
+TEST_CASE("JsonReader builds the same tree as picojson")
+{
+    const std::string json = R"({"streams":[{"w":640,"h":480,"fmt":"GRAY8","scale":0.5,"u":"é😀"}],"flag":false,"n":null,"big":1e300})";
+    JsonReader r(json);
+    const picojson::value fast = r.ReadValue();
+
+    picojson::value slow;
+    REQUIRE(picojson::parse(slow, json).empty());
+    REQUIRE(fast.serialize() == slow.serialize());
+    REQUIRE(fast["streams"][0]["w"].is<int64_t>());
+}
+
+TEST_CASE("JsonReader reports malformed input")
+{
+    const std::string bad_string = R"({"a": "oops)";
+    JsonReader unterminated(bad_string);
+    unterminated.BeginObject();
+    std::string key;
+    REQUIRE(unterminated.NextKey(key));
+    REQUIRE_THROWS_AS(unterminated.ReadString(), JsonReaderException);
+
+    const std::string bad_array = "[1 2]";
+    JsonReader missing_comma(bad_array);
+    missing_comma.BeginArray();
+    REQUIRE(missing_comma.NextElement());
+    missing_comma.ReadInt();
+    REQUIRE_THROWS_AS(missing_comma.NextElement(), JsonReaderException);
+}
+
+TEST_CASE("JsonReader rejects numbers its types can't hold")
+{
+    const auto read = [](const std::string& json, auto f) {
+        JsonReader r(json);
+        r.BeginArray();
+        REQUIRE(r.NextElement());
+        return f(r);
+    };
+    const auto read_int = [](JsonReader& r){ return r.ReadInt(); };
+    const auto read_uint = [](JsonReader& r){ return r.ReadUInt(); };
+    const auto read_double = [](JsonReader& r){ return r.ReadDouble(); };
+
+    REQUIRE(read("[2.75]", read_int) == 2);
+    REQUIRE(read("[-2.75]", read_int) == -2);
+    REQUIRE(read("[1e3]", read_uint) == 1000u);
+    REQUIRE(read("[-1.5e-2]", read_double) == -0.015);
+
+    REQUIRE_THROWS_AS(read("[-5]", read_uint), JsonReaderException);
+    REQUIRE_THROWS_AS(read("[1e30]", read_int), JsonReaderException);
+    REQUIRE_THROWS_AS(read("[1e30]", read_uint), JsonReaderException);
+    REQUIRE_THROWS_AS(read("[NaN]", read_int), JsonReaderException);
+    REQUIRE_THROWS_AS(read("[NaN]", read_double), JsonReaderException);
+    REQUIRE_THROWS_AS(read("[inf]", read_double), JsonReaderException);
+    REQUIRE_THROWS_AS(read("[+1]", read_double), JsonReaderException);
+    REQUIRE_THROWS_AS(read("[1.5x]", read_double), JsonReaderException);
+    REQUIRE_THROWS_AS(read("[1e999]", read_double), JsonReaderException);
+}
+
+TEST_CASE("ReadJsonText stops after one value")
+{
+    std::istringstream is(std::string("  {\"a\":\"}\",\"b\":[1,2]}\nBINARY"));
+    std::string text;
+    REQUIRE(ReadJsonText(is, text));
+    REQUIRE(text == "{\"a\":\"}\",\"b\":[1,2]}");
+    REQUIRE(is.get() == '\n');
+
+    std::string rest;
+    is >> rest;
+    REQUIRE(rest == "BINARY");
+}
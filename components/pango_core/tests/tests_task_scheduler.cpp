@@ -0,0 +1,150 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <pangolin/utils/task_scheduler.h>
+
+using namespace pangolin;
+
+TEST_CASE("ParallelFor covers the range exactly once")
+{
+    for(size_t workers : {0, 1, 4}) {
+        TaskScheduler scheduler(workers);
+        std::vector<std::atomic<int>> hits(1003);
+        for(auto& h : hits) h = 0;
+
+        ParallelFor(0, hits.size(), 7, [&](size_t b, size_t e){
+            for(size_t i=b; i < e; ++i) ++hits[i];
+        }, scheduler);
+
+        for(auto& h : hits) REQUIRE(h == 1);
+    }
+}
+
+TEST_CASE("ParallelForRows respects the minimum band size")
+{
+    TaskScheduler scheduler(3);
+    std::atomic<size_t> smallest(1000);
+    std::atomic<size_t> rows(0);
+    ParallelForRows(480, 64, [&](size_t y0, size_t y1){
+        if(y1 < 480) {
+            size_t s = smallest;
+            while(y1 - y0 < s && !smallest.compare_exchange_weak(s, y1 - y0)) {}
+        }
+        rows += y1 - y0;
+    }, scheduler);
+    REQUIRE(rows == 480);
+    REQUIRE(smallest >= 64);
+}
+
+TEST_CASE("TaskGroup runs nested groups without deadlock")
+{
+    TaskScheduler scheduler(2);
+    std::atomic<int> leaves(0);
+    TaskGroup outer(scheduler);
+    for(int i=0; i < 8; ++i) {
+        outer.Run([&](){
+            TaskGroup inner(scheduler);
+            for(int j=0; j < 8; ++j) inner.Run([&](){ ++leaves; });
+            inner.Wait();
+        });
+    }
+    outer.Wait();
+    REQUIRE(leaves == 64);
+}
+
+TEST_CASE("TaskGroup continuation runs after all tasks")
+{
+    TaskScheduler scheduler(4);
+    std::atomic<int> done(0);
+    int seen_by_continuation = -1;
+
+    TaskGroup group(scheduler);
+    for(int i=0; i < 100; ++i) group.Run([&](){ ++done; });
+    group.Then([&](){ seen_by_continuation = done; });
+    group.Wait();
+    REQUIRE(seen_by_continuation == 100);
+
+    // With nothing outstanding the continuation runs straight away
+    bool ran = false;
+    group.Then([&](){ ran = true; });
+    group.Wait();
+    REQUIRE(ran);
+}
+
+TEST_CASE("TaskGroup rethrows the first exception from Wait")
+{
+    TaskScheduler scheduler(2);
+    TaskGroup group(scheduler);
+    std::atomic<int> ran(0);
+    for(int i=0; i < 10; ++i) {
+        group.Run([&, i](){
+            ++ran;
+            if(i == 3) throw std::runtime_error("task failed");
+        });
+    }
+    REQUIRE_THROWS_AS(group.Wait(), std::runtime_error);
+    REQUIRE(ran == 10);
+
+    // The error is reported once
+    group.Wait();
+}
+
+TEST_CASE("TaskScheduler keeps queued tasks when reconfigured")
+{
+    TaskScheduler scheduler(2);
+    std::atomic<int> count(0);
+    TaskGroup group(scheduler);
+    for(int i=0; i < 50; ++i) group.Run([&](){ ++count; });
+    scheduler.Configure(3);
+    REQUIRE(scheduler.NumWorkers() == 3);
+    group.Wait();
+    REQUIRE(count == 50);
+}
+
+TEST_CASE("TaskScheduler can be reconfigured whilst other threads use it")
+{
+    TaskScheduler scheduler(2);
+    std::atomic<bool> stop(false);
+    std::atomic<int> count(0);
+    std::atomic<bool> lost(false);
+    int expected = 0;
+
+    std::thread user([&](){
+        while(!stop) {
+            TaskGroup group(scheduler);
+            for(int i=0; i < 10; ++i) group.Run([&](){ ++count; });
+            group.Wait();
+            expected += 10;
+            if(count != expected) lost = true;
+        }
+    });
+    for(size_t n : {3, 0, 1, 4, 0, 2}) {
+        scheduler.Configure(n);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    stop = true;
+    user.join();
+    REQUIRE(!lost);
+    REQUIRE(count == expected);
+}
+
+TEST_CASE("TaskGroup leaves tasks to the workers when waiting on another thread")
+{
+    TaskScheduler scheduler(2);
+    const std::thread::id waiter = std::this_thread::get_id();
+    std::atomic<int> ran_on_waiter(0);
+
+    TaskGroup group(scheduler);
+    for(int i=0; i < 200; ++i) {
+        group.Run([&](){
+            if(std::this_thread::get_id() == waiter) ++ran_on_waiter;
+        });
+    }
+    group.Wait();
+    REQUIRE(ran_on_waiter == 0);
+}
@@ -0,0 +1,66 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <stdexcept>
+#include <thread>
+#include <pangolin/utils/thread_policy.h>
+
+using namespace pangolin;
+
+TEST_CASE("ThreadPolicy defaults when no params are given")
+{
+    const ThreadPolicy policy = ThreadPolicy::FromParams(Params());
+    REQUIRE(policy.IsDefault());
+    REQUIRE(policy.cpus.empty());
+    REQUIRE(policy.scheduler == ThreadPolicy::Scheduler::Default);
+}
+
+TEST_CASE("ThreadPolicy parses prefixed params")
+{
+    Params params;
+    params.Set("writer_name", "disk");
+    params.Set("writer_cpu", "0+4-6");
+    params.Set("writer_priority", "fifo:20");
+    params.Set("cpu", "9");
+
+    const ThreadPolicy policy = ThreadPolicy::FromParams(params, "writer_");
+    REQUIRE(policy.name == "disk");
+    REQUIRE(policy.cpus == std::vector<int>({0,4,5,6}));
+    REQUIRE(policy.scheduler == ThreadPolicy::Scheduler::Fifo);
+    REQUIRE(policy.priority == 20);
+    REQUIRE(!policy.IsDefault());
+}
+
+TEST_CASE("ThreadPolicy rejects malformed params")
+{
+    Params bad_cpu;
+    bad_cpu.Set("cpu", "3-1");
+    REQUIRE_THROWS_AS(ThreadPolicy::FromParams(bad_cpu), std::invalid_argument);
+
+    Params bad_priority;
+    bad_priority.Set("priority", "urgent");
+    REQUIRE_THROWS_AS(ThreadPolicy::FromParams(bad_priority), std::invalid_argument);
+}
+
+TEST_CASE("ThreadPolicy default policy applies nothing")
+{
+    const ThreadPolicyResult result = ApplyThreadPolicy(ThreadPolicy(), false);
+    REQUIRE(!result.name);
+    REQUIRE(!result.affinity);
+    REQUIRE(!result.scheduler);
+    REQUIRE(result.error.empty());
+}
+
+#ifdef __linux__
+TEST_CASE("ThreadPolicy names the calling thread")
+{
+    ThreadPolicyResult result;
+    std::thread([&](){
+        ThreadPolicy policy;
+        policy.name = "pango_test";
+        result = ApplyThreadPolicy(policy, false);
+    }).join();
+    REQUIRE(result.name);
+    REQUIRE(result.error.empty());
+}
+#endif
@@ -142,6 +142,10 @@ namespace pangolin
   /// Toggle display of Pangolin console
   PANGOLIN_EXPORT
   void ShowConsole(TrueFalseToggle on_off);
+
+  /// Toggle GlProfiler and its overlay of per section CPU / GPU times
+  PANGOLIN_EXPORT
+  void ShowProfiler(TrueFalseToggle on_off);
 }
 
 #include <pangolin/display/display.hpp>
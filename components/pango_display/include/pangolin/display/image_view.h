@@ -3,6 +3,7 @@
 #include <pangolin/display/display.h>
 #include <pangolin/gl/glpixformat.h>
 #include <pangolin/gl/glformattraits.h>
+#include <pangolin/gl/glpixdecode.h>
 #include <pangolin/gl/glsl.h>
 #include <pangolin/handler/handler_image.h>
 #include <pangolin/image/image_utils.h>
@@ -37,12 +38,26 @@ class PANGOLIN_EXPORT ImageView : public pangolin::View, public pangolin::ImageV
         return SetImage(img.template UnsafeReinterpret<unsigned char>(), GlPixFormat::FromType<T>(), delayed_upload);
     }
 
+    /// Formats with no OpenGL equivalent (YUYV422, UYVY422, packed GRAY10 /
+    /// GRAY12) and Bayer images (see SetBayer) are decoded on the GPU.
+    ImageView& SetImage(const pangolin::Image<unsigned char>& img, const pangolin::PixelFormat& fmt, bool delayed_upload = false);
+
     ImageView& SetImage(const pangolin::TypedImage& img, bool delayed_upload = false);
 
     ImageView& SetImage(const pangolin::GlTexture& texture);
 
+    /// Treat subsequent grayscale images as raw Bayer mosaics with top-left
+    /// 2x2 tile \param tile (e.g. "RGGB"), debayered with white balance gains
+    /// \param wb_gains when drawn. Empty tile to disable.
+    ImageView& SetBayer(const std::string& tile, const std::array<float,3>& wb_gains = {{1.0f, 1.0f, 1.0f}});
+
+    /// Gamma applied when drawing images decoded on the GPU.
+    ImageView& SetGamma(float gamma);
+
     void LoadPending();
 
+    void UploadDecoded(const void* ptr, size_t w, size_t h, size_t pitch, const PixelFormat& raw_fmt);
+
     ImageView& Clear();
 
     std::pair<float, float>& GetOffsetScale();
@@ -60,6 +75,13 @@ class PANGOLIN_EXPORT ImageView : public pangolin::View, public pangolin::ImageV
     pangolin::ManagedImage<unsigned char> img_to_load;
     pangolin::GlPixFormat img_fmt_to_load;
 
+    // Formats GlPixFormat can't describe (YUYV, packed, Bayer) are uploaded
+    // raw and decoded by a shader as they are drawn instead of using tex.
+    pangolin::PixelFormat raw_fmt_to_load;
+    bool decode_to_load;
+    pangolin::GlPixDecoder decoder;
+    bool use_decoder;
+
     std::pair<float, float> offset_scale;
     pangolin::GlPixFormat fmt;
     pangolin::GlTexture tex;
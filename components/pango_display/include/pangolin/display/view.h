@@ -160,6 +160,10 @@ struct PANGOLIN_EXPORT View
     //! Return whether this view should be shown.
     //! This method should be checked if drawing manually
     bool IsShown() const;
+
+    //! Return whether this view is scrolled into its parent's layout.
+    //! Views are drawn only if both this and IsShown() are true.
+    bool IsScrolledIntoView() const { return scroll_show; }
     
     //! Returns viewport reflecting space that will actually get drawn
     //! The minimum of vp and v
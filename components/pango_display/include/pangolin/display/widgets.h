@@ -40,6 +40,65 @@ namespace pangolin
 PANGOLIN_EXPORT
 View& CreatePanel(const std::string& name);
 
+// Vertices for the appearance of a widget, in window pixel coordinates.
+struct PANGOLIN_EXPORT WidgetGeometry
+{
+    struct ColourVertex
+    {
+        GLfloat x, y;
+        GLfloat rgba[4];
+    };
+
+    void Clear();
+    void Append(const WidgetGeometry& o);
+
+    void Rect(const Viewport& v, const GLfloat colour[4]);
+    void Line(GLfloat x0, GLfloat y0, GLfloat x1, GLfloat y1, const GLfloat colour[4]);
+    void RectPerimeter(const Viewport& v, const GLfloat colour[4]);
+    void ShadowRect(const Viewport& v, bool pushed);
+    void Text(const GlText& text, GLfloat x, GLfloat y);
+
+    // Draw from client memory, for widgets outside of a Panel
+    void Draw() const;
+
+    std::vector<ColourVertex> triangles;
+    std::vector<ColourVertex> lines;
+    std::vector<XYUV> text;
+    const GlTexture* font_tex = nullptr;
+};
+
+// Widgets keep their geometry between frames and only rebuild it when their
+// value, interaction state or viewport changes.
+struct PANGOLIN_EXPORT PanelWidget
+{
+    virtual ~PanelWidget() {}
+
+    // Rebuild geometry if out of date. Returns true if it was rebuilt.
+    bool UpdateGeometry(const Viewport& v);
+
+    WidgetGeometry geometry;
+
+protected:
+    // Compare against (and remember) everything besides the viewport which
+    // the geometry depends on. Returns true if any of it changed.
+    virtual bool StateChanged() = 0;
+    virtual void BuildGeometry(WidgetGeometry& g) = 0;
+
+    // Convenience for StateChanged(): update cached and report a difference
+    template<typename T>
+    static bool Changed(T& cached, const T& now)
+    {
+        if(cached == now) return false;
+        cached = now;
+        return true;
+    }
+
+    Viewport built_viewport;
+    bool built = false;
+};
+
+// Vertical list of widgets, drawn together from one vertex buffer which is
+// only rebuilt when a widget's geometry or the layout changes.
 struct PANGOLIN_EXPORT Panel : public View
 {
     Panel();
@@ -51,19 +110,33 @@ private:
     void NewVarCallback(const VarState::Event& e);
     void AddVariable(const std::string& name, const std::shared_ptr<VarValueGeneric> &var);
     void RemoveVariable(const std::string& name);
+    void UploadBatch();
 
     sigslot::scoped_connection var_added_connection;
     std::string auto_register_var_prefix;
+
+    Viewport built_viewport;
+    std::vector<PanelWidget*> drawn_widgets;
+    WidgetGeometry batch;
+    GlBufferData batch_buffer;
+    size_t batch_line_offset = 0;
+    size_t batch_text_offset_bytes = 0;
 };
 
 template<typename T>
-struct Widget : public View, Handler, Var<T>
+struct Widget : public View, Handler, Var<T>, PanelWidget
 {
     Widget(std::string title, const std::shared_ptr<VarValueGeneric>& tv)
         : Var<T>(tv), title(title)
     {
         handler = this;
     }
+
+    void Render() override
+    {
+        UpdateGeometry(v);
+        geometry.Draw();
+    }
     
     std::string title;
 };
@@ -72,39 +145,45 @@ struct PANGOLIN_EXPORT Button : public Widget<bool>
 {
     Button(std::string title, const std::shared_ptr<VarValueGeneric> &tv);
     void Mouse(View&, MouseButton button, int x, int y, bool pressed, int mouse_state);
-    void Render();
+    bool StateChanged() override;
+    void BuildGeometry(WidgetGeometry& g) override;
     
     //Cache params on resize
     void ResizeChildren();
     GlText gltext;
     GLfloat raster[2];
     bool down;
+    bool built_down = false;
 };
 
 struct PANGOLIN_EXPORT FunctionButton : public Widget<std::function<void(void)> >
 {
     FunctionButton(std::string title, const std::shared_ptr<VarValueGeneric> &tv);
     void Mouse(View&, MouseButton button, int x, int y, bool pressed, int mouse_state);
-    void Render();
+    bool StateChanged() override;
+    void BuildGeometry(WidgetGeometry& g) override;
 
     //Cache params on resize
     void ResizeChildren();
     GlText gltext;
     GLfloat raster[2];
     bool down;
+    bool built_down = false;
 };
 
 struct PANGOLIN_EXPORT Checkbox : public Widget<bool>
 {
     Checkbox(std::string title, const std::shared_ptr<VarValueGeneric>& tv);
     void Mouse(View&, MouseButton button, int x, int y, bool pressed, int mouse_state);
-    void Render();
+    bool StateChanged() override;
+    void BuildGeometry(WidgetGeometry& g) override;
     
     //Cache params on resize
     void ResizeChildren();
     GlText gltext;
     GLfloat raster[2];
     Viewport vcb;
+    bool built_val = false;
 };
 
 struct PANGOLIN_EXPORT Slider : public Widget<double>
@@ -113,7 +192,8 @@ struct PANGOLIN_EXPORT Slider : public Widget<double>
     void Mouse(View&, MouseButton button, int x, int y, bool pressed, int mouse_state);
     void MouseMotion(View&, int x, int y, int mouse_state);
     void Keyboard(View&, unsigned char key, int x, int y, bool pressed);
-    void Render();
+    bool StateChanged() override;
+    void BuildGeometry(WidgetGeometry& g) override;
     
     //Cache params on resize
     void ResizeChildren();
@@ -122,6 +202,10 @@ struct PANGOLIN_EXPORT Slider : public Widget<double>
     bool lock_bounds;
     bool logscale;
     bool is_integral_type;
+
+    size_t built_generation = 0;
+    double built_val = 0.0;
+    double built_range[2] = {0.0, 0.0};
 };
 
 struct PANGOLIN_EXPORT TextInput : public Widget<std::string>
@@ -130,7 +214,8 @@ struct PANGOLIN_EXPORT TextInput : public Widget<std::string>
     void Mouse(View&, MouseButton button, int x, int y, bool pressed, int mouse_state);
     void MouseMotion(View&, int x, int y, int mouse_state);
     void Keyboard(View&, unsigned char key, int x, int y, bool pressed);
-    void Render();
+    bool StateChanged() override;
+    void BuildGeometry(WidgetGeometry& g) override;
     
     std::string edit;
     GlText gledit;
@@ -146,6 +231,11 @@ struct PANGOLIN_EXPORT TextInput : public Widget<std::string>
     GLfloat horizontal_margin = 2.f;
     int input_width;
     int edit_visible_part[2] = {0,1};
+
+    std::string built_edit;
+    bool built_do_edit = false;
+    int built_sel[2] = {-1,-1};
+    int built_visible_start = 0;
 };
 
 
@@ -42,6 +42,8 @@
 #include <pangolin/display/display.h>
 #include <pangolin/display/process.h>
 #include <pangolin/console/ConsoleView.h>
+#include <pangolin/display/profiler_view.h>
+#include <pangolin/gl/glprofiler.h>
 #include <pangolin/utils/simple_math.h>
 #include <pangolin/utils/timer.h>
 #include <pangolin/utils/type_convert.h>
@@ -298,6 +300,20 @@ void ShowConsole(TrueFalseToggle on_off)
 
 }
 
+void ShowProfiler(TrueFalseToggle on_off)
+{
+    if( !context->profiler_view) {
+        context->profiler_view = std::make_unique<ProfilerView>();
+        context->profiler_view->zorder = std::numeric_limits<int>::max() - 1;
+        context->profiler_view->Show(false);
+        DisplayBase().AddDisplay(*context->profiler_view);
+    }
+
+    const bool show = to_bool(on_off, context->profiler_view->IsShown());
+    context->profiler_view->Show(show);
+    GlProfiler::I().SetEnabled(show);
+}
+
 View& Display(const std::string& name)
 {
     // Get / Create View
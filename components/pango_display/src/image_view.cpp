@@ -7,7 +7,7 @@ namespace pangolin
 {
 
 ImageView::ImageView(const std::string & title)
-    : pangolin::ImageViewHandler(title), offset_scale(0.0f, 1.0f), lastPressed(false), mouseReleased(false), mousePressed(false), overlayRender(true)
+    : pangolin::ImageViewHandler(title), decode_to_load(false), use_decoder(false), offset_scale(0.0f, 1.0f), lastPressed(false), mouseReleased(false), mousePressed(false), overlayRender(true)
 {
     SetHandler(this);
 }
@@ -29,7 +29,15 @@ void ImageView::Render()
     this->UpdateView();
     this->glSetViewOrtho();
 
-    if(tex.IsValid())
+    if(use_decoder && decoder.IsValid())
+    {
+        decoder.offset = offset_scale.first;
+        decoder.scale = offset_scale.second;
+        decoder.Bind();
+        this->glRenderTexture(decoder.raw.tid, decoder.width, decoder.height);
+        decoder.Unbind();
+    }
+    else if(tex.IsValid())
     {
         if(offset_scale.first != 0.0 || offset_scale.second != 1.0)
         {
@@ -126,6 +134,7 @@ ImageView& ImageView::SetImage(void* ptr, size_t w, size_t h, size_t pitch, pang
     if(delayed_upload || !pangolin::GetBoundWindow() || IsDevicePtr(ptr) || convert_first )
     {
         texlock.lock();
+        decode_to_load = false;
         if(!convert_first) {
             img_to_load = ManagedImage<unsigned char>(w,h,w*pix_bytes);
             PitchedCopy((char*)img_to_load.ptr, img_to_load.pitch, (char*)ptr, pitch, w * pix_bytes, h);
@@ -141,6 +150,8 @@ ImageView& ImageView::SetImage(void* ptr, size_t w, size_t h, size_t pitch, pang
         return *this;
     }
 
+    use_decoder = false;
+
     PANGO_ASSERT(pitch % pix_bytes == 0);
     const size_t stride = pitch / pix_bytes;
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
@@ -169,9 +180,33 @@ ImageView& ImageView::SetImage(const pangolin::Image<unsigned char>& img, const
     return SetImage(img.ptr, img.w, img.h, img.pitch, glfmt, delayed_upload);
 }
 
+ImageView& ImageView::SetImage(const pangolin::Image<unsigned char>& img, const pangolin::PixelFormat& fmt, bool delayed_upload )
+{
+#ifndef HAVE_GLES
+    if(GlPixDecoder::Required(fmt, decoder.bayer))
+    {
+        if(delayed_upload || !pangolin::GetBoundWindow() || IsDevicePtr(img.ptr))
+        {
+            const size_t row_bytes = (img.w * fmt.bpp + 7) / 8;
+            texlock.lock();
+            img_to_load = ManagedImage<unsigned char>(img.w, img.h, row_bytes);
+            PitchedCopy((char*)img_to_load.ptr, img_to_load.pitch, (char*)img.ptr, img.pitch, row_bytes, img.h);
+            raw_fmt_to_load = fmt;
+            decode_to_load = true;
+            texlock.unlock();
+            return *this;
+        }
+
+        UploadDecoded(img.ptr, img.w, img.h, img.pitch, fmt);
+        return *this;
+    }
+#endif
+    return SetImage(img.ptr, img.w, img.h, img.pitch, pangolin::GlPixFormat(fmt), delayed_upload);
+}
+
 ImageView& ImageView::SetImage(const pangolin::TypedImage& img, bool delayed_upload )
 {
-    return SetImage(img.ptr, img.w, img.h, img.pitch, pangolin::GlPixFormat(img.fmt), delayed_upload);
+    return SetImage(img, img.fmt, delayed_upload);
 }
 
 ImageView& ImageView::SetImage(const pangolin::GlTexture& texture)
@@ -188,24 +223,56 @@ ImageView& ImageView::SetImage(const pangolin::GlTexture& texture)
     glCopyImageSubData(
             texture.tid, GL_TEXTURE_2D, 0, 0, 0, 0, tex.tid, GL_TEXTURE_2D, 0, 0, 0, 0, tex.width, tex.height, 1);
 
+    use_decoder = false;
     return *this;
 }
 
+void ImageView::UploadDecoded(const void* ptr, size_t w, size_t h, size_t pitch, const PixelFormat& raw_fmt)
+{
+    if(!use_decoder || decoder.width != w || decoder.height != h) {
+        SetDimensions(w, h);
+        SetAspect((float)w / (float)h);
+    }
+    decoder.Upload(ptr, w, h, pitch, raw_fmt);
+    use_decoder = true;
+}
+
 void ImageView::LoadPending()
 {
     if(img_to_load.ptr)
     {
         // Scoped lock
         texlock.lock();
-        SetImage(img_to_load, img_fmt_to_load, false);
+        if(decode_to_load) {
+            UploadDecoded(img_to_load.ptr, img_to_load.w, img_to_load.h, img_to_load.pitch, raw_fmt_to_load);
+        }else{
+            // Draw from tex, not the decoder's last frame
+            use_decoder = false;
+            SetImage(img_to_load, img_fmt_to_load, false);
+        }
         img_to_load.Deallocate();
         texlock.unlock();
     }
 }
 
+ImageView& ImageView::SetBayer(const std::string& tile, const std::array<float,3>& wb_gains)
+{
+    decoder.bayer = tile;
+    decoder.wb_gains = wb_gains;
+    return *this;
+}
+
+ImageView& ImageView::SetGamma(float gamma)
+{
+    decoder.gamma = gamma;
+    return *this;
+}
+
 ImageView& ImageView::Clear()
 {
     tex.Delete();
+    decoder.raw.Delete();
+    use_decoder = false;
     return *this;
 }
 
@@ -28,6 +28,8 @@
 #include "pangolin_gl.h"
 #include <pangolin/display/display.h>
 #include <pangolin/console/ConsoleView.h>
+#include <pangolin/display/profiler_view.h>
+#include <pangolin/gl/glprofiler.h>
 
 namespace pangolin
 {
@@ -71,11 +73,13 @@ void PangolinGl::FinishFrame()
     }
 
     if(window) {
+        GlProfileScope profile("FinishFrame");
         window->SwapBuffers();
         window->ProcessEvents();
     }
 
     Viewport::DisableScissor();
+    GlProfiler::I().EndFrame();
 }
 
 void PangolinGl::SetOnRender(std::function<void ()> on_render) {
@@ -43,6 +43,7 @@ namespace pangolin
 
 // Forward Declarations
 class ConsoleView;
+class ProfilerView;
 class GlFont;
 
 typedef std::map<const std::string,View*> ViewMap;
@@ -89,6 +90,7 @@ struct PANGOLIN_EXPORT PangolinGl
     std::shared_ptr<GlFont> font;
 
     std::unique_ptr<ConsoleView> console_view;
+    std::unique_ptr<ProfilerView> profiler_view;
 };
 
 PangolinGl* GetCurrentContext();
@@ -0,0 +1,132 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove, Richard Newcombe
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <pangolin/display/profiler_view.h>
+#include <pangolin/display/default_font.h>
+#include <pangolin/gl/gldraw.h>
+#include <pangolin/gl/glprofiler.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+
+namespace pangolin
+{
+
+namespace
+{
+constexpr int profiler_width = 460;
+constexpr int profiler_height = 300;
+constexpr int histogram_bins = 24;
+constexpr GLfloat histogram_width = 96.0f;
+
+void glColour(const Colour& c)
+{
+    glColor4f(c.r,c.g,c.b,c.a);
+}
+
+float Mean(const std::deque<float>& samples)
+{
+    return samples.empty() ? 0.0f :
+        std::accumulate(samples.begin(), samples.end(), 0.0f) / samples.size();
+}
+}
+
+ProfilerView::ProfilerView()
+    : background_colour(0.0f, 0.0f, 0.0f, 0.6f),
+      text_colour(1.0f, 1.0f, 1.0f, 1.0f),
+      bar_colour(0.3f, 0.8f, 0.3f, 0.8f)
+{
+    SetBounds(Attach::ReversePix(profiler_height), 1.0, Attach::ReversePix(profiler_width), 1.0);
+}
+
+void ProfilerView::Render()
+{
+    const std::vector<GlProfiler::Section>& sections = GlProfiler::I().Sections();
+
+#ifndef HAVE_GLES
+    glPushAttrib(GL_CURRENT_BIT | GL_ENABLE_BIT | GL_DEPTH_BUFFER_BIT | GL_SCISSOR_BIT | GL_VIEWPORT_BIT | GL_COLOR_BUFFER_BIT | GL_TRANSFORM_BIT);
+#endif
+
+    this->ActivatePixelOrthographic();
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_COLOR_MATERIAL);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glColour(background_colour);
+    glDrawRect(0.0f, 0.0f, (GLfloat)v.w, (GLfloat)v.h);
+
+    GlFont& font = default_font();
+    const GLfloat line_space = 1.2f * font.Height();
+    const GLfloat hist_x = v.w - histogram_width - 8.0f;
+    GLfloat y = v.h - line_space;
+
+    glColour(text_colour);
+    font.Text("section          cpu ms   gpu ms").Draw(8.0f, y);
+
+    char line[128];
+    for(const GlProfiler::Section& s : sections) {
+        y -= line_space;
+        if(y < 0.0f) break;
+        if(s.cpu_ms.empty()) continue;
+
+        if(s.gpu_ms.empty()) {
+            snprintf(line, sizeof(line), "%-16.16s %7.2f        -", s.name.c_str(), Mean(s.cpu_ms));
+        }else{
+            snprintf(line, sizeof(line), "%-16.16s %7.2f  %7.2f", s.name.c_str(), Mean(s.cpu_ms), Mean(s.gpu_ms));
+        }
+        glColour(text_colour);
+        font.Text(std::string(line)).Draw(8.0f, y);
+
+        // Histogram of frame times between zero and the window maximum
+        const float max_ms = *std::max_element(s.cpu_ms.begin(), s.cpu_ms.end());
+        if(max_ms <= 0.0f) continue;
+        int bins[histogram_bins] = {};
+        for(float ms : s.cpu_ms) {
+            ++bins[std::min(histogram_bins-1, (int)(histogram_bins * ms / max_ms))];
+        }
+        const int max_count = *std::max_element(bins, bins + histogram_bins);
+        const GLfloat bar_w = histogram_width / histogram_bins;
+        const GLfloat bar_h = 0.8f * line_space;
+        glColour(bar_colour);
+        for(int b=0; b < histogram_bins; ++b) {
+            if(bins[b]) {
+                const GLfloat x = hist_x + b * bar_w;
+                glDrawRect(x, y, x + bar_w - 1.0f, y + bar_h * bins[b] / max_count);
+            }
+        }
+    }
+
+#ifndef HAVE_GLES
+    glPopAttrib();
+#endif
+}
+
+}
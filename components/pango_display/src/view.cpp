@@ -29,6 +29,7 @@
 #include <pangolin/display/display.h>
 #include <pangolin/display/view.h>
 #include <pangolin/gl/gl.h>
+#include <pangolin/gl/glprofiler.h>
 #include <pangolin/gl/viewport.h>
 #include <pangolin/gl/opengl_render_state.h>
 #include <pangolin/platform.h>
@@ -236,6 +237,7 @@ void View::ResizeChildren()
 
 void View::Render()
 {
+    GlProfileScope profile("View::Render");
     if(extern_draw_function && show && scroll_show) {
         extern_draw_function(*this);
     }
@@ -28,7 +28,9 @@
 #include <thread>
 #include <mutex>
 #include <iostream>
-#include <iomanip>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
 
 #include <pangolin/display/widgets.h>
 #include <pangolin/display/display.h>
@@ -55,36 +57,6 @@ const static GLfloat colour_dn[4] = {1.0f, 0.7f, 0.7f, 1.0f};
 // TODO: It doesn't look like this is doing anything meaningful right now...
 std::mutex display_mutex;
 
-// Render at (x,y) in window coordinates.
-inline void DrawWindow(GlText& text, GLfloat x, GLfloat y, GLfloat z = 0.0)
-{
-    // Backup viewport
-    GLint    view[4];
-    glGetIntegerv(GL_VIEWPORT, view );
-
-    auto& d = DisplayBase();
-    d.Activate();
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    // Pixel continuous coords
-    ProjectionMatrixOrthographic(0.0, d.v.w, 0.0, d.v.h, -1.0, 1.0).Load();
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
-
-    glTranslatef( std::floor(x), std::floor(y), z);
-    text.Draw();
-
-    // Restore viewport
-    glViewport(view[0],view[1],view[2],view[3]);
-
-    // Restore modelview / project matrices
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
-    glMatrixMode(GL_MODELVIEW);
-    glPopMatrix();
-}
-
 static inline int cb_height()
 {
     return (int)(default_font().Height() * 1.0);
@@ -107,58 +79,111 @@ inline void MarkVarChangedByGui(VarValueT<T>& var)
     FlagVarChanged();
 }
 
-void glLine(GLfloat vs[4])
+void WidgetGeometry::Clear()
 {
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glVertexPointer(2, GL_FLOAT, 0, vs);
-    glDrawArrays( GL_LINE_STRIP, 0, 2);
-    glDisableClientState(GL_VERTEX_ARRAY);
+    triangles.clear();
+    lines.clear();
+    text.clear();
 }
 
-void glRect(Viewport v)
+void WidgetGeometry::Append(const WidgetGeometry& o)
 {
-    GLfloat vs[] = { (float)v.l,(float)v.b,
-                     (float)v.l,(float)v.t(),
-                     (float)v.r(),(float)v.t(),
-                     (float)v.r(),(float)v.b };
+    triangles.insert(triangles.end(), o.triangles.begin(), o.triangles.end());
+    lines.insert(lines.end(), o.lines.begin(), o.lines.end());
+    text.insert(text.end(), o.text.begin(), o.text.end());
+    if(o.font_tex) font_tex = o.font_tex;
+}
 
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glVertexPointer(2, GL_FLOAT, 0, vs);
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-    glDisableClientState(GL_VERTEX_ARRAY);
+void WidgetGeometry::Rect(const Viewport& v, const GLfloat c[4])
+{
+    const GLfloat l = (GLfloat)v.l, b = (GLfloat)v.b, r = (GLfloat)v.r(), t = (GLfloat)v.t();
+    const GLfloat xy[6][2] = { {l,b}, {l,t}, {r,t}, {l,b}, {r,t}, {r,b} };
+    for(const auto& p : xy) {
+        triangles.push_back({p[0], p[1], {c[0], c[1], c[2], c[3]}});
+    }
 }
 
-void glRect(Viewport v, int inset)
+void WidgetGeometry::Line(GLfloat x0, GLfloat y0, GLfloat x1, GLfloat y1, const GLfloat c[4])
 {
-    glRect(v.Inset(inset));
+    lines.push_back({x0, y0, {c[0], c[1], c[2], c[3]}});
+    lines.push_back({x1, y1, {c[0], c[1], c[2], c[3]}});
 }
 
-void DrawShadowRect(Viewport& v)
+void WidgetGeometry::RectPerimeter(const Viewport& v, const GLfloat c[4])
 {
-    glColor4fv(colour_s2);
-    glDrawRectPerimeter((GLfloat)v.l, (GLfloat)v.b, (GLfloat)v.r(), (GLfloat)v.t());
+    const GLfloat l = (GLfloat)v.l, b = (GLfloat)v.b, r = (GLfloat)v.r(), t = (GLfloat)v.t();
+    Line(l, b, l, t, c);
+    Line(l, t, r, t, c);
+    Line(r, t, r, b, c);
+    Line(r, b, l, b, c);
 }
 
-void DrawShadowRect(Viewport& v, bool pushed)
+void WidgetGeometry::ShadowRect(const Viewport& v, bool pushed)
 {
+    // Lit from the top left: light edges up and left, dark edges down and right
     const GLfloat* c1 = pushed ? colour_s1 : colour_s2;
     const GLfloat* c2 = pushed ? colour_s2 : colour_s1;
+    const GLfloat l = (GLfloat)v.l, b = (GLfloat)v.b, r = (GLfloat)v.r(), t = (GLfloat)v.t();
+    Line(l, b, l, t, c1);
+    Line(l, t, r, t, c1);
+    Line(r, t, r, b, c2);
+    Line(r, b, l, b, c2);
+}
 
-    GLfloat vs[] = { (float)v.l,(float)v.b,
-                     (float)v.l,(float)v.t(),
-                     (float)v.r(),(float)v.t(),
-                     (float)v.r(),(float)v.b,
-                     (float)v.l,(float)v.b };
+void WidgetGeometry::Text(const GlText& t, GLfloat x, GLfloat y)
+{
+    // GlText is laid out for a projection without the half pixel offset of
+    // ActivatePixelOrthographic, which the rest of the geometry assumes.
+    const GLfloat dx = std::floor(x) + 0.5f;
+    const GLfloat dy = std::floor(y) + 0.5f;
+    for(const XYUV& c : t.vs) {
+        text.emplace_back(c.x + dx, c.y + dy, c.tu, c.tv);
+    }
+    if(t.tex) font_tex = t.tex;
+}
 
+void WidgetGeometry::Draw() const
+{
     glEnableClientState(GL_VERTEX_ARRAY);
-    glVertexPointer(2, GL_FLOAT, 0, vs);
-    glColor4fv(c1);
-    glDrawArrays(GL_LINE_STRIP, 0, 3);
-
-    glColor4fv(c2);
-    glDrawArrays(GL_LINE_STRIP, 2, 3);
+    if(!triangles.empty() || !lines.empty()) {
+        glEnableClientState(GL_COLOR_ARRAY);
+        if(!triangles.empty()) {
+            glVertexPointer(2, GL_FLOAT, sizeof(ColourVertex), &triangles[0].x);
+            glColorPointer(4, GL_FLOAT, sizeof(ColourVertex), triangles[0].rgba);
+            glDrawArrays(GL_TRIANGLES, 0, (GLsizei)triangles.size());
+        }
+        if(!lines.empty()) {
+            glVertexPointer(2, GL_FLOAT, sizeof(ColourVertex), &lines[0].x);
+            glColorPointer(4, GL_FLOAT, sizeof(ColourVertex), lines[0].rgba);
+            glDrawArrays(GL_LINES, 0, (GLsizei)lines.size());
+        }
+        glDisableClientState(GL_COLOR_ARRAY);
+    }
+    if(!text.empty() && font_tex) {
+        glColor4fv(colour_tx);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glVertexPointer(2, GL_FLOAT, sizeof(XYUV), &text[0].x);
+        glTexCoordPointer(2, GL_FLOAT, sizeof(XYUV), &text[0].tu);
+        font_tex->Bind();
+        glEnable(GL_TEXTURE_2D);
+        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)text.size());
+        glDisable(GL_TEXTURE_2D);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    }
     glDisableClientState(GL_VERTEX_ARRAY);
+}
 
+bool PanelWidget::UpdateGeometry(const Viewport& v)
+{
+    const bool state_changed = StateChanged();
+    if(built && !state_changed && v == built_viewport) {
+        return false;
+    }
+    geometry.Clear();
+    BuildGeometry(geometry);
+    built_viewport = v;
+    built = true;
+    return true;
 }
 
 Panel::Panel()
@@ -271,11 +296,59 @@ void Panel::Render()
     glDisable( GL_COLOR_MATERIAL );
     glLineWidth(1.0);
 
-    glColor4fv(colour_bg);
-    glRect(v);
-    DrawShadowRect(v);
+    // Collect widgets which are shown, rebuilding any that are out of date
+    std::vector<PanelWidget*> widgets;
+    bool rebuild = (v != built_viewport);
+    for(View* child : views) {
+        if(!child->show || !child->IsScrolledIntoView()) continue;
+        if(PanelWidget* w = dynamic_cast<PanelWidget*>(child)) {
+            rebuild |= w->UpdateGeometry(child->v);
+            widgets.push_back(w);
+        }
+    }
+    rebuild |= (widgets != drawn_widgets);
+
+    if(rebuild) {
+        batch.Clear();
+        batch.Rect(v, colour_bg);
+        batch.RectPerimeter(v, colour_s2);
+        for(PanelWidget* w : widgets) {
+            batch.Append(w->geometry);
+        }
+        UploadBatch();
+        built_viewport = v;
+        drawn_widgets = std::move(widgets);
+    }
 
-    RenderChildren();
+    using CV = WidgetGeometry::ColourVertex;
+    batch_buffer.Bind();
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(CV), (void*)0);
+    glColorPointer(4, GL_FLOAT, sizeof(CV), (void*)offsetof(CV, rgba));
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)batch.triangles.size());
+    glDrawArrays(GL_LINES, (GLint)batch_line_offset, (GLsizei)batch.lines.size());
+    glDisableClientState(GL_COLOR_ARRAY);
+    if(!batch.text.empty() && batch.font_tex) {
+        glColor4fv(colour_tx);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glVertexPointer(2, GL_FLOAT, sizeof(XYUV), (void*)batch_text_offset_bytes);
+        glTexCoordPointer(2, GL_FLOAT, sizeof(XYUV), (void*)(batch_text_offset_bytes + offsetof(XYUV, tu)));
+        batch.font_tex->Bind();
+        glEnable(GL_TEXTURE_2D);
+        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)batch.text.size());
+        glDisable(GL_TEXTURE_2D);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+    batch_buffer.Unbind();
+
+    // Anything else placed in the panel draws itself
+    for(View* child : views) {
+        if(child->show && child->IsScrolledIntoView() && !dynamic_cast<PanelWidget*>(child)) {
+            child->Render();
+        }
+    }
 
 #ifndef HAVE_GLES
     glPopAttrib();
@@ -290,6 +363,26 @@ void Panel::ResizeChildren()
     View::ResizeChildren();
 }
 
+void Panel::UploadBatch()
+{
+    // Layout: triangle vertices, line vertices (both coloured), then text
+    using CV = WidgetGeometry::ColourVertex;
+    const size_t colour_bytes = (batch.triangles.size() + batch.lines.size()) * sizeof(CV);
+    const size_t text_bytes = batch.text.size() * sizeof(XYUV);
+    const size_t total_bytes = colour_bytes + text_bytes;
+
+    batch_line_offset = batch.triangles.size();
+    batch_text_offset_bytes = colour_bytes;
+
+    if(!batch_buffer.IsValid() || (size_t)batch_buffer.SizeBytes() < total_bytes) {
+        // Leave room to grow so that adding a few widgets doesn't reallocate
+        batch_buffer.Reinitialise(GlArrayBuffer, (GLsizeiptr)(total_bytes * 3 / 2 + 1024), GL_DYNAMIC_DRAW);
+    }
+    if(!batch.triangles.empty()) batch_buffer.Upload(batch.triangles.data(), batch.triangles.size() * sizeof(CV), 0);
+    if(!batch.lines.empty()) batch_buffer.Upload(batch.lines.data(), batch.lines.size() * sizeof(CV), batch_line_offset * sizeof(CV));
+    if(!batch.text.empty()) batch_buffer.Upload(batch.text.data(), text_bytes, batch_text_offset_bytes);
+}
+
 
 View& CreatePanel(const std::string& name)
 {
@@ -324,16 +417,22 @@ void Button::Mouse(View&, MouseButton button, int /*x*/, int /*y*/, bool pressed
     }
 }
 
-void Button::Render()
+bool Button::StateChanged()
 {
-    glColor4fv(colour_fg );
-    glRect(v);
-    glColor4fv(colour_tx);
+    bool changed = Changed(built_down, down);
     if(gltext.Text() != var->Meta().friendly) {
         gltext = default_font().Text(var->Meta().friendly);
+        ResizeChildren();
+        changed = true;
     }
-    DrawWindow(gltext, raster[0],raster[1]-down);
-    DrawShadowRect(v, down);
+    return changed;
+}
+
+void Button::BuildGeometry(WidgetGeometry& g)
+{
+    g.Rect(v, colour_fg);
+    g.Text(gltext, raster[0], raster[1]-down);
+    g.ShadowRect(v, down);
 }
 
 void Button::ResizeChildren()
@@ -364,16 +463,22 @@ void FunctionButton::Mouse(View&, MouseButton button, int /*x*/, int /*y*/, bool
     }
 }
 
-void FunctionButton::Render()
+bool FunctionButton::StateChanged()
 {
-    glColor4fv(colour_fg);
-    glRect(v);
-    glColor4fv(colour_tx);
+    bool changed = Changed(built_down, down);
     if(gltext.Text() != var->Meta().friendly) {
         gltext = default_font().Text(var->Meta().friendly);
+        ResizeChildren();
+        changed = true;
     }
-    DrawWindow(gltext, raster[0],raster[1]-down);
-    DrawShadowRect(v, down);
+    return changed;
+}
+
+void FunctionButton::BuildGeometry(WidgetGeometry& g)
+{
+    g.Rect(v, colour_fg);
+    g.Text(gltext, raster[0], raster[1]-down);
+    g.ShadowRect(v, down);
 }
 
 void FunctionButton::ResizeChildren()
@@ -410,21 +515,23 @@ void Checkbox::ResizeChildren()
     vcb = Viewport(v.l,v.b+t,cb_height(),cb_height());
 }
 
-void Checkbox::Render()
+bool Checkbox::StateChanged()
 {
-    const bool val = var->Get();
-
-    if( val )
-    {
-        glColor4fv(colour_dn);
-        glRect(vcb);
-    }
-    glColor4fv(colour_tx);
+    bool changed = Changed(built_val, (bool)var->Get());
     if(gltext.Text() != var->Meta().friendly) {
         gltext = default_font().Text(var->Meta().friendly);
+        changed = true;
+    }
+    return changed;
+}
+
+void Checkbox::BuildGeometry(WidgetGeometry& g)
+{
+    if( built_val ) {
+        g.Rect(vcb, colour_dn);
     }
-    DrawWindow(gltext, raster[0], raster[1]);
-    DrawShadowRect(vcb, val);
+    g.Text(gltext, raster[0], raster[1]);
+    g.ShadowRect(vcb, built_val);
 }
 
 inline bool IsIntegral(const char* typeidname)
@@ -549,37 +656,41 @@ void Slider::ResizeChildren()
     raster[1] = v.b + (v.h-gltext.Height())/2.0f;
 }
 
-void Slider::Render()
+bool Slider::StateChanged()
+{
+    // The generation catches changes made through Set(). The value itself is
+    // compared too since vars bound by reference change without it.
+    bool changed = Changed(built_generation, var->Generation());
+    changed |= Changed(built_val, (double)var->Get());
+    changed |= Changed(built_range[0], var->Meta().range[0]);
+    changed |= Changed(built_range[1], var->Meta().range[1]);
+    if(gltext.Text() != var->Meta().friendly) {
+        gltext = default_font().Text(var->Meta().friendly);
+        changed = true;
+    }
+    return changed;
+}
+
+void Slider::BuildGeometry(WidgetGeometry& g)
 {
-    const double val = var->Get();
+    const double val = built_val;
 
-    if( var->Meta().range[0] != var->Meta().range[1] )
+    if( built_range[0] != built_range[1] )
     {
-        double rval = val;
-        if (logscale)
-        {
-            rval = log(val);
-        }
-        glColor4fv(colour_fg);
-        glRect(v);
-        glColor4fv(colour_dn);
-        const double norm_val = max(0.0,min(1.0,(rval - var->Meta().range[0]) / (var->Meta().range[1] - var->Meta().range[0])));
-        glRect(Viewport(v.l,v.b, (int)(v.w*norm_val),v.h));
-        DrawShadowRect(v);
+        const double rval = logscale ? log(val) : val;
+        g.Rect(v, colour_fg);
+        const double norm_val = max(0.0,min(1.0,(rval - built_range[0]) / (built_range[1] - built_range[0])));
+        g.Rect(Viewport(v.l,v.b, (int)(v.w*norm_val),v.h), colour_dn);
+        g.RectPerimeter(v, colour_s2);
     }
 
-    glColor4fv(colour_tx);
-    if(gltext.Text() != var->Meta().friendly) {
-        gltext = default_font().Text(var->Meta().friendly);
-    }
-    DrawWindow(gltext, raster[0], raster[1]);
+    g.Text(gltext, raster[0], raster[1]);
 
-    std::ostringstream oss;
-    oss << setprecision(4) << val;
-    string str = oss.str();
-    GlText glval = default_font().Text(str);
+    char str[32];
+    snprintf(str, sizeof(str), "%.4g", val);
+    GlText glval = default_font().Text(std::string(str));
     const float l = glval.Width() + 2.0f;
-    DrawWindow(glval,  v.l + v.w - l, raster[1] );
+    g.Text(glval, v.l + v.w - l, raster[1]);
 }
 
 
@@ -753,14 +864,23 @@ void TextInput::CalcVisibleEditPart()
     }
 };
 
-void TextInput::Render()
+bool TextInput::StateChanged()
 {
     if(!do_edit) edit = var->Get();
 
+    bool changed = Changed(built_edit, edit);
+    changed |= Changed(built_do_edit, do_edit);
+    changed |= Changed(built_sel[0], sel[0]);
+    changed |= Changed(built_sel[1], sel[1]);
+    changed |= Changed(built_visible_start, edit_visible_part[0]);
+    return changed;
+}
+
+void TextInput::BuildGeometry(WidgetGeometry& g)
+{
     Viewport input_v(v.l,v.b,v.w,v.h / 2);
     
-    glColor4fv(colour_fg);
-    if(can_edit) glRect(input_v);
+    if(can_edit) g.Rect(input_v, colour_fg);
 
     std::string edit_visible = edit.substr(edit_visible_part[0], edit_visible_part[1]);
     gledit = default_font().Text(edit_visible);
@@ -772,19 +892,13 @@ void TextInput::Render()
     {
         const int tl = (int)(rl + default_font().Text(edit_visible.substr(0,sel[0] - edit_visible_part[0])).Width());
         const int tr = (int)(rl + default_font().Text(edit_visible.substr(0,sel[1] - edit_visible_part[0])).Width());
-        glColor4fv(colour_dn);
-        glRect(Viewport(tl,input_v.b,tr-tl,input_v.h));
-
-        glColor4fv(colour_tx);
-        GLfloat caret[4] = {(float) tr, (float) input_v.b, (float) tr, (float) input_v.b + input_v.h};
-        glLine(caret);
+        g.Rect(Viewport(tl,input_v.b,tr-tl,input_v.h), colour_dn);
+        g.Line((float) tr, (float) input_v.b, (float) tr, (float) input_v.b + input_v.h, colour_tx);
     }
 
-    glColor4fv(colour_tx);
-    DrawWindow(gltext, v.l + horizontal_margin, v.b + gltext.Height() + 3.f * vertical_margin);
-
-    DrawWindow(gledit, (GLfloat)(rl), input_v.b + vertical_margin);
-    if(can_edit) DrawShadowRect(input_v);
+    g.Text(gltext, v.l + horizontal_margin, v.b + gltext.Height() + 3.f * vertical_margin);
+    g.Text(gledit, (GLfloat)(rl), input_v.b + vertical_margin);
+    if(can_edit) g.ShadowRect(input_v, false);
 }
 
 }
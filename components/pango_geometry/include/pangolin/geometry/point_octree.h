@@ -0,0 +1,106 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <pangolin/platform.h>
+#include <pangolin/geometry/geometry.h>
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pangolin
+{
+
+// Point as stored in an octree file and uploaded to the GPU (interleaved
+// position and colour).
+struct OctreePoint
+{
+    float x, y, z;
+    uint8_t r, g, b, a;
+};
+static_assert(sizeof(OctreePoint) == 16, "OctreePoint must be tightly packed");
+
+// Octree nodes hold a representative subsample of the points within their
+// bounds which are not held by any ancestor. Drawing a node together with
+// all of its ancestors therefore gives the cloud at that node's resolution.
+struct PointOctreeNode
+{
+    float min[3];
+    float max[3];
+    // Index of each child node, or -1
+    int32_t children[8];
+    // Byte offset of this node's points in the file
+    uint64_t offset;
+    uint32_t num_points;
+    uint32_t depth;
+};
+static_assert(sizeof(PointOctreeNode) == 72, "PointOctreeNode layout is part of the file format");
+
+struct PointOctreeParams
+{
+    // Nodes with at most this many points are not subdivided
+    size_t max_leaf_points = 65536;
+    // Approximate number of points kept by each interior node
+    size_t node_sample_points = 32768;
+    size_t max_depth = 20;
+    size_t num_threads = std::thread::hardware_concurrency();
+};
+
+// Build octree for points (in parallel) and write it to filename
+PANGOLIN_EXPORT
+void BuildPointOctree(std::vector<OctreePoint> points, const std::string& filename, const PointOctreeParams& params = PointOctreeParams());
+
+// Gather all "vertex" attributes of geom, with colour from a matching
+// "color" attribute if present (white otherwise)
+PANGOLIN_EXPORT
+std::vector<OctreePoint> OctreePointsFromGeometry(const Geometry& geom);
+
+// Random access to the nodes of an octree file. Point data is only read
+// on request so that clouds larger than memory can be used.
+class PANGOLIN_EXPORT PointOctreeFile
+{
+public:
+    PointOctreeFile(const std::string& filename);
+
+    //! All nodes, root first
+    const std::vector<PointOctreeNode>& Nodes() const { return nodes; }
+
+    //! Read points of node from disk. Safe to call from any thread.
+    std::vector<OctreePoint> LoadNode(size_t node) const;
+
+private:
+    std::vector<PointOctreeNode> nodes;
+    mutable std::ifstream file;
+    mutable std::mutex file_mutex;
+};
+
+}
@@ -33,6 +33,8 @@
 #include <pangolin/utils/type_convert.h>
 #include <pangolin/utils/simple_math.h>
 #include <pangolin/image/image_io.h>
+#include <pangolin/utils/task_scheduler.h>
+
 
 namespace pangolin {
 
@@ -453,18 +455,32 @@ void AttachAssociatedTexturesPly(pangolin::Geometry& geom, const std::string& fi
     auto dot = filename.find_last_of('.');
     if(dot != filename.npos) {
         const std::string base = filename.substr(0, dot);
+
+        // Decode each texture slot concurrently
+        std::vector<TypedImage> textures(10);
+        TaskGroup loads;
         for(int i=0; i < 10; ++i) {
-            const std::string glob = FormatString("%_%.*", base, i);
-            std::vector<std::string> file_vec;
-            if(FilesMatchingWildcard(glob, file_vec)) {
-                for(const auto& file : file_vec) {
-                    try {
-                        geom.textures[FormatString("texture_%",i)] = LoadImage(file);
-                        break;
-                    }catch(std::runtime_error&)
-                    {
+            loads.Run([&textures,base,i](){
+                const std::string glob = FormatString("%_%.*", base, i);
+                std::vector<std::string> file_vec;
+                if(FilesMatchingWildcard(glob, file_vec)) {
+                    for(const auto& file : file_vec) {
+                        try {
+                            textures[i] = LoadImage(file);
+                            return;
+                        }catch(std::runtime_error&)
+                        {
+                        }
                     }
                 }
+            });
+        }
+        loads.Wait();
+
+        for(int i=0; i < 10; ++i) {
+            TypedImage& tex = textures[i];
+            if(tex.IsValid()) {
+                geom.textures[FormatString("texture_%",i)] = std::move(tex);
             }
         }
     }
@@ -0,0 +1,292 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2014 Steven Lovegrove
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <pangolin/geometry/point_octree.h>
+#include <pangolin/utils/task_scheduler.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <queue>
+
+namespace pangolin
+{
+
+namespace
+{
+
+const char octree_magic[8] = {'P','A','N','G','O','C','T','1'};
+
+struct BuildNode
+{
+    float min[3];
+    float max[3];
+    uint32_t depth;
+    std::vector<OctreePoint> points;
+    std::unique_ptr<BuildNode> children[8];
+};
+
+inline const float* PointPos(const OctreePoint& p)
+{
+    return &p.x;
+}
+
+// Move a spatially even subsample of [begin,end) to its front and return
+// the end of that subsample. At most one point is taken per cell of a
+// regular grid over the node.
+OctreePoint* SelectNodeSample(const BuildNode& node, OctreePoint* begin, OctreePoint* end, size_t sample_points)
+{
+    const size_t grid = std::max<size_t>(1, (size_t)std::round(std::cbrt((double)sample_points)));
+    std::vector<bool> occupied(grid*grid*grid, false);
+
+    float scale[3];
+    for(int d=0; d < 3; ++d) {
+        scale[d] = grid / std::max(node.max[d] - node.min[d], 1e-20f);
+    }
+
+    OctreePoint* mid = begin;
+    for(OctreePoint* it = begin; it != end; ++it) {
+        size_t cell = 0;
+        for(int d=0; d < 3; ++d) {
+            const size_t c = std::min(grid - 1, (size_t)std::max(0.0f, (PointPos(*it)[d] - node.min[d]) * scale[d]));
+            cell = cell * grid + c;
+        }
+        if(!occupied[cell]) {
+            occupied[cell] = true;
+            std::swap(*it, *mid++);
+        }
+    }
+    return mid;
+}
+
+void BuildRecursive(BuildNode& node, OctreePoint* begin, OctreePoint* end, const PointOctreeParams& params, size_t parallel_depth)
+{
+    const size_t count = end - begin;
+    if(count <= params.max_leaf_points || node.depth >= params.max_depth) {
+        node.points.assign(begin, end);
+        return;
+    }
+
+    OctreePoint* mid = SelectNodeSample(node, begin, end, params.node_sample_points);
+    node.points.assign(begin, mid);
+
+    // Split the remainder by octant: x is the most significant bit
+    float centre[3];
+    for(int d=0; d < 3; ++d) centre[d] = (node.min[d] + node.max[d]) / 2.0f;
+
+    OctreePoint* bounds[9];
+    bounds[0] = mid;
+    bounds[8] = end;
+    auto split = [&](OctreePoint* b, OctreePoint* e, int d) {
+        return std::partition(b, e, [&](const OctreePoint& p){ return PointPos(p)[d] < centre[d]; });
+    };
+    bounds[4] = split(bounds[0], bounds[8], 0);
+    bounds[2] = split(bounds[0], bounds[4], 1);
+    bounds[6] = split(bounds[4], bounds[8], 1);
+    for(int i=0; i < 8; i += 2) {
+        bounds[i+1] = split(bounds[i], bounds[i+2], 2);
+    }
+
+    TaskGroup tasks;
+    for(int c=0; c < 8; ++c) {
+        if(bounds[c] == bounds[c+1]) continue;
+
+        node.children[c].reset(new BuildNode());
+        BuildNode& child = *node.children[c];
+        child.depth = node.depth + 1;
+        for(int d=0; d < 3; ++d) {
+            const bool upper = c & (4 >> d);
+            child.min[d] = upper ? centre[d] : node.min[d];
+            child.max[d] = upper ? node.max[d] : centre[d];
+        }
+
+        if(node.depth < parallel_depth) {
+            tasks.Run([&,c](){
+                BuildRecursive(*node.children[c], bounds[c], bounds[c+1], params, parallel_depth);
+            });
+        }else{
+            BuildRecursive(child, bounds[c], bounds[c+1], params, parallel_depth);
+        }
+    }
+    tasks.Wait();
+}
+
+}
+
+void BuildPointOctree(std::vector<OctreePoint> points, const std::string& filename, const PointOctreeParams& params)
+{
+    BuildNode root;
+    root.depth = 0;
+
+    // Use a cube so that nodes at the same depth have the same size
+    for(int d=0; d < 3; ++d) {
+        root.min[d] = std::numeric_limits<float>::max();
+        root.max[d] = std::numeric_limits<float>::lowest();
+    }
+    for(const OctreePoint& p : points) {
+        for(int d=0; d < 3; ++d) {
+            root.min[d] = std::min(root.min[d], PointPos(p)[d]);
+            root.max[d] = std::max(root.max[d], PointPos(p)[d]);
+        }
+    }
+    float size = 0.0f;
+    for(int d=0; d < 3; ++d) {
+        if(points.empty()) root.min[d] = root.max[d] = 0.0f;
+        size = std::max(size, root.max[d] - root.min[d]);
+    }
+    for(int d=0; d < 3; ++d) {
+        root.max[d] = root.min[d] + size;
+    }
+
+    // Subtrees below this depth are built on the calling thread
+    size_t parallel_depth = 0;
+    for(size_t tasks = 1; tasks < params.num_threads; tasks *= 8) ++parallel_depth;
+
+    BuildRecursive(root, points.data(), points.data() + points.size(), params, parallel_depth);
+    points.clear();
+    points.shrink_to_fit();
+
+    // Flatten breadth first so that coarse nodes are near the start of the file
+    std::vector<const BuildNode*> order;
+    std::vector<PointOctreeNode> nodes;
+    std::queue<const BuildNode*> queue;
+    queue.push(&root);
+    while(!queue.empty()) {
+        const BuildNode* b = queue.front();
+        queue.pop();
+        order.push_back(b);
+        for(int c=0; c < 8; ++c) {
+            if(b->children[c]) queue.push(b->children[c].get());
+        }
+    }
+
+    uint64_t offset = sizeof(octree_magic) + sizeof(uint32_t) + order.size() * sizeof(PointOctreeNode);
+    size_t next_child = 1;
+    for(const BuildNode* b : order) {
+        PointOctreeNode n;
+        std::memcpy(n.min, b->min, sizeof(n.min));
+        std::memcpy(n.max, b->max, sizeof(n.max));
+        for(int c=0; c < 8; ++c) {
+            n.children[c] = b->children[c] ? (int32_t)next_child++ : -1;
+        }
+        n.offset = offset;
+        n.num_points = (uint32_t)b->points.size();
+        n.depth = b->depth;
+        offset += n.num_points * sizeof(OctreePoint);
+        nodes.push_back(n);
+    }
+
+    std::ofstream file(filename, std::ios::binary);
+    if(!file.is_open()) {
+        throw std::runtime_error("Unable to open octree file for writing: " + filename);
+    }
+    const uint32_t num_nodes = (uint32_t)nodes.size();
+    file.write(octree_magic, sizeof(octree_magic));
+    file.write((const char*)&num_nodes, sizeof(num_nodes));
+    file.write((const char*)nodes.data(), nodes.size() * sizeof(PointOctreeNode));
+    for(const BuildNode* b : order) {
+        file.write((const char*)b->points.data(), b->points.size() * sizeof(OctreePoint));
+    }
+    if(!file.good()) {
+        throw std::runtime_error("Error writing octree file: " + filename);
+    }
+}
+
+std::vector<OctreePoint> OctreePointsFromGeometry(const Geometry& geom)
+{
+    std::vector<OctreePoint> points;
+
+    for(const auto& b : geom.buffers) {
+        const auto it_vert = b.second.attributes.find("vertex");
+        if(it_vert == b.second.attributes.end()) continue;
+        const Image<float>& vs = std::get<Image<float>>(it_vert->second);
+
+        const auto it_color = b.second.attributes.find("color");
+        const Geometry::Element::Attribute* color = (it_color != b.second.attributes.end()) ? &it_color->second : nullptr;
+
+        for(size_t i=0; i < vs.h; ++i) {
+            OctreePoint p;
+            p.x = vs(0,i); p.y = vs(1,i); p.z = vs(2,i);
+            p.r = p.g = p.b = p.a = 255;
+            if(color) {
+                uint8_t* rgba[4] = {&p.r, &p.g, &p.b, &p.a};
+                if(auto c = std::get_if<Image<uint8_t>>(color)) {
+                    for(size_t k=0; k < std::min<size_t>(c->w,4); ++k) *rgba[k] = (*c)(k,i);
+                }else if(auto c = std::get_if<Image<float>>(color)) {
+                    for(size_t k=0; k < std::min<size_t>(c->w,4); ++k) *rgba[k] = (uint8_t)std::clamp((*c)(k,i) * 255.0f, 0.0f, 255.0f);
+                }else if(auto c = std::get_if<Image<uint16_t>>(color)) {
+                    for(size_t k=0; k < std::min<size_t>(c->w,4); ++k) *rgba[k] = (uint8_t)((*c)(k,i) >> 8);
+                }
+            }
+            points.push_back(p);
+        }
+    }
+
+    return points;
+}
+
+PointOctreeFile::PointOctreeFile(const std::string& filename)
+    : file(filename, std::ios::binary)
+{
+    if(!file.is_open()) {
+        throw std::runtime_error("Unable to open octree file: " + filename);
+    }
+
+    char magic[sizeof(octree_magic)];
+    uint32_t num_nodes = 0;
+    file.read(magic, sizeof(magic));
+    file.read((char*)&num_nodes, sizeof(num_nodes));
+    if(!file.good() || std::memcmp(magic, octree_magic, sizeof(magic))) {
+        throw std::runtime_error("Not a pangolin octree file: " + filename);
+    }
+
+    nodes.resize(num_nodes);
+    file.read((char*)nodes.data(), nodes.size() * sizeof(PointOctreeNode));
+    if(!file.good()) {
+        throw std::runtime_error("Truncated octree file: " + filename);
+    }
+}
+
+std::vector<OctreePoint> PointOctreeFile::LoadNode(size_t node) const
+{
+    const PointOctreeNode& n = nodes.at(node);
+    std::vector<OctreePoint> points(n.num_points);
+
+    std::lock_guard<std::mutex> l(file_mutex);
+    // A previous failed read shouldn't stop us reading other nodes
+    file.clear();
+    file.seekg(n.offset);
+    file.read((char*)points.data(), points.size() * sizeof(OctreePoint));
+    if(!file.good()) {
+        throw std::runtime_error("Unable to read octree node");
+    }
+    return points;
+}
+
+}
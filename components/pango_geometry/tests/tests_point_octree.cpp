@@ -0,0 +1,97 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <pangolin/geometry/point_octree.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+
+TEST_CASE( "Point octree partitions every point into exactly one node" )
+{
+    const std::string filename = "test_point_octree.octree";
+    const size_t num_points = 20000;
+
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> dist(-5.0f, 5.0f);
+    std::vector<pangolin::OctreePoint> points(num_points);
+    for(size_t i=0; i < num_points; ++i) {
+        points[i] = {dist(rng), dist(rng) * 0.5f, dist(rng) * 0.1f, uint8_t(i), uint8_t(i>>8), uint8_t(i>>16), 255};
+    }
+
+    pangolin::PointOctreeParams params;
+    params.max_leaf_points = 1000;
+    params.node_sample_points = 512;
+    params.num_threads = 4;
+    pangolin::BuildPointOctree(points, filename, params);
+
+    pangolin::PointOctreeFile octree(filename);
+    const auto& nodes = octree.Nodes();
+    REQUIRE(nodes.size() > 8);
+    REQUIRE(nodes[0].depth == 0);
+    REQUIRE(nodes[0].num_points <= params.node_sample_points);
+
+    std::vector<bool> seen(num_points, false);
+    for(size_t n=0; n < nodes.size(); ++n) {
+        const pangolin::PointOctreeNode& node = nodes[n];
+        bool leaf = true;
+        for(int c=0; c < 8; ++c) {
+            if(node.children[c] >= 0) {
+                leaf = false;
+                REQUIRE((size_t)node.children[c] > n);
+                REQUIRE(nodes[node.children[c]].depth == node.depth + 1);
+            }
+        }
+        if(leaf) REQUIRE(node.num_points <= params.max_leaf_points);
+
+        for(const pangolin::OctreePoint& p : octree.LoadNode(n)) {
+            REQUIRE(p.x >= node.min[0]); REQUIRE(p.x <= node.max[0]);
+            REQUIRE(p.y >= node.min[1]); REQUIRE(p.y <= node.max[1]);
+            REQUIRE(p.z >= node.min[2]); REQUIRE(p.z <= node.max[2]);
+            const size_t id = p.r | (p.g << 8) | (p.b << 16);
+            REQUIRE(id < num_points);
+            REQUIRE(!seen[id]);
+            seen[id] = true;
+        }
+    }
+    REQUIRE(std::count(seen.begin(), seen.end(), true) == (long)num_points);
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE( "Point octree nodes beyond a truncation fail without affecting others" )
+{
+    const std::string filename = "test_point_octree_truncated.octree";
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<pangolin::OctreePoint> points(5000);
+    for(pangolin::OctreePoint& p : points) {
+        p = {dist(rng), dist(rng), dist(rng), 0, 0, 0, 255};
+    }
+
+    pangolin::PointOctreeParams params;
+    params.max_leaf_points = 500;
+    params.node_sample_points = 256;
+    pangolin::BuildPointOctree(points, filename, params);
+
+    // Cut the file part way through the last node stored
+    size_t last = 0;
+    {
+        pangolin::PointOctreeFile octree(filename);
+        const auto& nodes = octree.Nodes();
+        for(size_t n=1; n < nodes.size(); ++n) {
+            if(nodes[n].offset > nodes[last].offset) last = n;
+        }
+        REQUIRE(last != 0);
+        REQUIRE(nodes[last].num_points > 1);
+        std::filesystem::resize_file(filename, nodes[last].offset + sizeof(pangolin::OctreePoint));
+    }
+
+    pangolin::PointOctreeFile octree(filename);
+    REQUIRE_THROWS(octree.LoadNode(last));
+    REQUIRE(octree.LoadNode(0).size() == octree.Nodes()[0].num_points);
+
+    std::remove(filename.c_str());
+}
@@ -31,6 +31,8 @@
 #include <pangolin/gl/gl.h>
 #include <pangolin/gl/glsl.h>
 
+#include <deque>
+
 namespace pangolin {
 
 struct GlGeometry
@@ -84,4 +86,40 @@ GlGeometry ToGlGeometry(const Geometry& geom);
 
 void GlDraw(GlSlProgram& prog, const GlGeometry& geom, const GlTexture *matcap);
 
+// Moves a Geometry onto the GPU a little at a time, so that large models can
+// be uploaded over several frames without stalling rendering. Textures are
+// uploaded first, then vertex buffers, then each object's indices. Elements
+// are only added to the target GlGeometry once fully uploaded, so whatever has
+// arrived so far can be drawn with GlDraw.
+class PANGOLIN_EXPORT GlGeometryUploader
+{
+public:
+    GlGeometryUploader(Geometry&& geom);
+
+    //! Upload roughly budget_bytes more data into gl (at least one texture
+    //! or buffer slice). Must be called with the GL context current.
+    //! Returns number of bytes uploaded.
+    size_t Upload(GlGeometry& gl, size_t budget_bytes);
+
+    bool Done() const { return items.empty(); }
+
+    size_t TotalBytes() const { return total_bytes; }
+    size_t BytesUploaded() const { return bytes_uploaded; }
+
+private:
+    struct Item {
+        enum Type { Texture, Buffer, Object } type;
+        std::string name;
+        const Geometry::Element* el;
+        const TypedImage* tex;
+    };
+
+    Geometry geom;
+    std::deque<Item> items;
+    GlGeometry::Element partial;
+    size_t partial_bytes;
+    size_t total_bytes;
+    size_t bytes_uploaded;
+};
+
 }
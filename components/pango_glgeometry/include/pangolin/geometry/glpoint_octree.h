@@ -0,0 +1,110 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2014 Steven Lovegrove
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <pangolin/geometry/point_octree.h>
+#include <pangolin/gl/gl.h>
+#include <pangolin/gl/opengl_render_state.h>
+#include <pangolin/gl/viewport.h>
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <set>
+#include <thread>
+
+namespace pangolin {
+
+// Level-of-detail renderer for point clouds built with BuildPointOctree.
+// Each frame, nodes are selected by frustum and projected size, coarse to
+// fine, up to a point budget. Selected nodes not on the GPU are read from
+// disk by a loader thread and uploaded over the following frames, whilst
+// the least recently drawn nodes are evicted to stay within a GPU memory
+// budget. Until a node arrives its ancestors still give a coarser view.
+// Nodes which fail to load are reported once and not requested again.
+class PANGOLIN_EXPORT GlPointOctree
+{
+public:
+    GlPointOctree(const std::string& filename, size_t gpu_budget_bytes = 512 << 20);
+    ~GlPointOctree();
+
+    //! Draw points visible from cam within viewport. The GL context must be
+    //! current and cam already applied (as for RenderVboCbo).
+    void Render(const OpenGlRenderState& cam, const Viewport& viewport);
+
+    //! Nodes smaller than this on screen are not refined further
+    float min_node_pixels = 128.0f;
+
+    //! Maximum number of points drawn per frame
+    size_t point_budget = 10000000;
+
+    //! Bound the number of nodes uploaded per frame to limit stalls
+    size_t max_uploads_per_frame = 8;
+
+    size_t NumNodes() const { return file.Nodes().size(); }
+    size_t NumResidentNodes() const { return resident.size(); }
+    size_t ResidentBytes() const { return resident_bytes; }
+    size_t PointsRendered() const { return points_rendered; }
+
+private:
+    struct GpuNode
+    {
+        GlBuffer buffer;
+        size_t last_frame_used;
+        std::list<size_t>::iterator lru_pos;
+    };
+
+    void LoaderThread();
+    void UploadLoadedNodes();
+    void SelectNodes(const OpenGlRenderState& cam, const Viewport& viewport, std::vector<size_t>& selected);
+    void EvictUnusedNodes();
+    void MarkUsed(GpuNode& gpu);
+
+    PointOctreeFile file;
+    size_t gpu_budget_bytes;
+
+    // Owned by the render thread
+    std::map<size_t, GpuNode> resident;
+    std::list<size_t> lru; // resident nodes, least recently used first
+    size_t resident_bytes;
+    size_t frame;
+    size_t points_rendered;
+
+    // Shared with the loader thread
+    std::mutex lock;
+    std::condition_variable cond;
+    std::deque<size_t> requests;
+    std::set<size_t> pending;
+    std::set<size_t> failed;
+    std::deque<std::pair<size_t, std::vector<OctreePoint>>> loaded;
+    bool should_quit;
+    std::thread loader;
+};
+
+}
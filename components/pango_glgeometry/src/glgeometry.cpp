@@ -31,9 +31,10 @@
 
 namespace pangolin {
 
-GlGeometry::Element ToGlGeometryElement(const Geometry::Element& el, GlBufferType buffertype)
+// Allocate GL buffer for el with matching attributes, optionally filling with data
+GlGeometry::Element MakeGlGeometryElement(const Geometry::Element& el, GlBufferType buffertype, uint8_t* data)
 {
-    GlGeometry::Element glel(buffertype, el.SizeBytes(), GL_STATIC_DRAW, el.ptr );
+    GlGeometry::Element glel(buffertype, el.SizeBytes(), GL_STATIC_DRAW, data );
     for(const auto& attrib_variant : el.attributes) {
         visit([&](auto&& attrib){
             using T = std::decay_t<decltype(attrib)>;
@@ -48,6 +49,11 @@ GlGeometry::Element ToGlGeometryElement(const Geometry::Element& el, GlBufferTyp
     return glel;
 }
 
+GlGeometry::Element ToGlGeometryElement(const Geometry::Element& el, GlBufferType buffertype)
+{
+    return MakeGlGeometryElement(el, buffertype, el.ptr);
+}
+
 GlGeometry ToGlGeometry(const Geometry& geom)
 {
     GlGeometry gl;
@@ -139,4 +145,69 @@ void GlDraw(GlSlProgram& prog, const GlGeometry& geom, const GlTexture* matcap)
     glActiveTexture(GL_TEXTURE0);
 }
 
+GlGeometryUploader::GlGeometryUploader(Geometry&& g)
+    : geom(std::move(g)), partial_bytes(0), total_bytes(0), bytes_uploaded(0)
+{
+    for(const auto& tex : geom.textures) {
+        items.push_back({Item::Texture, tex.first, nullptr, &tex.second});
+        total_bytes += tex.second.SizeBytes();
+    }
+    for(const auto& b : geom.buffers) {
+        items.push_back({Item::Buffer, b.first, &b.second, nullptr});
+        total_bytes += b.second.SizeBytes();
+    }
+    for(const auto& b : geom.objects) {
+        items.push_back({Item::Object, b.first, &b.second, nullptr});
+        total_bytes += b.second.SizeBytes();
+    }
+}
+
+size_t GlGeometryUploader::Upload(GlGeometry& gl, size_t budget_bytes)
+{
+    size_t uploaded = 0;
+
+    while(!items.empty() && (uploaded == 0 || uploaded < budget_bytes)) {
+        const Item& item = items.front();
+
+        if(item.type == Item::Texture) {
+            gl.textures[item.name].Load(*item.tex);
+            uploaded += item.tex->SizeBytes();
+            items.pop_front();
+            continue;
+        }
+
+        const Geometry::Element& el = *item.el;
+        if(!partial.IsValid()) {
+            partial = MakeGlGeometryElement(el, item.type == Item::Object ? GlElementArrayBuffer : GlArrayBuffer, nullptr);
+            partial_bytes = 0;
+        }
+
+        const size_t n = std::min(el.SizeBytes() - partial_bytes, std::max<size_t>(budget_bytes - uploaded, 1));
+        if(n) {
+            partial.Upload(el.ptr + partial_bytes, n, partial_bytes);
+        }
+        partial_bytes += n;
+        uploaded += n;
+
+        if(partial_bytes == el.SizeBytes()) {
+            if(item.type == Item::Object) {
+                gl.objects.emplace(item.name, std::move(partial));
+            }else{
+                gl.buffers[item.name] = std::move(partial);
+            }
+            partial = GlGeometry::Element();
+            items.pop_front();
+        }
+    }
+
+    bytes_uploaded += uploaded;
+
+    if(items.empty()) {
+        // Release CPU copy
+        geom = Geometry();
+    }
+
+    return uploaded;
+}
+
 }
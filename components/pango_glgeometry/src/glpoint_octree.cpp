@@ -0,0 +1,264 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2014 Steven Lovegrove
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <pangolin/geometry/glpoint_octree.h>
+#include <pangolin/utils/log.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <queue>
+
+namespace pangolin {
+
+namespace {
+
+// Returns true if box is entirely outside one of the clip planes of mvp
+bool OutsideFrustum(const OpenGlMatrix& mvp, const PointOctreeNode& node)
+{
+    int outside[6] = {0,0,0,0,0,0};
+    for(int i=0; i < 8; ++i) {
+        const GLprecision p[3] = {
+            (i & 4) ? node.max[0] : node.min[0],
+            (i & 2) ? node.max[1] : node.min[1],
+            (i & 1) ? node.max[2] : node.min[2]
+        };
+        GLprecision clip[4];
+        for(int r=0; r < 4; ++r) {
+            clip[r] = mvp(r,0)*p[0] + mvp(r,1)*p[1] + mvp(r,2)*p[2] + mvp(r,3);
+        }
+        for(int d=0; d < 3; ++d) {
+            outside[2*d]   += clip[d] < -clip[3];
+            outside[2*d+1] += clip[d] >  clip[3];
+        }
+    }
+    for(int plane=0; plane < 6; ++plane) {
+        if(outside[plane] == 8) return true;
+    }
+    return false;
+}
+
+// Approximate height in pixels of node's bounding sphere
+float ProjectedPixels(const OpenGlMatrix& P, const OpenGlMatrix& MV, const Viewport& viewport, const PointOctreeNode& node)
+{
+    GLprecision centre[3];
+    GLprecision radius = 0;
+    for(int d=0; d < 3; ++d) {
+        centre[d] = (node.min[d] + node.max[d]) / 2;
+        radius += (node.max[d] - node.min[d]) * (node.max[d] - node.min[d]) / 4;
+    }
+    radius = std::sqrt(radius);
+
+    const GLprecision scale = radius * P(1,1) * viewport.h / 2;
+    if(P(3,2) == 0) {
+        // Orthographic
+        return (float)scale;
+    }
+
+    const GLprecision depth = -(MV(2,0)*centre[0] + MV(2,1)*centre[1] + MV(2,2)*centre[2] + MV(2,3));
+    if(depth <= radius) {
+        // Camera inside (or very near) the node
+        return std::numeric_limits<float>::max();
+    }
+    return (float)(scale / depth);
+}
+
+}
+
+GlPointOctree::GlPointOctree(const std::string& filename, size_t gpu_budget_bytes)
+    : file(filename), gpu_budget_bytes(gpu_budget_bytes),
+      resident_bytes(0), frame(0), points_rendered(0), should_quit(false)
+{
+    loader = std::thread(&GlPointOctree::LoaderThread, this);
+}
+
+GlPointOctree::~GlPointOctree()
+{
+    {
+        std::lock_guard<std::mutex> l(lock);
+        should_quit = true;
+    }
+    cond.notify_all();
+    loader.join();
+}
+
+void GlPointOctree::LoaderThread()
+{
+    std::unique_lock<std::mutex> l(lock);
+    while(true) {
+        cond.wait(l, [&](){ return should_quit || !requests.empty(); });
+        if(should_quit) break;
+
+        const size_t node = requests.front();
+        requests.pop_front();
+        pending.insert(node);
+
+        l.unlock();
+        std::vector<OctreePoint> points;
+        try {
+            points = file.LoadNode(node);
+        }catch(const std::exception& e) {
+            // e.g. truncated or corrupt file. Keep drawing what we have.
+            pango_print_error("GlPointOctree: unable to load node %zu: %s\n", node, e.what());
+            l.lock();
+            pending.erase(node);
+            failed.insert(node);
+            continue;
+        }
+        l.lock();
+
+        loaded.emplace_back(node, std::move(points));
+    }
+}
+
+void GlPointOctree::UploadLoadedNodes()
+{
+    for(size_t i=0; i < max_uploads_per_frame; ++i) {
+        std::pair<size_t, std::vector<OctreePoint>> node;
+        {
+            std::lock_guard<std::mutex> l(lock);
+            if(loaded.empty()) break;
+            node = std::move(loaded.front());
+            loaded.pop_front();
+            pending.erase(node.first);
+        }
+
+        auto ins = resident.emplace(node.first, GpuNode());
+        GpuNode& gpu = ins.first->second;
+        if(ins.second) {
+            gpu.lru_pos = lru.insert(lru.end(), node.first);
+        }else{
+            resident_bytes -= gpu.buffer.SizeBytes();
+        }
+        gpu.buffer.Reinitialise(GlArrayBuffer, (GLuint)node.second.size(), GL_UNSIGNED_BYTE, sizeof(OctreePoint), GL_STATIC_DRAW, node.second.data());
+        resident_bytes += gpu.buffer.SizeBytes();
+        MarkUsed(gpu);
+    }
+}
+
+void GlPointOctree::MarkUsed(GpuNode& gpu)
+{
+    gpu.last_frame_used = frame;
+    lru.splice(lru.end(), lru, gpu.lru_pos);
+}
+
+void GlPointOctree::SelectNodes(const OpenGlRenderState& cam, const Viewport& viewport, std::vector<size_t>& selected)
+{
+    const OpenGlMatrix P = cam.GetProjectionMatrix();
+    const OpenGlMatrix MV = cam.GetModelViewMatrix();
+    const OpenGlMatrix mvp = P * MV;
+    const std::vector<PointOctreeNode>& nodes = file.Nodes();
+
+    // Largest nodes on screen first
+    std::priority_queue<std::pair<float,size_t>> queue;
+    if(!nodes.empty() && !OutsideFrustum(mvp, nodes[0])) {
+        queue.emplace(std::numeric_limits<float>::max(), 0);
+    }
+
+    size_t num_points = 0;
+    while(!queue.empty()) {
+        const size_t n = queue.top().second;
+        queue.pop();
+
+        const PointOctreeNode& node = nodes[n];
+        if(num_points + node.num_points > point_budget) break;
+        num_points += node.num_points;
+        selected.push_back(n);
+
+        for(int c=0; c < 8; ++c) {
+            if(node.children[c] < 0) continue;
+            const PointOctreeNode& child = nodes[node.children[c]];
+            if(OutsideFrustum(mvp, child)) continue;
+            const float pixels = ProjectedPixels(P, MV, viewport, child);
+            if(pixels >= min_node_pixels) {
+                queue.emplace(pixels, node.children[c]);
+            }
+        }
+    }
+}
+
+void GlPointOctree::EvictUnusedNodes()
+{
+    while(resident_bytes > gpu_budget_bytes && !lru.empty()) {
+        auto it = resident.find(lru.front());
+        // Everything left is needed for this frame
+        if(it->second.last_frame_used == frame) break;
+
+        resident_bytes -= it->second.buffer.SizeBytes();
+        lru.pop_front();
+        resident.erase(it);
+    }
+}
+
+void GlPointOctree::Render(const OpenGlRenderState& cam, const Viewport& viewport)
+{
+    ++frame;
+    UploadLoadedNodes();
+
+    std::vector<size_t> selected;
+    SelectNodes(cam, viewport, selected);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+
+    points_rendered = 0;
+    std::deque<size_t> missing;
+    for(size_t n : selected) {
+        auto it = resident.find(n);
+        if(it == resident.end()) {
+            missing.push_back(n);
+            continue;
+        }
+
+        GpuNode& gpu = it->second;
+        MarkUsed(gpu);
+        gpu.buffer.Bind();
+        glVertexPointer(3, GL_FLOAT, sizeof(OctreePoint), 0);
+        glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(OctreePoint), (void*)offsetof(OctreePoint, r));
+        glDrawArrays(GL_POINTS, 0, gpu.buffer.num_elements);
+        gpu.buffer.Unbind();
+        points_rendered += gpu.buffer.num_elements;
+    }
+
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    EvictUnusedNodes();
+
+    // Replace stale requests with what this view is missing, most important first
+    {
+        std::lock_guard<std::mutex> l(lock);
+        requests.clear();
+        for(size_t n : missing) {
+            if(!pending.count(n) && !failed.count(n)) requests.push_back(n);
+        }
+    }
+    cond.notify_one();
+}
+
+}
@@ -43,6 +43,21 @@ TypedImage LoadImage(const std::string& filename, ImageFileType file_type);
 PANGOLIN_EXPORT
 TypedImage LoadImage(const std::string& filename);
 
+/// Format and dimensions of an image file, as reported by its header
+struct ImageFileInfo
+{
+    PixelFormat fmt;
+    size_t w = 0;
+    size_t h = 0;
+    size_t pitch = 0;
+};
+
+/// Fill \param info from the header of \param filename without decoding
+/// pixel data. Returns false for file types which can't report this cheaply,
+/// in which case the image must be loaded instead.
+PANGOLIN_EXPORT
+bool LoadImageInfo(const std::string& filename, ImageFileType file_type, ImageFileInfo& info);
+
 PANGOLIN_EXPORT
 TypedImage LoadImage(const std::string& filename, const PixelFormat& raw_plane_fmt, size_t raw_width, size_t raw_height, size_t raw_pitch, size_t offset = 0, size_t image_planes = 1);
 
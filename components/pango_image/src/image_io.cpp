@@ -33,14 +33,17 @@ namespace pangolin {
 
 // PNG
 TypedImage LoadPng(std::istream& in);
+bool LoadPngInfo(std::istream& in, ImageFileInfo& info);
 void SavePng(const Image<unsigned char>& image, const pangolin::PixelFormat& fmt, std::ostream& out, bool top_line_first, int zlib_compression_level );
 
 // JPG
 TypedImage LoadJpg(std::istream& in);
+bool LoadJpgInfo(std::istream& in, ImageFileInfo& info);
 void SaveJpg(const Image<unsigned char>& image, const pangolin::PixelFormat& fmt, std::ostream& out, float quality);
 
 // PPM
 TypedImage LoadPpm(std::istream& in);
+bool LoadPpmInfo(std::istream& in, ImageFileInfo& info);
 void SavePpm(const Image<unsigned char>& image, const pangolin::PixelFormat& fmt, std::ostream& out, bool top_line_first);
 
 // TGA
@@ -129,6 +132,28 @@ TypedImage LoadImage(const std::string& filename, ImageFileType file_type)
     }
 }
 
+bool LoadImageInfo(const std::string& filename, ImageFileType file_type, ImageFileInfo& info)
+{
+    std::ifstream ifs(filename, std::ios_base::in|std::ios_base::binary);
+    if(!ifs.is_open()) return false;
+
+    try {
+        switch (file_type) {
+        case ImageFileTypePng:
+            return LoadPngInfo(ifs, info);
+        case ImageFileTypeJpg:
+            return LoadJpgInfo(ifs, info);
+        case ImageFileTypePpm:
+            return LoadPpmInfo(ifs, info);
+        default:
+            return false;
+        }
+    } catch (const std::exception&) {
+        // Unsupported variants are reported when the image is loaded
+        return false;
+    }
+}
+
 TypedImage LoadImage(const std::string& filename)
 {
     ImageFileType file_type = FileType(filename);
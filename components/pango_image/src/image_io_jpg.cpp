@@ -4,6 +4,7 @@
 
 #include <pangolin/platform.h>
 
+#include <pangolin/image/image_io.h>
 #include <pangolin/image/typed_image.h>
 
 #ifdef HAVE_JPEG
@@ -158,6 +159,40 @@ void pango_jpeg_set_dest_mgr(j_compress_ptr cinfo, std::ostream& os) {
 
 #endif // HAVE_JPEG
 
+bool LoadJpgInfo(std::istream& is, ImageFileInfo& info) {
+#ifdef HAVE_JPEG
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+
+    cinfo.err = jpeg_std_error(&jerr);
+    jerr.error_exit = error_handler;
+    jpeg_create_decompress(&cinfo);
+    pango_jpeg_set_source_mgr(&cinfo, is);
+
+    // Only the header is read, output dimensions follow from it.
+    bool good = false;
+    try {
+        if (jpeg_read_header(&cinfo, TRUE) == JPEG_HEADER_OK &&
+            (cinfo.num_components == 3 || cinfo.num_components == 1)) {
+            jpeg_calc_output_dimensions(&cinfo);
+            info.fmt = PixelFormatFromString(cinfo.output_components == 3 ? "RGB24" : "GRAY8");
+            info.w = cinfo.output_width;
+            info.h = cinfo.output_height;
+            info.pitch = info.w * cinfo.output_components;
+            good = true;
+        }
+    } catch (const std::exception&) {
+    }
+
+    jpeg_destroy_decompress(&cinfo);
+    return good;
+#else
+    PANGOLIN_UNUSED(is);
+    PANGOLIN_UNUSED(info);
+    return false;
+#endif
+}
+
 TypedImage LoadJpg(std::istream& is) {
 #ifdef HAVE_JPEG
     TypedImage image;
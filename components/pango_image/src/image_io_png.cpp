@@ -71,6 +71,55 @@ void pango_png_stream_write_flush(png_structp pngPtr)
 #endif // HAVE_PNG
 
 
+bool LoadPngInfo(std::istream& source, ImageFileInfo& info)
+{
+#ifdef HAVE_PNG
+    if (!pango_png_validate(source)) {
+        return false;
+    }
+
+    png_structp png_ptr = png_create_read_struct( PNG_LIBPNG_VER_STRING, (png_voidp)NULL, NULL, &PngWarningsCallback);
+    if (!png_ptr) {
+        return false;
+    }
+
+    png_infop info_ptr = png_create_info_struct(png_ptr);
+    if (!info_ptr)  {
+        png_destroy_read_struct(&png_ptr, (png_infopp)NULL, (png_infopp)NULL);
+        return false;
+    }
+
+    png_set_read_fn(png_ptr,(png_voidp)&source, pango_png_stream_read);
+    png_set_sig_bytes(png_ptr, PNGSIGSIZE);
+
+    // Reads chunks up to the first image data only
+    volatile bool good = false;
+    if (!setjmp(png_jmpbuf(png_ptr))) {
+        png_read_info(png_ptr, info_ptr);
+        if( png_get_interlace_type(png_ptr,info_ptr) == PNG_INTERLACE_NONE &&
+            png_get_bit_depth(png_ptr, info_ptr) >= 8 &&
+            png_get_color_type(png_ptr, info_ptr) != PNG_COLOR_TYPE_PALETTE )
+        {
+            try {
+                info.fmt = PngFormat(png_ptr, info_ptr);
+                info.w = png_get_image_width(png_ptr,info_ptr);
+                info.h = png_get_image_height(png_ptr,info_ptr);
+                info.pitch = png_get_rowbytes(png_ptr, info_ptr);
+                good = true;
+            } catch (const std::exception&) {
+            }
+        }
+    }
+
+    png_destroy_read_struct(&png_ptr, &info_ptr, (png_infopp)NULL);
+    return good;
+#else
+    PANGOLIN_UNUSED(source);
+    PANGOLIN_UNUSED(info);
+    return false;
+#endif // HAVE_PNG
+}
+
 TypedImage LoadPng(std::istream& source)
 {
 #ifdef HAVE_PNG
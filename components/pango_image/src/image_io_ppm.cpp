@@ -1,4 +1,5 @@
 #include <fstream>
+#include <pangolin/image/image_io.h>
 #include <pangolin/image/typed_image.h>
 
 namespace pangolin {
@@ -26,14 +27,8 @@ void PpmConsumeWhitespaceAndComments(std::istream& in)
     while( in.peek() == '#' )  in.ignore(4096, '\n');
 }
 
-TypedImage LoadPpm(std::istream& in)
+bool PpmReadHeader(std::istream& in, std::string& ppm_type, int& num_colors, int& w, int& h)
 {
-    // Parse header
-    std::string ppm_type = "";
-    int num_colors = 0;
-    int w = 0;
-    int h = 0;
-
     in >> ppm_type;
     PpmConsumeWhitespaceAndComments(in);
     in >> w;
@@ -43,7 +38,35 @@ TypedImage LoadPpm(std::istream& in)
     in >> num_colors;
     in.ignore(1,'\n');
 
-    if(!in.fail() && w > 0 && h > 0) {
+    return !in.fail() && w > 0 && h > 0;
+}
+
+bool LoadPpmInfo(std::istream& in, ImageFileInfo& info)
+{
+    std::string ppm_type = "";
+    int num_colors = 0;
+    int w = 0;
+    int h = 0;
+
+    if(PpmReadHeader(in, ppm_type, num_colors, w, h)) {
+        info.fmt = PpmFormat(ppm_type, num_colors);
+        info.w = w;
+        info.h = h;
+        info.pitch = info.w * info.fmt.bpp / 8;
+        return true;
+    }
+    return false;
+}
+
+TypedImage LoadPpm(std::istream& in)
+{
+    // Parse header
+    std::string ppm_type = "";
+    int num_colors = 0;
+    int w = 0;
+    int h = 0;
+
+    if(PpmReadHeader(in, ppm_type, num_colors, w, h)) {
         TypedImage img(w, h, PpmFormat(ppm_type, num_colors) );
 
         // Read in data
@@ -213,6 +213,13 @@ struct PANGOLIN_EXPORT GlBufferData
     void Unbind() const;
     void Upload(const GLvoid* data, GLsizeiptr size_bytes, GLintptr offset = 0);
     void Download(GLvoid* ptr, GLsizeiptr size_bytes, GLintptr offset = 0) const;
+
+#ifndef HAVE_GLES
+    //! Map size_bytes from offset into client memory with GL_MAP_*_BIT access.
+    //! The pointer is valid until Unmap(), which must precede any GL use of the buffer.
+    void* Map(GLintptr offset, GLsizeiptr size_bytes, GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    void Unmap();
+#endif
     
 
     template<typename T>
@@ -316,6 +323,7 @@ size_t GlFormatChannels(GLenum data_layout);
 
 size_t GlDataTypeBytes(GLenum type);
 
+// Blocking read of v from GL_BACK. See GlReadbackQueue to read without waiting.
 TypedImage ReadFramebuffer(const Viewport& v, const std::string& pixel_format = "RGBA32");
 
 }
@@ -29,6 +29,7 @@
 
 #include <pangolin/gl/gl.h>
 #include <pangolin/gl/glpixformat.h>
+#include <pangolin/gl/glprofiler.h>
 #include <pangolin/image/image_io.h>
 #include <pangolin/utils/type_convert.h>
 #include <algorithm>
@@ -206,6 +207,7 @@ inline void GlTexture::Upload(
     const void* data,
     GLenum data_format, GLenum data_type
 ) {
+    GlProfileScope profile("GlTexture::Upload");
     Bind();
     glTexSubImage2D(GL_TEXTURE_2D,0,0,0,width,height,data_format,data_type,data);
     CheckGlDieOnError();
@@ -217,6 +219,7 @@ inline void GlTexture::Upload(
     GLsizei data_w, GLsizei data_h,
     GLenum data_format, GLenum data_type )
 {
+    GlProfileScope profile("GlTexture::Upload");
     Bind();
     glTexSubImage2D(GL_TEXTURE_2D,0,tex_x_offset,tex_y_offset,data_w,data_h,data_format,data_type,data);
     CheckGlDieOnError();
@@ -224,6 +227,7 @@ inline void GlTexture::Upload(
 
 inline void GlTexture::Load(const TypedImage& image, bool sampling_linear)
 {
+    GlProfileScope profile("GlTexture::Upload");
     GlPixFormat fmt(image.fmt);
     Reinitialise((GLint)image.w, (GLint)image.h, fmt.scalable_internal_format, sampling_linear, 0, fmt.glformat, fmt.gltype, image.ptr );
 }
@@ -231,6 +235,7 @@ inline void GlTexture::Load(const TypedImage& image, bool sampling_linear)
 template<typename T>
 void GlTexture::Load(const Image<T>& image, bool sampling_linear)
 {
+    GlProfileScope profile("GlTexture::Upload");
     using GlFmt = GlFormatTraits<T>;
 
     Reinitialise(
@@ -788,6 +793,31 @@ inline void GlBufferData::Download(GLvoid* data, GLsizeiptr size_bytes, GLintptr
     Unbind();
 }
 
+#ifndef HAVE_GLES
+inline void* GlBufferData::Map(GLintptr offset, GLsizeiptr size_bytes, GLbitfield access)
+{
+    if(offset < 0 || size_bytes < 0 || offset + size_bytes > this->size_bytes) {
+        throw std::runtime_error("GlBufferData: Trying to map past capacity.");
+    }
+
+    Bind();
+    void* ptr = glMapBufferRange(buffer_type, offset, size_bytes, access);
+    Unbind();
+
+    if(!ptr) {
+        throw std::runtime_error("GlBufferData: Unable to map buffer.");
+    }
+    return ptr;
+}
+
+inline void GlBufferData::Unmap()
+{
+    Bind();
+    glUnmapBuffer(buffer_type);
+    Unbind();
+}
+#endif
+
 template<typename T>
 inline void GlBufferData::Upload(const std::vector<T>& data, GLintptr offset)
 {
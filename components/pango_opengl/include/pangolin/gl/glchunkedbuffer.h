@@ -0,0 +1,317 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <pangolin/gl/gl.h>
+#include <cstring>
+#include <vector>
+
+namespace pangolin
+{
+
+////////////////////////////////////////////////
+// Interface
+////////////////////////////////////////////////
+
+// Append-only vertex data (e.g. a growing trajectory or map) stored as a
+// sequence of fixed-size GL buffers. Unlike GlSizeableBuffer, nothing already
+// on the GPU is ever reallocated or copied when it grows. Added elements are
+// staged on the CPU and uploaded in one glBufferSubData per touched chunk
+// when Flush() is called, which RenderChunkedVbo does once per frame.
+//
+// Each chunk holds a multiple of 6 added elements, so that lists of lines or
+// triangles never straddle two chunks. Each chunk after the first also begins
+// with copies of the last two elements of the chunk before, so that line and
+// triangle strips remain connected (with consistent winding) across chunk
+// boundaries. Loops and fans are not joined between chunks.
+class GlChunkedBuffer
+{
+public:
+    //! Elements at the start of each chunk after the first copied from the
+    //! end of the chunk before
+    static constexpr size_t chunk_overlap = 2;
+
+    GlChunkedBuffer(GlBufferType buffer_type, GLenum datatype, GLuint count_per_element, GLuint chunk_num_elements = 1 << 20, GLenum gluse = GL_DYNAMIC_DRAW);
+
+    GlChunkedBuffer(const GlChunkedBuffer&) = delete;
+
+    //! Stage num_elements elements for upload on next Flush()
+    void Add(const void* data, size_t num_elements);
+
+    template<typename T>
+    void Add(const std::vector<T>& data);
+
+#ifdef USE_EIGEN
+    //! Stage each column of vec as an element
+    template<typename Derived>
+    void Add(const Eigen::DenseBase<Derived>& vec);
+#endif
+
+    //! Upload all staged elements, allocating new chunks as required
+    void Flush();
+
+    //! Forget all elements, keeping chunks allocated for reuse
+    void Clear();
+
+    //! Number of elements added, including those not yet flushed
+    size_t size() const;
+
+    size_t NumChunks() const;
+
+    //! Chunk i. The first chunk_overlap elements of chunks after the first
+    //! duplicate the end of the previous chunk.
+    const GlBuffer& Chunk(size_t i) const;
+
+    //! Number of valid elements in uploaded chunk i, including any overlap
+    size_t ChunkSize(size_t i) const;
+
+    //! Number of added elements each chunk holds, excluding any overlap
+    size_t ChunkCapacity() const;
+
+    size_t ElementBytes() const;
+
+    //! Range of the chunk_size elements in chunk i to draw with primitive mode
+    //! so that, drawn in order, the chunks render as one contiguous array.
+    static void ChunkDrawRange(GLenum mode, size_t i, size_t chunk_size, GLint& first, GLsizei& count);
+
+protected:
+    //! Upload all staged elements, calling upload(chunk, data, num_elements,
+    //! first_element) for each write into a chunk.
+    template<typename F>
+    void FlushTo(F upload);
+
+    GlBufferType buffer_type;
+    GLenum datatype;
+    GLuint count_per_element;
+    size_t chunk_capacity;
+    GLenum gluse;
+
+    std::vector<GlBuffer> chunks;
+    std::vector<size_t> chunk_sizes;
+    size_t num_chunks_used;
+    size_t num_uploaded;
+
+    std::vector<unsigned char> staged;
+
+    // Up to the last chunk_overlap elements uploaded
+    std::vector<unsigned char> tail;
+};
+
+void RenderChunkedVbo(GlChunkedBuffer& vbo, GLenum mode = GL_POINTS);
+
+// vbo and cbo must have the same chunk size and number of elements
+void RenderChunkedVboCbo(GlChunkedBuffer& vbo, GlChunkedBuffer& cbo, bool draw_color = true, GLenum mode = GL_POINTS);
+
+////////////////////////////////////////////////
+// Implementation
+////////////////////////////////////////////////
+
+inline GlChunkedBuffer::GlChunkedBuffer(GlBufferType buffer_type, GLenum datatype, GLuint count_per_element, GLuint chunk_num_elements, GLenum gluse)
+    : buffer_type(buffer_type), datatype(datatype), count_per_element(count_per_element),
+      chunk_capacity(std::max<size_t>(6, (std::max<size_t>(chunk_num_elements, chunk_overlap) - chunk_overlap) / 6 * 6)), gluse(gluse),
+      num_chunks_used(0), num_uploaded(0)
+{
+}
+
+inline void GlChunkedBuffer::Add(const void* data, size_t num_elements)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    staged.insert(staged.end(), bytes, bytes + num_elements * ElementBytes());
+}
+
+template<typename T>
+inline void GlChunkedBuffer::Add(const std::vector<T>& data)
+{
+    assert( (data.size() * sizeof(T)) % ElementBytes() == 0 );
+    Add(data.data(), data.size() * sizeof(T) / ElementBytes());
+}
+
+#ifdef USE_EIGEN
+template<typename Derived>
+inline void GlChunkedBuffer::Add(const Eigen::DenseBase<Derived>& vec)
+{
+    typedef typename Eigen::DenseBase<Derived>::Scalar Scalar;
+    assert(vec.rows()==count_per_element);
+    assert(sizeof(Scalar)==GlDataTypeBytes(datatype));
+    // Evaluate into contiguous column-major storage
+    const typename Derived::PlainObject plain = vec.derived();
+    Add(plain.data(), plain.cols());
+}
+#endif
+
+template<typename F>
+inline void GlChunkedBuffer::FlushTo(F upload)
+{
+    const size_t element_bytes = ElementBytes();
+    const size_t num_staged = staged.size() / element_bytes;
+    size_t done = 0;
+
+    while(done < num_staged) {
+        if(num_chunks_used == 0 || chunk_sizes[num_chunks_used-1] == chunk_capacity + (num_chunks_used > 1 ? chunk_overlap : 0)) {
+            // Start a new chunk, reusing any left over from before Clear()
+            if(num_chunks_used == chunk_sizes.size()) {
+                chunk_sizes.push_back(0);
+            }
+            chunk_sizes[num_chunks_used] = 0;
+            if(num_chunks_used > 0) {
+                upload(num_chunks_used, tail.data(), chunk_overlap, (size_t)0);
+                chunk_sizes[num_chunks_used] = chunk_overlap;
+            }
+            ++num_chunks_used;
+        }
+
+        const size_t i = num_chunks_used-1;
+        const size_t chunk_end = chunk_capacity + (i > 0 ? chunk_overlap : 0);
+        const size_t n = std::min(num_staged - done, chunk_end - chunk_sizes[i]);
+        const unsigned char* data = staged.data() + done * element_bytes;
+        upload(i, data, n, chunk_sizes[i]);
+        chunk_sizes[i] += n;
+        done += n;
+
+        // Keep what the next chunk would need to carry over
+        const size_t keep = std::min(n, chunk_overlap);
+        tail.insert(tail.end(), data + (n - keep) * element_bytes, data + n * element_bytes);
+        if(tail.size() > chunk_overlap * element_bytes) {
+            tail.erase(tail.begin(), tail.end() - chunk_overlap * element_bytes);
+        }
+    }
+
+    num_uploaded += num_staged;
+    staged.clear();
+}
+
+inline void GlChunkedBuffer::Flush()
+{
+    const size_t element_bytes = ElementBytes();
+    FlushTo([&](size_t i, const unsigned char* data, size_t num_elements, size_t first_element){
+        if(i == chunks.size()) {
+            chunks.emplace_back(buffer_type, chunk_capacity + chunk_overlap, datatype, count_per_element, gluse);
+        }
+        chunks[i].Upload(data, num_elements * element_bytes, first_element * element_bytes);
+    });
+}
+
+inline void GlChunkedBuffer::Clear()
+{
+    num_chunks_used = 0;
+    num_uploaded = 0;
+    staged.clear();
+    tail.clear();
+}
+
+inline size_t GlChunkedBuffer::size() const
+{
+    return num_uploaded + staged.size() / ElementBytes();
+}
+
+inline size_t GlChunkedBuffer::NumChunks() const
+{
+    return num_chunks_used;
+}
+
+inline const GlBuffer& GlChunkedBuffer::Chunk(size_t i) const
+{
+    return chunks[i];
+}
+
+inline size_t GlChunkedBuffer::ChunkSize(size_t i) const
+{
+    return chunk_sizes[i];
+}
+
+inline size_t GlChunkedBuffer::ChunkCapacity() const
+{
+    return chunk_capacity;
+}
+
+inline size_t GlChunkedBuffer::ElementBytes() const
+{
+    return count_per_element * GlDataTypeBytes(datatype);
+}
+
+inline void GlChunkedBuffer::ChunkDrawRange(GLenum mode, size_t i, size_t chunk_size, GLint& first, GLsizei& count)
+{
+    if(i == 0) {
+        first = 0;
+    }else if(mode == GL_TRIANGLE_STRIP) {
+        // Chunks start at an even element, so winding order is unchanged
+        first = 0;
+    }else if(mode == GL_LINE_STRIP) {
+        first = chunk_overlap - 1;
+    }else{
+        first = chunk_overlap;
+    }
+    count = (GLsizei)chunk_size - first;
+}
+
+inline void RenderChunkedVbo(GlChunkedBuffer& vbo, GLenum mode)
+{
+    vbo.Flush();
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    for(size_t i=0; i < vbo.NumChunks(); ++i) {
+        GLint first;
+        GLsizei count;
+        GlChunkedBuffer::ChunkDrawRange(mode, i, vbo.ChunkSize(i), first, count);
+        vbo.Chunk(i).Bind();
+        glVertexPointer(vbo.Chunk(i).count_per_element, vbo.Chunk(i).datatype, 0, 0);
+        glDrawArrays(mode, first, count);
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+inline void RenderChunkedVboCbo(GlChunkedBuffer& vbo, GlChunkedBuffer& cbo, bool draw_color, GLenum mode)
+{
+    if(!draw_color) {
+        RenderChunkedVbo(vbo, mode);
+        return;
+    }
+
+    vbo.Flush();
+    cbo.Flush();
+    assert(vbo.NumChunks() == cbo.NumChunks());
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    for(size_t i=0; i < vbo.NumChunks(); ++i) {
+        GLint first;
+        GLsizei count;
+        GlChunkedBuffer::ChunkDrawRange(mode, i, std::min(vbo.ChunkSize(i), cbo.ChunkSize(i)), first, count);
+        cbo.Chunk(i).Bind();
+        glColorPointer(cbo.Chunk(i).count_per_element, cbo.Chunk(i).datatype, 0, 0);
+        vbo.Chunk(i).Bind();
+        glVertexPointer(vbo.Chunk(i).count_per_element, vbo.Chunk(i).datatype, 0, 0);
+        glDrawArrays(mode, first, count);
+    }
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+}
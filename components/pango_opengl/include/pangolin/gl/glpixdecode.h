@@ -0,0 +1,247 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove, Richard Newcombe
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <pangolin/gl/gl.h>
+#include <pangolin/gl/glsl.h>
+#include <pangolin/image/pixel_format.h>
+
+#include <array>
+#include <string>
+
+namespace pangolin
+{
+
+////////////////////////////////////////////////
+// Interface
+////////////////////////////////////////////////
+
+// Displays pixel formats which GlPixFormat can't describe (YUYV422, UYVY422,
+// packed GRAY10 / GRAY12) and raw Bayer mosaics, without converting on the
+// CPU first. The raw bytes are uploaded unchanged as a single channel texture
+// and a fragment shader decodes them as the image is drawn.
+class GlPixDecoder
+{
+public:
+    // Colour filter arrangement of raw images, named by its top-left 2x2 tile
+    // ("RGGB", "BGGR", "GRBG" or "GBRG"). Empty for non-Bayer images.
+    std::string bayer;
+    std::array<float,3> wb_gains = {{1.0f, 1.0f, 1.0f}};
+    float offset = 0.0f;
+    float scale = 1.0f;
+    float gamma = 1.0f;
+
+    //! True if images in fmt must be drawn via a GlPixDecoder. Grayscale
+    //! formats only do when bayer is non-empty.
+    static bool Required(const PixelFormat& fmt, const std::string& bayer = "");
+
+    //! Upload raw image bytes. w and h are in pixels, pitch in bytes.
+    void Upload(const void* ptr, size_t w, size_t h, size_t pitch, const PixelFormat& fmt);
+
+    bool IsValid() const { return raw.IsValid(); }
+
+    //! Bind decoding program and raw texture (to unit 0) for drawing texture
+    //! coordinates [0,1]^2 across the image, as GlTexture::RenderToViewport
+    //! or ImageViewHandler::glRenderTexture do.
+    void Bind();
+
+    void Unbind();
+
+    size_t width = 0;
+    size_t height = 0;
+    GlTexture raw;
+
+private:
+    enum RawFormat { Gray8=0, Gray16=1, Gray10p=2, Gray12p=3, Yuyv=4, Uyvy=5 };
+
+    static RawFormat RawFormatFor(const PixelFormat& fmt);
+    void Compile();
+
+    RawFormat raw_format = Gray8;
+    GlSlProgram prog;
+};
+
+////////////////////////////////////////////////
+// Implementation
+////////////////////////////////////////////////
+
+inline GlPixDecoder::RawFormat GlPixDecoder::RawFormatFor(const PixelFormat& fmt)
+{
+    if(fmt.format == "GRAY8")    return Gray8;
+    if(fmt.format == "GRAY16LE") return Gray16;
+    if(fmt.format == "GRAY10")   return Gray10p;
+    if(fmt.format == "GRAY12")   return Gray12p;
+    if(fmt.format == "YUYV422")  return Yuyv;
+    if(fmt.format == "UYVY422")  return Uyvy;
+    throw std::runtime_error("GlPixDecoder: Unsupported format '" + fmt.format + "'");
+}
+
+inline bool GlPixDecoder::Required(const PixelFormat& fmt, const std::string& bayer)
+{
+    if(fmt.format == "GRAY10" || fmt.format == "GRAY12" ||
+       fmt.format == "YUYV422" || fmt.format == "UYVY422") {
+        return true;
+    }
+    return !bayer.empty() && (fmt.format == "GRAY8" || fmt.format == "GRAY16LE");
+}
+
+inline void GlPixDecoder::Upload(const void* ptr, size_t w, size_t h, size_t pitch, const PixelFormat& fmt)
+{
+    raw_format = RawFormatFor(fmt);
+    width = w;
+    height = h;
+
+    const GLint row_bytes = (GLint)((w * fmt.bpp + 7) / 8);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)pitch);
+    if(!raw.IsValid() || raw.width != row_bytes || raw.height != (GLint)h) {
+        raw.Reinitialise(row_bytes, (GLint)h, GL_R8, false, 0, GL_RED, GL_UNSIGNED_BYTE, (GLvoid*)ptr);
+    }else{
+        raw.Upload(ptr, GL_RED, GL_UNSIGNED_BYTE);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+inline void GlPixDecoder::Compile()
+{
+    // Bytes are fetched exactly with texelFetch, so the texture needs no
+    // integer format and its filter settings don't matter.
+    const char* source =
+        "#version 130\n"
+        "uniform sampler2D raw;\n"
+        "uniform int raw_format;\n"
+        "uniform ivec2 size;\n"
+        "uniform ivec2 red;\n"
+        "uniform bool bayer;\n"
+        "uniform vec3 wb;\n"
+        "uniform float offset;\n"
+        "uniform float scale;\n"
+        "uniform float inv_gamma;\n"
+        "\n"
+        "int Byte(int x, int y) {\n"
+        "  return int(texelFetch(raw, ivec2(x,y), 0).r * 255.0 + 0.5);\n"
+        "}\n"
+        "\n"
+        "// Packed little-endian value of 'bits' starting at bit offset\n"
+        "int Packed(int bit, int bits, int y) {\n"
+        "  int v = Byte(bit/8, y) | (Byte(bit/8 + 1, y) << 8);\n"
+        "  return (v >> (bit - 8*(bit/8))) & ((1 << bits) - 1);\n"
+        "}\n"
+        "\n"
+        "float Gray(ivec2 p) {\n"
+        "  // Stay on the same mosaic colour when stepping off the edge\n"
+        "  if(p.x < 0) p.x += 2; else if(p.x >= size.x) p.x -= 2;\n"
+        "  if(p.y < 0) p.y += 2; else if(p.y >= size.y) p.y -= 2;\n"
+        "  if(raw_format == 0) return float(Byte(p.x, p.y)) / 255.0;\n"
+        "  if(raw_format == 1) return float(Byte(2*p.x, p.y) | (Byte(2*p.x+1, p.y) << 8)) / 65535.0;\n"
+        "  if(raw_format == 2) return float(Packed(10*p.x, 10, p.y)) / 1023.0;\n"
+        "  return float(Packed(12*p.x, 12, p.y)) / 4095.0;\n"
+        "}\n"
+        "\n"
+        "vec3 Yuv(ivec2 p) {\n"
+        "  int base = 4*(p.x/2);\n"
+        "  int odd = p.x - 2*(p.x/2);\n"
+        "  float y, u, v;\n"
+        "  if(raw_format == 4) {\n"
+        "    y = float(Byte(base + 2*odd, p.y)); u = float(Byte(base+1, p.y)); v = float(Byte(base+3, p.y));\n"
+        "  }else{\n"
+        "    y = float(Byte(base + 2*odd + 1, p.y)); u = float(Byte(base, p.y)); v = float(Byte(base+2, p.y));\n"
+        "  }\n"
+        "  // BT.601, limited range\n"
+        "  y = 1.164 * (y - 16.0); u -= 128.0; v -= 128.0;\n"
+        "  return vec3(y + 1.596*v, y - 0.392*u - 0.813*v, y + 2.017*u) / 255.0;\n"
+        "}\n"
+        "\n"
+        "vec3 Debayer(ivec2 p) {\n"
+        "  float c = Gray(p);\n"
+        "  float cross = 0.25 * (Gray(p+ivec2(-1,0)) + Gray(p+ivec2(1,0)) + Gray(p+ivec2(0,-1)) + Gray(p+ivec2(0,1)));\n"
+        "  float diag  = 0.25 * (Gray(p+ivec2(-1,-1)) + Gray(p+ivec2(1,-1)) + Gray(p+ivec2(-1,1)) + Gray(p+ivec2(1,1)));\n"
+        "  float horiz = 0.5 * (Gray(p+ivec2(-1,0)) + Gray(p+ivec2(1,0)));\n"
+        "  float vert  = 0.5 * (Gray(p+ivec2(0,-1)) + Gray(p+ivec2(0,1)));\n"
+        "  ivec2 parity = p - 2*(p/2);\n"
+        "  if(parity == red)                      return vec3(c, cross, diag);\n"
+        "  if(parity == ivec2(1,1) - red)         return vec3(diag, cross, c);\n"
+        "  if(parity.y == red.y)                  return vec3(horiz, c, vert);\n"
+        "  return vec3(vert, c, horiz);\n"
+        "}\n"
+        "\n"
+        "void main() {\n"
+        "  vec2 uv = gl_TexCoord[0].st;\n"
+        "  if(uv.x < 0.0 || uv.x > 1.0 || uv.y < 0.0 || uv.y > 1.0) {\n"
+        "    gl_FragColor = vec4(0.1, 0.1, 0.1, 1.0);\n"
+        "    return;\n"
+        "  }\n"
+        "  ivec2 p = min(ivec2(uv * vec2(size)), size - ivec2(1));\n"
+        "  vec3 rgb;\n"
+        "  if(raw_format >= 4) rgb = Yuv(p);\n"
+        "  else if(bayer)      rgb = wb * Debayer(p);\n"
+        "  else                rgb = vec3(Gray(p));\n"
+        "  rgb = pow(max((rgb + vec3(offset)) * scale, vec3(0.0)), vec3(inv_gamma));\n"
+        "  gl_FragColor = vec4(rgb, 1.0);\n"
+        "}\n";
+    prog.AddShader(GlSlFragmentShader, source);
+    prog.Link();
+}
+
+inline void GlPixDecoder::Bind()
+{
+    if(!prog.Valid()) Compile();
+
+    int red_x = 0, red_y = 0;
+    if(bayer == "BGGR") {
+        red_x = 1; red_y = 1;
+    }else if(bayer == "GRBG") {
+        red_x = 1;
+    }else if(bayer == "GBRG") {
+        red_y = 1;
+    }else if(!bayer.empty() && bayer != "RGGB") {
+        throw std::runtime_error("GlPixDecoder: Unknown Bayer tile '" + bayer + "'");
+    }
+
+    prog.Bind();
+    prog.SetUniform("raw", 0);
+    prog.SetUniform("raw_format", (int)raw_format);
+    prog.SetUniform("size", (int)width, (int)height);
+    prog.SetUniform("red", red_x, red_y);
+    prog.SetUniform("bayer", bayer.empty() ? 0 : 1);
+    prog.SetUniform("wb", wb_gains[0], wb_gains[1], wb_gains[2]);
+    prog.SetUniform("offset", offset);
+    prog.SetUniform("scale", scale);
+    prog.SetUniform("inv_gamma", 1.0f / gamma);
+
+    glActiveTexture(GL_TEXTURE0);
+    raw.Bind();
+}
+
+inline void GlPixDecoder::Unbind()
+{
+    raw.Unbind();
+    prog.Unbind();
+}
+
+}
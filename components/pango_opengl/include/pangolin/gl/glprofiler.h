@@ -0,0 +1,164 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <pangolin/platform.h>
+#include <pangolin/gl/glinclude.h>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pangolin
+{
+
+// Frame profiler for code running on the GL thread. Named sections, which may
+// nest, record CPU time and, where timer queries are available, GPU time.
+// Frames are kept until their GPU timestamps are available, which usually
+// takes a frame, so the profiler only stalls the pipeline if the GPU falls
+// several frames behind. Statistics are kept over a rolling window of recent
+// frames.
+//
+// Only the thread which enabled the profiler (normally the one rendering the
+// main context) is profiled. Sections begun on other threads, such as
+// texture uploads from worker contexts, are ignored.
+//
+// Pangolin instruments View::Render, Plotter::Render, GlTexture uploads and
+// FinishFrame. Add more with GlProfileScope. The profiler is disabled
+// (and almost free) until SetEnabled(true) or ShowProfiler(true).
+class PANGOLIN_EXPORT GlProfiler
+{
+public:
+    struct Section
+    {
+        std::string name;
+        // Per frame totals in milliseconds, oldest first. gpu_ms is empty if
+        // timer queries aren't supported.
+        std::deque<float> cpu_ms;
+        std::deque<float> gpu_ms;
+    };
+
+    static GlProfiler& I();
+
+    //! Call from the thread to profile, with its GL context current
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const { return enabled; }
+
+    //! Number of frames kept for statistics and trace export
+    void SetHistory(size_t frames);
+
+    //! Returns false, recording nothing, if disabled or not called from the
+    //! profiled thread. Only call End() if true.
+    bool Begin(const char* name);
+    void End();
+
+    //! Mark end of frame. Called by FinishFrame().
+    void EndFrame();
+
+    //! Statistics per section, in order of first use. "Frame" holds the time
+    //! between calls to EndFrame.
+    const std::vector<Section>& Sections() const { return sections; }
+
+    //! Write recent frames in Chrome trace event format (chrome://tracing)
+    void SaveChromeTrace(const std::string& filename) const;
+
+private:
+    struct Event
+    {
+        uint32_t section;
+        uint32_t depth;
+        // False if nested inside a section of the same name
+        bool aggregate;
+        int64_t cpu_begin_us;
+        int64_t cpu_end_us;
+        GLuint queries[2];
+    };
+
+    struct Frame
+    {
+        std::vector<Event> events;
+        int64_t cpu_begin_us = 0;
+        int64_t cpu_end_us = 0;
+        // Subtract from GPU time (ns) to get CPU time (ns)
+        int64_t gpu_to_cpu_ns = 0;
+        bool has_gpu = false;
+    };
+
+    struct TraceEvent
+    {
+        uint32_t section;
+        bool gpu;
+        int64_t begin_us;
+        int64_t duration_us;
+    };
+
+    GlProfiler();
+
+    uint32_t SectionId(const char* name);
+    GLuint NewQuery();
+    void ReleaseQueries();
+    bool GpuResultsAvailable(const Frame& frame) const;
+    void Resolve(Frame& frame);
+
+    std::atomic<bool> enabled;
+    std::thread::id thread;
+    bool timer_queries;
+    size_t history;
+
+    // Frame being recorded, and ended frames waiting for GPU results
+    Frame current;
+    std::deque<Frame> pending;
+    std::vector<size_t> stack;
+    std::vector<GLuint> free_queries;
+
+    std::map<std::string, uint32_t> section_ids;
+    std::vector<Section> sections;
+    std::deque<std::vector<TraceEvent>> trace;
+};
+
+// Profile the enclosing scope as a section named name
+struct GlProfileScope
+{
+    GlProfileScope(const char* name)
+        : active(GlProfiler::I().IsEnabled() && GlProfiler::I().Begin(name))
+    {
+    }
+
+    ~GlProfileScope()
+    {
+        if(active) GlProfiler::I().End();
+    }
+
+    bool active;
+};
+
+}
@@ -0,0 +1,242 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove, Richard Newcombe
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <pangolin/gl/gl.h>
+#include <pangolin/gl/glpixformat.h>
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+namespace pangolin
+{
+
+////////////////////////////////////////////////
+// Interface
+////////////////////////////////////////////////
+
+// Non-blocking alternative to ReadFramebuffer. Enqueue() issues glReadPixels
+// into a pixel pack buffer followed by a fence and returns straight away, so
+// rendering continues while the copy completes. Readbacks are collected in
+// order, later, into TypedImages which are pooled for reuse along with the
+// pixel buffers. Use from the context which enqueued.
+class GlReadbackQueue
+{
+public:
+    typedef uint64_t Ticket;
+
+    GlReadbackQueue(size_t max_pooled_images = 4);
+
+    GlReadbackQueue(const GlReadbackQueue&) = delete;
+
+    ~GlReadbackQueue();
+
+    //! Queue a copy of v from the current read buffer (GL_BACK, or the bound
+    //! framebuffer) and return a ticket identifying it
+    Ticket Enqueue(const Viewport& v, const std::string& pixel_format = "RGBA32");
+
+    size_t NumPending() const;
+
+    //! True if the oldest pending readback can be collected without waiting
+    bool Ready() const;
+
+    //! Collect the oldest readback into image if it has finished
+    bool TryCollect(Ticket& ticket, TypedImage& image);
+
+    //! Collect the oldest readback into image, waiting for it if necessary.
+    //! Any buffer held by image beforehand is recycled. Rows are bottom
+    //! first, as with ReadFramebuffer (save with top_line_first = false).
+    Ticket Collect(TypedImage& image);
+
+    //! Return an image to the pool for a later Collect to fill
+    void Recycle(TypedImage&& image);
+
+private:
+    struct Readback
+    {
+        Ticket ticket;
+        Viewport v;
+        PixelFormat fmt;
+#ifndef HAVE_GLES
+        GlBufferData pbo;
+        GLsync fence;
+#else
+        TypedImage staged;
+#endif
+    };
+
+    TypedImage PooledImage(size_t w, size_t h, const PixelFormat& fmt);
+
+    std::deque<Readback> pending;
+#ifndef HAVE_GLES
+    std::vector<GlBufferData> free_pbos;
+#endif
+    std::vector<TypedImage> pool;
+    size_t max_pooled_images;
+    Ticket next_ticket;
+};
+
+////////////////////////////////////////////////
+// Implementation
+////////////////////////////////////////////////
+
+inline GlReadbackQueue::GlReadbackQueue(size_t max_pooled_images)
+    : max_pooled_images(max_pooled_images), next_ticket(0)
+{
+}
+
+inline GlReadbackQueue::~GlReadbackQueue()
+{
+#ifndef HAVE_GLES
+    for(Readback& r : pending) {
+        glDeleteSync(r.fence);
+    }
+#endif
+}
+
+inline GlReadbackQueue::Ticket GlReadbackQueue::Enqueue(const Viewport& v, const std::string& pixel_format)
+{
+    Readback r;
+    r.ticket = next_ticket++;
+    r.v = v;
+    r.fmt = PixelFormatFromString(pixel_format);
+    const GlPixFormat glfmt(r.fmt);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+#ifndef HAVE_GLES
+    const GLsizeiptr size_bytes = (GLsizeiptr)v.w * v.h * r.fmt.bpp / 8;
+    auto fits = std::find_if(free_pbos.begin(), free_pbos.end(), [size_bytes](const GlBufferData& b){
+        return b.SizeBytes() >= size_bytes;
+    });
+    if(fits != free_pbos.end()) {
+        r.pbo = std::move(*fits);
+        free_pbos.erase(fits);
+    }else{
+        r.pbo.Reinitialise(GlPixelPackBuffer, size_bytes, GL_STREAM_READ);
+    }
+
+    r.pbo.Bind();
+    glReadPixels(v.l, v.b, v.w, v.h, glfmt.glformat, glfmt.gltype, 0);
+    r.pbo.Unbind();
+    r.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // Submit now so the copy progresses even if the context then idles
+    glFlush();
+#else
+    // No pixel pack buffers: read synchronously, but keep the same interface
+    r.staged = PooledImage(v.w, v.h, r.fmt);
+    glReadPixels(v.l, v.b, v.w, v.h, glfmt.glformat, glfmt.gltype, r.staged.ptr);
+#endif
+
+    pending.push_back(std::move(r));
+    return pending.back().ticket;
+}
+
+inline size_t GlReadbackQueue::NumPending() const
+{
+    return pending.size();
+}
+
+inline bool GlReadbackQueue::Ready() const
+{
+    if(pending.empty()) return false;
+#ifndef HAVE_GLES
+    GLint status = GL_UNSIGNALED;
+    glGetSynciv(pending.front().fence, GL_SYNC_STATUS, sizeof(status), nullptr, &status);
+    return status == GL_SIGNALED;
+#else
+    return true;
+#endif
+}
+
+inline bool GlReadbackQueue::TryCollect(Ticket& ticket, TypedImage& image)
+{
+    if(!Ready()) return false;
+    ticket = Collect(image);
+    return true;
+}
+
+inline GlReadbackQueue::Ticket GlReadbackQueue::Collect(TypedImage& image)
+{
+    PANGO_ASSERT(!pending.empty(), "No readback enqueued");
+
+    if(image.IsValid()) Recycle(std::move(image));
+
+    Readback r = std::move(pending.front());
+    pending.pop_front();
+
+#ifndef HAVE_GLES
+    while(glClientWaitSync(r.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+    glDeleteSync(r.fence);
+
+    image = PooledImage(r.v.w, r.v.h, r.fmt);
+    const size_t row_bytes = image.w * r.fmt.bpp / 8;
+
+    r.pbo.Bind();
+    const unsigned char* mapped = (const unsigned char*)glMapBufferRange(
+        GL_PIXEL_PACK_BUFFER, 0, row_bytes * image.h, GL_MAP_READ_BIT
+    );
+    if(mapped) {
+        for(size_t y=0; y < image.h; ++y) {
+            std::memcpy(image.RowPtr(y), mapped + y*row_bytes, row_bytes);
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    r.pbo.Unbind();
+    free_pbos.push_back(std::move(r.pbo));
+#else
+    image = std::move(r.staged);
+#endif
+
+    return r.ticket;
+}
+
+inline void GlReadbackQueue::Recycle(TypedImage&& image)
+{
+    if(image.IsValid() && pool.size() < max_pooled_images) {
+        pool.push_back(std::move(image));
+    }
+    image.Deallocate();
+}
+
+inline TypedImage GlReadbackQueue::PooledImage(size_t w, size_t h, const PixelFormat& fmt)
+{
+    TypedImage image;
+    auto match = std::find_if(pool.begin(), pool.end(), [&](const TypedImage& i){
+        return i.w == w && i.h == h && i.fmt.format == fmt.format;
+    });
+    if(match != pool.end()) {
+        image = std::move(*match);
+        pool.erase(match);
+    }else{
+        image.Reinitialise(w, h, fmt);
+    }
+    return image;
+}
+
+}
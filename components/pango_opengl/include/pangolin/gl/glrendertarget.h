@@ -0,0 +1,138 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove, Richard Newcombe
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <pangolin/gl/gl.h>
+#include <pangolin/gl/glreadback.h>
+
+namespace pangolin
+{
+
+////////////////////////////////////////////////
+// Interface
+////////////////////////////////////////////////
+
+// Offscreen colour and depth framebuffer whose colour attachment can be read
+// back without blocking. StartReadback() queues a copy through a
+// GlReadbackQueue; FinishReadback() collects it once the GPU is done. Render
+// into the next target (or next frame) in between so that the two overlap.
+//
+// Like all framebuffers, a GlRenderTarget belongs to the context that created
+// it, but may render any shared textures and buffers (see HeadlessGlContext).
+class GlRenderTarget
+{
+public:
+    GlRenderTarget(GLint width, GLint height, GLint colour_format = GL_RGBA8);
+
+    GlRenderTarget(const GlRenderTarget&) = delete;
+
+    //! Bind framebuffer for rendering and set the viewport to cover it
+    void Bind() const;
+
+    void Unbind() const;
+
+    //! Begin asynchronous copy of the colour attachment, in pixel_format
+    void StartReadback(const std::string& pixel_format = "RGBA32");
+
+    //! True if StartReadback() has been called without FinishReadback()
+    bool ReadbackPending() const;
+
+    //! True if FinishReadback() would return without waiting
+    bool ReadbackReady() const;
+
+    //! Wait for the pending readback and copy it into image. Rows are bottom
+    //! first, as with ReadFramebuffer (save with top_line_first = false).
+    void FinishReadback(TypedImage& image);
+
+    TypedImage FinishReadback();
+
+    GLint width;
+    GLint height;
+    GlTexture colour;
+    GlRenderBuffer depth;
+    GlFramebuffer fbo;
+
+private:
+    GlReadbackQueue readback;
+};
+
+////////////////////////////////////////////////
+// Implementation
+////////////////////////////////////////////////
+
+inline GlRenderTarget::GlRenderTarget(GLint width, GLint height, GLint colour_format)
+    : width(width), height(height),
+      colour(width, height, colour_format),
+      depth(width, height),
+      fbo(colour, depth)
+{
+}
+
+inline void GlRenderTarget::Bind() const
+{
+    fbo.Bind();
+    glViewport(0, 0, width, height);
+}
+
+inline void GlRenderTarget::Unbind() const
+{
+    fbo.Unbind();
+}
+
+inline void GlRenderTarget::StartReadback(const std::string& pixel_format)
+{
+    PANGO_ASSERT(!ReadbackPending(), "Previous readback not finished");
+    fbo.Bind();
+    readback.Enqueue(Viewport(0, 0, width, height), pixel_format);
+    fbo.Unbind();
+}
+
+inline bool GlRenderTarget::ReadbackPending() const
+{
+    return readback.NumPending() > 0;
+}
+
+inline bool GlRenderTarget::ReadbackReady() const
+{
+    return readback.Ready();
+}
+
+inline void GlRenderTarget::FinishReadback(TypedImage& image)
+{
+    PANGO_ASSERT(ReadbackPending(), "No readback started");
+    readback.Collect(image);
+}
+
+inline TypedImage GlRenderTarget::FinishReadback()
+{
+    TypedImage image;
+    FinishReadback(image);
+    return image;
+}
+
+}
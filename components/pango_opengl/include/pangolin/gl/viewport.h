@@ -57,6 +57,10 @@ struct PANGOLIN_EXPORT Viewport
     GLint t() const { return b+h;}
     GLfloat aspect() const { return (GLfloat)w / (GLfloat)h; }
     GLint area() const { return w * h; }
+
+    bool operator==(const Viewport& o) const { return l == o.l && b == o.b && w == o.w && h == o.h; }
+    bool operator!=(const Viewport& o) const { return !(*this == o); }
+
     GLint l,b,w,h;
 };
 
@@ -0,0 +1,320 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <pangolin/gl/glprofiler.h>
+#include <pangolin/utils/picojson.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace pangolin
+{
+
+namespace
+{
+
+// Beyond this many frames behind, wait for the GPU rather than keep queuing
+const size_t max_pending_frames = 4;
+
+int64_t NowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+bool TimerQueriesSupported()
+{
+#ifdef HAVE_GLES
+    return false;
+#else
+    int major = 0, minor = 0;
+    const char* version = (const char*)glGetString(GL_VERSION);
+    if(version && std::sscanf(version, "%d.%d", &major, &minor) == 2) {
+        if(major > 3 || (major == 3 && minor >= 3)) return true;
+    }
+    const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+    return extensions && std::strstr(extensions, "GL_ARB_timer_query");
+#endif
+}
+
+}
+
+GlProfiler& GlProfiler::I()
+{
+    static GlProfiler profiler;
+    return profiler;
+}
+
+GlProfiler::GlProfiler()
+    : enabled(false), timer_queries(false), history(120)
+{
+}
+
+void GlProfiler::SetEnabled(bool enable)
+{
+    if(enable && !enabled) {
+        thread = std::this_thread::get_id();
+        timer_queries = TimerQueriesSupported();
+        current = Frame();
+        pending.clear();
+        stack.clear();
+        current.cpu_begin_us = NowUs();
+    }else if(!enable && enabled) {
+        ReleaseQueries();
+    }
+    enabled = enable;
+}
+
+void GlProfiler::ReleaseQueries()
+{
+#ifndef HAVE_GLES
+    // Including those in flight, which will never be read now
+    pending.push_back(std::move(current));
+    for(const Frame& f : pending) {
+        for(const Event& e : f.events) {
+            for(GLuint q : e.queries) {
+                if(q) free_queries.push_back(q);
+            }
+        }
+    }
+    if(!free_queries.empty()) {
+        glDeleteQueries((GLsizei)free_queries.size(), free_queries.data());
+    }
+#endif
+    free_queries.clear();
+    pending.clear();
+    current = Frame();
+    stack.clear();
+}
+
+void GlProfiler::SetHistory(size_t frames)
+{
+    history = std::max<size_t>(frames, 1);
+}
+
+uint32_t GlProfiler::SectionId(const char* name)
+{
+    auto it = section_ids.find(name);
+    if(it != section_ids.end()) return it->second;
+
+    const uint32_t id = (uint32_t)sections.size();
+    section_ids[name] = id;
+    sections.emplace_back();
+    sections.back().name = name;
+    return id;
+}
+
+GLuint GlProfiler::NewQuery()
+{
+    GLuint query = 0;
+#ifndef HAVE_GLES
+    if(free_queries.empty()) {
+        glGenQueries(1, &query);
+    }else{
+        query = free_queries.back();
+        free_queries.pop_back();
+    }
+#endif
+    return query;
+}
+
+bool GlProfiler::Begin(const char* name)
+{
+    if(!enabled || std::this_thread::get_id() != thread) {
+        // e.g. a worker thread with its own context, which can't use our queries
+        return false;
+    }
+
+    Event e;
+    e.section = SectionId(name);
+    e.depth = (uint32_t)stack.size();
+    e.aggregate = true;
+    for(size_t i : stack) {
+        if(current.events[i].section == e.section) e.aggregate = false;
+    }
+    e.queries[0] = e.queries[1] = 0;
+
+#ifndef HAVE_GLES
+    if(timer_queries) {
+        if(!current.has_gpu) {
+            // Relate GPU clock to CPU clock (doesn't wait for the GPU)
+            GLint64 gpu_now_ns = 0;
+            glGetInteger64v(GL_TIMESTAMP, &gpu_now_ns);
+            current.gpu_to_cpu_ns = gpu_now_ns - NowUs() * 1000;
+            current.has_gpu = true;
+        }
+        e.queries[0] = NewQuery();
+        e.queries[1] = NewQuery();
+        glQueryCounter(e.queries[0], GL_TIMESTAMP);
+    }
+#endif
+
+    e.cpu_begin_us = e.cpu_end_us = NowUs();
+    stack.push_back(current.events.size());
+    current.events.push_back(e);
+    return true;
+}
+
+void GlProfiler::End()
+{
+    if(stack.empty() || std::this_thread::get_id() != thread) return;
+
+    Event& e = current.events[stack.back()];
+    stack.pop_back();
+    e.cpu_end_us = NowUs();
+#ifndef HAVE_GLES
+    if(e.queries[1]) glQueryCounter(e.queries[1], GL_TIMESTAMP);
+#endif
+}
+
+void GlProfiler::EndFrame()
+{
+    if(!enabled || std::this_thread::get_id() != thread) return;
+
+    while(!stack.empty()) End();
+    const int64_t now = NowUs();
+    current.cpu_end_us = now;
+    pending.push_back(std::move(current));
+    current = Frame();
+    current.cpu_begin_us = now;
+
+    // Resolve frames in order once their GPU work has finished
+    while(!pending.empty() && (pending.size() > max_pending_frames || GpuResultsAvailable(pending.front()))) {
+        Resolve(pending.front());
+        pending.pop_front();
+    }
+}
+
+bool GlProfiler::GpuResultsAvailable(const Frame& f) const
+{
+#ifndef HAVE_GLES
+    // Check the latest queries first, which are most likely to be outstanding
+    for(auto e = f.events.rbegin(); e != f.events.rend(); ++e) {
+        for(GLuint q : e->queries) {
+            if(!q) continue;
+            GLint available = 0;
+            glGetQueryObjectiv(q, GL_QUERY_RESULT_AVAILABLE, &available);
+            if(!available) return false;
+        }
+    }
+#endif
+    return true;
+}
+
+void GlProfiler::Resolve(Frame& frame)
+{
+    // Reading results waits for any still outstanding
+    const bool gpu_ready = frame.has_gpu;
+
+    const uint32_t frame_section = SectionId("Frame");
+    std::vector<float> cpu_ms(sections.size(), 0.0f);
+    std::vector<float> gpu_ms(sections.size(), 0.0f);
+    std::vector<TraceEvent> frame_trace;
+
+    cpu_ms[frame_section] = (frame.cpu_end_us - frame.cpu_begin_us) / 1000.0f;
+    frame_trace.push_back({frame_section, false, frame.cpu_begin_us, frame.cpu_end_us - frame.cpu_begin_us});
+
+    for(const Event& e : frame.events) {
+        const int64_t cpu_us = e.cpu_end_us - e.cpu_begin_us;
+        if(e.aggregate) cpu_ms[e.section] += cpu_us / 1000.0f;
+        frame_trace.push_back({e.section, false, e.cpu_begin_us, cpu_us});
+
+#ifndef HAVE_GLES
+        if(gpu_ready) {
+            GLuint64 begin_ns = 0, end_ns = 0;
+            glGetQueryObjectui64v(e.queries[0], GL_QUERY_RESULT, &begin_ns);
+            glGetQueryObjectui64v(e.queries[1], GL_QUERY_RESULT, &end_ns);
+            const int64_t gpu_ns = (int64_t)(end_ns - begin_ns);
+            if(e.aggregate) gpu_ms[e.section] += gpu_ns / 1e6f;
+            frame_trace.push_back({e.section, true, ((int64_t)begin_ns - frame.gpu_to_cpu_ns) / 1000, gpu_ns / 1000});
+        }
+        for(GLuint q : e.queries) {
+            if(q) free_queries.push_back(q);
+        }
+#endif
+    }
+
+    for(size_t s=0; s < sections.size(); ++s) {
+        Section& section = sections[s];
+        section.cpu_ms.push_back(cpu_ms[s]);
+        while(section.cpu_ms.size() > history) section.cpu_ms.pop_front();
+        if(gpu_ready) {
+            section.gpu_ms.push_back(gpu_ms[s]);
+            while(section.gpu_ms.size() > history) section.gpu_ms.pop_front();
+        }
+    }
+
+    trace.push_back(std::move(frame_trace));
+    while(trace.size() > history) trace.pop_front();
+}
+
+void GlProfiler::SaveChromeTrace(const std::string& filename) const
+{
+    picojson::value events(picojson::array_type, false);
+
+    const char* thread_names[] = {"CPU", "GPU"};
+    for(int tid=0; tid < 2; ++tid) {
+        picojson::value meta(picojson::object_type, false);
+        meta["name"] = "thread_name";
+        meta["ph"] = "M";
+        meta["pid"] = 0;
+        meta["tid"] = tid;
+        meta["args"]["name"] = thread_names[tid];
+        events.push_back(meta);
+    }
+
+    for(const auto& frame : trace) {
+        for(const TraceEvent& e : frame) {
+            picojson::value event(picojson::object_type, false);
+            event["name"] = sections[e.section].name;
+            event["cat"] = e.gpu ? "gpu" : "cpu";
+            event["ph"] = "X";
+            event["ts"] = (double)e.begin_us;
+            event["dur"] = (double)e.duration_us;
+            event["pid"] = 0;
+            event["tid"] = e.gpu ? 1 : 0;
+            events.push_back(event);
+        }
+    }
+
+    picojson::value json(picojson::object_type, false);
+    json["traceEvents"] = events;
+    json["displayTimeUnit"] = "ms";
+
+    std::ofstream f(filename);
+    if(!f.is_open()) {
+        throw std::runtime_error("Unable to open trace file for writing: " + filename);
+    }
+    f << json.serialize();
+}
+
+}
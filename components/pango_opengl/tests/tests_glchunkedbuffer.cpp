@@ -0,0 +1,94 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <pangolin/gl/glchunkedbuffer.h>
+
+#include <array>
+
+namespace
+{
+
+// Keeps chunks in host memory so that chunk layout can be checked without GL
+struct HostChunkedBuffer : public pangolin::GlChunkedBuffer
+{
+    HostChunkedBuffer(GLuint chunk_num_elements)
+        : GlChunkedBuffer(pangolin::GlArrayBuffer, GL_FLOAT, 1, chunk_num_elements)
+    {
+    }
+
+    void Flush()
+    {
+        FlushTo([&](size_t i, const unsigned char* data, size_t num_elements, size_t first_element){
+            if(i == host_chunks.size()) {
+                host_chunks.emplace_back(chunk_capacity + chunk_overlap);
+            }
+            REQUIRE(first_element + num_elements <= host_chunks[i].size());
+            std::memcpy(host_chunks[i].data() + first_element, data, num_elements * sizeof(float));
+        });
+    }
+
+    std::vector<std::vector<float>> host_chunks;
+};
+
+using Primitive = std::array<float,3>;
+
+// Primitives glDrawArrays(mode, first, count) would assemble from v
+void AppendPrimitives(GLenum mode, const float* v, GLint first, GLsizei count, std::vector<Primitive>& prims)
+{
+    v += first;
+    if(mode == GL_POINTS) {
+        for(GLsizei k=0; k < count; ++k) prims.push_back({v[k], 0, 0});
+    }else if(mode == GL_LINES) {
+        for(GLsizei k=0; k+1 < count; k += 2) prims.push_back({v[k], v[k+1], 0});
+    }else if(mode == GL_LINE_STRIP) {
+        for(GLsizei k=0; k+1 < count; ++k) prims.push_back({v[k], v[k+1], 0});
+    }else if(mode == GL_TRIANGLES) {
+        for(GLsizei k=0; k+2 < count; k += 3) prims.push_back({v[k], v[k+1], v[k+2]});
+    }else if(mode == GL_TRIANGLE_STRIP) {
+        // Odd triangles are wound the other way
+        for(GLsizei k=0; k+2 < count; ++k) {
+            if(k % 2) prims.push_back({v[k+1], v[k], v[k+2]});
+            else      prims.push_back({v[k], v[k+1], v[k+2]});
+        }
+    }
+}
+
+}
+
+TEST_CASE( "Chunked buffer draws the same primitives as one contiguous buffer" )
+{
+    const std::vector<GLenum> modes = {GL_POINTS, GL_LINES, GL_LINE_STRIP, GL_TRIANGLES, GL_TRIANGLE_STRIP};
+
+    for(GLuint chunk_num_elements : {8u, 20u, 33u}) {
+        HostChunkedBuffer buffer(chunk_num_elements);
+        REQUIRE(buffer.ChunkCapacity() % 6 == 0);
+        REQUIRE(buffer.ChunkCapacity() + HostChunkedBuffer::chunk_overlap <= chunk_num_elements);
+
+        // Added in uneven batches, flushing part way through chunks
+        std::vector<float> all;
+        for(size_t batch=1; all.size() < 150; ++batch) {
+            std::vector<float> v(batch);
+            for(float& x : v) {
+                x = float(all.size());
+                all.push_back(x);
+            }
+            buffer.Add(v);
+            buffer.Flush();
+        }
+        REQUIRE(buffer.size() == all.size());
+        REQUIRE(buffer.NumChunks() > 3);
+
+        for(GLenum mode : modes) {
+            std::vector<Primitive> expected, drawn;
+            AppendPrimitives(mode, all.data(), 0, (GLsizei)all.size(), expected);
+            for(size_t i=0; i < buffer.NumChunks(); ++i) {
+                GLint first;
+                GLsizei count;
+                pangolin::GlChunkedBuffer::ChunkDrawRange(mode, i, buffer.ChunkSize(i), first, count);
+                AppendPrimitives(mode, buffer.host_chunks[i].data(), first, count, drawn);
+            }
+            INFO("chunk_num_elements " << chunk_num_elements << ", mode " << mode);
+            REQUIRE(drawn == expected);
+        }
+    }
+}
@@ -26,6 +26,7 @@
 #pragma once
 
 #include <mutex>
+#include <vector>
 
 #include <pangolin/log/packetstream.h>
 #include <pangolin/log/packetstream_source.h>
@@ -36,6 +37,12 @@ namespace pangolin {
 struct PANGOLIN_EXPORT Packet
 {
     Packet(PacketStream& s, std::unique_lock<std::recursive_mutex>&& mutex, std::vector<PacketStreamSource>& srcs);
+
+    // Packet whose data is already in memory, such as one from a decompressed
+    // group. Stream() reads from data until the packet is destroyed.
+    Packet(PacketStream& s, std::unique_lock<std::recursive_mutex>&& mutex, PacketStreamSourceId src,
+           int64_t time, size_t sequence_num, std::streampos frame_streampos,
+           picojson::value&& meta, const char* data, size_t size);
     Packet(const Packet&) = delete;
     Packet(Packet&& o);
     ~Packet();
@@ -43,6 +50,12 @@ struct PANGOLIN_EXPORT Packet
     size_t BytesRead() const;
     int BytesRemaining() const;
 
+    // Read all of this packet's data into memory and check it against the
+    // stored CRC32C. Call before reading from Stream(), which then reads the
+    // checked copy. True for packets stored without a checksum, and for
+    // packets from compressed groups, whose checksum is checked on reading.
+    bool VerifyChecksum();
+
     PacketStream& Stream()
     {
         return _stream;
@@ -55,6 +68,10 @@ struct PANGOLIN_EXPORT Packet
     picojson::value meta;
     std::streampos frame_streampos;
 
+    // CRC32C of the stored data, if its source records checksums
+    bool has_checksum;
+    uint32_t checksum;
+
 private:
     void ParsePacketHeader(PacketStream& s, std::vector<PacketStreamSource>& srcs);
     void ReadRemaining();
@@ -65,6 +82,8 @@ private:
 
     std::streampos data_streampos;
     size_t _data_len;
+    bool _buffered;
+    std::vector<char> _verified;
 };
 
 }
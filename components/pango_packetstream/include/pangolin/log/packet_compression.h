@@ -0,0 +1,53 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove, Richard Newcombe
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <pangolin/platform.h>
+
+#include <string>
+#include <vector>
+
+namespace pangolin {
+
+// Packet level compression for PacketStreamSource::compression. Methods are
+// "lz4" and "zstd", each available when Pangolin is built with the library.
+
+PANGOLIN_EXPORT
+bool PacketCompressionSupported(const std::string& method);
+
+// Compress len bytes from data into out, replacing its contents. Throws
+// std::invalid_argument if method isn't supported.
+PANGOLIN_EXPORT
+void CompressPacketData(const std::string& method, int level, const char* data, size_t len, std::vector<char>& out);
+
+// Decompress into exactly out_len bytes at out. Throws std::runtime_error
+// if the data doesn't decompress to that size.
+PANGOLIN_EXPORT
+void DecompressPacketData(const std::string& method, const char* data, size_t len, char* out, size_t out_len);
+
+}
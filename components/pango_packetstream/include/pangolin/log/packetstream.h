@@ -26,6 +26,7 @@
 #pragma once
 
 #include <fstream>
+#include <streambuf>
 
 #include <pangolin/platform.h>
 
@@ -39,14 +40,14 @@ class PANGOLIN_EXPORT PacketStream: public std::ifstream
 {
 public:
     PacketStream()
-        : _is_pipe(false)
+        : _is_pipe(false), _file_tag(0)
     {
         cclear();
     }
 
     PacketStream(const std::string& filename)
         : Base(filename.c_str(), std::ios::in | std::ios::binary),
-          _is_pipe(IsPipe(filename))
+          _is_pipe(IsPipe(filename)), _file_tag(0)
     {
         cclear();
     }
@@ -85,6 +86,8 @@ public:
 
     int64_t readTimestamp();
 
+    uint32_t readChecksum();
+
     PangoTagType peekTag();
 
     PangoTagType readTag();
@@ -93,11 +96,28 @@ public:
 
     PangoTagType syncToTag();
 
+    // Read from the len bytes at data, rather than the file, until
+    // EndBuffer(). Positions are relative to data meanwhile. Used to present
+    // decompressed packets to readers in the same way as stored ones.
+    void BeginBuffer(const char* data, size_t len);
+
+    void EndBuffer();
+
 private:
     using Base = std::ifstream;
 
+    // Seekable read only view of memory
+    struct MemoryBuffer : public std::streambuf
+    {
+        void Reset(const char* data, size_t len);
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+    };
+
     bool _is_pipe;
     PangoTagType _tag;
+    MemoryBuffer _memory;
+    PangoTagType _file_tag;
 
     // Amount of frame data left to read. Tracks our position within a data block.
 
@@ -25,6 +25,7 @@
 
 #pragma once
 
+#include <deque>
 #include <fstream>
 #include <mutex>
 #include <thread>
@@ -93,6 +94,10 @@ private:
 
     std::streampos ParseFooter();
 
+    void ParseGroup();
+
+    Packet NextGroupedPacket(std::unique_lock<std::recursive_mutex>&& lock);
+
     void SkipSync();
 
     void ReSync() {
@@ -106,6 +111,23 @@ private:
     PacketStream _stream;
     std::recursive_mutex _mutex;
 
+    // Packets of the most recent compressed group, handed out in order
+    struct GroupedPacket
+    {
+        int64_t time;
+        size_t sequence_num;
+        size_t meta_offset, meta_len;
+        size_t data_offset, data_len;
+    };
+    PacketStreamSourceId _group_src;
+    std::streampos _group_pos;
+    std::vector<char> _group_data;
+    std::deque<GroupedPacket> _group_packets;
+
+    // After seeking into the middle of a group, earlier packets are skipped
+    PacketStreamSourceId _group_skip_src;
+    size_t _group_skip_to;
+
     bool _is_pipe;
     int _pipe_fd;
 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <iostream>
 #include <pangolin/platform.h>
 #include <pangolin/utils/picojson.h>
@@ -14,6 +15,8 @@ struct PANGOLIN_EXPORT PacketStreamSource
     {
         std::streampos pos;
         int64_t capture_time;
+        // False for packets which can only be decoded given earlier packets
+        bool keyframe = true;
     };
 
     PacketStreamSource()
@@ -21,6 +24,9 @@ struct PANGOLIN_EXPORT PacketStreamSource
           version(0),
           data_alignment_bytes(1),
           data_size_bytes(0),
+          compression_level(0),
+          compression_batch_bytes(0),
+          checksum(false),
           next_packet_id(0)
     {
     }
@@ -35,6 +41,17 @@ struct PANGOLIN_EXPORT PacketStreamSource
 
     }
 
+    // Returns the id of the closest keyframe at or before packet_id
+    size_t FindKeyframe(size_t packet_id) const
+    {
+        if(index.empty()) return 0;
+        packet_id = std::min(packet_id, index.size()-1);
+        while(packet_id > 0 && !index[packet_id].keyframe) {
+            --packet_id;
+        }
+        return packet_id;
+    }
+
     int64_t NextPacketTime() const
     {
         if(next_packet_id < index.size()) {
@@ -53,6 +70,22 @@ struct PANGOLIN_EXPORT PacketStreamSource
     std::string     data_definitions;
     int64_t         data_size_bytes;
 
+    // Optional packet compression, "lz4" or "zstd", recorded in the source
+    // header and undone transparently by PacketStreamReader.
+    std::string     compression;
+    int             compression_level;
+
+    // With compression, consecutive packets are held back and compressed
+    // together until they total at least this many bytes. 0 compresses each
+    // packet on its own. Not recorded in the stream. Held back packets land
+    // in the file after later packets of other sources, so readers which
+    // interleave sources by file position see them out of time order.
+    size_t          compression_batch_bytes;
+
+    // Store a CRC32C with each packet (or compressed group) so that damaged
+    // data can be detected, see Packet::VerifyChecksum().
+    bool            checksum;
+
     // Index keyed by packet_id
     std::vector<PacketInfo> index;
 
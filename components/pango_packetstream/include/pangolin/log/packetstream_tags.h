@@ -20,6 +20,9 @@ const static std::string pss_pkt_alignment_bytes = "alignment_bytes";
 const static std::string pss_pkt_definitions = "definitions";
 const static std::string pss_pkt_size_bytes = "size_bytes";
 const static std::string pss_pkt_format_written = "format_written";
+const static std::string pss_pkt_compression = "compression";
+const static std::string pss_pkt_compression_level = "compression_level";
+const static std::string pss_pkt_checksum = "checksum";
 
 const unsigned int TAG_LENGTH = 3;
 
@@ -32,6 +35,7 @@ const PangoTagType TAG_PANGO_FOOTER = PANGO_TAG('F', 'T', 'R');
 const PangoTagType TAG_ADD_SOURCE   = PANGO_TAG('S', 'R', 'C');
 const PangoTagType TAG_SRC_JSON     = PANGO_TAG('J', 'S', 'N');
 const PangoTagType TAG_SRC_PACKET   = PANGO_TAG('P', 'K', 'T');
+const PangoTagType TAG_SRC_GROUP    = PANGO_TAG('G', 'R', 'P');
 const PangoTagType TAG_END          = PANGO_TAG('E', 'N', 'D');
 #undef PANGO_TAG
 
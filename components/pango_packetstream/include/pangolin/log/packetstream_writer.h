@@ -56,10 +56,11 @@ public:
         Close();
     }
 
-    void Open(const std::string& filename, size_t buffer_size = 100 * 1024 * 1024)
+    //! writer_policy applies to the thread which writes to file
+    void Open(const std::string& filename, size_t buffer_size = 100 * 1024 * 1024, const ThreadPolicy& writer_policy = ThreadPolicy())
     {
         Close();
-        _buffer.open(filename, buffer_size);
+        _buffer.open(filename, buffer_size, writer_policy);
         _open = _stream.good();
         _bytes_written = 0;
         _indexable = !IsPipe(filename);
@@ -70,6 +71,7 @@ public:
     {
         if (_open)
         {
+            WriteGroups();
             if (_indexable) {
                 WriteEnd();
             }
@@ -84,6 +86,7 @@ public:
         if (_open)
         {
         _buffer.force_close();
+        for(auto& group : _groups) group = PendingGroup();
         Close();
         }
     }
@@ -96,9 +99,12 @@ public:
     // If constructor is called inline
     PacketStreamSourceId AddSource(const PacketStreamSource& source);
 
+    // keyframe should be false for packets which depend on the preceding
+    // packet of the same source. This is recorded in the index for seeking.
     void WriteSourcePacket(
         PacketStreamSourceId src, const char* source,const int64_t receive_time_us,
-        size_t sourcelen, const picojson::value& meta = picojson::value()
+        size_t sourcelen, const picojson::value& meta = picojson::value(),
+        bool keyframe = true
     );
 
     // For stream read/write synchronization. Note that this is NOT the same as
@@ -109,6 +115,9 @@ public:
     // the underlying ostream.
     void WriteEnd();
 
+    // Write out any packets held back for compression in groups
+    void WriteGroups();
+
     const std::vector<PacketStreamSource>& Sources() const {
         return _sources;
     }
@@ -117,16 +126,33 @@ public:
         return _open;
     }
 
+    // Bytes of packet data written since opening, after any compression
+    size_t BytesWritten() const {
+        return _bytes_written;
+    }
+
 private:
+    // Uncompressed packets of one source waiting to be compressed together
+    struct PendingGroup
+    {
+        std::vector<char> data;
+        size_t first_packet = 0;
+        size_t num_packets = 0;
+    };
+
     void WriteHeader();
     void Write(const PacketStreamSource&);
     void WriteMeta(PacketStreamSourceId src, const picojson::value& data);
+    void WriteGroupedPacket(PacketStreamSourceId src, const char* source, int64_t receive_time_us, size_t sourcelen, const picojson::value& meta, bool keyframe);
+    void WriteGroup(PacketStreamSourceId src);
 
     threadedfilebuf _buffer;
     std::ostream _stream;
     bool _indexable, _open;
 
     std::vector<PacketStreamSource> _sources;
+    std::vector<PendingGroup> _groups;
+    std::vector<char> _compressed;
     size_t _bytes_written;
     std::recursive_mutex _lock;
 };
@@ -146,6 +172,11 @@ inline void writeTimestamp(std::ostream& writer, int64_t time_us)
     writer.write(reinterpret_cast<const char*>(&time_us), sizeof(decltype(time_us)));
 }
 
+inline void writeChecksum(std::ostream& writer, uint32_t crc)
+{
+    writer.write(reinterpret_cast<const char*>(&crc), sizeof(crc));
+}
+
 inline void writeTag(std::ostream& writer, const PangoTagType tag)
 {
     writer.write(reinterpret_cast<const char*>(&tag), TAG_LENGTH);
@@ -158,14 +189,32 @@ inline picojson::value SourceStats(const std::vector<PacketStreamSource>& srcs)
     stat["src_packet_index"] = picojson::array();
     stat["src_packet_times"] = picojson::array();
 
+    // Keyframe ids are only listed for sources containing non-keyframes.
+    // An empty list means every packet is a keyframe.
+    picojson::value src_keyframes = picojson::array();
+    bool any_delta_packets = false;
+
     for(auto& src : srcs) {
-        picojson::array pkt_index, pkt_times;
+        picojson::array pkt_index, pkt_times, pkt_keyframes;
+        bool all_keyframes = true;
         for (const PacketStreamSource::PacketInfo& frame : src.index) {
             pkt_index.emplace_back(frame.pos);
             pkt_times.emplace_back(frame.capture_time);
+            all_keyframes &= frame.keyframe;
+        }
+        if(!all_keyframes) {
+            for(size_t f=0; f < src.index.size(); ++f) {
+                if(src.index[f].keyframe) pkt_keyframes.emplace_back(f);
+            }
+            any_delta_packets = true;
         }
         stat["src_packet_index"].push_back(std::move(pkt_index));
         stat["src_packet_times"].push_back(std::move(pkt_times));
+        src_keyframes.push_back(std::move(pkt_keyframes));
+    }
+
+    if(any_delta_packets) {
+        stat["src_packet_keyframes"] = src_keyframes;
     }
     return stat;
 }
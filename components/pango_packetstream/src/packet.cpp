@@ -1,25 +1,45 @@
 #include <pangolin/log/packet.h>
+#include <pangolin/utils/crc32c.h>
+#include <pangolin/utils/json_reader.h>
 
 namespace pangolin {
 
 
 Packet::Packet(PacketStream& s, std::unique_lock<std::recursive_mutex>&& lock, std::vector<PacketStreamSource>& srcs)
-    : _stream(s), lock(std::move(lock))
+    : has_checksum(false), checksum(0), _stream(s), lock(std::move(lock)), _buffered(false)
 {
     ParsePacketHeader(s, srcs);
 }
 
+Packet::Packet(PacketStream& s, std::unique_lock<std::recursive_mutex>&& lock, PacketStreamSourceId src,
+               int64_t time, size_t sequence_num, std::streampos frame_streampos,
+               picojson::value&& meta, const char* data, size_t size)
+    : src(src), time(time), size(size), sequence_num(sequence_num), frame_streampos(frame_streampos),
+      has_checksum(false), checksum(0), _stream(s), lock(std::move(lock)), data_streampos(0), _data_len(size), _buffered(true)
+{
+    std::swap(this->meta, meta);
+    _stream.BeginBuffer(data, size);
+}
+
 Packet::Packet(Packet&& o)
     : src(o.src), time(o.time), size(o.size), sequence_num(o.sequence_num),
-      meta(std::move(o.meta)), frame_streampos(o.frame_streampos), _stream(o._stream),
-      lock(std::move(o.lock)), data_streampos(o.data_streampos), _data_len(o._data_len)
+      meta(std::move(o.meta)), frame_streampos(o.frame_streampos),
+      has_checksum(o.has_checksum), checksum(o.checksum), _stream(o._stream),
+      lock(std::move(o.lock)), data_streampos(o.data_streampos), _data_len(o._data_len),
+      _buffered(o._buffered), _verified(std::move(o._verified))
 {
     o._data_len = 0;
+    o._buffered = false;
 }
 
 Packet::~Packet()
 {
-    ReadRemaining();
+    if(_buffered) {
+        // Nothing left to consume in the file
+        _stream.EndBuffer();
+    }else{
+        ReadRemaining();
+    }
 }
 
 size_t Packet::BytesRead() const
@@ -45,7 +65,9 @@ void Packet::ParsePacketHeader(PacketStream& s, std::vector<PacketStreamSource>&
     {
         s.readTag(TAG_SRC_JSON);
         json_src = s.readUINT();
-        picojson::parse(meta, s);
+        std::string text;
+        PANGO_ENSURE(ReadJsonText(s, text), "Unable to read packet metadata. Stream may be corrupt.");
+        meta = JsonReader(text).ReadValue();
     }
 
     s.readTag(TAG_SRC_PACKET);
@@ -62,10 +84,34 @@ void Packet::ParsePacketHeader(PacketStream& s, std::vector<PacketStreamSource>&
     }
     sequence_num = src_packet.next_packet_id++;
 
+    has_checksum = src_packet.checksum;
+    if (has_checksum) {
+        checksum = s.readChecksum();
+    }
+
     _data_len = size;
     data_streampos = s.tellg();
 }
 
+bool Packet::VerifyChecksum()
+{
+    if(!has_checksum || _buffered) {
+        return true;
+    }
+    PANGO_ENSURE(BytesRead() == 0, "Packet checksum must be verified before its data is read");
+
+    _verified.resize(size);
+    const size_t bytes = _stream.read(_verified.data(), size);
+    _verified.resize(bytes);
+
+    // Serve the rest of this packet from the copy just checked
+    _stream.BeginBuffer(_verified.data(), _verified.size());
+    _buffered = true;
+    data_streampos = 0;
+
+    return bytes == size && Crc32c(_verified.data(), _verified.size()) == checksum;
+}
+
 void Packet::ReadRemaining()
 {
     int bytes_left = BytesRemaining();
@@ -0,0 +1,119 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove, Richard Newcombe
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <pangolin/log/packet_compression.h>
+
+#include <stdexcept>
+
+#ifdef HAVE_LZ4
+#  include <lz4.h>
+#  include <lz4hc.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#  include <zstd.h>
+#endif
+
+namespace pangolin {
+
+bool PacketCompressionSupported(const std::string& method)
+{
+#ifdef HAVE_LZ4
+    if(method == "lz4") return true;
+#endif
+#ifdef HAVE_ZSTD
+    if(method == "zstd") return true;
+#endif
+    PANGOLIN_UNUSED(method);
+    return false;
+}
+
+void CompressPacketData(const std::string& method, int level, const char* data, size_t len, std::vector<char>& out)
+{
+#ifdef HAVE_LZ4
+    if(method == "lz4") {
+        if(len > size_t(LZ4_MAX_INPUT_SIZE)) {
+            throw std::invalid_argument("Packet too large for lz4 compression");
+        }
+        out.resize(LZ4_compressBound((int)len));
+        // Levels above 1 select the slower high compression mode
+        const int bytes = (level > 1) ?
+            LZ4_compress_HC(data, out.data(), (int)len, (int)out.size(), level) :
+            LZ4_compress_default(data, out.data(), (int)len, (int)out.size());
+        if(bytes <= 0) {
+            throw std::runtime_error("lz4 compression failed");
+        }
+        out.resize(bytes);
+        return;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if(method == "zstd") {
+        out.resize(ZSTD_compressBound(len));
+        const size_t bytes = ZSTD_compress(out.data(), out.size(), data, len, level);
+        if(ZSTD_isError(bytes)) {
+            throw std::runtime_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(bytes));
+        }
+        out.resize(bytes);
+        return;
+    }
+#endif
+    PANGOLIN_UNUSED(level);
+    PANGOLIN_UNUSED(data);
+    PANGOLIN_UNUSED(len);
+    PANGOLIN_UNUSED(out);
+    throw std::invalid_argument("Packet compression '" + method + "' is not supported by this build");
+}
+
+void DecompressPacketData(const std::string& method, const char* data, size_t len, char* out, size_t out_len)
+{
+#ifdef HAVE_LZ4
+    if(method == "lz4") {
+        const int bytes = LZ4_decompress_safe(data, out, (int)len, (int)out_len);
+        if(bytes < 0 || size_t(bytes) != out_len) {
+            throw std::runtime_error("Corrupt lz4 packet data");
+        }
+        return;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if(method == "zstd") {
+        const size_t bytes = ZSTD_decompress(out, out_len, data, len);
+        if(ZSTD_isError(bytes) || bytes != out_len) {
+            throw std::runtime_error("Corrupt zstd packet data");
+        }
+        return;
+    }
+#endif
+    PANGOLIN_UNUSED(data);
+    PANGOLIN_UNUSED(len);
+    PANGOLIN_UNUSED(out);
+    PANGOLIN_UNUSED(out_len);
+    throw std::runtime_error("Packet compression '" + method + "' is not supported by this build");
+}
+
+}
@@ -26,6 +26,13 @@ int64_t PacketStream::readTimestamp()
     return time_us;
 }
 
+uint32_t PacketStream::readChecksum()
+{
+    uint32_t crc = 0;
+    read(reinterpret_cast<char*>(&crc), sizeof(crc));
+    return crc;
+}
+
 PangoTagType PacketStream::readTag()
 {
     auto r = peekTag();
@@ -102,6 +109,42 @@ void PacketStream::seekg(std::streamoff off, std::ios_base::seekdir way)
     }
 }
 
+void PacketStream::MemoryBuffer::Reset(const char* data, size_t len)
+{
+    char* p = const_cast<char*>(data);
+    setg(p, p, p + len);
+}
+
+std::streambuf::pos_type PacketStream::MemoryBuffer::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    char* base = (dir == std::ios_base::beg) ? eback() : (dir == std::ios_base::cur) ? gptr() : egptr();
+    if(!(which & std::ios_base::in) || off < eback() - base || off > egptr() - base) {
+        return pos_type(off_type(-1));
+    }
+    setg(eback(), base + off, egptr());
+    return pos_type(gptr() - eback());
+}
+
+std::streambuf::pos_type PacketStream::MemoryBuffer::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+void PacketStream::BeginBuffer(const char* data, size_t len)
+{
+    _file_tag = _tag;
+    _tag = 0;
+    _memory.Reset(data, len);
+    std::ios::rdbuf(&_memory);
+}
+
+void PacketStream::EndBuffer()
+{
+    // Restores the file buffer and clears any eof reached in memory
+    std::ios::rdbuf(Base::rdbuf());
+    _tag = _file_tag;
+}
+
 static bool valid(PangoTagType t)
 {
     switch (t)
@@ -110,6 +153,7 @@ static bool valid(PangoTagType t)
         case TAG_ADD_SOURCE:
         case TAG_SRC_JSON:
         case TAG_SRC_PACKET:
+        case TAG_SRC_GROUP:
         case TAG_PANGO_STATS:
         case TAG_PANGO_FOOTER:
         case TAG_END:
@@ -23,8 +23,11 @@
  * OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <pangolin/log/packet_compression.h>
 #include <pangolin/log/packetstream_reader.h>
 #include <pangolin/log/packetstream_writer.h>
+#include <pangolin/utils/crc32c.h>
+#include <pangolin/utils/json_reader.h>
 
 using std::string;
 using std::istream;
@@ -45,12 +48,12 @@ namespace pangolin
 {
 
 PacketStreamReader::PacketStreamReader()
-    : _pipe_fd(-1)
+    : _group_src(0), _group_skip_src(-1), _group_skip_to(0), _pipe_fd(-1)
 {
 }
 
 PacketStreamReader::PacketStreamReader(const std::string& filename)
-    : _pipe_fd(-1)
+    : _group_src(0), _group_skip_src(-1), _group_skip_to(0), _pipe_fd(-1)
 {
     Open(filename);
 }
@@ -101,6 +104,8 @@ void PacketStreamReader::Close() {
 
     _stream.close();
     _sources.clear();
+    _group_packets.clear();
+    _group_skip_src = -1;
 
 #ifndef _WIN_
     if (_pipe_fd != -1) {
@@ -113,11 +118,17 @@ void PacketStreamReader::ParseHeader()
 {
     _stream.readTag(TAG_PANGO_HDR);
 
-    picojson::value json_header;
-    picojson::parse(json_header, _stream);
+    std::string text;
+    PANGO_ENSURE(ReadJsonText(_stream, text), "Unable to read pango header");
 
     // File timestamp
-    const int64_t start_us = json_header["time_us"].get<int64_t>();
+    int64_t start_us = 0;
+    JsonReader json(text);
+    json.BeginObject();
+    for(string key; json.NextKey(key); ) {
+        if(key == "time_us") start_us = json.ReadInt();
+        else json.Skip();
+    }
     packet_stream_start = SyncTime::TimePoint() + std::chrono::microseconds(start_us);
 
     _stream.get(); // consume newline
@@ -126,26 +137,65 @@ void PacketStreamReader::ParseHeader()
 void PacketStreamReader::ParseNewSource()
 {
     _stream.readTag(TAG_ADD_SOURCE);
-    picojson::value json;
-    picojson::parse(json, _stream);
+    std::string text;
+    PANGO_ENSURE(ReadJsonText(_stream, text), "Unable to read source description");
     _stream.get(); // consume newline
 
+    PacketStreamSource src;
+    bool has_id = false;
+
+    JsonReader json(text);
+    json.BeginObject();
+    for(string key; json.NextKey(key); ) {
+        if(key == pss_src_id) {
+            src.id = json.ReadUInt();
+            has_id = true;
+        }else if(key == pss_src_driver) {
+            json.ReadString(src.driver);
+        }else if(key == pss_src_uri) {
+            json.ReadString(src.uri);
+        }else if(key == pss_src_info) {
+            src.info = json.ReadValue();
+        }else if(key == pss_src_version) {
+            src.version = json.ReadInt();
+        }else if(key == pss_src_packet) {
+            json.BeginObject();
+            for(string pkt_key; json.NextKey(pkt_key); ) {
+                if(pkt_key == pss_pkt_alignment_bytes) src.data_alignment_bytes = json.ReadInt();
+                else if(pkt_key == pss_pkt_definitions) json.ReadString(src.data_definitions);
+                else if(pkt_key == pss_pkt_size_bytes) src.data_size_bytes = json.ReadInt();
+                else if(pkt_key == pss_pkt_compression) json.ReadString(src.compression);
+                else if(pkt_key == pss_pkt_compression_level) src.compression_level = (int)json.ReadInt();
+                else if(pkt_key == pss_pkt_checksum) {
+                    const std::string method = json.ReadString();
+                    if(method != "crc32c") throw std::runtime_error("Unsupported packet checksum '" + method + "'");
+                    src.checksum = true;
+                }
+                else json.Skip();
+            }
+        }else{
+            json.Skip();
+        }
+    }
+    PANGO_ENSURE(has_id, "Source description is missing '%'", pss_src_id);
 
-    const size_t src_id = json[pss_src_id].get<int64_t>();
-
-    if(_sources.size() <= src_id) {
-        _sources.resize(src_id+1);
+    if(_sources.size() <= src.id) {
+        _sources.resize(src.id+1);
     }
 
-    PacketStreamSource& pss = _sources[src_id];
-    pss.id = src_id;
-    pss.driver = json[pss_src_driver].get<string>();
-    pss.uri = json[pss_src_uri].get<string>();
-    pss.info = json[pss_src_info];
-    pss.version = json[pss_src_version].get<int64_t>();
-    pss.data_alignment_bytes = json[pss_src_packet][pss_pkt_alignment_bytes].get<int64_t>();
-    pss.data_definitions = json[pss_src_packet][pss_pkt_definitions].get<string>();
-    pss.data_size_bytes = json[pss_src_packet][pss_pkt_size_bytes].get<int64_t>();
+    // Only the description is replaced, an index read from the footer is kept
+    PacketStreamSource& pss = _sources[src.id];
+    pss.id = src.id;
+    pss.driver = std::move(src.driver);
+    pss.uri = std::move(src.uri);
+    pss.info = std::move(src.info);
+    pss.version = src.version;
+    pss.data_alignment_bytes = src.data_alignment_bytes;
+    pss.data_definitions = std::move(src.data_definitions);
+    pss.data_size_bytes = src.data_size_bytes;
+    pss.compression = std::move(src.compression);
+    pss.compression_level = src.compression_level;
+    pss.checksum = src.checksum;
 }
 
 bool PacketStreamReader::SetupIndex()
@@ -189,17 +239,46 @@ streampos PacketStreamReader::ParseFooter() //returns position of index.
 bool PacketStreamReader::ParseIndex()
 {
     _stream.readTag(TAG_PANGO_STATS);
-    picojson::value json;
-    picojson::parse(json, _stream);
+    std::string text;
+    if(!ReadJsonText(_stream, text)) return false;
+
+    // Two-dimensional serialized arrays, [source id][sequence number] ---> packet position / capture time
+    std::vector<std::vector<int64_t>> json_index;
+    std::vector<std::vector<int64_t>> json_times;
+    std::vector<std::vector<uint64_t>> json_keyframes;
+    bool has_index = false;
+    bool has_times = false;
+    bool has_keyframes = false;
+
+    auto read_2d = [](JsonReader& json, auto& out) {
+        json.BeginArray();
+        while(json.NextElement()) {
+            out.emplace_back();
+            json.ReadArray(out.back());
+        }
+    };
 
-    const bool index_good = json.contains("src_packet_index") && json.contains("src_packet_times");
+    JsonReader json(text);
+    json.BeginObject();
+    for(string key; json.NextKey(key); ) {
+        if(key == "src_packet_index") {
+            read_2d(json, json_index);
+            has_index = true;
+        }else if(key == "src_packet_times") {
+            read_2d(json, json_times);
+            has_times = true;
+        }else if(key == "src_packet_keyframes") {
+            read_2d(json, json_keyframes);
+            has_keyframes = true;
+        }else{
+            json.Skip();
+        }
+    }
+
+    const bool index_good = has_index && has_times;
 
     if (index_good)
     {
-        // This is a two-dimensional serialized array, [source id][sequence number] ---> packet position in stream
-        const auto& json_index = json["src_packet_index"].get<picojson::array>();
-        const auto& json_times = json["src_packet_times"].get<picojson::array>();
-
         // We shouldn't have seen more sources than exist in the index
         PANGO_ENSURE(_sources.size() <= json_index.size());
         PANGO_ENSURE(json_index.size() == json_times.size());
@@ -211,8 +290,22 @@ bool PacketStreamReader::ParseIndex()
             PANGO_ENSURE(json_index[i].size() == json_times[i].size());
             _sources[i].index.resize(json_index[i].size());
             for(size_t f=0; f < json_index[i].size(); ++f) {
-                _sources[i].index[f].pos = json_index[i][f].get<int64_t>();
-                _sources[i].index[f].capture_time = json_times[i][f].get<int64_t>();
+                _sources[i].index[f].pos = json_index[i][f];
+                _sources[i].index[f].capture_time = json_times[i][f];
+            }
+        }
+
+        // Optional keyframe list, only present for streams with non-keyframes
+        if(has_keyframes) {
+            PANGO_ENSURE(json_keyframes.size() == _sources.size());
+            for(size_t i=0; i < _sources.size(); ++i) {
+                if(json_keyframes[i].size() > 0) {
+                    for(auto& info : _sources[i].index) info.keyframe = false;
+                    for(const size_t f : json_keyframes[i]) {
+                        PANGO_ENSURE(f < _sources[i].index.size());
+                        _sources[i].index[f].keyframe = true;
+                    }
+                }
             }
         }
     }
@@ -256,6 +349,9 @@ Packet PacketStreamReader::NextFrame()
 {
     std::unique_lock<std::recursive_mutex> lock(_mutex);
 
+    if (!_group_packets.empty())
+        return NextGroupedPacket(std::move(lock));
+
     while (GoodToRead())
     {
         const PangoTagType t = _stream.peekTag();
@@ -271,6 +367,11 @@ Packet PacketStreamReader::NextFrame()
         case TAG_SRC_JSON: //frames are sometimes preceded by metadata, but metadata must ALWAYS be followed by a frame from the same source.
         case TAG_SRC_PACKET:
             return Packet(_stream, std::move(lock), _sources);
+        case TAG_SRC_GROUP:
+            ParseGroup();
+            if (!_group_packets.empty())
+                return NextGroupedPacket(std::move(lock));
+            break;
         case TAG_PANGO_STATS:
             ParseIndex();
             break;
@@ -294,6 +395,79 @@ Packet PacketStreamReader::NextFrame()
     throw std::runtime_error("PacketStreamReader: no frame");
 }
 
+void PacketStreamReader::ParseGroup()
+{
+    _group_pos = _stream.tellg();
+    _stream.readTag(TAG_SRC_GROUP);
+    const size_t src = _stream.readUINT();
+    const size_t first_packet = _stream.readUINT();
+    const size_t num_packets = _stream.readUINT();
+    const size_t data_len = _stream.readUINT();
+    const size_t compressed_len = _stream.readUINT();
+
+    if (!_stream.good() || src >= _sources.size())
+        throw std::runtime_error("PacketStreamReader: bad packet group. Stream may be corrupt.");
+
+    PacketStreamSource& pss = _sources[src];
+    const uint32_t checksum = pss.checksum ? _stream.readChecksum() : 0;
+
+    std::vector<char> compressed(compressed_len);
+    if (_stream.read(compressed.data(), compressed_len) != compressed_len)
+        throw std::runtime_error("PacketStreamReader: truncated packet group");
+
+    // Always checked, since the data has been read in full anyway
+    if (pss.checksum && Crc32c(compressed.data(), compressed_len) != checksum)
+        throw std::runtime_error("PacketStreamReader: packet group checksum mismatch");
+
+    _group_data.resize(data_len);
+    DecompressPacketData(pss.compression, compressed.data(), compressed_len, _group_data.data(), data_len);
+
+    // Split the group using the stream's own primitives over memory
+    _group_src = src;
+    _group_packets.clear();
+    _stream.BeginBuffer(_group_data.data(), _group_data.size());
+    for (size_t i = 0; i < num_packets && _stream.good(); ++i) {
+        GroupedPacket gp;
+        gp.time = _stream.readTimestamp();
+        gp.sequence_num = first_packet + i;
+        gp.meta_len = _stream.readUINT();
+        gp.meta_offset = _stream.tellg();
+        _stream.skip(gp.meta_len);
+        gp.data_len = _stream.readUINT();
+        gp.data_offset = _stream.tellg();
+        _stream.skip(gp.data_len);
+
+        if (src != _group_skip_src || gp.sequence_num >= _group_skip_to)
+            _group_packets.push_back(gp);
+    }
+    const bool good = _stream.good() && size_t(_stream.tellg()) == data_len;
+    _stream.EndBuffer();
+
+    if (!good) {
+        _group_packets.clear();
+        throw std::runtime_error("PacketStreamReader: bad packet group. Stream may be corrupt.");
+    }
+
+    if (src == _group_skip_src)
+        _group_skip_src = -1;
+    pss.next_packet_id = first_packet + num_packets;
+}
+
+Packet PacketStreamReader::NextGroupedPacket(std::unique_lock<std::recursive_mutex>&& lock)
+{
+    const GroupedPacket gp = _group_packets.front();
+    _group_packets.pop_front();
+
+    picojson::value meta;
+    if (gp.meta_len) {
+        const char* json = _group_data.data() + gp.meta_offset;
+        meta = JsonReader(json, json + gp.meta_len).ReadValue();
+    }
+
+    return Packet(_stream, std::move(lock), _group_src, gp.time, gp.sequence_num, _group_pos,
+                  std::move(meta), _group_data.data() + gp.data_offset, gp.data_len);
+}
+
 Packet PacketStreamReader::NextFrame(PacketStreamSourceId src)
 {
     while (1)
@@ -386,6 +560,11 @@ size_t PacketStreamReader::Seek(PacketStreamSourceId src, size_t framenum)
         _stream.clear();
         _stream.seekg(source.index[framenum].pos);
         source.next_packet_id = framenum;
+
+        // Packets in a compressed group share its position
+        _group_packets.clear();
+        _group_skip_src = src;
+        _group_skip_to = framenum;
     }
     return source.next_packet_id;
 }
@@ -421,7 +600,7 @@ void PacketStreamReader::SkipSync()
     if (_stream.get() != 'G' && _stream.get() != 'O')
         throw std::runtime_error("Unknown packet type.");
 
-    while (_stream.peekTag() != TAG_SRC_PACKET && _stream.peekTag() != TAG_END)
+    while (_stream.peekTag() != TAG_SRC_PACKET && _stream.peekTag() != TAG_SRC_GROUP && _stream.peekTag() != TAG_END)
         _stream.readTag();
 }
 
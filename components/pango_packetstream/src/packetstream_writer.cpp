@@ -23,7 +23,9 @@
  * OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <pangolin/log/packet_compression.h>
 #include <pangolin/log/packetstream_writer.h>
+#include <pangolin/utils/crc32c.h>
 #include <pangolin/utils/file_utils.h>
 #include <pangolin/utils/timer.h>
 
@@ -75,6 +77,13 @@ void PacketStreamWriter::Write(const PacketStreamSource& source)
     serialize[pss_src_packet][pss_pkt_alignment_bytes] = source.data_alignment_bytes;
     serialize[pss_src_packet][pss_pkt_definitions] = source.data_definitions;
     serialize[pss_src_packet][pss_pkt_size_bytes] = source.data_size_bytes;
+    if (!source.compression.empty()) {
+        serialize[pss_src_packet][pss_pkt_compression] = source.compression;
+        serialize[pss_src_packet][pss_pkt_compression_level] = (int64_t)source.compression_level;
+    }
+    if (source.checksum) {
+        serialize[pss_src_packet][pss_pkt_checksum] = "crc32c";
+    }
 
     writeTag(_stream, TAG_ADD_SOURCE);
     serialize.serialize(std::ostream_iterator<char>(_stream), true);
@@ -91,9 +100,13 @@ PacketStreamSourceId PacketStreamWriter::AddSource(PacketStreamSource& source)
 PacketStreamSourceId PacketStreamWriter::AddSource(const PacketStreamSource& source)
 {
     SCOPED_LOCK;
+    if (!source.compression.empty() && !PacketCompressionSupported(source.compression))
+        throw std::invalid_argument("PacketStreamWriter: unsupported packet compression '" + source.compression + "'");
+
     PacketStreamSourceId r = _sources.size(); //source id is by vector position, so we must reassign.
     _sources.push_back(source);
     _sources.back().id = r;
+    _groups.resize(_sources.size());
 
     if (_open) //we might be a pipe, in which case we may not be open
         Write(_sources.back());
@@ -109,11 +122,19 @@ void PacketStreamWriter::WriteMeta(PacketStreamSourceId src, const picojson::val
     data.serialize(std::ostream_iterator<char>(_stream), false);
 }
 
-void PacketStreamWriter::WriteSourcePacket(PacketStreamSourceId src, const char* source, const int64_t receive_time_us, size_t sourcelen, const picojson::value& meta)
+void PacketStreamWriter::WriteSourcePacket(PacketStreamSourceId src, const char* source, const int64_t receive_time_us, size_t sourcelen, const picojson::value& meta, bool keyframe)
 {
 
     SCOPED_LOCK;
-    _sources[src].index.push_back({_stream.tellp(), receive_time_us});
+    if (_sources[src].data_size_bytes && sourcelen != static_cast<size_t>(_sources[src].data_size_bytes))
+        throw std::runtime_error("oPacketStream::writePacket --> Tried to write a fixed-size packet with bad size.");
+
+    if (!_sources[src].compression.empty()) {
+        WriteGroupedPacket(src, source, receive_time_us, sourcelen, meta, keyframe);
+        return;
+    }
+
+    _sources[src].index.push_back({_stream.tellp(), receive_time_us, keyframe});
 
     if (!meta.is<picojson::null>())
         WriteMeta(src, meta);
@@ -122,17 +143,89 @@ void PacketStreamWriter::WriteSourcePacket(PacketStreamSourceId src, const char*
     writeTimestamp(_stream, receive_time_us);
     writeCompressedUnsignedInt(_stream, src);
 
-    if (_sources[src].data_size_bytes) {
-        if (sourcelen != static_cast<size_t>(_sources[src].data_size_bytes))
-            throw std::runtime_error("oPacketStream::writePacket --> Tried to write a fixed-size packet with bad size.");
-    } else {
+    if (!_sources[src].data_size_bytes) {
         writeCompressedUnsignedInt(_stream, sourcelen);
     }
 
+    if (_sources[src].checksum) {
+        writeChecksum(_stream, Crc32c(source, sourcelen));
+    }
+
     _stream.write(source, sourcelen);
     _bytes_written += sourcelen;
 }
 
+// Group layout, uncompressed, per packet: timestamp, metadata length,
+// metadata json, data length, data.
+void PacketStreamWriter::WriteGroupedPacket(PacketStreamSourceId src, const char* source, int64_t receive_time_us, size_t sourcelen, const picojson::value& meta, bool keyframe)
+{
+    PacketStreamSource& pss = _sources[src];
+    PendingGroup& group = _groups[src];
+
+    if (group.num_packets == 0)
+        group.first_packet = pss.index.size();
+
+    // Position is filled in once the group is written
+    pss.index.push_back({std::streampos(-1), receive_time_us, keyframe});
+
+    auto append_uint = [&group](size_t n) {
+        while (n >= 0x80) {
+            group.data.push_back(char(0x80 | (n & 0x7F)));
+            n >>= 7;
+        }
+        group.data.push_back(char(n));
+    };
+
+    const char* time_bytes = reinterpret_cast<const char*>(&receive_time_us);
+    group.data.insert(group.data.end(), time_bytes, time_bytes + sizeof(receive_time_us));
+
+    const std::string meta_json = meta.is<picojson::null>() ? std::string() : meta.serialize();
+    append_uint(meta_json.size());
+    group.data.insert(group.data.end(), meta_json.begin(), meta_json.end());
+
+    append_uint(sourcelen);
+    group.data.insert(group.data.end(), source, source + sourcelen);
+    ++group.num_packets;
+
+    if (group.data.size() >= pss.compression_batch_bytes)
+        WriteGroup(src);
+}
+
+void PacketStreamWriter::WriteGroup(PacketStreamSourceId src)
+{
+    PacketStreamSource& pss = _sources[src];
+    PendingGroup& group = _groups[src];
+    if (group.num_packets == 0)
+        return;
+
+    CompressPacketData(pss.compression, pss.compression_level, group.data.data(), group.data.size(), _compressed);
+
+    const std::streampos pos = _stream.tellp();
+    for (size_t i = 0; i < group.num_packets; ++i)
+        pss.index[group.first_packet + i].pos = pos;
+
+    writeTag(_stream, TAG_SRC_GROUP);
+    writeCompressedUnsignedInt(_stream, src);
+    writeCompressedUnsignedInt(_stream, group.first_packet);
+    writeCompressedUnsignedInt(_stream, group.num_packets);
+    writeCompressedUnsignedInt(_stream, group.data.size());
+    writeCompressedUnsignedInt(_stream, _compressed.size());
+    if (pss.checksum)
+        writeChecksum(_stream, Crc32c(_compressed.data(), _compressed.size()));
+    _stream.write(_compressed.data(), _compressed.size());
+    _bytes_written += _compressed.size();
+
+    group.data.clear();
+    group.num_packets = 0;
+}
+
+void PacketStreamWriter::WriteGroups()
+{
+    SCOPED_LOCK;
+    for (PacketStreamSourceId src = 0; src < _groups.size(); ++src)
+        WriteGroup(src);
+}
+
 void PacketStreamWriter::WriteSync()
 {
     SCOPED_LOCK;
@@ -146,6 +239,9 @@ void PacketStreamWriter::WriteEnd()
     if (!_indexable)
         return;
 
+    // Index positions of grouped packets are only known once written
+    WriteGroups();
+
     auto indexpos = _stream.tellp();
     writeTag(_stream, TAG_PANGO_STATS);
     SourceStats(_sources).serialize(std::ostream_iterator<char>(_stream), false);
@@ -0,0 +1,159 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <pangolin/log/packet_compression.h>
+#include <pangolin/log/packetstream_reader.h>
+#include <pangolin/log/packetstream_writer.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+
+namespace {
+
+std::vector<char> TestPacket(size_t i)
+{
+    // Compressible, with a size that varies from packet to packet
+    std::vector<char> data(100 + (i * 37) % 900);
+    for(size_t b=0; b < data.size(); ++b) data[b] = char((b / 16 + i) & 0xff);
+    return data;
+}
+
+std::vector<char> ReadData(pangolin::Packet& packet)
+{
+    std::vector<char> data(packet.size);
+    packet.Stream().read(data.data(), data.size());
+    return data;
+}
+
+}
+
+TEST_CASE( "Packets from compressed sources read back transparently" )
+{
+    for(const std::string method : {"lz4", "zstd"}) {
+        pangolin::PacketStreamSource src;
+        src.driver = "test";
+        src.compression = method;
+        src.compression_level = 3;
+
+        if(!pangolin::PacketCompressionSupported(method)) {
+            pangolin::PacketStreamWriter writer;
+            REQUIRE_THROWS_AS(writer.AddSource(src), std::invalid_argument);
+            continue;
+        }
+
+        const std::string filename = "test_packet_compression_" + method + ".pango";
+        const size_t num_packets = 60;
+
+        pangolin::PacketStreamSource batched = src;
+        batched.compression_batch_bytes = 4096;
+        batched.checksum = true;
+        pangolin::PacketStreamSource plain;
+        plain.driver = "test";
+
+        std::map<size_t, picojson::value> metas;
+        {
+            pangolin::PacketStreamWriter writer(filename);
+            REQUIRE(writer.AddSource(src) == 0);
+            REQUIRE(writer.AddSource(batched) == 1);
+            REQUIRE(writer.AddSource(plain) == 2);
+            for(size_t i=0; i < num_packets; ++i) {
+                const auto data = TestPacket(i);
+                picojson::value meta;
+                if(i % 7 == 0) {
+                    meta["frame"] = (int64_t)i;
+                    metas[i] = meta;
+                }
+                for(pangolin::PacketStreamSourceId s=0; s < 3; ++s) {
+                    writer.WriteSourcePacket(s, data.data(), 1000 + i, data.size(), meta);
+                }
+            }
+        }
+
+        pangolin::PacketStreamReader reader(filename);
+        REQUIRE(reader.Sources().size() == 3);
+        REQUIRE(reader.Sources()[0].compression == method);
+        REQUIRE(reader.Sources()[1].compression == method);
+        REQUIRE(reader.Sources()[2].compression.empty());
+
+        std::vector<size_t> next(3, 0);
+        for(size_t n=0; n < 3 * num_packets; ++n) {
+            auto packet = reader.NextFrame();
+            const size_t i = next[packet.src]++;
+            REQUIRE(packet.sequence_num == i);
+            REQUIRE(packet.time == int64_t(1000 + i));
+            REQUIRE(ReadData(packet) == TestPacket(i));
+            if(metas.count(i)) {
+                REQUIRE(packet.meta.serialize() == metas[i].serialize());
+            }else{
+                REQUIRE(packet.meta.is<picojson::null>());
+            }
+        }
+        REQUIRE(next == std::vector<size_t>(3, num_packets));
+
+        // Seeking lands inside a group for the batched source
+        for(pangolin::PacketStreamSourceId s=0; s < 3; ++s) {
+            for(size_t i : {41, 3, 59}) {
+                REQUIRE(reader.Seek(s, i) == i);
+                auto packet = reader.NextFrame(s);
+                REQUIRE(packet.sequence_num == i);
+                REQUIRE(ReadData(packet) == TestPacket(i));
+            }
+        }
+
+        std::remove(filename.c_str());
+    }
+}
+
+TEST_CASE( "Packet checksums detect damaged data" )
+{
+    const std::string filename = "test_packet_checksum.pango";
+    const size_t num_packets = 20;
+    const size_t damaged = 7;
+
+    pangolin::PacketStreamSource src;
+    src.driver = "test";
+    src.checksum = true;
+    pangolin::PacketStreamSource fixed = src;
+    fixed.data_size_bytes = TestPacket(0).size();
+    {
+        pangolin::PacketStreamWriter writer(filename);
+        REQUIRE(writer.AddSource(src) == 0);
+        REQUIRE(writer.AddSource(fixed) == 1);
+        for(size_t i=0; i < num_packets; ++i) {
+            const auto data = TestPacket(i);
+            writer.WriteSourcePacket(0, data.data(), 1000 + i, data.size());
+            const auto data0 = TestPacket(0);
+            writer.WriteSourcePacket(1, data0.data(), 1000 + i, data0.size());
+        }
+    }
+
+    // Flip one byte within the data of a single packet
+    {
+        std::fstream f(filename, std::ios::in | std::ios::out | std::ios::binary);
+        std::vector<char> bytes((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+        const auto data = TestPacket(damaged);
+        auto it = std::search(bytes.begin(), bytes.end(), data.begin(), data.end());
+        REQUIRE(it != bytes.end());
+        f.clear();
+        f.seekp(std::distance(bytes.begin(), it) + 10);
+        f.put(char(it[10] ^ 0x40));
+    }
+
+    pangolin::PacketStreamReader reader(filename);
+    REQUIRE(reader.Sources()[0].checksum);
+    for(size_t n=0; n < 2 * num_packets; ++n) {
+        auto packet = reader.NextFrame();
+        REQUIRE(packet.has_checksum);
+        const size_t i = packet.sequence_num;
+        const bool bad = packet.src == 0 && i == damaged;
+        REQUIRE(packet.VerifyChecksum() == !bad);
+        // Data remains readable after verification
+        const auto data = ReadData(packet);
+        REQUIRE((data == TestPacket(packet.src == 0 ? i : 0)) == !bad);
+    }
+
+    std::remove(filename.c_str());
+}
@@ -29,6 +29,7 @@
 #define PLOTTER_H
 
 #include <limits>
+#include <memory>
 
 #include <pangolin/display/view.h>
 #include <pangolin/gl/colour.h>
@@ -50,6 +51,8 @@ enum DrawingMode
     DrawingModeDashed = GL_LINES,
     DrawingModeLine = GL_LINE_STRIP,
     DrawingModeNone,
+    // Points accumulated into per-pixel counts and shown through a colour map
+    DrawingModeDensity,
 };
 
 struct Marker
@@ -193,6 +196,10 @@ public:
         showTicks = show;
     }
 
+    /// Colour map used by DrawingModeDensity series, named as in colormaps.glsl.h,
+    /// e.g. "viridis", "inferno", "hot" or "gray".
+    void SetDensityColourMap(const std::string& name);
+
 protected:
     struct PANGOLIN_EXPORT Tick
     {
@@ -211,6 +218,34 @@ protected:
         int location;
     };
 
+    // Single channel float render target
+    struct PANGOLIN_EXPORT DensityTarget
+    {
+        DensityTarget(GLint w, GLint h);
+
+        GlTexture tex;
+        GlFramebuffer fbo;
+    };
+
+    // Per-pixel sample counts of a DrawingModeDensity series
+    struct PANGOLIN_EXPORT DensityBuffer
+    {
+        DensityBuffer(GLint w, GLint h);
+
+        // Texture whose first texel holds the largest count once reduced
+        GlTexture& MaxCount();
+
+        DensityTarget counts;
+
+        // Successive 4x4 max reductions of counts, down to 1x1
+        std::vector<std::unique_ptr<DensityTarget>> reduced;
+
+        // View the counts were accumulated in, and the samples [begin,end) so far
+        XYRangef view;
+        size_t begin;
+        size_t end;
+    };
+
     struct PANGOLIN_EXPORT PlotSeries
     {
         PlotSeries();
@@ -224,6 +259,7 @@ protected:
         GLenum drawing_mode;
         Colour colour;
         bool used;
+        std::unique_ptr<DensityBuffer> density;
     };
 
     struct PANGOLIN_EXPORT PlotImplicit
@@ -243,6 +279,11 @@ protected:
         GlSlProgram prog;
     };
 
+    // Draw samples [begin,end) of ps from log with its current program
+    void DrawSeriesSamples(PlotSeries& ps, DataLog& log, size_t begin, size_t end);
+    void RenderDensity(PlotSeries& ps, DataLog& log, float sx, float sy, float ox, float oy);
+    void ReduceDensityMax(DensityBuffer& d);
+
     void FixSelection();
     void UpdateView();
     Tick FindTickFactor(float tick);
@@ -256,6 +297,9 @@ protected:
 
     GlSlProgram prog_lines;
     GlSlProgram prog_text;
+    GlSlProgram prog_density;
+    GlSlProgram prog_density_max;
+    std::string density_colourmap;
 
     std::vector<PlotSeries> plotseries;
     std::vector<Marker> plotmarkers;
@@ -26,6 +26,7 @@
  */
 
 #include <pangolin/gl/gldraw.h>
+#include <pangolin/gl/glprofiler.h>
 #include <pangolin/plot/plotter.h>
 #include <pangolin/display/default_font.h>
 
@@ -204,6 +205,7 @@ Plotter::Plotter(
     Plotter* linked_plotter_y
 )   : default_log(log),
       colour_wheel(0.6f),
+      density_colourmap("viridis"),
       rview_default(left,right,bottom,top), rview(rview_default), target(rview),
       selection(0,0,0,0),
       track(false), track_x("$i"), track_y(""),
@@ -371,8 +373,276 @@ XYRangef Plotter::ComputeAutoSelection()
     return range;
 }
 
+void Plotter::DrawSeriesSamples(PlotSeries& ps, DataLog& log, size_t begin, size_t end)
+{
+    static size_t id_size = 0;
+    static float* id_array = 0;
+
+    GlSlProgram& prog = ps.prog;
+    const GLenum mode = (ps.drawing_mode == pangolin::DrawingModeDensity) ? GL_POINTS : ps.drawing_mode;
+
+    for(const DataLogBlock* block = log.FirstBlock(); block; block = block->NextBlock()) {
+        // Part of [begin,end) within this block
+        const size_t first = std::max(begin, block->StartId());
+        const size_t last = std::min(end, block->StartId() + block->Samples());
+        if(first >= last) {
+            continue;
+        }
+
+        if(ps.contains_id ) {
+            if(id_size < block->Samples() ) {
+                // Create index array that we can bind
+                delete[] id_array;
+                id_size = block->MaxSamples();
+                id_array = new float[id_size];
+                for(size_t k=0; k < id_size; ++k) {
+                    id_array[k] = (float)k;
+                }
+            }
+            prog.SetUniform("u_id_offset",  (float)block->StartId() );
+        }
+
+        // Enable appropriate attributes
+        bool shouldRender = true;
+        for(size_t i=0; i< ps.attribs.size(); ++i) {
+            if(0 <= ps.attribs[i].plot_id && ps.attribs[i].plot_id < (int)block->Dimensions() ) {
+                glVertexAttribPointer(ps.attribs[i].location, 1, GL_FLOAT, GL_FALSE, (GLsizei)(block->Dimensions()*sizeof(float)), block->DimData(ps.attribs[i].plot_id) );
+                glEnableVertexAttribArray(ps.attribs[i].location);
+            }else if( ps.attribs[i].plot_id == -1 ){
+                glVertexAttribPointer(ps.attribs[i].location, 1, GL_FLOAT, GL_FALSE, 0, id_array );
+                glEnableVertexAttribArray(ps.attribs[i].location);
+            }else{
+                // bad id: don't render
+                shouldRender = false;
+                break;
+            }
+        }
+
+        if(shouldRender) {
+            // Draw geometry
+            glDrawArrays(mode, (GLint)(first - block->StartId()), (GLsizei)(last - first));
+            ps.used = true;
+        }
+
+        // Disable enabled attributes
+        for(size_t i=0; i< ps.attribs.size(); ++i) {
+            glDisableVertexAttribArray(ps.attribs[i].location);
+        }
+    }
+}
+
+Plotter::DensityTarget::DensityTarget(GLint w, GLint h)
+#ifndef HAVE_GLES
+    : tex(w, h, GL_R32F, false, 0, GL_RED, GL_FLOAT),
+#else
+    : tex(w, h),
+#endif
+      fbo(tex)
+{
+}
+
+Plotter::DensityBuffer::DensityBuffer(GLint w, GLint h)
+    : counts(w, h), begin(0), end(0)
+{
+    while(w > 1 || h > 1) {
+        w = (w + 3) / 4;
+        h = (h + 3) / 4;
+        reduced.emplace_back(new DensityTarget(w, h));
+    }
+}
+
+GlTexture& Plotter::DensityBuffer::MaxCount()
+{
+    return reduced.empty() ? counts.tex : reduced.back()->tex;
+}
+
+void Plotter::SetDensityColourMap(const std::string& name)
+{
+    density_colourmap = name;
+    prog_density.ClearShaders();
+}
+
+void Plotter::ReduceDensityMax(DensityBuffer& d)
+{
+#ifndef HAVE_GLES
+    if(!prog_density_max.Valid()) {
+        prog_density_max.AddShader( GlSlVertexShader,
+                             "#version 130\n"
+                             "attribute vec2 a_position;\n"
+                             "void main() {\n"
+                             "    gl_Position = vec4(a_position,0,1);\n"
+                             "}\n"
+                             );
+        prog_density_max.AddShader( GlSlFragmentShader,
+                             "#version 130\n"
+                             "uniform sampler2D u_src;\n"
+                             "uniform ivec2 u_src_size;\n"
+                             "void main() {\n"
+                             "  ivec2 base = 4 * ivec2(gl_FragCoord.xy);\n"
+                             "  float m = 0.0;\n"
+                             "  for(int j=0; j < 4; ++j) {\n"
+                             "    for(int i=0; i < 4; ++i) {\n"
+                             "      ivec2 p = base + ivec2(i,j);\n"
+                             "      if(p.x < u_src_size.x && p.y < u_src_size.y) {\n"
+                             "        m = max(m, texelFetch(u_src, p, 0).r);\n"
+                             "      }\n"
+                             "    }\n"
+                             "  }\n"
+                             "  gl_FragColor = vec4(m,0,0,0);\n"
+                             "}\n"
+                             );
+        prog_density_max.BindPangolinDefaultAttribLocationsAndLink();
+    }
+
+    // Each pass writes the max of 4x4 blocks of the previous level, so no
+    // counts need to come back to the CPU.
+    glDisable(GL_BLEND);
+    prog_density_max.SaveBind();
+    prog_density_max.SetUniform("u_src", 0);
+    GlTexture* src = &d.counts.tex;
+    for(auto& level : d.reduced) {
+        level->fbo.Bind();
+        glViewport(0, 0, level->tex.width, level->tex.height);
+        prog_density_max.SetUniform("u_src_size", src->width, src->height);
+        src->Bind();
+        glDrawRect(-1.0f, -1.0f, 1.0f, 1.0f);
+        level->fbo.Unbind();
+        src = &level->tex;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    prog_density_max.Unbind();
+    glEnable(GL_BLEND);
+#else
+    PANGOLIN_UNUSED(d);
+#endif
+}
+
+void Plotter::RenderDensity(PlotSeries& ps, DataLog& log, float sx, float sy, float ox, float oy)
+{
+#ifndef HAVE_GLES
+    // Most samples accumulated per frame, so that rendering time stays bounded.
+    // Larger logs fill in over several frames, newest samples first.
+    const size_t max_samples_per_frame = 1 << 22;
+
+    if(!prog_density.Valid()) {
+        prog_density.AddShader( GlSlVertexShader,
+                             "#version 130\n"
+                             "attribute vec2 a_position;\n"
+                             "uniform vec2 u_scale;\n"
+                             "uniform vec2 u_offset;\n"
+                             "void main() {\n"
+                             "    gl_Position = vec4(u_scale * (a_position + u_offset),0,1);\n"
+                             "}\n"
+                             );
+        prog_density.AddShader( GlSlFragmentShader,
+                             "#version 130\n"
+                             "#include \"colormaps.glsl.h\"\n"
+                             "uniform sampler2D u_counts;\n"
+                             "uniform sampler2D u_max;\n"
+                             "uniform vec2 u_origin;\n"
+                             "uniform vec2 u_size;\n"
+                             "void main() {\n"
+                             "  float c = texture2D(u_counts, (gl_FragCoord.xy - u_origin) / u_size).r;\n"
+                             "  if(c <= 0.0) discard;\n"
+                             "  float m = texelFetch(u_max, ivec2(0,0), 0).r;\n"
+                             "  float t = log(1.0 + c) / log(1.0 + m);\n"
+                             "  gl_FragColor = vec4(" + density_colourmap + "(t), 1.0);\n"
+                             "}\n",
+                             {}, {"/components/pango_opengl/shaders"}
+                             );
+        prog_density.BindPangolinDefaultAttribLocationsAndLink();
+    }
+
+    std::unique_ptr<DensityBuffer>& d = ps.density;
+    const size_t total = log.Samples();
+    bool reset = !d || d->counts.tex.width != v.w || d->counts.tex.height != v.h;
+    if(reset) {
+        d.reset(new DensityBuffer(v.w, v.h));
+    }
+
+    // Start again from the newest samples if the view or data have changed
+    // under us, or if more samples arrived than we can draw this frame.
+    reset = reset || d->view.x.min != rview.x.min || d->view.x.max != rview.x.max ||
+            d->view.y.min != rview.y.min || d->view.y.max != rview.y.max ||
+            total < d->end || total - d->end > max_samples_per_frame;
+    if(reset) {
+        d->counts.fbo.Bind();
+        glViewport(0, 0, v.w, v.h);
+        glDisable(GL_SCISSOR_TEST);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        d->counts.fbo.Unbind();
+        d->view = rview;
+        d->begin = total - std::min(total, max_samples_per_frame);
+        d->end = d->begin;
+    }
+
+    // Add new samples, then older ones with what remains of the budget
+    const size_t newer = total - d->end;
+    const size_t older = std::min(d->begin, max_samples_per_frame - newer);
+    if(newer || older) {
+        d->counts.fbo.Bind();
+        glViewport(0, 0, v.w, v.h);
+        glDisable(GL_SCISSOR_TEST);
+        glBlendFunc(GL_ONE, GL_ONE);
+        glPointSize(1.0f);
+
+        ps.prog.SaveBind();
+        ps.prog.SetUniform("u_scale",  sx, sy);
+        ps.prog.SetUniform("u_offset", ox, oy);
+        ps.prog.SetUniform("u_color", Colour(1.0f, 1.0f, 1.0f, 1.0f));
+        DrawSeriesSamples(ps, log, d->end, total);
+        DrawSeriesSamples(ps, log, d->begin - older, d->begin);
+        ps.prog.Unbind();
+        d->counts.fbo.Unbind();
+        d->begin -= older;
+        d->end = total;
+
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        ReduceDensityMax(*d);
+    }
+
+    // Back to the plot's own viewport after drawing into the counts
+    if(reset || newer || older) {
+        ActivateAndScissor();
+    }
+    ps.used = ps.used || d->end > d->begin;
+
+    if(d->end > d->begin) {
+        prog_density.SaveBind();
+        prog_density.SetUniform("u_scale",  sx, sy);
+        prog_density.SetUniform("u_offset", ox, oy);
+        prog_density.SetUniform("u_origin", (float)v.l, (float)v.b);
+        prog_density.SetUniform("u_size", (float)v.w, (float)v.h);
+        prog_density.SetUniform("u_counts", 0);
+        prog_density.SetUniform("u_max", 1);
+        glActiveTexture(GL_TEXTURE1);
+        d->MaxCount().Bind();
+        glActiveTexture(GL_TEXTURE0);
+        d->counts.tex.Bind();
+        glDrawRect(rview.x.min,rview.y.min,rview.x.max,rview.y.max);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        prog_density.Unbind();
+    }
+#else
+    // No float render targets, so draw as points
+    ps.prog.SaveBind();
+    ps.prog.SetUniform("u_scale",  sx, sy);
+    ps.prog.SetUniform("u_offset", ox, oy);
+    ps.prog.SetUniform("u_color", ps.colour );
+    DrawSeriesSamples(ps, log, 0, log.Samples());
+    ps.prog.Unbind();
+    PANGOLIN_UNUSED(sx); PANGOLIN_UNUSED(sy); PANGOLIN_UNUSED(ox); PANGOLIN_UNUSED(oy);
+#endif
+}
+
 void Plotter::Render()
 {
+    GlProfileScope profile("Plotter::Render");
+
     // Animate scroll / zooming
     UpdateView();
 
@@ -503,71 +773,29 @@ void Plotter::Render()
     //////////////////////////////////////////////////////////////////////////
     // Draw series
 
-    static size_t id_size = 0;
-    static float* id_array = 0;
-
     for(size_t i=0; i < plotseries.size(); ++i)
     {
         PlotSeries& ps = plotseries[i];
 
         if(ps.drawing_mode != pangolin::DrawingModeNone)
         {
-            GlSlProgram& prog = ps.prog;
             ps.used = false;
 
-            prog.SaveBind();
-            prog.SetUniform("u_scale",  sx, sy);
-            prog.SetUniform("u_offset", ox, oy);
-            prog.SetUniform("u_color", ps.colour );
-
             // TODO: Try to skip drawing of blocks which aren't in view.
             DataLog* log = ps.log ? ps.log : default_log;
             std::lock_guard<std::mutex> l(log->access_mutex);
 
-            const DataLogBlock* block = log->FirstBlock();
-            while(block) {
-                if(ps.contains_id ) {
-                    if(id_size < block->Samples() ) {
-                        // Create index array that we can bind
-                        delete[] id_array;
-                        id_size = block->MaxSamples();
-                        id_array = new float[id_size];
-                        for(size_t k=0; k < id_size; ++k) {
-                            id_array[k] = (float)k;
-                        }
-                    }
-                    prog.SetUniform("u_id_offset",  (float)block->StartId() );
-                }
-
-                // Enable appropriate attributes
-                bool shouldRender = true;
-                for(size_t i=0; i< ps.attribs.size(); ++i) {
-                    if(0 <= ps.attribs[i].plot_id && ps.attribs[i].plot_id < (int)block->Dimensions() ) {
-                        glVertexAttribPointer(ps.attribs[i].location, 1, GL_FLOAT, GL_FALSE, (GLsizei)(block->Dimensions()*sizeof(float)), block->DimData(ps.attribs[i].plot_id) );
-                        glEnableVertexAttribArray(ps.attribs[i].location);
-                    }else if( ps.attribs[i].plot_id == -1 ){
-                        glVertexAttribPointer(ps.attribs[i].location, 1, GL_FLOAT, GL_FALSE, 0, id_array );
-                        glEnableVertexAttribArray(ps.attribs[i].location);
-                    }else{
-                        // bad id: don't render
-                        shouldRender = false;
-                        break;
-                    }
-                }
-
-                if(shouldRender) {
-                    // Draw geometry
-                    glDrawArrays(ps.drawing_mode, 0, (GLsizei)block->Samples());
-                    ps.used = true;
-                }
-
-                // Disable enabled attributes
-                for(size_t i=0; i< ps.attribs.size(); ++i) {
-                    glDisableVertexAttribArray(ps.attribs[i].location);
-                }
-
-                block = block->NextBlock();
+            if(ps.drawing_mode == pangolin::DrawingModeDensity) {
+                RenderDensity(ps, *log, sx, sy, ox, oy);
+                continue;
             }
+
+            GlSlProgram& prog = ps.prog;
+            prog.SaveBind();
+            prog.SetUniform("u_scale",  sx, sy);
+            prog.SetUniform("u_offset", ox, oy);
+            prog.SetUniform("u_color", ps.colour );
+            DrawSeriesSamples(ps, *log, 0, log->Samples());
             prog.Unbind();
         }
     }
@@ -58,6 +58,9 @@ namespace py_pangolin {
     m.def("ShowFullscreen",
           &pangolin::ShowFullscreen);
 
+    m.def("ShowProfiler",
+          &pangolin::ShowProfiler);
+
     m.def("ShowConsole",
           &pangolin::ShowConsole);
 
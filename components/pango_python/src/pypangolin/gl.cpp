@@ -29,6 +29,9 @@
 #include <pangolin/gl/gl.h>
 #include <pybind11/numpy.h>
 
+#include <cstring>
+#include <vector>
+
 namespace py_pangolin {
 
   bool is_packed(const pybind11::buffer_info & info) {
@@ -42,6 +45,129 @@ namespace py_pangolin {
     return true;
   }
 
+  // Pointer to the contents of info packed in C order. This is info.ptr when
+  // already packed and otherwise a copy held in staging.
+  const void* packed_data(const pybind11::buffer_info & info, std::vector<unsigned char>& staging) {
+    if (info.size == 0 || is_packed(info)) {
+      return info.ptr;
+    }
+
+    // Copy the longest contiguous run of trailing dimensions at a time
+    pybind11::ssize_t run = info.itemsize;
+    pybind11::ssize_t outer_dims = info.ndim;
+    while (outer_dims > 0 && info.strides[outer_dims-1] == run) {
+      run *= info.shape[outer_dims-1];
+      --outer_dims;
+    }
+
+    staging.resize(info.size * info.itemsize);
+    std::vector<pybind11::ssize_t> index(outer_dims, 0);
+    for (unsigned char* dst = staging.data(); dst != staging.data() + staging.size(); dst += run) {
+      const unsigned char* src = (const unsigned char*)info.ptr;
+      for (pybind11::ssize_t d = 0; d < outer_dims; ++d) {
+        src += index[d] * info.strides[d];
+      }
+      std::memcpy(dst, src, run);
+      for (pybind11::ssize_t d = outer_dims-1; d >= 0 && ++index[d] == info.shape[d]; --d) {
+        index[d] = 0;
+      }
+    }
+    return staging.data();
+  }
+
+  GLenum gl_type_for_buffer(const pybind11::buffer_info & info) {
+    const char c = info.format.empty() ? 0 : info.format.back();
+    if (c == 'f' || c == 'd') {
+      if (info.itemsize == 4) return GL_FLOAT;
+#ifndef HAVE_GLES
+      if (info.itemsize == 8) return GL_DOUBLE;
+#endif
+    } else if (c == 'B' || c == 'H' || c == 'I' || c == 'L' || c == 'Q') {
+      if (info.itemsize == 1) return GL_UNSIGNED_BYTE;
+      if (info.itemsize == 2) return GL_UNSIGNED_SHORT;
+      if (info.itemsize == 4) return GL_UNSIGNED_INT;
+    } else if (c == 'b' || c == 'h' || c == 'i' || c == 'l' || c == 'q') {
+      if (info.itemsize == 1) return GL_BYTE;
+      if (info.itemsize == 2) return GL_SHORT;
+      if (info.itemsize == 4) return GL_INT;
+    }
+    throw std::runtime_error("no GL type for buffer format '" + info.format + "'");
+  }
+
+  GLenum gl_format_for_channels(pybind11::ssize_t channels) {
+    switch (channels) {
+      case 1: return GL_LUMINANCE;
+      case 2: return GL_LUMINANCE_ALPHA;
+      case 3: return GL_RGB;
+      case 4: return GL_RGBA;
+      default: throw std::runtime_error("no GL format for " + std::to_string(channels) + " channels");
+    }
+  }
+
+  // Upload a buffer of any other shape, read in C order, as the whole texture.
+  // This keeps flat buffers working as they did before arrays were shaped.
+  void upload_texture_whole(pangolin::GlTexture & texture, const pybind11::buffer_info & info, GLenum data_format, GLenum data_type, GLint x, GLint y) {
+    const pybind11::ssize_t pixels = (pybind11::ssize_t)texture.width * texture.height;
+    if (x != 0 || y != 0 || pixels == 0 || info.size % pixels != 0) {
+      throw std::runtime_error("GlTexture.Upload: flat data must fill the whole texture, use an (h,w) or (h,w,channels) array for regions");
+    }
+    if (!data_format) data_format = gl_format_for_channels(info.size / pixels);
+    if (!data_type) data_type = gl_type_for_buffer(info);
+
+    std::vector<unsigned char> staging;
+    pybind11::gil_scoped_release release;
+    const void* ptr = packed_data(info, staging);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    texture.Upload(ptr, data_format, data_type);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  }
+
+  // Upload an (h,w) or (h,w,channels) array into texture at (x,y), inferring
+  // the format and type from the array when they are zero. Buffers of other
+  // shapes fill the whole texture, see upload_texture_whole().
+  void upload_texture(pangolin::GlTexture & texture, pybind11::buffer b, GLenum data_format, GLenum data_type, GLint x, GLint y) {
+    pybind11::buffer_info info = b.request();
+    if (info.ndim != 2 && info.ndim != 3) {
+      upload_texture_whole(texture, info, data_format, data_type, x, y);
+      return;
+    }
+    const GLint h = (GLint)info.shape[0];
+    const GLint w = (GLint)info.shape[1];
+    const pybind11::ssize_t channels = info.ndim == 3 ? info.shape[2] : 1;
+    if (x < 0 || y < 0 || x + w > texture.width || y + h > texture.height) {
+      throw std::runtime_error("GlTexture.Upload: array does not fit in texture");
+    }
+    if (!data_format) data_format = gl_format_for_channels(channels);
+    if (!data_type) data_type = gl_type_for_buffer(info);
+
+    // Rows of packed pixels can be read in place, whatever the row pitch
+    const pybind11::ssize_t pixel_bytes = info.itemsize * channels;
+    GLint row_length = 0;
+    bool in_place = (info.ndim == 2 || info.strides[2] == info.itemsize) &&
+        info.strides[1] == pixel_bytes && info.strides[0] >= w * pixel_bytes &&
+        info.strides[0] % pixel_bytes == 0;
+    if (in_place && info.strides[0] != w * pixel_bytes) {
+#ifndef HAVE_GLES
+      row_length = (GLint)(info.strides[0] / pixel_bytes);
+#else
+      in_place = false;
+#endif
+    }
+
+    std::vector<unsigned char> staging;
+    pybind11::gil_scoped_release release;
+    const void* ptr = in_place ? info.ptr : packed_data(info, staging);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+#ifndef HAVE_GLES
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, row_length);
+#endif
+    texture.Upload(ptr, x, y, w, h, data_format, data_type);
+#ifndef HAVE_GLES
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#endif
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  }
+
   void bind_gl(pybind11::module &m) {
 
     pybind11::class_<pangolin::GlTexture>(m, "GlTexture")
@@ -50,10 +176,7 @@ namespace py_pangolin {
       .def("Reinitialise", &pangolin::GlTexture::Reinitialise)
       .def("Bind", &pangolin::GlTexture::Bind)
       .def("Unbind", &pangolin::GlTexture::Unbind)
-      .def("Upload", [](pangolin::GlTexture & texture, pybind11::buffer b, GLenum data_format, GLenum type){
-        pybind11::buffer_info info = b.request();
-        texture.Upload(info.ptr, data_format, type);
-      })
+      .def("Upload", &upload_texture, pybind11::arg("data"), pybind11::arg("data_format")=0, pybind11::arg("data_type")=0, pybind11::arg("x")=0, pybind11::arg("y")=0)
       .def("Download", [](pangolin::GlTexture & texture, pybind11::buffer b, GLenum data_layout, GLenum data_type) {
         pybind11::buffer_info info = b.request();
         if (!is_packed(info)) {
@@ -102,14 +225,48 @@ namespace py_pangolin {
       .def("Unbind", &pangolin::GlBufferData::Unbind)
       .def("Upload", [](pangolin::GlBufferData & gl_buffer, pybind11::buffer b, GLsizeiptr size_bytes, GLintptr offset) {
         pybind11::buffer_info info = b.request();
-        gl_buffer.Upload(info.ptr, size_bytes, offset);
-      }, pybind11::arg("data"), pybind11::arg("size_bytes"), pybind11::arg("offset")=0)
+        const GLsizeiptr data_bytes = info.size * info.itemsize;
+        if (size_bytes < 0) {
+          size_bytes = data_bytes;
+        } else if (size_bytes > data_bytes) {
+          throw std::runtime_error("GlBufferData.Upload: size_bytes exceeds the data given");
+        }
+        std::vector<unsigned char> staging;
+        pybind11::gil_scoped_release release;
+        gl_buffer.Upload(packed_data(info, staging), size_bytes, offset);
+      }, pybind11::arg("data"), pybind11::arg("size_bytes")=-1, pybind11::arg("offset")=0)
+#ifndef HAVE_GLES
+      // The returned array keeps the buffer alive but must not be used after Unmap()
+      .def("Map", [](pybind11::object self, GLintptr offset, GLsizeiptr size_bytes, GLbitfield access) {
+        pangolin::GlBufferData & gl_buffer = self.cast<pangolin::GlBufferData &>();
+        if (size_bytes < 0) {
+          size_bytes = gl_buffer.size_bytes - offset;
+        }
+        void* ptr = gl_buffer.Map(offset, size_bytes, access);
+        return pybind11::array(pybind11::dtype::of<uint8_t>(), {(size_t)size_bytes}, {(size_t)1}, ptr, self);
+      }, pybind11::arg("offset")=0, pybind11::arg("size_bytes")=-1, pybind11::arg("access")=GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT)
+      .def("Unmap", &pangolin::GlBufferData::Unmap)
+#endif
       .def_readwrite("size_bytes", &pangolin::GlBufferData::size_bytes);
 
     pybind11::class_<pangolin::GlBuffer, pangolin::GlBufferData>(m, "GlBuffer")
       .def(pybind11::init<>())
       .def(pybind11::init<pangolin::GlBufferType, GLuint, GLenum, GLuint, GLenum>(), pybind11::arg("buffer_type"), pybind11::arg("num_elements"), pybind11::arg("datatype"), pybind11::arg("count_per_element"), pybind11::arg("gluse")=GL_DYNAMIC_DRAW)
       .def("Resize", &pangolin::GlBuffer::Resize, pybind11::arg("num_elements"))
+      .def("UploadElements", [](pangolin::GlBuffer & gl_buffer, pybind11::buffer b, GLuint first) {
+        pybind11::buffer_info info = b.request();
+        if (gl_type_for_buffer(info) != gl_buffer.datatype) {
+          throw std::runtime_error("GlBuffer.UploadElements: array type does not match buffer datatype");
+        }
+        const GLsizeiptr element_bytes = gl_buffer.count_per_element * info.itemsize;
+        const GLsizeiptr data_bytes = info.size * info.itemsize;
+        if (element_bytes == 0 || data_bytes % element_bytes != 0) {
+          throw std::runtime_error("GlBuffer.UploadElements: array does not hold whole elements");
+        }
+        std::vector<unsigned char> staging;
+        pybind11::gil_scoped_release release;
+        gl_buffer.Upload(packed_data(info, staging), data_bytes, first * element_bytes);
+      }, pybind11::arg("data"), pybind11::arg("first")=0)
       .def_readwrite("num_elements", &pangolin::GlBuffer::num_elements)
       .def_readwrite("count_per_element", &pangolin::GlBuffer::count_per_element);
 
@@ -62,6 +62,7 @@ namespace py_pangolin {
       .value("DrawingModeDashed", pangolin::DrawingMode::DrawingModeDashed)
       .value("DrawingModeLine", pangolin::DrawingMode::DrawingModeLine)
       .value("DrawingModeNone", pangolin::DrawingMode::DrawingModeNone)
+      .value("DrawingModeDensity", pangolin::DrawingMode::DrawingModeDensity)
       .export_values();
 
     pybind11::class_<pangolin::Marker> marker(m, "Marker");
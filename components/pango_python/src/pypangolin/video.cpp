@@ -28,10 +28,13 @@
 #include "video.hpp"
 #include <pangolin/video/video_interface.h>
 #include <pangolin/video/video_input.h>
+#include <pangolin/video/video_output.h>
 
 #include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 
+#include <future>
+
 namespace py_pangolin {
 
     class PyVideoInterface: public pangolin::VideoInterface{
@@ -390,6 +393,165 @@ namespace py_pangolin {
       return pjson;
   }
 
+  // Returns obj as an array of T that can be written without copying: rows
+  // may be strided, but pixels within a row must be densely packed.
+  // Anything else falls back to a converted contiguous copy.
+  template<typename T>
+  pybind11::array StreamArray(pybind11::handle obj)
+  {
+      pybind11::array arr = pybind11::array::ensure(obj);
+      if(arr && pybind11::isinstance<pybind11::array_t<T>>(arr) && (arr.ndim() == 2 || arr.ndim() == 3)) {
+          const int64_t channels = (arr.ndim() == 3) ? arr.shape(2) : 1;
+          const int64_t pixel_bytes = channels * arr.itemsize();
+          const bool dense_pixels = (arr.ndim() == 2 || arr.strides(2) == arr.itemsize());
+          const bool dense_rows = (arr.strides(1) == pixel_bytes);
+          const bool forward_pitch = (arr.strides(0) >= pixel_bytes * arr.shape(1));
+          if(dense_pixels && dense_rows && forward_pitch) {
+              return arr;
+          }
+      }
+      return pybind11::array_t<T, pybind11::array::c_style | pybind11::array::forcecast>::ensure(obj);
+  }
+
+  // Wrap each numpy array as an image for the corresponding output stream.
+  // arrays keeps any converted copies alive for as long as the images are used.
+  std::vector<pangolin::Image<unsigned char>> StreamImagesFromArrays(const pangolin::VideoOutput& vo, pybind11::list images, std::vector<pybind11::array>& arrays)
+  {
+      PANGO_ASSERT(images.size() == vo.Streams().size(), "length of input streams not consistent");
+
+      std::vector<pangolin::Image<unsigned char>> imgs;
+      for(size_t i=0; i < images.size(); ++i) {
+          const pangolin::StreamInfo& so = vo.Streams()[i];
+          const unsigned int bpc = so.PixFormat().channel_bit_depth;
+
+          pybind11::array arr;
+          if (bpc == 8){
+              arr = StreamArray<uint8_t>(images[i]);
+          }else if (bpc == 12 || bpc == 16){
+              arr = StreamArray<uint16_t>(images[i]);
+          }else if (bpc == 32){
+              arr = StreamArray<float_t>(images[i]);
+          }else if (bpc == 64){
+              arr = StreamArray<double_t>(images[i]);
+          }else{
+              PANGO_ASSERT(false, "format must have 8, 12, 16, 32 or 64 bit depth");
+          }
+          PANGO_ASSERT(arr, "input stream is not convertible to a numpy array");
+
+          const size_t channels = (arr.ndim() == 3) ? arr.shape(2) : 1;
+          PANGO_ASSERT((size_t)arr.shape(0) == so.Height() && (size_t)arr.shape(1) == so.Width(), "input stream dimensions don't match output stream");
+          PANGO_ASSERT(so.Width() * channels * (size_t)arr.itemsize() == so.RowBytes(), "input stream channels don't match output stream");
+
+          imgs.emplace_back((unsigned char*)arr.data(), so.Width(), so.Height(), (size_t)arr.strides(0));
+          arrays.push_back(arr);
+      }
+      return imgs;
+  }
+
+  // Add streams to vo matching the numpy images provided
+  void SetOutputStreamsFromArrays(pangolin::VideoOutput& vo, pybind11::list images, const std::vector<int> &streamsBitDepth, pybind11::object device_properties, const std::string& descriptive_uri)
+  {
+      PANGO_ASSERT(streamsBitDepth.size() == images.size() || streamsBitDepth.size() == 0);
+
+      // Setup stream info
+      for(size_t i = 0; i < images.size(); ++i){
+          // num bits per channel
+          auto arr = pybind11::array::ensure(images[i]);
+
+          // num channels
+          PANGO_ASSERT(arr.ndim() == 2 || arr.ndim() == 3, "Method only accepts ndarrays of 2 or 3 dimensions.");
+          const size_t channels = (arr.ndim() == 3) ? arr.shape(2) : 1;
+
+          std::string fmtStr;
+          if(pybind11::isinstance<pybind11::array_t<std::uint8_t>>(arr)){
+             if(channels == 1) fmtStr = "GRAY8";
+             else if(channels == 3) fmtStr = "RGB24";
+             else if(channels == 4) fmtStr = "RGBA32";
+             else PANGO_ASSERT(false, "Only 1, 3 and 4 channel uint8_t formats are supported.");
+          } else if (pybind11::isinstance<pybind11::array_t<std::uint16_t>>(arr)){
+             if(channels == 1) fmtStr = "GRAY16LE";
+             else if(channels == 3) fmtStr = "RGB48";
+             else if(channels == 4) fmtStr = "RGBA64";
+             else PANGO_ASSERT(false, "Only 1, 3 and 4 channel uint16_t formats are supported.");
+          } else if (pybind11::isinstance<pybind11::array_t<std::float_t>>(arr)){
+              if(channels == 1) fmtStr = "GRAY32F";
+              else if(channels == 3) fmtStr = "RGB96F";
+              else if(channels == 4) fmtStr = "RGBA128F";
+              else PANGO_ASSERT(false, "Only 1, 3 and 4 channel float_t formats are supported.");
+          } else if (pybind11::isinstance<pybind11::array_t<std::double_t>>(arr)){
+              if(channels == 1) fmtStr = "GRAY64F";
+              else PANGO_ASSERT(false, "Only 1 channel double_t format is supported.");
+          } else {
+              PANGO_ASSERT(false, "numpy dtype must be either uint8_t, uint16_t, float_t or double_t");
+          }
+
+          pangolin::PixelFormat pf = pangolin::PixelFormatFromString(fmtStr);
+          if(streamsBitDepth.size())
+              pf.channel_bit_depth = (unsigned int) streamsBitDepth[i];
+
+          vo.AddStream(pf, arr.shape(1), arr.shape(0));
+      }
+
+      picojson::value json_device_properties;
+      if(device_properties) {
+          json_device_properties = PicojsonFromPyObject(device_properties);
+      }
+
+      vo.SetStreams(descriptive_uri, json_device_properties);
+  }
+
+  // VideoOutput as bound to Python. It owns the chain of frames being written
+  // in the background by WriteStreamsAsync, and waits for them on destruction
+  // since they refer to it.
+  struct PyVideoOutput : public pangolin::VideoOutput
+  {
+      using pangolin::VideoOutput::VideoOutput;
+
+      ~PyVideoOutput() {
+          if(pending.valid()) pending.wait();
+      }
+
+      // Block until all frames submitted asynchronously have been written,
+      // rethrowing the first error amongst them. Must be called with the GIL held.
+      void Flush() {
+          if(pending.valid()) {
+              const std::shared_future<int> last = pending;
+              pending = std::shared_future<int>();
+              pybind11::gil_scoped_release release;
+              last.get();
+          }
+      }
+
+      // Last frame submitted asynchronously. Each write waits on the previous
+      // so that frames stay in order, and fails without writing if it failed.
+      std::shared_future<int> pending;
+  };
+
+  // Handle to a frame being encoded and written in the background
+  struct VideoOutputWrite
+  {
+      ~VideoOutputWrite() {
+          // Arrays must outlive the write
+          if(result.valid()) {
+              pybind11::gil_scoped_release release;
+              result.wait();
+          }
+      }
+
+      int Wait() {
+          pybind11::gil_scoped_release release;
+          return result.get();
+      }
+
+      bool Done() const {
+          return result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+      }
+
+      pybind11::object output;
+      std::vector<pybind11::array> arrays;
+      std::shared_future<int> result;
+  };
+
   void bind_video(pybind11::module& m){
         pybind11::class_<pangolin::VideoInterface, PyVideoInterface > video_interface(m, "VideoInterface");
     video_interface
@@ -538,62 +700,21 @@ namespace py_pangolin {
       .def("IsRecording", &pangolin::VideoInput::IsRecording)
       .def("__iter__", [](pybind11::object s) { return VideoInputIterator(s.cast<pangolin::VideoInput&>(), s);});
 
-    pybind11::class_<pangolin::VideoOutput>(m, "VideoOutput", video_output_interface)
+    pybind11::class_<VideoOutputWrite>(m, "VideoOutputWrite")
+      .def("Wait", &VideoOutputWrite::Wait)
+      .def("Done", &VideoOutputWrite::Done);
+
+    pybind11::class_<PyVideoOutput>(m, "VideoOutput", video_output_interface)
       .def(pybind11::init<>())
       .def(pybind11::init<const std::string&>())
       .def("IsOpen", &pangolin::VideoOutput::IsOpen)
-      .def("Open", &pangolin::VideoOutput::Open)
-      .def("Close", &pangolin::VideoOutput::Close)
+      .def("Open", [](PyVideoOutput& vo, const std::string& uri){ vo.Flush(); vo.Open(uri); })
+      .def("Close", [](PyVideoOutput& vo){ vo.Flush(); vo.Close(); })
       .def("Streams", &pangolin::VideoOutput::Streams)
-      .def("WriteStreams", [](pangolin::VideoOutput& vo, pybind11::list images, const std::vector<int> &streamsBitDepth, pybind11::object frame_properties, pybind11::object device_properties, const std::string& descriptive_uri){
+      .def("WriteStreams", [](PyVideoOutput& vo, pybind11::list images, const std::vector<int> &streamsBitDepth, pybind11::object frame_properties, pybind11::object device_properties, const std::string& descriptive_uri){
+        vo.Flush();
         if(vo.SizeBytes()==0) {
-            PANGO_ASSERT(streamsBitDepth.size() == images.size() || streamsBitDepth.size() == 0);
-
-            // Setup stream info
-            for(size_t i = 0; i < images.size(); ++i){
-                // num bits per channel
-                auto arr = pybind11::array::ensure(images[i]);
-
-                // num channels
-                PANGO_ASSERT(arr.ndim() == 2 || arr.ndim() == 3, "Method only accepts ndarrays of 2 or 3 dimensions.");
-                const size_t channels = (arr.ndim() == 3) ? arr.shape(2) : 1;
-
-                std::string fmtStr;
-                if(pybind11::isinstance<pybind11::array_t<std::uint8_t>>(arr)){
-                   if(channels == 1) fmtStr = "GRAY8";
-                   else if(channels == 3) fmtStr = "RGB24";
-                   else if(channels == 4) fmtStr = "RGBA32";
-                   else PANGO_ASSERT(false, "Only 1, 3 and 4 channel uint8_t formats are supported.");
-                } else if (pybind11::isinstance<pybind11::array_t<std::uint16_t>>(arr)){
-                   if(channels == 1) fmtStr = "GRAY16LE";
-                   else if(channels == 3) fmtStr = "RGB48";
-                   else if(channels == 4) fmtStr = "RGBA64";
-                   else PANGO_ASSERT(false, "Only 1, 3 and 4 channel uint16_t formats are supported.");
-                } else if (pybind11::isinstance<pybind11::array_t<std::float_t>>(arr)){
-                    if(channels == 1) fmtStr = "GRAY32F";
-                    else if(channels == 3) fmtStr = "RGB96F";
-                    else if(channels == 4) fmtStr = "RGBA128F";
-                    else PANGO_ASSERT(false, "Only 1, 3 and 4 channel float_t formats are supported.");
-                } else if (pybind11::isinstance<pybind11::array_t<std::double_t>>(arr)){
-                    if(channels == 1) fmtStr = "GRAY64F";
-                    else PANGO_ASSERT(false, "Only 1 channel double_t format is supported.");
-                } else {
-                    PANGO_ASSERT(false, "numpy dtype must be either uint8_t, uint16_t, float_t or double_t");
-                }
-
-                pangolin::PixelFormat pf = pangolin::PixelFormatFromString(fmtStr);
-                if(streamsBitDepth.size())
-                    pf.channel_bit_depth = (unsigned int) streamsBitDepth[i];
-
-                vo.AddStream(pf, arr.shape(1), arr.shape(0));
-            }
-
-            picojson::value json_device_properties;
-            if(device_properties) {
-                json_device_properties = PicojsonFromPyObject(device_properties);
-            }
-
-            vo.SetStreams(descriptive_uri, json_device_properties);
+            SetOutputStreamsFromArrays(vo, images, streamsBitDepth, device_properties, descriptive_uri);
         }
 
         picojson::value json_frame_properties;
@@ -601,39 +722,40 @@ namespace py_pangolin {
             json_frame_properties = PicojsonFromPyObject(frame_properties);
         }
 
-        std::unique_ptr<uint8_t[]> buffer(new uint8_t[vo.SizeBytes()]);
-        std::vector<pangolin::Image<unsigned char>> bimgs = vo.GetOutputImages(buffer.get());
-        PANGO_ASSERT(bimgs.size() == images.size(), "length of input streams not consistent");
-        for(size_t i=0; i < images.size(); ++i) {
-            const pangolin::StreamInfo& so = vo.Streams()[i];
-            const unsigned int bpc = so.PixFormat().channel_bit_depth;
-            const unsigned int Bpp = so.PixFormat().bpp / (8);
-            if (bpc == 8){
-                pybind11::array_t<uint8_t> arr = images[i].cast<pybind11::array_t<unsigned char, pybind11::array::c_style | pybind11::array::forcecast>>();
-                pangolin::Image<uint8_t> srcImg(arr.mutable_data(0,0), bimgs[i].w, bimgs[i].h, bimgs[i].w * Bpp);
-                pangolin::PitchedCopy((char*)bimgs[i].ptr, bimgs[i].pitch, (char*)srcImg.ptr,
-                                      srcImg.pitch, srcImg.pitch, srcImg.h);
-            }else if (bpc == 12 || bpc == 16){
-                pybind11::array_t<uint16_t> arr = images[i].cast<pybind11::array_t<uint16_t, pybind11::array::c_style | pybind11::array::forcecast>>();
-                pangolin::Image<uint16_t> srcImg(arr.mutable_data(0,0), bimgs[i].w, bimgs[i].h, bimgs[i].w * Bpp);
-                pangolin::PitchedCopy((char*)bimgs[i].ptr, bimgs[i].pitch, (char*)srcImg.ptr,
-                                      srcImg.pitch, srcImg.pitch, srcImg.h);
-            }else if (bpc == 32){
-                pybind11::array_t<float_t> arr = images[i].cast<pybind11::array_t<float_t, pybind11::array::c_style | pybind11::array::forcecast>>();
-                pangolin::Image<float_t> srcImg(arr.mutable_data(0,0), bimgs[i].w, bimgs[i].h, bimgs[i].w * Bpp);
-                pangolin::PitchedCopy((char*)bimgs[i].ptr, bimgs[i].pitch, (char*)srcImg.ptr,
-                                      srcImg.pitch, srcImg.pitch, srcImg.h);
-            }else if (bpc == 64){
-                pybind11::array_t<double_t> arr = images[i].cast<pybind11::array_t<double_t, pybind11::array::c_style | pybind11::array::forcecast>>();
-                pangolin::Image<double_t> srcImg(arr.mutable_data(0,0), bimgs[i].w, bimgs[i].h, bimgs[i].w * Bpp);
-                pangolin::PitchedCopy((char*)bimgs[i].ptr, bimgs[i].pitch, (char*)srcImg.ptr,
-                                      srcImg.pitch, srcImg.pitch, srcImg.h);
-            }else{
-                PANGO_ASSERT(false, "format must have 8, 12, 16, 32 or 64 bit depth");
-            }
+        std::vector<pybind11::array> arrays;
+        const std::vector<pangolin::Image<unsigned char>> imgs = StreamImagesFromArrays(vo, images, arrays);
+
+        pybind11::gil_scoped_release release;
+        return vo.WriteStreams(imgs, json_frame_properties);
+      }, pybind11::arg("images"), pybind11::arg("streamsBitDepth") = std::vector<int>(), pybind11::arg("frame_properties") = pybind11::none(), pybind11::arg("device_properties") = pybind11::none(), pybind11::arg("descriptive_uri") = "python://")
+      .def("WriteStreamsAsync", [](pybind11::object self, pybind11::list images, const std::vector<int> &streamsBitDepth, pybind11::object frame_properties, pybind11::object device_properties, const std::string& descriptive_uri){
+        // Arrays must not be modified until the returned write is done.
+        PyVideoOutput& vo = self.cast<PyVideoOutput&>();
+        if(vo.SizeBytes()==0) {
+            vo.Flush();
+            SetOutputStreamsFromArrays(vo, images, streamsBitDepth, device_properties, descriptive_uri);
         }
-        vo.WriteStreams(buffer.get(), json_frame_properties);
+
+        picojson::value json_frame_properties;
+        if(frame_properties) {
+            json_frame_properties = PicojsonFromPyObject(frame_properties);
+        }
+
+        std::unique_ptr<VideoOutputWrite> write(new VideoOutputWrite());
+        write->output = self;
+        const std::vector<pangolin::Image<unsigned char>> imgs = StreamImagesFromArrays(vo, images, write->arrays);
+
+        // vo waits for this task before it is destroyed
+        PyVideoOutput* out = &vo;
+        const std::shared_future<int> previous = vo.pending;
+        write->result = std::async(std::launch::async, [out, previous, imgs, json_frame_properties](){
+            if(previous.valid()) previous.get();
+            return out->WriteStreams(imgs, json_frame_properties);
+        }).share();
+        vo.pending = write->result;
+        return write;
       }, pybind11::arg("images"), pybind11::arg("streamsBitDepth") = std::vector<int>(), pybind11::arg("frame_properties") = pybind11::none(), pybind11::arg("device_properties") = pybind11::none(), pybind11::arg("descriptive_uri") = "python://")
+      .def("Flush", &PyVideoOutput::Flush)
       .def("IsPipe", &pangolin::VideoOutput::IsPipe)
       .def("AddStream", (void (pangolin::VideoOutput::*)(const pangolin::PixelFormat&, size_t,size_t,size_t))&pangolin::VideoOutput::AddStream)
       .def("AddStream", (void (pangolin::VideoOutput::*)(const pangolin::PixelFormat&, size_t,size_t))&pangolin::VideoOutput::AddStream)
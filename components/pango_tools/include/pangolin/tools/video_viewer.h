@@ -4,6 +4,7 @@
 #include <pangolin/windowing/window.h>
 #include <pangolin/video/video_input.h>
 
+#include <atomic>
 #include <functional>
 #include <mutex>
 #include <string>
@@ -61,7 +62,7 @@ public:
     void DrawEveryNFrames(int n);
 
 
-    // Register to be notified of new image data
+    // Register to be notified of new image data. Called from the grab thread.
     void SetFrameChangedCallback(FrameChangedCallbackFn cb);
 
     void WaitUntilExit();
@@ -78,7 +79,14 @@ public:
 protected:
     void RegisterDefaultKeyShortcutsAndPangoVariables();
 
+    // Grab (and record) frames until grab_running is cleared, handing every
+    // draw_nth_frame'th to the render loop through mailbox_buffer
+    void GrabLoop();
+
+    // Guards playback state. Never held whilst grabbing.
     std::mutex control_mutex;
+    // Guards use of video, which the grab thread holds whilst grabbing
+    std::mutex video_mutex;
     std::string window_name;
     std::thread vv_thread;
 
@@ -88,7 +96,9 @@ protected:
 
     std::string output_uri;
 
+    // Last frame grabbed (grab thread) and last drawn, shown as ui.frame
     int current_frame;
+    int display_frame;
     int grab_until;
     int record_nth_frame;
     int draw_nth_frame;
@@ -98,6 +108,19 @@ protected:
     uint16_t active_cam;
 
     FrameChangedCallbackFn frame_changed_callback;
+
+    std::thread grab_thread;
+    std::atomic<bool> grab_running;
+    std::atomic<int> seek_request;
+    std::atomic<size_t> frames_grabbed;
+    std::atomic<size_t> frames_dropped;
+
+    // Latest frame not yet drawn, if mailbox_fresh
+    std::mutex frame_mutex;
+    std::unique_ptr<unsigned char[]> grab_buffer;
+    std::unique_ptr<unsigned char[]> mailbox_buffer;
+    bool mailbox_fresh;
+    int mailbox_frame;
 };
 
 
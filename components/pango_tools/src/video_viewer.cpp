@@ -3,14 +3,20 @@
 #include <pangolin/gl/gldraw.h>
 #include <pangolin/gl/glpixformat.h>
 #include <pangolin/gl/gltexturecache.h>
+#include <pangolin/display/default_font.h>
 #include <pangolin/display/image_view.h>
 #include <pangolin/display/widgets.h>
 #include <pangolin/utils/file_utils.h>
 #include <pangolin/utils/sigstate.h>
+#include <pangolin/utils/thread_policy.h>
+#include <pangolin/utils/timer.h>
 #include <pangolin/video/video_input.h>
 #include <pangolin/handler/handler_image.h>
 #include <pangolin/var/var.h>
 
+#include <chrono>
+#include <cmath>
+
 
 namespace pangolin
 {
@@ -26,15 +32,22 @@ VideoViewer::VideoViewer(const std::string& window_name, const std::string& inpu
       video_interface(nullptr),
       output_uri(output_uri),
       current_frame(-1),
+      display_frame(-1),
       grab_until(std::numeric_limits<int>::max()),
       record_nth_frame(1),
       draw_nth_frame(1),
       video_grab_wait(true),
       video_grab_newest(false),
       should_run(true),
-      active_cam(0)
+      active_cam(0),
+      grab_running(false),
+      seek_request(-1),
+      frames_grabbed(0),
+      frames_dropped(0),
+      mailbox_fresh(false),
+      mailbox_frame(-1)
 {
-    pangolin::Var<int>::Attach("ui.frame", current_frame);
+    pangolin::Var<int>::Attach("ui.frame", display_frame);
     pangolin::Var<int>::Attach("ui.record_nth_frame", record_nth_frame);
     pangolin::Var<int>::Attach("ui.draw_nth_frame", draw_nth_frame);
 
@@ -86,7 +99,12 @@ void VideoViewer::Run()
     /// Register pangolin variables
     /////////////////////////////////////////////////////////////////////////
 
-    std::unique_ptr<unsigned char[]> buffer(new unsigned char[video.SizeBytes()+1]);
+    // Frames pass from grab_buffer (grab thread) to mailbox_buffer to
+    // render_buffer (this thread) by swapping, so neither thread copies.
+    grab_buffer.reset(new unsigned char[video.SizeBytes()+1]);
+    mailbox_buffer.reset(new unsigned char[video.SizeBytes()+1]);
+    std::unique_ptr<unsigned char[]> render_buffer(new unsigned char[video.SizeBytes()+1]);
+    mailbox_fresh = false;
 
     const int slider_size = (TotalFrames() < std::numeric_limits<int>::max() ? 20 : 0);
 
@@ -126,6 +144,16 @@ void VideoViewer::Run()
         }
     };
 
+    // Grab / render rates and frames which were replaced before being drawn
+    std::string stats;
+    pangolin::View& stats_view = pangolin::Display("stats").
+            SetBounds(pangolin::Attach::Pix(slider_size), pangolin::Attach::Pix(slider_size+20), 0.0, pangolin::Attach::Pix(360));
+    stats_view.extern_draw_function = [&](pangolin::View& v){
+        v.ActivatePixelOrthographic();
+        glColor3f(1.0f, 1.0f, 1.0f);
+        pangolin::default_font().Text(stats).Draw(4.0f, 6.0f);
+    };
+
     std::vector<pangolin::Image<unsigned char> > images;
 
     /////////////////////////////////////////////////////////////////////////
@@ -158,47 +186,142 @@ void VideoViewer::Run()
 
     video.Start();
 
-    // Stream and display video
+    // Grab (and record) on a separate thread so that neither slow sources
+    // nor vsync throttle the other
+    frames_grabbed = 0;
+    frames_dropped = 0;
+    seek_request = -1;
+    grab_running = true;
+    grab_thread = std::thread(&VideoViewer::GrabLoop, this);
+
+    size_t frames_rendered = 0;
+    size_t stats_grabbed = 0;
+    size_t stats_rendered = 0;
+    basetime stats_time = TimeNow();
+
+    // Display video at render rate
     while(should_run && !pangolin::ShouldQuit())
     {
         glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
         glColor3f(1.0f, 1.0f, 1.0f);
 
-        {
-            std::lock_guard<std::mutex> lock(control_mutex);
+        if(frame.GuiChanged()) {
+            seek_request = frame;
+        }
 
-            if(frame.GuiChanged()) {
-                if(video_playback) {
-                    frame = video_playback->Seek(frame) -1;
-                }
-                grab_until = frame + 1;
+        bool new_frame = false;
+        {
+            std::lock_guard<std::mutex> lock(frame_mutex);
+            if(mailbox_fresh) {
+                std::swap(mailbox_buffer, render_buffer);
+                display_frame = mailbox_frame;
+                mailbox_fresh = false;
+                new_frame = true;
             }
+        }
 
-            if ( frame < grab_until && video.Grab(&buffer[0], images, video_grab_wait, video_grab_newest)) {
-                frame = frame +1;
-
-                if(frame_changed_callback) {
-                    frame_changed_callback(buffer.get(), images, GetVideoFrameProperties(video_interface));
-                }
-
-                // Update images
-                if((frame-1) % draw_nth_frame == 0) {
-                    for(unsigned int i=0; i<images.size(); ++i)
-                        if(stream_views[i].IsShown()) {
-                            stream_views[i].SetImage(images[i], pangolin::GlPixFormat(video.Streams()[i].PixFormat() ));
-                        }
+        // Update images
+        if(new_frame) {
+            images.resize(video.Streams().size());
+            for(unsigned int i=0; i<images.size(); ++i) {
+                images[i] = video.Streams()[i].StreamImage(render_buffer.get());
+                if(stream_views[i].IsShown()) {
+                    stream_views[i].SetImage(images[i], video.Streams()[i].PixFormat());
                 }
             }
         }
 
+        ++frames_rendered;
+        const double stats_dt = TimeDiff_s(stats_time, TimeNow());
+        if(stats_dt >= 1.0) {
+            const size_t grabbed = frames_grabbed;
+            stats = FormatString("grab % Hz  render % Hz  dropped %",
+                (int)std::round((grabbed - stats_grabbed) / stats_dt),
+                (int)std::round((frames_rendered - stats_rendered) / stats_dt),
+                (size_t)frames_dropped
+            );
+            stats_grabbed = grabbed;
+            stats_rendered = frames_rendered;
+            stats_time = TimeNow();
+        }
+
         // leave in pixel orthographic for slider to render.
         pangolin::DisplayBase().ActivatePixelOrthographic();
         pangolin::FinishFrame();
     }
 
+    grab_running = false;
+    grab_thread.join();
+
     pangolin::DestroyWindow(window_name);
 }
 
+void VideoViewer::GrabLoop()
+{
+    ThreadPolicy policy;
+    policy.name = "pango_grab";
+    ApplyThreadPolicy(policy, false);
+
+    std::vector<pangolin::Image<unsigned char> > images;
+
+    while(grab_running)
+    {
+        // Only video_mutex is held whilst waiting on the video, so that
+        // playback controls never wait for a slow source.
+        const int seek = seek_request.exchange(-1);
+        int seek_frame = -1;
+        if(seek >= 0 && video_playback) {
+            std::lock_guard<std::mutex> lock(video_mutex);
+            seek_frame = video_playback->Seek(seek) -1;
+        }
+
+        bool grab, wait, newest;
+        FrameChangedCallbackFn callback;
+        {
+            std::lock_guard<std::mutex> lock(control_mutex);
+            if(seek >= 0) {
+                if(video_playback) {
+                    current_frame = seek_frame;
+                }
+                grab_until = current_frame + 1;
+            }
+            grab = current_frame < grab_until;
+            wait = video_grab_wait;
+            newest = video_grab_newest;
+            callback = frame_changed_callback;
+        }
+
+        bool grabbed = false;
+        if(grab) {
+            std::lock_guard<std::mutex> lock(video_mutex);
+            grabbed = video.Grab(grab_buffer.get(), images, wait, newest);
+            if(grabbed && callback) {
+                callback(grab_buffer.get(), images, GetVideoFrameProperties(video_interface));
+            }
+        }
+
+        if(grabbed) {
+            int frame_id;
+            {
+                std::lock_guard<std::mutex> lock(control_mutex);
+                frame_id = ++current_frame;
+            }
+            ++frames_grabbed;
+
+            // Hand over to the render loop, replacing any frame it hasn't drawn
+            if((frame_id-1) % draw_nth_frame == 0) {
+                std::lock_guard<std::mutex> frame_lock(frame_mutex);
+                if(mailbox_fresh) ++frames_dropped;
+                std::swap(grab_buffer, mailbox_buffer);
+                mailbox_frame = frame_id;
+                mailbox_fresh = true;
+            }
+        }else{
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
 void VideoViewer::RegisterDefaultKeyShortcutsAndPangoVariables()
 {
     pangolin::RegisterKeyPressCallback(' ', [this](){TogglePlay();} );
@@ -219,6 +342,7 @@ void VideoViewer::RegisterDefaultKeyShortcutsAndPangoVariables()
 
 void VideoViewer::OpenInput(const std::string& input_uri)
 {
+    std::lock_guard<std::mutex> video_lock(video_mutex);
     std::lock_guard<std::mutex> lock(control_mutex);
     video.Open(input_uri, output_uri);
 
@@ -251,13 +375,14 @@ void VideoViewer::OpenInput(const std::string& input_uri)
 
 void VideoViewer::CloseInput()
 {
+    std::lock_guard<std::mutex> video_lock(video_mutex);
     std::lock_guard<std::mutex> lock(control_mutex);
     video.Close();
 }
 
 void VideoViewer::Record()
 {
-    std::lock_guard<std::mutex> lock(control_mutex);
+    std::lock_guard<std::mutex> lock(video_mutex);
     if(!video.IsRecording()) {
         video.Record();
     }
@@ -265,13 +390,13 @@ void VideoViewer::Record()
 
 void VideoViewer::RecordOneFrame()
 {
-    std::lock_guard<std::mutex> lock(control_mutex);
+    std::lock_guard<std::mutex> lock(video_mutex);
     video.RecordOneFrame();
 }
 
 void VideoViewer::StopRecording()
 {
-    std::lock_guard<std::mutex> lock(control_mutex);
+    std::lock_guard<std::mutex> lock(video_mutex);
     if(video.IsRecording()) {
         video.Stop();
     }
@@ -285,7 +410,7 @@ void VideoViewer::TogglePlay()
 
 void VideoViewer::ToggleRecord()
 {
-    std::lock_guard<std::mutex> lock(control_mutex);
+    std::lock_guard<std::mutex> lock(video_mutex);
     if(!video.IsRecording()) {
         video.SetTimelapse( static_cast<size_t>(record_nth_frame) );
         video.Record();
@@ -364,10 +489,10 @@ void VideoViewer::Skip(int frames)
     std::lock_guard<std::mutex> lock(control_mutex);
 
     if(video_playback) {
+        // Seeks happen on the grab thread, between grabs
         const int next_frame = current_frame + frames;
         if (next_frame >= 0) {
-            current_frame = video_playback->Seek(next_frame) -1;
-            grab_until = current_frame + 1;
+            seek_request = next_frame;
         }
     }else{
         if(frames >= 0) {
@@ -381,7 +506,7 @@ void VideoViewer::Skip(int frames)
 
 bool VideoViewer::ChangeExposure(int delta_us)
 {
-    std::lock_guard<std::mutex> lock(control_mutex);
+    std::lock_guard<std::mutex> lock(video_mutex);
 
     std::vector<pangolin::GenicamVideoInterface*> ifs = FindMatchingVideoInterfaces<pangolin::GenicamVideoInterface>(video);
     std::string exposure_time;
@@ -397,7 +522,7 @@ bool VideoViewer::ChangeExposure(int delta_us)
 
 bool VideoViewer::ChangeGain(float delta)
 {
-    std::lock_guard<std::mutex> lock(control_mutex);
+    std::lock_guard<std::mutex> lock(video_mutex);
 
     std::vector<pangolin::GenicamVideoInterface*> ifs = FindMatchingVideoInterfaces<pangolin::GenicamVideoInterface>(video);
 
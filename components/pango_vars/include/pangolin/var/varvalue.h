@@ -65,6 +65,7 @@ public:
     void Reset()
     {
         value = default_value;
+        ++this->generation;
     }
 
     VarMeta& Meta()
@@ -85,6 +86,7 @@ public:
     void Set(const VarT& val)
     {
         value = val;
+        ++this->generation;
     }
 
 protected:
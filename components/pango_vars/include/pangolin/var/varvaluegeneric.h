@@ -92,6 +92,7 @@ class VarValueGeneric
 {
 public:
     VarValueGeneric()
+        : generation(0)
     {
     }
 
@@ -103,7 +104,17 @@ public:
     virtual void Reset() = 0;
     virtual VarMeta& Meta() = 0;
 
+    //! Incremented by Set() and Reset() so that observers such as widgets can
+    //! skip work when nothing changed. Writes through a reference returned by
+    //! Get(), or to a variable bound by reference, are not counted.
+    virtual size_t Generation() const
+    {
+        return generation;
+    }
+
 //protected:
+    size_t generation;
+
     // String serialisation object.
     std::shared_ptr<VarValueT<std::string>> str;
 };
@@ -65,6 +65,11 @@ public:
         return src->Meta();
     }
 
+    size_t Generation() const
+    {
+        return src->Generation();
+    }
+
     const T& Get() const
     {
         // This might throw, but we can't reset because this is a const method
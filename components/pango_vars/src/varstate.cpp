@@ -1,6 +1,8 @@
 #include <iostream>
 #include <fstream>
+#include <iterator>
 #include <pangolin/var/varstate.h>
+#include <pangolin/utils/json_reader.h>
 #include <pangolin/utils/picojson.h>
 #include <pangolin/utils/transform.h>
 
@@ -100,25 +102,29 @@ void VarState::AddOrSetGeneric(const std::string& name, const std::string& value
 
 void VarState::LoadFromJsonStream(std::istream& is)
 {
-    picojson::value file_json(picojson::object_type,true);
-    const std::string err = picojson::parse(file_json,is);
-    if(err.empty()) {
-        if(file_json.contains("vars") ) {
-            picojson::value var_json = file_json["vars"];
-            if(var_json.is<picojson::object>()) {
-                for(picojson::object::iterator
-                    i = var_json.get<picojson::object>().begin();
-                    i!= var_json.get<picojson::object>().end();
-                    ++i)
-                {
-                    const std::string& name = i->first;
-                    const std::string& val = i->second.get<std::string>();
-                    AddOrSetGeneric(name, val);
+    const std::string text{std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+
+    try {
+        JsonReader json(text);
+        json.BeginObject();
+        for(std::string key; json.NextKey(key); ) {
+            if(key != "vars" || json.Peek() != JsonReader::Type::Object) {
+                json.Skip();
+                continue;
+            }
+            json.BeginObject();
+            for(std::string name, val; json.NextKey(name); ) {
+                // Non-string values are taken verbatim, as they would be written
+                if(json.Peek() == JsonReader::Type::String) {
+                    json.ReadString(val);
+                }else{
+                    val = std::string(json.RawValue());
                 }
+                AddOrSetGeneric(name, val);
             }
         }
-    }else{
-        pango_print_error("%s\n", err.c_str());
+    }catch(const JsonReaderException& e) {
+        pango_print_error("%s\n", e.what());
     }
 }
 
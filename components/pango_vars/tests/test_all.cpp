@@ -407,3 +407,32 @@ SCENARIO("Var Events")
         }
     }
 }
+
+SCENARIO("Var Generation")
+{
+    VarState::I().Clear();
+
+    GIVEN("A Var") {
+        Var<int> x("gen_int", 1);
+        const size_t g0 = x.Ref()->Generation();
+
+        WHEN("It is set or reset") {
+            x = 2;
+            THEN("The generation advances") {
+                REQUIRE(x.Ref()->Generation() == g0 + 1);
+                x.Reset();
+                REQUIRE(x.Ref()->Generation() == g0 + 2);
+            }
+        }
+
+        WHEN("It is seen through a wrapper of another type") {
+            Var<double> as_double("gen_int");
+            const size_t gw = as_double.Ref()->Generation();
+            x = 5;
+            THEN("The wrapper reports the underlying generation") {
+                REQUIRE(as_double.Ref()->Generation() == gw + 1);
+                REQUIRE(as_double == 5.0);
+            }
+        }
+    }
+}
@@ -0,0 +1,103 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove, Richard Newcombe
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <pangolin/video/stream_encoder_factory.h>
+#include <pangolin/video/stream_info.h>
+#include <pangolin/utils/memstreambuf.h>
+
+#include <string>
+#include <vector>
+
+namespace pangolin
+{
+
+struct AdaptiveEncoderSettings
+{
+    // Encoder specs such as "lzf1" or "png12", or "raw" for uncompressed rows
+    std::vector<std::string> candidates = {"raw", "lzf1", "zstd1", "png12", "zstd5"};
+
+    // Share of the time between frames which encoding may take
+    double cpu_fraction = 0.8;
+
+    // Bytes per second which encoded frames may use, or 0 for no limit
+    double disk_bytes_per_sec = 0.0;
+};
+
+// Chooses among several lossless encoders for one stream, measuring the encode
+// time and compressed size of each on live frames. The encoder chosen is the
+// one which compresses best while keeping up with the frame rate within a
+// CPU budget, and within a disk bandwidth budget if one is given. Changes of
+// choice need a clear margin, so the encoder doesn't flip back and forth.
+//
+// Each encoded image is prefixed by one byte giving the index of the encoder
+// used, within the list recorded by Spec(), which StreamEncoderFactory can
+// decode.
+class PANGOLIN_EXPORT AdaptiveStreamEncoder
+{
+public:
+    // Candidates which are lossy, or can't encode images of stream, are dropped.
+    AdaptiveStreamEncoder(const StreamInfo& stream, const AdaptiveEncoderSettings& settings);
+
+    // Encoder spec for the stream header, e.g. "auto:raw,lzf1,png12"
+    std::string Spec() const;
+
+    // Name of the encoder currently preferred
+    const std::string& Current() const;
+
+    // Encode img, captured at time_us, to os.
+    void Encode(std::ostream& os, const Image<unsigned char>& img, int64_t time_us);
+
+private:
+    struct Candidate
+    {
+        std::string spec;
+        ImageEncoderFunc encoder;
+        size_t samples;
+        double seconds;
+        double bytes;
+    };
+
+    // Of time and disk budgets, the greatest fraction used by candidate c
+    double Load(const Candidate& c) const;
+
+    // Index of the candidate to use from now on, changing from current
+    // only by a clear margin if hysteresis is set
+    size_t Choose(bool hysteresis) const;
+
+    std::vector<Candidate> candidates;
+    AdaptiveEncoderSettings settings;
+
+    size_t current;
+    size_t frames;
+    int64_t last_time_us;
+    double frame_interval;
+    memstreambuf scratch;
+};
+
+}
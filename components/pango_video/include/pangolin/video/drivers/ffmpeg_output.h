@@ -52,6 +52,7 @@ public:
 
     void SetStreams(const std::vector<StreamInfo>& streams, const std::string& uri, const picojson::value& properties) override;
 
+    using VideoOutputInterface::WriteStreams;
     int WriteStreams(const unsigned char* data, const picojson::value& frame_properties) override;
 
     bool IsPipe() const override;
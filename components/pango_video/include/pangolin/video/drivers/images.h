@@ -40,12 +40,15 @@ namespace pangolin
 class PANGOLIN_EXPORT ImagesVideo : public VideoInterface, public VideoPlaybackInterface, public VideoPropertiesInterface
 {
 public:
-    ImagesVideo(const std::string& wildcard_path);
+    /// \param manifest_dir if not empty, directory in which to cache the
+    /// sorted file listing of large image directories between runs.
+    ImagesVideo(const std::string& wildcard_path, const std::string& manifest_dir = std::string());
 
     ImagesVideo(
         const std::string& wildcard_path, const PixelFormat& raw_fmt,
         size_t raw_width, size_t raw_height, size_t raw_pitch,
-        size_t raw_offset, size_t raw_planes
+        size_t raw_offset, size_t raw_planes,
+        const std::string& manifest_dir = std::string()
     );
 
     // Explicitly delete copy ctor and assignment operator.
@@ -105,6 +108,7 @@ protected:
     std::vector<StreamInfo> streams;
     size_t size_bytes;
     
+    std::string manifest_dir;
     size_t num_files;
     size_t num_channels;
     size_t next_frame_id;
@@ -121,8 +125,14 @@ protected:
 
     // Load any json properties if they are defined
     picojson::value device_properties;
-    picojson::value json_frames;
     picojson::value null_props;
+
+    // Archive text and the [offset,length) of each frame's properties within
+    // it. Properties are parsed on demand for the current frame only.
+    std::string json_text;
+    std::vector<std::pair<size_t,size_t>> frame_props_spans;
+    mutable size_t cached_props_frame = size_t(-1);
+    mutable picojson::value cached_props;
 };
 
 }
@@ -42,6 +42,7 @@ public:
 
     const std::vector<StreamInfo>& Streams() const override;
     void SetStreams(const std::vector<StreamInfo>& streams, const std::string& uri, const picojson::value& device_properties) override;
+    using VideoOutputInterface::WriteStreams;
     int WriteStreams(const unsigned char* data, const picojson::value& frame_properties) override;
     bool IsPipe() const override;
 
@@ -33,7 +33,7 @@ namespace pangolin
 {
 
 class PANGOLIN_EXPORT JoinVideo
-    : public VideoInterface, public VideoFilterInterface
+    : public VideoInterface, public VideoFilterInterface, public VideoLayoutInterface
 {
 public:
     JoinVideo(std::vector<std::unique_ptr<VideoInterface>> &src, const bool verbose);
@@ -62,12 +62,17 @@ public:
 
     std::vector<VideoInterface*>& InputStreams();
 
+    // Accepted only if every source accepts its share of the layout
+    bool SetStreamLayout(const std::vector<StreamInfo>& layout, size_t size_bytes);
+
 protected:
     int64_t GetAdjustedCaptureTime(size_t src_index);
 
     std::vector<std::unique_ptr<VideoInterface>> storage;
     std::vector<VideoInterface*> src;
     std::vector<bool> frame_seen;
+    // Offset of each source within our buffer
+    std::vector<size_t> src_offsets;
     std::vector<StreamInfo> streams;
     size_t size_bytes;
 
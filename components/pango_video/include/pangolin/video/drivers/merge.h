@@ -34,7 +34,7 @@ namespace pangolin
 {
 
 // Take N streams, and place them into one big buffer.
-class PANGOLIN_EXPORT MergeVideo : public VideoInterface, public VideoFilterInterface
+class PANGOLIN_EXPORT MergeVideo : public VideoInterface, public VideoFilterInterface, public VideoLayoutInterface
 {
 public:
     MergeVideo(std::unique_ptr<VideoInterface>& src, const std::vector<Point>& stream_pos, size_t w, size_t h);
@@ -53,8 +53,16 @@ public:
     bool GrabNewest( unsigned char* image, bool wait = true ) override;
 
     std::vector<VideoInterface*>& InputStreams() override;
+
+    bool SetStreamLayout(const std::vector<StreamInfo>& layout, size_t size_bytes) override;
     
 protected:
+    // Layout of src streams positioned within our output stream
+    std::vector<StreamInfo> MergedLayout() const;
+
+    // Grab src in place if it supports it, or via buffer otherwise
+    void NegotiateSrcLayout();
+
     void CopyBuffer(unsigned char* dst_bytes, unsigned char* src_bytes);
 
     std::unique_ptr<VideoInterface> src;
@@ -64,6 +72,7 @@ protected:
 
     std::vector<StreamInfo> streams;
     size_t size_bytes;
+    bool in_place;
 };
 
 }
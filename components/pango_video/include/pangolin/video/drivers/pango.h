@@ -37,9 +37,12 @@ namespace pangolin
 {
 
 class PANGOLIN_EXPORT PangoVideo
-    : public VideoInterface, public VideoPropertiesInterface, public VideoPlaybackInterface
+    : public VideoInterface, public VideoPropertiesInterface, public VideoPlaybackInterface,
+      public VideoLayoutInterface
 {
 public:
+    // filename may also be a segment pattern such as rec_%05d.pango, in which
+    // case the segments are played back in turn as a single video.
     PangoVideo(const std::string& filename, std::shared_ptr<PlaybackSession> playback_session);
     ~PangoVideo();
 
@@ -75,14 +78,26 @@ public:
 
     size_t Seek(size_t frameid) override;
 
+    // Implement VideoLayoutInterface
+
+    bool SetStreamLayout(const std::vector<StreamInfo>& layout, size_t size_bytes) override;
+
     std::string GetSourceUri();
 
 private:
     void HandlePipeClosed();
 
 protected:
-    int FindPacketStreamSource();
+    static int FindPacketStreamSource(const PacketStreamReader& reader);
+    void OpenSegments();
+    void SetSegment(size_t segment);
+    int64_t NextPacketTime() const;
     void SetupStreams(const PacketStreamSource& src);
+    void DecodePacket(Packet& fi, unsigned char* image);
+    void ReadFixedSizeStreams(Packet& fi, unsigned char* image);
+    void DecodeFromKeyframe(unsigned char* image);
+    size_t FindKeyframe(size_t frameid);
+    bool IsKeyframe(size_t frameid);
 
     const std::string _filename;
     std::shared_ptr<PlaybackSession> _playback_session;
@@ -94,11 +109,35 @@ protected:
     size_t _size_bytes;
     bool _fixed_size;
     std::vector<StreamInfo> _streams;
+    // Layout of streams as recorded, which may differ from _streams
+    std::vector<StreamInfo> _file_streams;
+    bool _custom_layout;
     std::vector<ImageDecoderFunc> stream_decoder;
     picojson::value _device_properties;
     picojson::value _frame_properties;
     std::string _source_uri;
 
+    // Non-zero if the stream contains delta frames
+    size_t _keyframe_interval;
+    size_t _last_decoded_id;
+    std::vector<unsigned char> _previous_frame;
+
+    // Files of a segmented recording, each numbering its frames from zero.
+    // _reader, _src_id and _source refer to the current one.
+    struct Segment
+    {
+        std::shared_ptr<PacketStreamReader> reader;
+        int src_id;
+        const PacketStreamSource* source;
+        size_t first_frame;
+        // False if the index was rebuilt without keyframe flags
+        bool keyframes_indexed = false;
+        // Frame types read back from packets when not indexed, 0 if not yet read
+        std::vector<char> frame_types;
+    };
+    std::vector<Segment> _segments;
+    size_t _segment;
+
     sigslot::scoped_connection session_seek;
 };
 
@@ -29,25 +29,91 @@
 
 #include <pangolin/video/video_output_interface.h>
 #include <pangolin/log/packetstream_writer.h>
+#include <pangolin/video/adaptive_stream_encoder.h>
 #include <pangolin/video/stream_encoder_factory.h>
 
+#include <pangolin/utils/thread_policy.h>
+
 #include <functional>
+#include <future>
+#include <memory>
 
 namespace pangolin
 {
 
+// Leading byte of every frame packet when keyframes are enabled.
+enum PangoFrameType : char
+{
+    PangoFrameKey = 'K',
+    PangoFrameDelta = 'D'
+};
+
+// Filename of a recording segment, from a pattern such as rec_%05d.pango with
+// one printf style integer field. Throws std::invalid_argument for other patterns.
+PANGOLIN_EXPORT
+std::string PangoSegmentFilename(const std::string& pattern, size_t segment);
+
+// Compression of whole frame packets by the PacketStreamWriter, after any
+// stream encoders. See PacketStreamSource::compression.
+struct PangoPacketCompression
+{
+    // "lz4", "zstd" or empty for none
+    std::string method;
+    int level = 1;
+
+    // Frames compressed together, see PacketStreamSource::compression_batch_bytes
+    size_t batch_bytes = 0;
+};
+
 class PANGOLIN_EXPORT PangoVideoOutput : public VideoOutputInterface
 {
 public:
-    PangoVideoOutput(const std::string& filename, size_t buffer_size_bytes, const std::map<size_t, std::string> &stream_encoder_uris);
+    // If keyframe_interval > 0, only every keyframe_interval'th frame is
+    // encoded in full. Frames in between are stored as the XOR of each
+    // stream against the previous frame before passing to the stream encoder.
+    // writer_policy applies to the file writing thread and encoder_policy to
+    // the threads encoding streams after the first (which encodes on the
+    // calling thread). If checksum is set, each frame is stored with a CRC32C.
+    // If segment_bytes or segment_us is non-zero, filename is a segment
+    // pattern (see PangoSegmentFilename) and a new file is started once the
+    // current one holds that much frame data or spans that long.
+    // Streams with encoder "auto" use an AdaptiveStreamEncoder configured by
+    // auto_settings, whose disk budget is shared between them by size.
+    // Frame packets are then compressed as a whole according to compression.
+    PangoVideoOutput(const std::string& filename, size_t buffer_size_bytes, const std::map<size_t, std::string> &stream_encoder_uris, size_t keyframe_interval = 0,
+                     const ThreadPolicy& writer_policy = ThreadPolicy(), const ThreadPolicy& encoder_policy = ThreadPolicy(),
+                     bool checksum = false, size_t segment_bytes = 0, int64_t segment_us = 0,
+                     const AdaptiveEncoderSettings& auto_settings = AdaptiveEncoderSettings(),
+                     const PangoPacketCompression& compression = PangoPacketCompression());
     ~PangoVideoOutput();
 
     const std::vector<StreamInfo>& Streams() const override;
     void SetStreams(const std::vector<StreamInfo>& streams, const std::string& uri, const picojson::value& device_properties) override;
     int WriteStreams(const unsigned char* data, const picojson::value& frame_properties) override;
+    int WriteStreams(const std::vector<Image<unsigned char>>& images, const picojson::value& frame_properties) override;
     bool IsPipe() const override;
 
+    // Whether EncodeFrame() may run on any thread, ahead of WriteEncodedFrame()
+    // writing its results in order. False when frames depend on earlier ones,
+    // i.e. with keyframe_interval or encoder=auto.
+    bool CanEncodeConcurrently() const;
+
+    // Encode one frame with streams laid out as Streams(), ready for WriteEncodedFrame()
+    void EncodeFrame(const unsigned char* data, std::vector<unsigned char>& encoded) const;
+
+    // Write a frame from EncodeFrame(). Frames must be written in order.
+    int WriteEncodedFrame(const std::vector<unsigned char>& encoded, const picojson::value& frame_properties);
+
 protected:
+    // Returns false if there is nothing to write to (e.g. pipe without reader)
+    bool ReadyToWrite();
+
+    // Open the following segment in the background, ready for NextSegmentIfDue()
+    void PrepareNextSegment();
+
+    // Switch to the next segment if the current one is full
+    void NextSegmentIfDue(int64_t time_us);
+
 //    void WriteHeader();
 
     std::vector<StreamInfo> streams;
@@ -55,7 +121,7 @@ protected:
     const std::string filename;
     picojson::value device_properties;
 
-    PacketStreamWriter packetstream;
+    std::unique_ptr<PacketStreamWriter> packetstream;
     size_t packetstream_buffer_size_bytes;
     int packetstreamsrcid;
     size_t total_frame_size;
@@ -64,6 +130,31 @@ protected:
     bool fixed_size;
     std::map<size_t, std::string> stream_encoder_uris;
     std::vector<ImageEncoderFunc> stream_encoders;
+    AdaptiveEncoderSettings auto_settings;
+    std::vector<std::unique_ptr<AdaptiveStreamEncoder>> auto_encoders;
+
+    size_t keyframe_interval;
+    size_t frames_since_keyframe;
+    std::vector<unsigned char> previous_frame;
+    std::vector<unsigned char> delta_frame;
+
+    ThreadPolicy writer_policy;
+    ThreadPolicy encoder_policy;
+    bool encoder_policy_reported;
+
+    bool checksum;
+    PangoPacketCompression compression;
+
+    size_t segment_bytes;
+    int64_t segment_us;
+    size_t segment;
+    int64_t segment_start_us;
+    PacketStreamSource segment_source;
+    std::future<std::unique_ptr<PacketStreamWriter>> next_segment;
+    std::future<void> closing_segment;
+
+    // Staging buffer for writing pitched images as fixed-size packets
+    std::vector<unsigned char> packed_frame;
 };
 
 }
@@ -33,7 +33,7 @@ namespace pangolin
 {
 
 // Video class that outputs test video signal.
-class PANGOLIN_EXPORT TestVideo : public VideoInterface
+class PANGOLIN_EXPORT TestVideo : public VideoInterface, public VideoLayoutInterface
 {
 public:
     TestVideo(size_t w, size_t h, size_t n, std::string pix_fmt);
@@ -56,10 +56,14 @@ public:
     
     //! Implement VideoInput::GrabNewest()
     bool GrabNewest( unsigned char* image, bool wait = true ) override;
+
+    //! Implement VideoLayoutInterface::SetStreamLayout()
+    bool SetStreamLayout(const std::vector<StreamInfo>& layout, size_t size_bytes) override;
     
 protected:
     std::vector<StreamInfo> streams;
     size_t size_bytes;
+    bool custom_layout;
 };
 
 }
@@ -30,6 +30,7 @@
 #include <memory>
 #include <pangolin/video/video_interface.h>
 #include <pangolin/utils/fix_size_buffer_queue.h>
+#include <pangolin/utils/thread_policy.h>
 
 namespace pangolin
 {
@@ -37,10 +38,13 @@ namespace pangolin
 
 // Video class that creates a thread that keeps pulling frames and processing from its children.
 class PANGOLIN_EXPORT ThreadVideo :  public VideoInterface, public VideoPropertiesInterface,
-        public BufferAwareVideoInterface, public VideoFilterInterface
+        public BufferAwareVideoInterface, public VideoFilterInterface, public VideoLayoutInterface
 {
 public:
     ThreadVideo(std::unique_ptr<VideoInterface>& videoin, size_t num_buffers, const std::string& name);
+
+    //! Grab thread is named, pinned and scheduled according to policy.
+    ThreadVideo(std::unique_ptr<VideoInterface>& videoin, size_t num_buffers, const ThreadPolicy& policy);
     ~ThreadVideo();
 
     //! Implement VideoInput::Start()
@@ -73,7 +77,14 @@ public:
 
     std::vector<VideoInterface*>& InputStreams();
 
+    //! Implement VideoLayoutInterface::SetStreamLayout()
+    //! Not in place: the grab thread still fills its own queue buffers, and
+    //! frames are copied out of the queue into the requested layout.
+    bool SetStreamLayout(const std::vector<StreamInfo>& layout, size_t size_bytes);
+
 protected:
+    void CopyFrame(unsigned char* image, const unsigned char* buffer);
+
     struct GrabResult
     {
         GrabResult(const size_t buffer_size)
@@ -96,13 +107,17 @@ protected:
     std::unique_ptr<VideoInterface> src;
     std::vector<VideoInterface*> videoin;
 
+    std::vector<StreamInfo> streams;
+    size_t size_bytes;
+    bool custom_layout;
+
     bool quit_grab_thread;
     FixSizeBuffersQueue<GrabResult> queue;
 
     std::condition_variable cv;
     std::mutex cvMtx;
     std::thread grab_thread;
-    std::string thread_name;
+    ThreadPolicy thread_policy;
 
     mutable picojson::value device_properties;
     picojson::value frame_properties;
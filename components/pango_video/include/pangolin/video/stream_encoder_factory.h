@@ -17,6 +17,12 @@ public:
     ImageEncoderFunc GetEncoder(const std::string& encoder_spec, const PixelFormat& fmt);
 
     ImageDecoderFunc GetDecoder(const std::string& encoder_spec, const PixelFormat& fmt);
+
+    // True if decoding an encoded image reproduces it bit-exactly.
+    bool IsLossless(const std::string& encoder_spec);
+
+    // Spec of a fast lossless encoder which works for fmt, or empty if none are available.
+    std::string DefaultLosslessEncoder(const PixelFormat& fmt);
 };
 
 }
@@ -32,6 +32,8 @@
 #include <pangolin/video/video_interface.h>
 #include <pangolin/video/video_output_interface.h>
 
+#include <cstring>
+
 namespace pangolin
 {
 
@@ -90,6 +92,75 @@ T* FindFirstMatchingVideoInterface( VideoInterface& video )
     return 0;
 }
 
+//! Returns true if images a and b, placed within the same buffer, share any bytes.
+inline
+bool StreamsOverlap(const StreamInfo& a, const StreamInfo& b)
+{
+    const size_t a0 = (size_t)a.Offset();
+    const size_t b0 = (size_t)b.Offset();
+    if(a0 + a.SizeBytes() <= b0 || b0 + b.SizeBytes() <= a0) {
+        return false;
+    }
+
+    // Images side by side with a shared pitch interleave rows without
+    // touching, so compare their rectangles of rows and row bytes.
+    const size_t p = a.Pitch();
+    if(p && p == b.Pitch() && a0 % p + a.RowBytes() <= p && b0 % p + b.RowBytes() <= p) {
+        const size_t ax = a0 % p, ay = a0 / p;
+        const size_t bx = b0 % p, by = b0 / p;
+        return ax < bx + b.RowBytes() && bx < ax + a.RowBytes() &&
+               ay < by + b.Height() && by < ay + a.Height();
+    }
+    return true;
+}
+
+//! Returns true if layout describes images of the same format and size as
+//! streams, each contained within a buffer of size_bytes and not overlapping
+//! one another.
+inline
+bool IsValidStreamLayout(const std::vector<StreamInfo>& streams, const std::vector<StreamInfo>& layout, size_t size_bytes)
+{
+    if(layout.size() != streams.size()) return false;
+    for(size_t i=0; i < layout.size(); ++i) {
+        const StreamInfo& a = streams[i];
+        const StreamInfo& b = layout[i];
+        if( a.PixFormat().format != b.PixFormat().format ||
+            a.Width() != b.Width() || a.Height() != b.Height() ||
+            b.Pitch() < b.RowBytes() ||
+            (size_t)b.Offset() + b.SizeBytes() > size_bytes )
+        {
+            return false;
+        }
+        for(size_t j=0; j < i; ++j) {
+            if(StreamsOverlap(layout[j], b)) return false;
+        }
+    }
+    return true;
+}
+
+//! Ask video to write its streams directly into layout within a buffer of
+//! size_bytes. Returns true if video supports and accepted the layout.
+inline
+bool NegotiateStreamLayout(VideoInterface& video, const std::vector<StreamInfo>& layout, size_t size_bytes)
+{
+    VideoLayoutInterface* vl = dynamic_cast<VideoLayoutInterface*>(&video);
+    return vl && vl->SetStreamLayout(layout, size_bytes);
+}
+
+//! Copy each stream of src_bytes in src_layout to dst_bytes in dst_layout
+inline
+void CopyStreams(unsigned char* dst_bytes, const std::vector<StreamInfo>& dst_layout, const unsigned char* src_bytes, const std::vector<StreamInfo>& src_layout)
+{
+    PANGO_ASSERT(dst_layout.size() == src_layout.size());
+    for(size_t i=0; i < src_layout.size(); ++i) {
+        Image<unsigned char> dst = dst_layout[i].StreamImage(dst_bytes);
+        const Image<unsigned char> src = src_layout[i].StreamImage(src_bytes);
+        for(size_t y=0; y < src.h; ++y) {
+            std::memcpy(dst.RowPtr(y), src.RowPtr(y), src_layout[i].RowBytes());
+        }
+    }
+}
+
 inline
 picojson::value GetVideoFrameProperties(VideoInterface* video)
 {
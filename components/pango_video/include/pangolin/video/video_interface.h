@@ -165,6 +165,23 @@ struct PANGOLIN_EXPORT VideoUvcInterface
     virtual bool SetGain(float gain) = 0;
 };
 
+//! Interface for video sources which can write their streams directly into
+//! a buffer layout chosen by their consumer, saving it an intermediate copy.
+//! Sources which grab ahead into their own queue (e.g. ThreadVideo) cannot
+//! decode in place, and instead copy each queued frame into the layout.
+struct PANGOLIN_EXPORT VideoLayoutInterface
+{
+    virtual ~VideoLayoutInterface() {}
+
+    //! Request that subsequent grabs write stream i into the region described
+    //! by layout[i], which must match Streams()[i] in format and dimension but
+    //! may use any offset and pitch within a buffer of size_bytes. Bytes outside
+    //! of these regions are left untouched. Should be called before Start().
+    //! Returns true if accepted, in which case Streams() and SizeBytes()
+    //! describe the new layout. Otherwise the existing layout is kept.
+    virtual bool SetStreamLayout(const std::vector<StreamInfo>& layout, size_t size_bytes) = 0;
+};
+
 struct PANGOLIN_EXPORT VideoPlaybackInterface
 {
     virtual ~VideoPlaybackInterface() {}
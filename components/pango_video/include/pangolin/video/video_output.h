@@ -69,6 +69,8 @@ public:
 
     int WriteStreams(const unsigned char* data, const picojson::value& frame_properties = picojson::value() ) override;
 
+    int WriteStreams(const std::vector<Image<unsigned char>>& images, const picojson::value& frame_properties = picojson::value() ) override;
+
     bool IsPipe() const override;
 
     void AddStream(const PixelFormat& pf, size_t w,size_t h,size_t pitch);
@@ -27,9 +27,12 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstring>
 #include <vector>
 #include <pangolin/platform.h>
 #include <pangolin/video/stream_info.h>
+#include <pangolin/video/video_exception.h>
 #include <pangolin/utils/picojson.h>
 
 namespace pangolin {
@@ -46,6 +49,35 @@ struct PANGOLIN_EXPORT VideoOutputInterface
 
     virtual int WriteStreams(const unsigned char* data, const picojson::value& frame_properties = picojson::value() ) = 0;
 
+    //! Write one frame given as a separate image per stream. Images may have
+    //! any pitch and need not share a buffer. The default implementation
+    //! packs them into the layout given by Streams(); outputs which can
+    //! consume each stream directly should override this to avoid the copy.
+    virtual int WriteStreams(const std::vector<Image<unsigned char>>& images, const picojson::value& frame_properties = picojson::value() )
+    {
+        const std::vector<StreamInfo>& streams = Streams();
+        if(images.size() != streams.size()) {
+            throw VideoException("WriteStreams: expected one image per stream");
+        }
+
+        size_t size_bytes = 0;
+        for(const StreamInfo& si : streams) {
+            size_bytes = std::max(size_bytes, (size_t)si.Offset() + si.SizeBytes());
+        }
+
+        std::vector<unsigned char> buffer(size_bytes);
+        for(size_t i=0; i < streams.size(); ++i) {
+            Image<unsigned char> dst = streams[i].StreamImage(buffer.data());
+            if(images[i].w != dst.w || images[i].h != dst.h) {
+                throw VideoException("WriteStreams: image dimensions don't match stream");
+            }
+            for(size_t row=0; row < dst.h; ++row) {
+                std::memcpy(dst.RowPtr(row), images[i].RowPtr(row), streams[i].RowBytes());
+            }
+        }
+        return WriteStreams(buffer.data(), frame_properties);
+    }
+
     virtual bool IsPipe() const = 0;
 };
 
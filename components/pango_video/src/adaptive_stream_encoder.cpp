@@ -0,0 +1,169 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove, Richard Newcombe
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <pangolin/video/adaptive_stream_encoder.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <sstream>
+
+namespace pangolin
+{
+
+namespace
+{
+// Frames given to each candidate before the first choice
+const size_t warmup_frames = 2;
+
+// Every this many frames, re-measure a candidate other than the current one
+const size_t probe_interval = 50;
+
+// Relative improvement needed before changing encoder
+const double switch_margin = 0.1;
+}
+
+AdaptiveStreamEncoder::AdaptiveStreamEncoder(const StreamInfo& stream, const AdaptiveEncoderSettings& settings)
+    : settings(settings), current(0), frames(0), last_time_us(0), frame_interval(0.0), scratch(stream.SizeBytes())
+{
+    // Keep encoders which work for this stream, judged on a blank image
+    std::vector<unsigned char> blank(stream.RowBytes() * stream.Height(), 0);
+    const Image<unsigned char> img(blank.data(), stream.Width(), stream.Height(), stream.RowBytes());
+
+    for(const std::string& spec : settings.candidates) {
+        if(!StreamEncoderFactory::I().IsLossless(spec)) {
+            continue;
+        }
+        try {
+            ImageEncoderFunc encoder = StreamEncoderFactory::I().GetEncoder(spec, stream.PixFormat());
+            std::ostringstream test;
+            encoder(test, img);
+            candidates.push_back({spec, encoder, 0, 0.0, 0.0});
+        }catch(const std::exception&) {
+        }
+    }
+
+    if(candidates.empty() || candidates.size() > std::numeric_limits<unsigned char>::max()) {
+        throw std::invalid_argument("No usable encoders for encoder=auto with format " + stream.PixFormat().format);
+    }
+}
+
+std::string AdaptiveStreamEncoder::Spec() const
+{
+    std::string spec = "auto:";
+    for(size_t i=0; i < candidates.size(); ++i) {
+        spec += (i ? "," : "") + candidates[i].spec;
+    }
+    return spec;
+}
+
+const std::string& AdaptiveStreamEncoder::Current() const
+{
+    return candidates[current].spec;
+}
+
+double AdaptiveStreamEncoder::Load(const Candidate& c) const
+{
+    if(frame_interval <= 0.0) {
+        return 0.0;
+    }
+    const double cpu = c.seconds / (frame_interval * settings.cpu_fraction);
+    const double disk = settings.disk_bytes_per_sec > 0.0 ? c.bytes / (frame_interval * settings.disk_bytes_per_sec) : 0.0;
+    return std::max(cpu, disk);
+}
+
+size_t AdaptiveStreamEncoder::Choose(bool hysteresis) const
+{
+    // Smallest output within budget, else the least over budget
+    size_t best = current;
+    for(size_t i=0; i < candidates.size(); ++i) {
+        const Candidate& c = candidates[i];
+        const Candidate& b = candidates[best];
+        const double load = Load(c), best_load = Load(b);
+        if(!c.samples) continue;
+        if((load <= 1.0 && (best_load > 1.0 || c.bytes < b.bytes)) || (load > 1.0 && load < best_load)) {
+            best = i;
+        }
+    }
+
+    if(!hysteresis || best == current) {
+        return best;
+    }
+
+    const Candidate& cur = candidates[current];
+    const double cur_load = Load(cur);
+    if(cur_load > 1.0 + switch_margin) {
+        // Falling behind
+        return best;
+    }
+    if(cur_load <= 1.0 && Load(candidates[best]) <= 1.0 - switch_margin &&
+       candidates[best].bytes < (1.0 - switch_margin) * cur.bytes) {
+        // Comfortably able to compress better
+        return best;
+    }
+    return current;
+}
+
+void AdaptiveStreamEncoder::Encode(std::ostream& os, const Image<unsigned char>& img, int64_t time_us)
+{
+    if(frames && time_us > last_time_us) {
+        const double dt = (time_us - last_time_us) * 1e-6;
+        frame_interval = frame_interval > 0.0 ? 0.9 * frame_interval + 0.1 * dt : dt;
+    }
+    last_time_us = time_us;
+
+    // Try each candidate in turn to begin with, then occasionally one other
+    const size_t n = candidates.size();
+    size_t index = current;
+    if(frames < warmup_frames * n) {
+        index = frames % n;
+    }else if(n > 1 && frames % probe_interval == 0) {
+        index = (current + 1 + (frames / probe_interval) % (n - 1)) % n;
+    }
+
+    Candidate& c = candidates[index];
+    scratch.clear();
+    std::ostream scratch_stream(&scratch);
+    const auto start = std::chrono::steady_clock::now();
+    c.encoder(scratch_stream, img);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const double alpha = c.samples ? 0.2 : 1.0;
+    c.seconds += alpha * (seconds - c.seconds);
+    c.bytes += alpha * (scratch.size() - c.bytes);
+    ++c.samples;
+    ++frames;
+
+    os.put((char)index);
+    os.write(reinterpret_cast<const char*>(scratch.data()), scratch.size());
+
+    if(frames >= warmup_frames * n) {
+        current = Choose(frames > warmup_frames * n);
+    }
+}
+
+}
@@ -29,6 +29,7 @@
 #include <pangolin/factory/factory_registry.h>
 #include <pangolin/video/iostream_operators.h>
 #include <pangolin/video/video.h>
+#include <pangolin/utils/task_scheduler.h>
 
 #ifdef HAVE_DC1394
 #   include <dc1394/conversions.h>
@@ -235,14 +236,19 @@ void ProcessImage(Image<Tout>& img_out, const Image<Tin>& img_in, bayer_method_t
 {
     if(method == BAYER_METHOD_NONE) {
         PitchedImageCopy(img_out, img_in.template UnsafeReinterpret<Tout>() );
-    }else if(method == BAYER_METHOD_DOWNSAMPLE_MONO) {
-        if( sizeof(Tout) == 1) {
-            DownsampleToMono<int,Tout, Tin>(img_out, img_in);
-        }else{
-            DownsampleToMono<double,Tout, Tin>(img_out, img_in);
-        }
-    }else if(method == BAYER_METHOD_DOWNSAMPLE) {
-        DownsampleDebayer(img_out, img_in, tile, wb_gains, has_metadata_line);
+    }else if(method == BAYER_METHOD_DOWNSAMPLE_MONO || method == BAYER_METHOD_DOWNSAMPLE) {
+        // Each output row depends only on two input rows, so split into bands.
+        ParallelForRows(img_out.h, 32, [&](size_t y0, size_t y1){
+            Image<Tout> out_band = img_out.SubImage(0, y0, img_out.w, y1 - y0);
+            const Image<Tin> in_band(const_cast<Tin*>(img_in.RowPtr(2*y0)), img_in.w, img_in.h - 2*y0, img_in.pitch);
+            if(method == BAYER_METHOD_DOWNSAMPLE) {
+                DownsampleDebayer(out_band, in_band, tile, wb_gains, has_metadata_line);
+            }else if( sizeof(Tout) == 1) {
+                DownsampleToMono<int,Tout, Tin>(out_band, in_band);
+            }else{
+                DownsampleToMono<double,Tout, Tin>(out_band, in_band);
+            }
+        });
     }else{
 #ifdef HAVE_DC1394
         if(sizeof(Tout) == 1) {
@@ -27,11 +27,13 @@
 
 #include <pangolin/factory/factory_registry.h>
 #include <pangolin/utils/file_utils.h>
+#include <pangolin/utils/json_reader.h>
 #include <pangolin/video/drivers/images.h>
 #include <pangolin/video/iostream_operators.h>
 
 #include <cstring>
 #include <fstream>
+#include <iterator>
 
 namespace pangolin
 {
@@ -59,36 +61,71 @@ bool ImagesVideo::LoadFrame(size_t i)
 
 void ImagesVideo::PopulateFilenamesFromJson(const std::string& filename)
 {
-    std::ifstream ifs( PathExpand(filename));
-    picojson::value json;
-    const std::string err = picojson::parse(json, ifs);
-    if(err.empty()) {
-        const std::string folder = PathParent(filename) + "/";
-        device_properties = json["device_properties"];
-        json_frames = json["frames"];
-
-        num_files = json_frames.size();
-        if(num_files == 0) {
-            throw VideoException("Empty Json Image archive.");
+    std::ifstream ifs( PathExpand(filename), std::ios::in | std::ios::binary);
+    if(!ifs.is_open()) {
+        throw VideoException("Unable to open Json Image archive: " + filename);
+    }
+    json_text.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+
+    const std::string folder = PathParent(filename) + "/";
+    std::vector<std::vector<std::string>> frame_files;
+    frame_props_spans.clear();
+
+    try {
+        JsonReader json(json_text);
+        json.BeginObject();
+        for(std::string key; json.NextKey(key); ) {
+            if(key == "device_properties") {
+                device_properties = json.ReadValue();
+            }else if(key == "frames") {
+                json.BeginArray();
+                while(json.NextElement()) {
+                    frame_files.emplace_back();
+                    std::pair<size_t,size_t> span(0,0);
+                    json.BeginObject();
+                    for(std::string frame_key; json.NextKey(frame_key); ) {
+                        if(frame_key == "stream_files") {
+                            json.ReadArray(frame_files.back());
+                        }else if(frame_key == "frame_properties") {
+                            const std::string_view raw = json.RawValue();
+                            span = {size_t(raw.data() - json_text.data()), raw.size()};
+                        }else{
+                            json.Skip();
+                        }
+                    }
+                    frame_props_spans.push_back(span);
+                }
+            }else{
+                json.Skip();
+            }
         }
+    }catch(const JsonReaderException& e) {
+        throw VideoException(filename + ": " + e.what());
+    }
 
-        num_channels = json_frames[0]["stream_files"].size();
-        if(num_channels == 0) {
-            throw VideoException("Empty Json Image archive.");
-        }
+    num_files = frame_files.size();
+    if(num_files == 0) {
+        throw VideoException("Empty Json Image archive.");
+    }
 
-        filenames.resize(num_channels);
-        for(size_t c=0; c < num_channels; ++c) {
-            filenames[c].resize(num_files);
-            for(size_t i = 0; i < num_files; ++i) {
-                const std::string path = json_frames[i]["stream_files"][c].get<std::string>();
-                filenames[c][i] = (path.size() && path[0] == '/') ? path : (folder + path);
+    num_channels = frame_files[0].size();
+    if(num_channels == 0) {
+        throw VideoException("Empty Json Image archive.");
+    }
+
+    filenames.resize(num_channels);
+    for(size_t c=0; c < num_channels; ++c) {
+        filenames[c].resize(num_files);
+        for(size_t i = 0; i < num_files; ++i) {
+            if(frame_files[i].size() != num_channels) {
+                throw VideoException(FormatString("Json Image archive frame % has % stream files, expected %.", i, frame_files[i].size(), num_channels));
             }
+            const std::string& path = frame_files[i][c];
+            filenames[c][i] = (path.size() && path[0] == '/') ? path : (folder + path);
         }
-        loaded.resize(num_files);
-    }else{
-        throw VideoException(err);
     }
+    loaded.resize(num_files);
+    cached_props_frame = size_t(-1);
 }
 
 void ImagesVideo::PopulateFilenames(const std::string& wildcard_path)
@@ -113,7 +150,7 @@ void ImagesVideo::PopulateFilenames(const std::string& wildcard_path)
 
     for(size_t i = 0; i < wildcards.size(); ++i) {
         const std::string channel_wildcard = PathExpand(wildcards[i]);
-        FilesMatchingWildcard(channel_wildcard, filenames[i],  SortMethod::NATURAL);
+        FilesMatchingWildcardCached(channel_wildcard, filenames[i], SortMethod::NATURAL, manifest_dir);
         if(num_files == size_t(-1)) {
             num_files = filenames[i].size();
         }else{
@@ -133,25 +170,43 @@ void ImagesVideo::PopulateFilenames(const std::string& wildcard_path)
 
 void ImagesVideo::ConfigureStreamSizes()
 {
+    // Image headers are enough to size the streams for common formats, so
+    // the first frame is only decoded up front when one of them can't be read.
+    std::vector<ImageFileInfo> infos(num_channels);
+    bool have_infos = !unknowns_are_raw;
+    for(size_t c=0; have_infos && c < num_channels; ++c) {
+        const std::string& filename = Filename(0,c);
+        have_infos = LoadImageInfo(filename, FileType(filename), infos[c]);
+    }
+
+    if(!have_infos) {
+        LoadFrame(0);
+        for(size_t c=0; c < num_channels; ++c) {
+            const TypedImage& img = loaded[0][c];
+            infos[c].fmt = img.fmt;
+            infos[c].w = img.w;
+            infos[c].h = img.h;
+            infos[c].pitch = img.pitch;
+        }
+    }
+
     size_bytes = 0;
     for(size_t c=0; c < num_channels; ++c) {
-        const TypedImage& img = loaded[0][c];
-        const StreamInfo stream_info(img.fmt, img.w, img.h, img.pitch, (unsigned char*)(size_bytes));
+        const ImageFileInfo& info = infos[c];
+        const StreamInfo stream_info(info.fmt, info.w, info.h, info.pitch, (unsigned char*)(size_bytes));
         streams.push_back(stream_info);
-        size_bytes += img.h*img.pitch;
+        size_bytes += info.h*info.pitch;
     }
 }
 
-ImagesVideo::ImagesVideo(const std::string& wildcard_path)
-    : num_files(-1), num_channels(0), next_frame_id(0),
+ImagesVideo::ImagesVideo(const std::string& wildcard_path, const std::string& manifest_dir)
+    : manifest_dir(manifest_dir), num_files(-1), num_channels(0), next_frame_id(0),
       unknowns_are_raw(false)
 {
     // Work out which files to sequence
     PopulateFilenames(wildcard_path);
 
-    // Load first image in order to determine stream sizes etc
-    LoadFrame(next_frame_id);
-
+    // Determine stream sizes etc from the first frame
     ConfigureStreamSizes();
 
     // TODO: Queue frames in another thread.
@@ -162,8 +217,9 @@ ImagesVideo::ImagesVideo(
     const PixelFormat& raw_fmt,
     size_t raw_width, size_t raw_height,
     size_t raw_pitch, size_t raw_offset,
-    size_t raw_planes
-) : num_files(-1), num_channels(0), next_frame_id(0),
+    size_t raw_planes,
+    const std::string& manifest_dir
+) : manifest_dir(manifest_dir), num_files(-1), num_channels(0), next_frame_id(0),
     unknowns_are_raw(true), raw_fmt(raw_fmt),
     raw_width(raw_width), raw_height(raw_height),
     raw_planes(raw_planes), raw_pitch(raw_pitch),
@@ -172,9 +228,7 @@ ImagesVideo::ImagesVideo(
     // Work out which files to sequence
     PopulateFilenames(wildcard_path);
 
-    // Load first image in order to determine stream sizes etc
-    LoadFrame(next_frame_id);
-
+    // Determine stream sizes etc from the first frame
     ConfigureStreamSizes();
 
     // TODO: Queue frames in another thread.
@@ -267,11 +321,13 @@ const picojson::value& ImagesVideo::FrameProperties() const
 {
     const size_t frame = GetCurrentFrameId();
 
-    if( json_frames.evaluate_as_boolean() && frame < json_frames.size()) {
-        const picojson::value& frame_props = json_frames[frame];
-        if(frame_props.contains("frame_properties")) {
-            return frame_props["frame_properties"];
+    if( frame < frame_props_spans.size() && frame_props_spans[frame].second > 0) {
+        if(cached_props_frame != frame) {
+            const char* props = json_text.data() + frame_props_spans[frame].first;
+            cached_props = JsonReader(props, props + frame_props_spans[frame].second).ReadValue();
+            cached_props_frame = frame;
         }
+        return cached_props;
     }
 
     return null_props;
@@ -295,7 +351,8 @@ PANGOLIN_REGISTER_FACTORY(ImagesVideo)
                 {"size","640x480","RAW files only. Image size, required if fmt is specified"},
                 {"pitch","0","RAW files only. Specify distance from the start of one row to the next in bytes. If not specified, assumed image is packed."},
                 {"offset","0","Offset from the start of the file in bytes where the image starts"},
-                {"planes","1","Number of channel planes (outer array channels) for raw image. fmt should be the format of an element in the individual plane."}
+                {"planes","1","Number of channel planes (outer array channels) for raw image. fmt should be the format of an element in the individual plane."},
+                {"manifest","1","Cache the sorted file list of large directories in the user cache directory (PANGOLIN_CACHE_DIR), reused until the directory is modified. Set to 0 to always list the directory."}
             }};
         }
         std::unique_ptr<VideoInterface> Open(const Uri& uri) override {
@@ -303,6 +360,7 @@ PANGOLIN_REGISTER_FACTORY(ImagesVideo)
 
             const bool raw = reader.Contains("fmt");
             const std::string path = PathExpand(uri.url);
+            const std::string manifest_dir = reader.Get<bool>("manifest") ? DefaultCacheDir() : std::string();
 
             if(raw) {
                 const std::string sfmt = reader.Get<std::string>("fmt");
@@ -312,10 +370,10 @@ PANGOLIN_REGISTER_FACTORY(ImagesVideo)
                 const size_t image_offset = reader.Get<int>("offset");
                 const size_t image_planes = reader.Get<int>("planes");
                 return std::unique_ptr<VideoInterface>( new ImagesVideo(
-                    path, fmt, dim.x, dim.y, image_pitch, image_offset, image_planes
+                    path, fmt, dim.x, dim.y, image_pitch, image_offset, image_planes, manifest_dir
                 ));
             }else{
-                return std::unique_ptr<VideoInterface>( new ImagesVideo(path) );
+                return std::unique_ptr<VideoInterface>( new ImagesVideo(path, manifest_dir) );
             }
         }
     };
@@ -27,6 +27,7 @@
 
 #include <thread>
 #include <pangolin/factory/factory_registry.h>
+#include <pangolin/utils/async_log.h>
 #include <pangolin/video/drivers/join.h>
 #include <pangolin/video/iostream_operators.h>
 #include <pangolin/video/video.h>
@@ -77,6 +78,7 @@ JoinVideo::JoinVideo(std::vector<std::unique_ptr<VideoInterface>>& src_, const b
             const Image<unsigned char> img_offset = si.StreamImage((unsigned char*)size_bytes);
             streams.push_back(StreamInfo(fmt, img_offset));
         }
+        src_offsets.push_back(size_bytes);
         size_bytes += src[s]->SizeBytes();
     }
 }
@@ -180,7 +182,7 @@ int64_t JoinVideo::GetAdjustedCaptureTime(size_t src_index)
             {
                 transfer_time_us = src[src_index]->SizeBytes() / transfer_bandwidth_bytes_per_us;
             }
-            std::cerr << "JoinVideo: Stream " << src_index << " does contain PANGO_ESTIMATED_CENTER_CAPTURE_TIME_US using incorrect fallback. " << std::endl;
+            pango_log_limited(LogLevel::Warn, 5000, "JoinVideo: Stream %zu does not contain PANGO_ESTIMATED_CENTER_CAPTURE_TIME_US, using incorrect fallback.\n", src_index);
             return props[PANGO_HOST_RECEPTION_TIME_US].get<int64_t>() - transfer_time_us;
         }
         else
@@ -203,7 +205,7 @@ int64_t JoinVideo::GetAdjustedCaptureTime(size_t src_index)
                         {
                             transfer_time_us = src[src_index]->SizeBytes() / transfer_bandwidth_bytes_per_us;
                         }
-                     std::cerr << "JoinVideo: Stream " << src_index << " does contain PANGO_ESTIMATED_CENTER_CAPTURE_TIME_US using incorrect fallback. " << std::endl;
+                        pango_log_limited(LogLevel::Warn, 5000, "JoinVideo: Stream %zu does not contain PANGO_ESTIMATED_CENTER_CAPTURE_TIME_US, using incorrect fallback.\n", src_index);
                         return streams[0][PANGO_HOST_RECEPTION_TIME_US].get<int64_t>() - transfer_time_us;
                     }
                 }
@@ -234,9 +236,9 @@ bool JoinVideo::GrabNext(unsigned char* image, bool wait)
 
     while (true)
     {
-        size_t offset = 0;
         for(size_t s = 0; s < src.size(); ++s)
         {
+            const size_t offset = src_offsets[s];
             if (capture_us[s] == 0) {
                 if(src[s]->GrabNext(image + offset, false))
                 {
@@ -254,8 +256,6 @@ bool JoinVideo::GrabNext(unsigned char* image, bool wait)
                     unfilled_images -= 1;
                 }
             }
-
-            offset += src[s]->SizeBytes();
         }
 
         if (!wait || unfilled_images == 0)
@@ -271,19 +271,18 @@ bool JoinVideo::GrabNext(unsigned char* image, bool wait)
         if (sync_tolerance_us != 0 && total_sleep_us > total_sleep_threshold_us)
         {
             // We've waited long enough. Report on which cameras were not responding.
-            pango_print_warn(
-                "JoinVideo: Not all frames were delivered within the threshold of %zuus. Cameras not reporting:\n",
-                total_sleep_threshold_us);
+            std::string blocked_streams;
             for(size_t blocked = 0; blocked < src.size(); ++blocked)
             {
                 if (capture_us[blocked] == 0)
                 {
                     // Unfortunately, at this level we don't have any good label/description for the stream.
-                    pango_print_warn("           Stream %zu%s\n",
-                                     blocked,
-                                     frame_seen[blocked] ? "" : " [never reported]");
+                    blocked_streams += " " + std::to_string(blocked) + (frame_seen[blocked] ? "" : " [never reported]");
                 }
             }
+            pango_log_limited(LogLevel::Warn, 1000,
+                "JoinVideo: Not all frames were delivered within the threshold of %zuus. Streams not reporting:%s\n",
+                total_sleep_threshold_us, blocked_streams.c_str());
             // Give up on this frame.
             break;
         }
@@ -303,7 +302,7 @@ bool JoinVideo::GrabNext(unsigned char* image, bool wait)
         {
             if(verbose)
             {
-                pango_print_warn(
+                pango_log_limited(LogLevel::Warn, 1000,
                     "JoinVideo: Source timestamps span  %lu us, not within %lu us. Ignoring frames, trying to "
                     "sync...\n",
                     (unsigned long)((*range.second - *range.first)),
@@ -348,7 +347,7 @@ bool JoinVideo::GrabNext(unsigned char* image, bool wait)
     }
     else
     {
-        pango_print_warn("JoinVideo: sync_tolerance_us = 0, frames are not synced!\n");
+        pango_log_limited(LogLevel::Warn, 5000, "JoinVideo: sync_tolerance_us = 0, frames are not synced!\n");
         return true;
     }
 }
@@ -391,7 +390,7 @@ bool JoinVideo::GrabNewest(unsigned char* image, bool wait)
                 auto bai = dynamic_cast<BufferAwareVideoInterface*>(src[s]);
                 if(!bai->DropNFrames(minN - 1))
                 {
-                    pango_print_error(
+                    pango_log_limited(LogLevel::Error, 1000,
                             "Stream %lu did not drop %u frames altough available.\n", (unsigned long)s, (minN - 1));
                     return false;
                 }
@@ -406,7 +405,7 @@ bool JoinVideo::GrabNewest(unsigned char* image, bool wait)
         // Simply calling GrabNewest on the child streams might cause loss of sync,
         // instead we perform as many GrabNext as possible on the first stream and
         // then pull the same number of frames from every other stream.
-        size_t offset = 0;
+        size_t offset = src_offsets[0];
         std::vector<size_t> offsets;
         std::vector<int64_t> reception_times;
         int64_t newest = std::numeric_limits<int64_t>::min();
@@ -430,7 +429,6 @@ bool JoinVideo::GrabNewest(unsigned char* image, bool wait)
             }
         } while(got_frame);
         offsets.push_back(offset);
-        offset += src[0]->SizeBytes();
         if(sync_tolerance_us > 0)
         {
             reception_times.push_back(rt);
@@ -443,6 +441,7 @@ bool JoinVideo::GrabNewest(unsigned char* image, bool wait)
 
         for(size_t s = 1; s < src.size(); ++s)
         {
+            offset = src_offsets[s];
             for(int i = 0; i < first_stream_backlog; i++)
             {
                 grabbed_any |= src[s]->GrabNext(image + offset, true);
@@ -452,7 +451,6 @@ bool JoinVideo::GrabNewest(unsigned char* image, bool wait)
                 }
             }
             offsets.push_back(offset);
-            offset += src[s]->SizeBytes();
             if(sync_tolerance_us > 0)
             {
                 reception_times.push_back(rt);
@@ -470,7 +468,7 @@ bool JoinVideo::GrabNewest(unsigned char* image, bool wait)
             {
                 if(verbose)
                 {
-                    pango_print_warn("Join timestamps not within %lu us trying to sync\n",
+                    pango_log_limited(LogLevel::Warn, 1000, "Join timestamps not within %lu us trying to sync\n",
                                  (unsigned long)sync_tolerance_us);
                 }
                 for(size_t n = 0; n < 10; ++n)
@@ -519,6 +517,39 @@ std::vector<VideoInterface*>& JoinVideo::InputStreams()
     return src;
 }
 
+bool JoinVideo::SetStreamLayout(const std::vector<StreamInfo>& layout, size_t layout_size_bytes)
+{
+    if(!IsValidStreamLayout(streams, layout, layout_size_bytes)) {
+        return false;
+    }
+
+    // Each source writes its own streams at their absolute offset in our buffer
+    std::vector<std::vector<StreamInfo>> prev_layouts;
+    std::vector<size_t> prev_sizes;
+    size_t first_stream = 0;
+    for(size_t s = 0; s < src.size(); ++s)
+    {
+        const size_t n = src[s]->Streams().size();
+        const std::vector<StreamInfo> src_layout(layout.begin() + first_stream, layout.begin() + first_stream + n);
+        prev_layouts.push_back(src[s]->Streams());
+        prev_sizes.push_back(src[s]->SizeBytes());
+
+        if(!NegotiateStreamLayout(*src[s], src_layout, layout_size_bytes)) {
+            // Put back those we've already changed
+            for(size_t r = 0; r < s; ++r) {
+                NegotiateStreamLayout(*src[r], prev_layouts[r], prev_sizes[r]);
+            }
+            return false;
+        }
+        first_stream += n;
+    }
+
+    std::fill(src_offsets.begin(), src_offsets.end(), 0);
+    streams = layout;
+    size_bytes = layout_size_bytes;
+    return true;
+}
+
 std::vector<std::string> SplitBrackets(const std::string src, char open = '{', char close = '}')
 {
     std::vector<std::string> splits;
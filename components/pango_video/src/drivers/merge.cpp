@@ -38,7 +38,7 @@ namespace pangolin
 {
 
 MergeVideo::MergeVideo(std::unique_ptr<VideoInterface>& src_, const std::vector<Point>& stream_pos, size_t w = 0, size_t h = 0 )
-    : src( std::move(src_) ), buffer(new uint8_t[src->SizeBytes()]), stream_pos(stream_pos)
+    : src( std::move(src_) ), stream_pos(stream_pos), in_place(false)
 {
     videoin.push_back(src.get());
 
@@ -69,6 +69,8 @@ MergeVideo::MergeVideo(std::unique_ptr<VideoInterface>& src_, const std::vector<
 
     size_bytes = w*h*fmt.bpp/8;
     streams.emplace_back(fmt,w,h,w*fmt.bpp/8,(unsigned char*)0);
+
+    NegotiateSrcLayout();
 }
 
 MergeVideo::~MergeVideo()
@@ -100,28 +102,41 @@ const std::vector<StreamInfo>& MergeVideo::Streams() const
     return streams;
 }
 
-void MergeVideo::CopyBuffer(unsigned char* dst_bytes, unsigned char* src_bytes)
+std::vector<StreamInfo> MergeVideo::MergedLayout() const
 {
-    Image<unsigned char> dst_image = Streams()[0].StreamImage(dst_bytes);
-    const size_t dst_pix_bytes = Streams()[0].PixFormat().bpp / 8;
+    const StreamInfo& dst = streams[0];
+    const size_t dst_pix_bytes = dst.PixFormat().bpp / 8;
 
+    std::vector<StreamInfo> layout;
     for(size_t i=0; i < stream_pos.size(); ++i) {
-        const StreamInfo& src_stream = src->Streams()[i];
-        const Image<unsigned char> src_image = src_stream.StreamImage(src_bytes);
+        const StreamInfo& si = src->Streams()[i];
         const Point& p = stream_pos[i];
-        for(size_t y=0; y < src_stream.Height(); ++y) {
-            // Copy row from src to dst
-            std::memcpy(
-                dst_image.RowPtr(y + p.y) + p.x * dst_pix_bytes,
-                src_image.RowPtr(y), src_stream.RowBytes()
-            );
-        }
+        unsigned char* offset = dst.Offset() + p.y * dst.Pitch() + p.x * dst_pix_bytes;
+        layout.emplace_back(si.PixFormat(), si.Width(), si.Height(), dst.Pitch(), offset);
+    }
+    return layout;
+}
+
+void MergeVideo::NegotiateSrcLayout()
+{
+    in_place = NegotiateStreamLayout(*src, MergedLayout(), size_bytes);
+    if(in_place) {
+        buffer.reset();
+    }else{
+        buffer.reset(new uint8_t[src->SizeBytes()]);
     }
 }
 
+void MergeVideo::CopyBuffer(unsigned char* dst_bytes, unsigned char* src_bytes)
+{
+    CopyStreams(dst_bytes, MergedLayout(), src_bytes, src->Streams());
+}
+
 //! Implement VideoInput::GrabNext()
 bool MergeVideo::GrabNext( unsigned char* image, bool wait )
 {
+    if(in_place) return src->GrabNext(image, wait);
+
     const bool success = src->GrabNext(buffer.get(), wait);
     if(success) CopyBuffer(image, buffer.get());
     return success;
@@ -130,11 +145,26 @@ bool MergeVideo::GrabNext( unsigned char* image, bool wait )
 //! Implement VideoInput::GrabNewest()
 bool MergeVideo::GrabNewest( unsigned char* image, bool wait )
 {
+    if(in_place) return src->GrabNewest(image, wait);
+
     const bool success = src->GrabNewest(buffer.get(), wait);
     if(success) CopyBuffer(image, buffer.get());
     return success;
 }
 
+bool MergeVideo::SetStreamLayout(const std::vector<StreamInfo>& layout, size_t layout_size_bytes)
+{
+    if(!IsValidStreamLayout(streams, layout, layout_size_bytes)) {
+        return false;
+    }
+
+    // We can always satisfy the layout, copying if src can't
+    streams = layout;
+    size_bytes = layout_size_bytes;
+    NegotiateSrcLayout();
+    return true;
+}
+
 std::vector<VideoInterface*>& MergeVideo::InputStreams()
 {
     return videoin;
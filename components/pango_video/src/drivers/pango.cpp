@@ -31,6 +31,12 @@
 #include <pangolin/utils/file_utils.h>
 #include <pangolin/utils/signal_slot.h>
 #include <pangolin/video/drivers/pango.h>
+#include <pangolin/video/drivers/pango_video_output.h>
+#include <pangolin/video/video.h>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
 
 #include <functional>
 
@@ -39,29 +45,63 @@ namespace pangolin
 
 const std::string pango_video_type = "raw_video";
 
+namespace
+{
+bool IsSegmentPattern(const std::string& filename)
+{
+    return filename.find('%') != std::string::npos;
+}
+}
+
 PangoVideo::PangoVideo(const std::string& filename, std::shared_ptr<PlaybackSession> playback_session)
     : _filename(filename),
       _playback_session(playback_session),
-      _reader(_playback_session->Open(filename)),
+      _reader(_playback_session->Open(IsSegmentPattern(filename) ? PangoSegmentFilename(filename, 0) : filename)),
       _event_promise(_playback_session->Time()),
-      _src_id(FindPacketStreamSource()),
-      _source(nullptr)
+      _src_id(FindPacketStreamSource(*_reader)),
+      _source(nullptr),
+      _custom_layout(false),
+      _keyframe_interval(0),
+      _last_decoded_id(-1),
+      _segment(0)
 {
     PANGO_ENSURE(_src_id != -1, "No appropriate video streams found in log.");
 
     _source = &_reader->Sources()[_src_id];
     SetupStreams(*_source);
+    OpenSegments();
+
+    if(_keyframe_interval) {
+        // A rebuilt index (e.g. of the last segment after a crash) won't know
+        // about keyframes, but we can infer them
+        for(Segment& seg : _segments) {
+            seg.keyframes_indexed = std::any_of(seg.source->index.begin(), seg.source->index.end(),
+                [](const PacketStreamSource::PacketInfo& info){ return !info.keyframe; }
+            );
+        }
+        _previous_frame.resize(_size_bytes);
+    }
 
     // Make sure we time-seek with other playback devices
     session_seek = _playback_session->Time().OnSeek.connect(
         [&](SyncTime::TimePoint t){
             _event_promise.Cancel();
+
+            // Use the first segment which doesn't end before t
+            const int64_t t_us = std::chrono::duration_cast<std::chrono::microseconds>(t.time_since_epoch()).count();
+            size_t s = 0;
+            while(s + 1 < _segments.size() && (_segments[s].source->index.empty() ||
+                  _segments[s].source->index.back().capture_time < t_us)) {
+                ++s;
+            }
+            SetSegment(s);
+
             _reader->Seek(_src_id, t);
-            _event_promise.WaitAndRenew(_source->NextPacketTime());
+            _event_promise.WaitAndRenew(NextPacketTime());
         }
     );
 
-    _event_promise.WaitAndRenew(_source->NextPacketTime());
+    _event_promise.WaitAndRenew(NextPacketTime());
 }
 
 PangoVideo::~PangoVideo()
@@ -92,42 +132,163 @@ bool PangoVideo::GrabNext(unsigned char* image, bool /*wait*/)
 {
     try
     {
+        if(_source->next_packet_id >= _source->index.size() && _segment + 1 < _segments.size()) {
+            // Continue from the start of the next segment
+            SetSegment(_segment + 1);
+            _reader->Seek(_src_id, 0);
+        }
+
+        if(_keyframe_interval) {
+            DecodeFromKeyframe(image);
+        }
+
         Packet fi = _reader->NextFrame(_src_id);
         _frame_properties = fi.meta;
+        DecodePacket(fi, image);
 
-        if(_fixed_size) {
-            fi.Stream().read(reinterpret_cast<char*>(image), _size_bytes);
+        _event_promise.WaitAndRenew(NextPacketTime());
+        return true;
+    }
+    catch(...)
+    {
+        _frame_properties = picojson::value();
+        return false;
+    }
+}
+
+void PangoVideo::DecodePacket(Packet& fi, unsigned char* image)
+{
+    bool keyframe = true;
+    if(_keyframe_interval) {
+        const char frame_type = fi.Stream().get();
+        PANGO_ENSURE(frame_type == PangoFrameKey || frame_type == PangoFrameDelta, "Unrecognised frame type.");
+        keyframe = (frame_type == PangoFrameKey);
+        PANGO_ENSURE(keyframe || _last_decoded_id + 1 == fi.sequence_num, "Delta frame without preceding frame.");
+    }
+
+    if(_fixed_size) {
+        if(_custom_layout) {
+            ReadFixedSizeStreams(fi, image);
         }else{
-            for(size_t s=0; s < _streams.size(); ++s) {
-                StreamInfo& si = _streams[s];
-                pangolin::Image<unsigned char> dst = si.StreamImage(image);
+            fi.Stream().read(reinterpret_cast<char*>(image), _size_bytes);
+        }
+    }else{
+        for(size_t s=0; s < _streams.size(); ++s) {
+            StreamInfo& si = _streams[s];
+            pangolin::Image<unsigned char> dst = si.StreamImage(image);
 
-                if(stream_decoder[s]) {
-                    pangolin::TypedImage img = stream_decoder[s](fi.Stream());
-                    PANGO_ENSURE(img.IsValid());
+            if(stream_decoder[s]) {
+                pangolin::TypedImage img = stream_decoder[s](fi.Stream());
+                PANGO_ENSURE(img.IsValid());
 
-                    // TODO: We can avoid this copy by decoding directly into img
-                    for(size_t row =0; row < dst.h; ++row) {
-                        std::memcpy(dst.RowPtr(row), img.RowPtr(row), si.RowBytes());
-                    }
-                }else{
-                    for(size_t row =0; row < dst.h; ++row) {
-                        fi.Stream().read((char*)dst.RowPtr(row), si.RowBytes());
+                // TODO: We can avoid this copy by decoding directly into img
+                for(size_t row =0; row < dst.h; ++row) {
+                    std::memcpy(dst.RowPtr(row), img.RowPtr(row), si.RowBytes());
+                }
+            }else{
+                for(size_t row =0; row < dst.h; ++row) {
+                    fi.Stream().read((char*)dst.RowPtr(row), si.RowBytes());
+                }
+            }
+        }
+    }
+
+    if(_keyframe_interval) {
+        // Undo the XOR against the previous frame and remember this one.
+        for(size_t s=0; s < _streams.size(); ++s) {
+            const StreamInfo& si = _streams[s];
+            pangolin::Image<unsigned char> dst = si.StreamImage(image);
+            pangolin::Image<unsigned char> prev = si.StreamImage(_previous_frame.data());
+            for(size_t row =0; row < dst.h; ++row) {
+                unsigned char* d = dst.RowPtr(row);
+                unsigned char* p = prev.RowPtr(row);
+                if(!keyframe) {
+                    for(size_t b=0; b < si.RowBytes(); ++b) {
+                        d[b] ^= p[b];
                     }
                 }
+                std::memcpy(p, d, si.RowBytes());
             }
         }
+    }
 
-        _event_promise.WaitAndRenew(_source->NextPacketTime());
-        return true;
+    _last_decoded_id = fi.sequence_num;
+}
+
+void PangoVideo::ReadFixedSizeStreams(Packet& fi, unsigned char* image)
+{
+    // Visit streams in the order they appear within the packet
+    std::vector<size_t> order(_streams.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b){
+        return _file_streams[a].Offset() < _file_streams[b].Offset();
+    });
+
+    size_t pos = 0;
+    for(size_t s : order) {
+        const StreamInfo& file_si = _file_streams[s];
+        pangolin::Image<unsigned char> dst = _streams[s].StreamImage(image);
+
+        const size_t offset = (size_t)file_si.Offset();
+        PANGO_ENSURE(offset >= pos, "Overlapping streams can't be relocated.");
+        fi.Stream().skip(offset - pos);
+        pos = offset;
+
+        for(size_t row =0; row < dst.h; ++row) {
+            if(row > 0) {
+                fi.Stream().skip(file_si.Pitch() - file_si.RowBytes());
+                pos += file_si.Pitch() - file_si.RowBytes();
+            }
+            fi.Stream().read((char*)dst.RowPtr(row), file_si.RowBytes());
+            pos += file_si.RowBytes();
+        }
     }
-    catch(...)
-    {
-        _frame_properties = picojson::value();
-        return false;
+}
+
+void PangoVideo::DecodeFromKeyframe(unsigned char* image)
+{
+    // After a seek, the frame before the next one may not have been decoded.
+    // Rewind to the nearest keyframe and decode forwards to restore it.
+    const size_t next_id = _source->next_packet_id;
+    if(next_id >= _source->index.size() || next_id == _last_decoded_id + 1) {
+        return;
+    }
+
+    // Reading frame types may have moved the reader, so always seek back
+    const size_t key_id = FindKeyframe(next_id);
+    _reader->Seek(_src_id, key_id);
+    for(size_t id = key_id; id < next_id; ++id) {
+        Packet fi = _reader->NextFrame(_src_id);
+        DecodePacket(fi, image);
     }
 }
 
+size_t PangoVideo::FindKeyframe(size_t frameid)
+{
+    if(_segments[_segment].keyframes_indexed) {
+        return _source->FindKeyframe(frameid);
+    }
+
+    // A rebuilt index doesn't know keyframes, and they needn't be regular
+    // (e.g. after a pipe reader reconnects), so read frame types instead.
+    while(frameid > 0 && !IsKeyframe(frameid)) {
+        --frameid;
+    }
+    return frameid;
+}
+
+bool PangoVideo::IsKeyframe(size_t frameid)
+{
+    std::vector<char>& frame_types = _segments[_segment].frame_types;
+    frame_types.resize(_source->index.size(), 0);
+    if(!frame_types[frameid]) {
+        _reader->Seek(_src_id, frameid);
+        Packet fi = _reader->NextFrame(_src_id);
+        frame_types[frameid] = (char)fi.Stream().get();
+    }
+    return frame_types[frameid] == PangoFrameKey;
+}
+
 bool PangoVideo::GrabNewest( unsigned char* image, bool wait )
 {
     return GrabNext(image, wait);
@@ -135,34 +296,102 @@ bool PangoVideo::GrabNewest( unsigned char* image, bool wait )
 
 size_t PangoVideo::GetCurrentFrameId() const
 {
-    return (int)(_reader->Sources()[_src_id].next_packet_id) - 1;
+    return _segments[_segment].first_frame + _source->next_packet_id - 1;
 }
 
 size_t PangoVideo::GetTotalFrames() const
 {
-    return _source->index.size();
+    return _segments.back().first_frame + _segments.back().source->index.size();
 }
 
 size_t PangoVideo::Seek(size_t next_frame_id)
 {
+    // Find the segment holding the frame
+    auto seg = std::upper_bound(_segments.begin(), _segments.end(), next_frame_id,
+        [](size_t id, const Segment& s){ return id < s.first_frame; }
+    ) - 1;
+    const size_t local_id = next_frame_id - seg->first_frame;
+
     // Get time for seek
-    if(next_frame_id < _source->index.size()) {
-        const int64_t capture_time = _source->index[next_frame_id].capture_time;
+    if(local_id < seg->source->index.size()) {
+        const int64_t capture_time = seg->source->index[local_id].capture_time;
         _playback_session->Time().Seek(SyncTime::TimePoint(std::chrono::microseconds(capture_time)));
+
+        // Frames can share a capture time, so land on the exact packet
+        SetSegment(seg - _segments.begin());
+        if(_source->next_packet_id != local_id) {
+            _reader->Seek(_src_id, local_id);
+        }
         return next_frame_id;
     }else{
-        return _source->next_packet_id;
+        return _segments[_segment].first_frame + _source->next_packet_id;
     }
 }
 
+bool PangoVideo::SetStreamLayout(const std::vector<StreamInfo>& layout, size_t size_bytes)
+{
+    if(!IsValidStreamLayout(_streams, layout, size_bytes)) {
+        return false;
+    }
+
+    _streams = layout;
+    _size_bytes = size_bytes;
+    _custom_layout = true;
+    if(_keyframe_interval) {
+        _previous_frame.assign(_size_bytes, 0);
+        _last_decoded_id = -1;
+    }
+    return true;
+}
+
 std::string PangoVideo::GetSourceUri()
 {
     return _source_uri;
 }
 
-int PangoVideo::FindPacketStreamSource()
+void PangoVideo::OpenSegments()
+{
+    _segments = {{_reader, _src_id, _source, 0}};
+    if(!IsSegmentPattern(_filename)) {
+        return;
+    }
+
+    for(size_t i = 1; FileExists(PangoSegmentFilename(_filename, i)); ++i) {
+        const Segment& prev = _segments.back();
+        auto reader = _playback_session->Open(PangoSegmentFilename(_filename, i));
+        const int src_id = FindPacketStreamSource(*reader);
+        PANGO_ENSURE(src_id != -1, "No video stream found in segment %.", i);
+        _segments.push_back({reader, src_id, &reader->Sources()[src_id], prev.first_frame + prev.source->index.size()});
+    }
+}
+
+void PangoVideo::SetSegment(size_t segment)
+{
+    if(segment == _segment) {
+        return;
+    }
+
+    _segment = segment;
+    _reader = _segments[segment].reader;
+    _src_id = _segments[segment].src_id;
+    _source = _segments[segment].source;
+
+    // Each segment begins with a keyframe
+    _last_decoded_id = -1;
+}
+
+int64_t PangoVideo::NextPacketTime() const
+{
+    if(_source->next_packet_id >= _source->index.size() && _segment + 1 < _segments.size()) {
+        const auto& next_index = _segments[_segment + 1].source->index;
+        return next_index.empty() ? 0 : next_index.front().capture_time;
+    }
+    return _source->NextPacketTime();
+}
+
+int PangoVideo::FindPacketStreamSource(const PacketStreamReader& reader)
 {
-    for(const auto& src : _reader->Sources())
+    for(const auto& src : reader.Sources())
     {
         if (!src.driver.compare(pango_video_type))
         {
@@ -181,6 +410,7 @@ void PangoVideo::SetupStreams(const PacketStreamSource& src)
     _source_uri = src.uri;
 
     _device_properties = src.info["device"];
+    _keyframe_interval = src.info.get_value<int64_t>("keyframe_interval", 0);
     const picojson::value& json_streams = src.info["streams"];
     const size_t num_streams = json_streams.size();
 
@@ -218,6 +448,7 @@ void PangoVideo::SetupStreams(const PacketStreamSource& src)
 
         _streams.push_back(si);
     }
+    _file_streams = _streams;
 }
 
 PANGOLIN_REGISTER_FACTORY(PangoVideo)
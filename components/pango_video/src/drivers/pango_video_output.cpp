@@ -26,14 +26,20 @@
  */
 
 #include <pangolin/factory/factory_registry.h>
+#include <pangolin/log/packet_compression.h>
 #include <pangolin/utils/file_utils.h>
+#include <pangolin/utils/log.h>
 #include <pangolin/utils/memstreambuf.h>
 #include <pangolin/utils/picojson.h>
 #include <pangolin/utils/sigstate.h>
+#include <pangolin/utils/task_scheduler.h>
 #include <pangolin/utils/timer.h>
 #include <pangolin/video/drivers/pango_video_output.h>
 #include <pangolin/video/iostream_operators.h>
 #include <pangolin/video/video_interface.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <set>
 #include <future>
 
@@ -51,18 +57,45 @@ void SigPipeHandler(int sig)
     SigState::I().sig_callbacks.at(sig).value = true;
 }
 
-PangoVideoOutput::PangoVideoOutput(const std::string& filename, size_t buffer_size_bytes, const std::map<size_t, std::string> &stream_encoder_uris)
+PangoVideoOutput::PangoVideoOutput(const std::string& filename, size_t buffer_size_bytes, const std::map<size_t, std::string> &stream_encoder_uris, size_t keyframe_interval,
+                                   const ThreadPolicy& writer_policy, const ThreadPolicy& encoder_policy, bool checksum,
+                                   size_t segment_bytes, int64_t segment_us, const AdaptiveEncoderSettings& auto_settings,
+                                   const PangoPacketCompression& compression)
     : filename(filename),
+      packetstream(new PacketStreamWriter()),
       packetstream_buffer_size_bytes(buffer_size_bytes),
       packetstreamsrcid(-1),
       total_frame_size(0),
       is_pipe(pangolin::IsPipe(filename)),
       fixed_size(true),
-      stream_encoder_uris(stream_encoder_uris)
+      stream_encoder_uris(stream_encoder_uris),
+      auto_settings(auto_settings),
+      keyframe_interval(keyframe_interval),
+      frames_since_keyframe(0),
+      writer_policy(writer_policy),
+      encoder_policy(encoder_policy),
+      encoder_policy_reported(false),
+      checksum(checksum),
+      compression(compression),
+      segment_bytes(segment_bytes),
+      segment_us(segment_us),
+      segment(0),
+      segment_start_us(-1)
 {
-    if(!is_pipe)
+    if(!compression.method.empty() && !PacketCompressionSupported(compression.method)) {
+        throw std::invalid_argument("Packet compression '" + compression.method + "' is not supported by this build");
+    }
+
+    if(segment_bytes || segment_us)
     {
-        packetstream.Open(filename, packetstream_buffer_size_bytes);
+        if(is_pipe) {
+            throw std::invalid_argument("Segmented recording needs a file, not a pipe: " + filename);
+        }
+        packetstream->Open(PangoSegmentFilename(filename, 0), packetstream_buffer_size_bytes, writer_policy);
+    }
+    else if(!is_pipe)
+    {
+        packetstream->Open(filename, packetstream_buffer_size_bytes, writer_policy);
     }
     else
     {
@@ -74,6 +107,33 @@ PangoVideoOutput::PangoVideoOutput(const std::string& filename, size_t buffer_si
 
 PangoVideoOutput::~PangoVideoOutput()
 {
+    if(closing_segment.valid()) {
+        closing_segment.wait();
+    }
+    if(next_segment.valid()) {
+        // Remove the segment opened ahead of time which never received frames
+        try {
+            next_segment.get().reset();
+        }catch(const std::exception&) {
+            // It was never opened
+        }
+        std::remove(PangoSegmentFilename(filename, segment + 1).c_str());
+    }
+}
+
+std::string PangoSegmentFilename(const std::string& pattern, size_t segment)
+{
+    // Allow one field of the form %d, %5d or %05d
+    const size_t field = pattern.find('%');
+    const size_t conv = (field == std::string::npos) ? field : pattern.find_first_not_of("0123456789", field + 1);
+    if(conv == std::string::npos || pattern[conv] != 'd' || pattern.find('%', conv) != std::string::npos) {
+        throw std::invalid_argument("Expected one %d field for the segment number in '" + pattern + "'");
+    }
+
+    const int len = std::snprintf(nullptr, 0, pattern.c_str(), (int)segment);
+    std::string name(len, '\0');
+    std::snprintf(&name[0], len + 1, pattern.c_str(), (int)segment);
+    return name;
 }
 
 const std::vector<StreamInfo>& PangoVideoOutput::Streams() const
@@ -108,8 +168,18 @@ void PangoVideoOutput::SetStreams(const std::vector<StreamInfo>& st, const std::
         json_header["device"] = device_properties;
 
         stream_encoders.resize(streams.size());
+        auto_encoders.resize(streams.size());
 
-        fixed_size = true;
+        size_t auto_bytes = 0;
+        for(size_t i=0; i < streams.size(); ++i) {
+            if(stream_encoder_uris[i] == "auto") auto_bytes += streams[i].SizeBytes();
+        }
+
+        // Delta frames are prefixed with a frame type so can't be fixed size
+        fixed_size = (keyframe_interval == 0);
+        if(keyframe_interval) {
+            json_header["keyframe_interval"] = keyframe_interval;
+        }
 
         total_frame_size = 0;
         for (unsigned int i = 0; i < streams.size(); ++i)
@@ -120,11 +190,28 @@ void PangoVideoOutput::SetStreams(const std::vector<StreamInfo>& st, const std::
             picojson::value& json_stream = json_streams.push_back();
 
             std::string encoder_name = si.PixFormat().format;
-            if(stream_encoder_uris.find(i) != stream_encoder_uris.end() && !stream_encoder_uris[i].empty() ) {
+            std::string encoder_uri = stream_encoder_uris.count(i) ? stream_encoder_uris[i] : "";
+            if(encoder_uri.empty() && keyframe_interval) {
+                // Deltas are mostly zero, so only pay off when compressed
+                encoder_uri = StreamEncoderFactory::I().DefaultLosslessEncoder(si.PixFormat());
+            }
+            if(!encoder_uri.empty()) {
                 // instantiate encoder and write it's name to the stream properties
                 json_stream["decoded"] = si.PixFormat().format;
-                encoder_name = stream_encoder_uris[i];
-                stream_encoders[i] = StreamEncoderFactory::I().GetEncoder(encoder_name, si.PixFormat());
+                encoder_name = encoder_uri;
+                if(encoder_name == "auto") {
+                    // Each auto stream gets a share of the disk budget by size
+                    AdaptiveEncoderSettings settings = auto_settings;
+                    settings.disk_bytes_per_sec *= double(si.SizeBytes()) / auto_bytes;
+                    auto_encoders[i].reset(new AdaptiveStreamEncoder(si, settings));
+                    encoder_name = auto_encoders[i]->Spec();
+                }
+                if(keyframe_interval && !StreamEncoderFactory::I().IsLossless(encoder_name)) {
+                    throw std::invalid_argument("keyframe_interval requires lossless encoders, got: " + encoder_name);
+                }
+                if(!auto_encoders[i]) {
+                    stream_encoders[i] = StreamEncoderFactory::I().GetEncoder(encoder_name, si.PixFormat());
+                }
                 fixed_size = false;
             }
 
@@ -142,17 +229,29 @@ void PangoVideoOutput::SetStreams(const std::vector<StreamInfo>& st, const std::
         pss.info = json_header;
         pss.data_size_bytes = fixed_size ? total_frame_size : 0;
         pss.data_definitions = "struct Frame{ uint8 stream_data[" + pangolin::Convert<std::string, size_t>::Do(total_frame_size) + "];};";
+        pss.checksum = checksum;
+        pss.compression = compression.method;
+        pss.compression_level = compression.level;
+        pss.compression_batch_bytes = compression.batch_bytes;
+
+        if(keyframe_interval) {
+            previous_frame.resize(total_frame_size);
+            delta_frame.resize(total_frame_size);
+        }
 
-        packetstreamsrcid = (int)packetstream.AddSource(pss);
+        packetstreamsrcid = (int)packetstream->AddSource(pss);
+
+        if(segment_bytes || segment_us) {
+            segment_source = pss;
+            PrepareNextSegment();
+        }
     } else {
         throw std::runtime_error("Unable to add new streams");
     }
 }
 
-int PangoVideoOutput::WriteStreams(const unsigned char* data, const picojson::value& frame_properties)
+bool PangoVideoOutput::ReadyToWrite()
 {
-    const int64_t host_reception_time_us = frame_properties.get_value(PANGO_HOST_RECEPTION_TIME_US, Time_us(TimeNow()));
-
 #ifndef _WIN_
     if (is_pipe)
     {
@@ -166,12 +265,15 @@ int PangoVideoOutput::WriteStreams(const unsigned char* data, const picojson::va
         // opening a file descriptor will fail and errno will be ENXIO.
         int fd = WritablePipeFileDescriptor(filename);
 
-        if (!packetstream.IsOpen())
+        if (!packetstream->IsOpen())
         {
             if (fd != -1)
             {
-                packetstream.Open(filename, packetstream_buffer_size_bytes);
+                packetstream->Open(filename, packetstream_buffer_size_bytes, writer_policy);
                 close(fd);
+
+                // A new reader can't decode deltas from before it connected
+                frames_since_keyframe = 0;
             }
         }
         else
@@ -185,7 +287,7 @@ int PangoVideoOutput::WriteStreams(const unsigned char* data, const picojson::va
             {
                 if (errno == ENXIO)
                 {
-                    packetstream.ForceClose();
+                    packetstream->ForceClose();
                     SigState::I().sig_callbacks.at(SIGPIPE).value = false;
 
                     // This should be unnecessary since per the man page,
@@ -196,11 +298,111 @@ int PangoVideoOutput::WriteStreams(const unsigned char* data, const picojson::va
             }
         }
 
-        if (!packetstream.IsOpen())
-            return 0;
+        if (!packetstream->IsOpen())
+            return false;
     }
 #endif
 
+    return true;
+}
+
+void PangoVideoOutput::PrepareNextSegment()
+{
+    // Creating the file and writing its headers happen off the recording thread
+    next_segment = std::async(std::launch::async,
+        [filename=PangoSegmentFilename(filename, segment + 1), buffer_size=packetstream_buffer_size_bytes,
+         policy=writer_policy, pss=segment_source]() {
+            auto writer = std::make_unique<PacketStreamWriter>();
+            writer->Open(filename, buffer_size, policy);
+            writer->AddSource(pss);
+            return writer;
+        }
+    );
+}
+
+void PangoVideoOutput::NextSegmentIfDue(int64_t time_us)
+{
+    if(!next_segment.valid()) {
+        return;
+    }
+
+    if(segment_start_us < 0) {
+        segment_start_us = time_us;
+    }
+
+    const bool full = (segment_bytes && packetstream->BytesWritten() >= segment_bytes) ||
+                      (segment_us && time_us - segment_start_us >= segment_us);
+    if(!full) {
+        return;
+    }
+
+    std::unique_ptr<PacketStreamWriter> next;
+    try {
+        next = next_segment.get();
+    }catch(const std::exception& e) {
+        // e.g. disk full or no permission. Keep recording, unsplit, to this segment.
+        pango_print_error("PangoVideoOutput: unable to start next segment, continuing in current file: %s\n", e.what());
+        return;
+    }
+
+    // Finish the last segment (flushing and writing its index) in the background
+    if(closing_segment.valid()) {
+        closing_segment.wait();
+    }
+    closing_segment = std::async(std::launch::async,
+        [finished = std::shared_ptr<PacketStreamWriter>(std::move(packetstream))]() {
+            finished->Close();
+        }
+    );
+
+    packetstream = std::move(next);
+    ++segment;
+    segment_start_us = time_us;
+
+    // Segments must decode without their predecessors
+    frames_since_keyframe = 0;
+
+    PrepareNextSegment();
+}
+
+int PangoVideoOutput::WriteStreams(const unsigned char* data, const picojson::value& frame_properties)
+{
+    if(!fixed_size) {
+        // Encoders consume each stream separately
+        std::vector<Image<unsigned char>> images;
+        for(const StreamInfo& si : streams) {
+            images.push_back(si.StreamImage(data));
+        }
+        return WriteStreams(images, frame_properties);
+    }
+
+    if(!ReadyToWrite())
+        return 0;
+
+    const int64_t host_reception_time_us = frame_properties.get_value(PANGO_HOST_RECEPTION_TIME_US, Time_us(TimeNow()));
+    NextSegmentIfDue(host_reception_time_us);
+    packetstream->WriteSourcePacket(packetstreamsrcid, reinterpret_cast<const char*>(data), host_reception_time_us, total_frame_size, frame_properties);
+    return 0;
+}
+
+int PangoVideoOutput::WriteStreams(const std::vector<Image<unsigned char>>& images, const picojson::value& frame_properties)
+{
+    if(images.size() != streams.size()) {
+        throw std::invalid_argument("Expected one image per stream.");
+    }
+    for(size_t i=0; i < streams.size(); ++i) {
+        if(images[i].w != streams[i].Width() || images[i].h != streams[i].Height()) {
+            throw std::invalid_argument("Image dimensions don't match stream.");
+        }
+    }
+
+    if(!ReadyToWrite())
+        return 0;
+
+    const int64_t host_reception_time_us = frame_properties.get_value(PANGO_HOST_RECEPTION_TIME_US, Time_us(TimeNow()));
+    NextSegmentIfDue(host_reception_time_us);
+    const bool keyframe = !keyframe_interval || (frames_since_keyframe % keyframe_interval == 0);
+
     if(!fixed_size) {
         // TODO: Make this more efficient (without so many allocs and memcpy's)
 
@@ -218,14 +420,45 @@ int PangoVideoOutput::WriteStreams(const unsigned char* data, const picojson::va
             std::ostream encode_stream(&encoded_stream_data[i]);
 
             const StreamInfo& si = streams[i];
-            const Image<unsigned char> stream_image = si.StreamImage(data);
+            Image<unsigned char> stream_image = images[i];
 
-            if(stream_encoders[i]) {
+            if(keyframe_interval) {
+                if(i == 0) {
+                    // Frame type precedes all stream data
+                    encode_stream.put(keyframe ? PangoFrameKey : PangoFrameDelta);
+                }
+
+                if(!keyframe) {
+                    // Replace stream with its XOR against the previous frame
+                    const Image<unsigned char> prev_image = si.StreamImage(previous_frame.data());
+                    Image<unsigned char> delta_image = si.StreamImage(delta_frame.data());
+                    for(size_t row=0; row < stream_image.h; ++row) {
+                        const unsigned char* cur = stream_image.RowPtr(row);
+                        const unsigned char* prev = prev_image.RowPtr(row);
+                        unsigned char* delta = delta_image.RowPtr(row);
+                        for(size_t b=0; b < si.RowBytes(); ++b) {
+                            delta[b] = cur[b] ^ prev[b];
+                        }
+                    }
+                    stream_image = delta_image;
+                }
+
+                // Remember this frame for the next delta
+                Image<unsigned char> prev_image = si.StreamImage(previous_frame.data());
+                const Image<unsigned char>& cur_image = images[i];
+                for(size_t row=0; row < cur_image.h; ++row) {
+                    std::memcpy(prev_image.RowPtr(row), cur_image.RowPtr(row), si.RowBytes());
+                }
+            }
+
+            if(auto_encoders[i]) {
+                auto_encoders[i]->Encode(encode_stream, stream_image, host_reception_time_us);
+            }else if(stream_encoders[i]) {
                 // Encode to buffer
                 stream_encoders[i](encode_stream, stream_image);
             }else{
-                if(stream_image.IsContiguous()) {
-                    encode_stream.write((char*)stream_image.ptr, streams[i].SizeBytes());
+                if(stream_image.pitch == si.RowBytes()) {
+                    encode_stream.write((char*)stream_image.ptr, si.RowBytes() * stream_image.h);
                 }else{
                     for(size_t row=0; row < stream_image.h; ++row) {
                         encode_stream.write((char*)stream_image.RowPtr(row), si.RowBytes());
@@ -235,30 +468,100 @@ int PangoVideoOutput::WriteStreams(const unsigned char* data, const picojson::va
             return true;
         };
 
-        // Compress each stream (>0 in another thread)
+        // Compress each stream (>0 on another thread). Use the shared
+        // scheduler unless dedicated encoder threads were configured.
         std::vector<std::future<bool>> encode_finished;
-        for(size_t i=1; i < streams.size(); ++i) {
-            encode_finished.emplace_back(std::async(std::launch::async, [&,i](){
-                return encode_stream(i);
-            }));
+        TaskGroup encode_group;
+        if(encoder_policy.IsDefault()) {
+            for(size_t i=1; i < streams.size(); ++i) {
+                encode_group.Run([&,i](){ encode_stream(i); });
+            }
+        }else{
+            const bool report_policy = !encoder_policy_reported && streams.size() > 1;
+            encoder_policy_reported = encoder_policy_reported || report_policy;
+            for(size_t i=1; i < streams.size(); ++i) {
+                encode_finished.emplace_back(std::async(std::launch::async, [&,i](){
+                    ApplyThreadPolicy(encoder_policy, report_policy && i == 1);
+                    return encode_stream(i);
+                }));
+            }
         }
         // Encode stream 0 in this thread
         encode_stream(0);
 
+        // Wait on all streams to finish
+        encode_group.Wait();
+        for(auto& f : encode_finished) f.get();
+
         // Reuse our first compression stream for the rest of the data too.
         std::vector<uint8_t>& encoded = encoded_stream_data[0].buffer;
-
-        // Wait on all threads to finish and copy into data packet
         for(size_t i=1; i < streams.size(); ++i) {
-            encode_finished[i-1].get();
             encoded.insert(encoded.end(), encoded_stream_data[i].buffer.begin(), encoded_stream_data[i].buffer.end());
         }
 
-        packetstream.WriteSourcePacket(packetstreamsrcid, reinterpret_cast<const char*>(encoded.data()), host_reception_time_us, encoded.size(), frame_properties);
+        packetstream->WriteSourcePacket(packetstreamsrcid, reinterpret_cast<const char*>(encoded.data()), host_reception_time_us, encoded.size(), frame_properties, keyframe);
     }else{
-        packetstream.WriteSourcePacket(packetstreamsrcid, reinterpret_cast<const char*>(data), host_reception_time_us, total_frame_size, frame_properties);
+        // Raw packets must match the layout declared in the header
+        packed_frame.resize(total_frame_size);
+        for(size_t i=0; i < streams.size(); ++i) {
+            Image<unsigned char> dst = streams[i].StreamImage(packed_frame.data());
+            for(size_t row=0; row < dst.h; ++row) {
+                std::memcpy(dst.RowPtr(row), images[i].RowPtr(row), streams[i].RowBytes());
+            }
+        }
+        packetstream->WriteSourcePacket(packetstreamsrcid, reinterpret_cast<const char*>(packed_frame.data()), host_reception_time_us, total_frame_size, frame_properties);
+    }
+
+    ++frames_since_keyframe;
+
+    return 0;
+}
+
+bool PangoVideoOutput::CanEncodeConcurrently() const
+{
+    return !keyframe_interval && std::none_of(auto_encoders.begin(), auto_encoders.end(),
+        [](const std::unique_ptr<AdaptiveStreamEncoder>& e){ return (bool)e; });
+}
+
+void PangoVideoOutput::EncodeFrame(const unsigned char* data, std::vector<unsigned char>& encoded) const
+{
+    if(!CanEncodeConcurrently()) {
+        throw std::runtime_error("PangoVideoOutput: frames can't be encoded independently with keyframes or encoder=auto.");
     }
 
+    if(fixed_size) {
+        encoded.assign(data, data + total_frame_size);
+        return;
+    }
+
+    // Reuse the caller's allocation
+    memstreambuf buf(0);
+    buf.buffer.swap(encoded);
+    buf.clear();
+    std::ostream os(&buf);
+
+    for(size_t i=0; i < streams.size(); ++i) {
+        const StreamInfo& si = streams[i];
+        const Image<unsigned char> img = si.StreamImage(data);
+        if(stream_encoders[i]) {
+            stream_encoders[i](os, img);
+        }else{
+            for(size_t row=0; row < img.h; ++row) {
+                os.write((char*)img.RowPtr(row), si.RowBytes());
+            }
+        }
+    }
+    encoded.swap(buf.buffer);
+}
+
+int PangoVideoOutput::WriteEncodedFrame(const std::vector<unsigned char>& encoded, const picojson::value& frame_properties)
+{
+    if(!ReadyToWrite())
+        return 0;
+
+    const int64_t host_reception_time_us = frame_properties.get_value(PANGO_HOST_RECEPTION_TIME_US, Time_us(TimeNow()));
+    NextSegmentIfDue(host_reception_time_us);
+    packetstream->WriteSourcePacket(packetstreamsrcid, reinterpret_cast<const char*>(encoded.data()), host_reception_time_us, encoded.size(), frame_properties);
     return 0;
 }
 
@@ -278,7 +581,23 @@ PANGOLIN_REGISTER_FACTORY(PangoVideoOutput)
             return {{
                 {"buffer_size_mb","100","Buffer size in MB"},
                 {"unique_filename","","This is flag to create a unique file name in the case of file already exists."},
-                {"encoder(\\d+)?"," ","encoder or encoderN, 1 <= N <= 100. The default values of encoderN are set to encoder"}
+                {"encoder(\\d+)?"," ","encoder or encoderN, 1 <= N <= 100. The default values of encoderN are set to encoder. Use auto to choose between auto_encoders as frames arrive"},
+                {"auto_encoders","raw+lzf1+zstd1+png12+zstd5","Lossless encoders which encoder=auto chooses between, separated by +"},
+                {"auto_cpu","0.8","Share of the time between frames which encoder=auto may spend encoding each stream"},
+                {"auto_disk_mbps","0","Disk bandwidth in MB/s which encoder=auto streams should stay within together. 0 for no limit"},
+                {"keyframe_interval","0","Write a full frame every N frames and XOR deltas against the previous frame in between. 0 disables. Requires lossless encoders, and streams without one use lz4, zstd or png if available."},
+                {"checksum","0","Store a CRC32C with each frame, checked by PangoVerify"},
+                {"compression","","Compress whole frames with lz4 or zstd, after any encoders. Playback decompresses transparently"},
+                {"compression_level","1","zstd level, or for lz4 1 for fast and higher for its high compression mode"},
+                {"compression_batch_kb","0","Compress consecutive frames together until they total this many KB. Held back frames are written after later packets of other sources, so out of time order between sources"},
+                {"segment_mb","0","Start a new file after this many MB of frame data. The filename must then contain a %d field for the segment number, e.g. rec_%05d.pango"},
+                {"segment_seconds","0","Start a new file after this many seconds of frames, as for segment_mb"},
+                {"writer_name","","Name of the file writing thread"},
+                {"writer_cpu","","CPUs for the file writing thread, e.g. 2 or 0+4-7"},
+                {"writer_priority","default","Scheduling of the file writing thread: fifo:N, rr:N, batch, idle or default"},
+                {"encoder_name","","Name of stream encoding threads"},
+                {"encoder_cpu","","CPUs for stream encoding threads"},
+                {"encoder_priority","default","Scheduling of stream encoding threads"}
             }};
         }
         std::unique_ptr<VideoOutputInterface> Open(const Uri& uri) override {
@@ -307,8 +626,25 @@ PANGOLIN_REGISTER_FACTORY(PangoVideoOutput)
                 stream_encoder_uris[i] = reader.Get<std::string>(encoder_key, default_encoder);
             }
 
+            const size_t keyframe_interval = reader.Get<size_t>("keyframe_interval");
+            const ThreadPolicy writer_policy = ThreadPolicy::FromParams(uri, "writer_");
+            const ThreadPolicy encoder_policy = ThreadPolicy::FromParams(uri, "encoder_");
+            const bool checksum = reader.Get<bool>("checksum");
+            const size_t segment_bytes = reader.Get<size_t>("segment_mb") * mb;
+            const int64_t segment_us = (int64_t)(reader.Get<double>("segment_seconds") * 1e6);
+
+            PangoPacketCompression compression;
+            compression.method = reader.Get<std::string>("compression");
+            compression.level = reader.Get<int>("compression_level");
+            compression.batch_bytes = reader.Get<size_t>("compression_batch_kb") * 1024;
+
+            AdaptiveEncoderSettings auto_settings;
+            auto_settings.candidates = Split(reader.Get<std::string>("auto_encoders"), '+');
+            auto_settings.cpu_fraction = reader.Get<double>("auto_cpu");
+            auto_settings.disk_bytes_per_sec = reader.Get<double>("auto_disk_mbps") * mb;
+
             return std::unique_ptr<VideoOutputInterface>(
-                new PangoVideoOutput(filename, buffer_size_bytes, stream_encoder_uris)
+                new PangoVideoOutput(filename, buffer_size_bytes, stream_encoder_uris, keyframe_interval, writer_policy, encoder_policy, checksum, segment_bytes, segment_us, auto_settings, compression)
             );
         }
     };
@@ -28,6 +28,7 @@
 #include <pangolin/video/drivers/test.h>
 #include <pangolin/factory/factory_registry.h>
 #include <pangolin/video/iostream_operators.h>
+#include <pangolin/video/video.h>
 
 namespace pangolin
 {
@@ -40,6 +41,7 @@ void setRandomData(unsigned char * arr, size_t size){
 }
 
 TestVideo::TestVideo(size_t w, size_t h, size_t n, std::string pix_fmt)
+    : custom_layout(false)
 {
     const PixelFormat pfmt = PixelFormatFromString(pix_fmt);
 
@@ -84,7 +86,16 @@ const std::vector<StreamInfo>& TestVideo::Streams() const
 //! Implement VideoInput::GrabNext()
 bool TestVideo::GrabNext( unsigned char* image, bool /*wait*/ )
 {
-    setRandomData(image, size_bytes);
+    if(custom_layout) {
+        for(const StreamInfo& si : streams) {
+            Image<unsigned char> img = si.StreamImage(image);
+            for(size_t y=0; y < img.h; ++y) {
+                setRandomData(img.RowPtr(y), si.RowBytes());
+            }
+        }
+    }else{
+        setRandomData(image, size_bytes);
+    }
     return true;
 }
 
@@ -94,6 +105,17 @@ bool TestVideo::GrabNewest( unsigned char* image, bool wait )
     return GrabNext(image,wait);
 }
 
+bool TestVideo::SetStreamLayout(const std::vector<StreamInfo>& layout, size_t layout_size_bytes)
+{
+    if(!IsValidStreamLayout(streams, layout, layout_size_bytes)) {
+        return false;
+    }
+    streams = layout;
+    size_bytes = layout_size_bytes;
+    custom_layout = true;
+    return true;
+}
+
 PANGOLIN_REGISTER_FACTORY(TestVideo)
 {
     struct TestVideoFactory final : public TypedFactoryInterface<VideoInterface> {
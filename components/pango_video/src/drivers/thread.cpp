@@ -26,6 +26,7 @@
  */
 
 #include <pangolin/factory/factory_registry.h>
+#include <pangolin/utils/async_log.h>
 #include <pangolin/video/drivers/thread.h>
 #include <pangolin/video/iostream_operators.h>
 #include <pangolin/video/video.h>
@@ -48,12 +49,19 @@ const uint64_t grab_fail_thread_sleep_us = 1000;
 const uint64_t capture_timout_ms = 5000;
 
 ThreadVideo::ThreadVideo(std::unique_ptr<VideoInterface> &src_, size_t num_buffers, const std::string& name)
-    : src(std::move(src_)), quit_grab_thread(true), thread_name(name)
+    : ThreadVideo(src_, num_buffers, [&](){ ThreadPolicy p; p.name = name; return p; }())
+{
+}
+
+ThreadVideo::ThreadVideo(std::unique_ptr<VideoInterface> &src_, size_t num_buffers, const ThreadPolicy& policy)
+    : src(std::move(src_)), custom_layout(false), quit_grab_thread(true), thread_policy(policy)
 {
     if(!src) {
         throw VideoException("ThreadVideo: VideoInterface in must not be null");
     }
     videoin.push_back(src.get());
+    streams = src->Streams();
+    size_bytes = src->SizeBytes();
 
 //    // queue init allocates buffers.
     const size_t buffer_size = videoin[0]->SizeBytes();
@@ -94,13 +102,13 @@ void ThreadVideo::Stop()
 //! Implement VideoInput::SizeBytes()
 size_t ThreadVideo::SizeBytes() const
 {
-    return videoin[0]->SizeBytes();
+    return size_bytes;
 }
 
 //! Implement VideoInput::Streams()
 const std::vector<StreamInfo>& ThreadVideo::Streams() const
 {
-    return videoin[0]->Streams();
+    return streams;
 }
 
 const picojson::value& ThreadVideo::DeviceProperties() const
@@ -130,7 +138,7 @@ bool ThreadVideo::GrabNext( unsigned char* image, bool wait )
     TSTART()
 
     if(queue.EmptyBuffers() == 0) {
-       pango_print_warn("Thread %s(%12p) has run out of %d buffers\n", thread_name.c_str(), this, (int)queue.AvailableFrames());
+       pango_log_limited(LogLevel::Warn, 1000, "Thread %s(%12p) has run out of %d buffers\n", thread_policy.name.c_str(), this, (int)queue.AvailableFrames());
     }
 
     if(queue.AvailableFrames() == 0 && !wait) {
@@ -157,8 +165,7 @@ bool ThreadVideo::GrabNext( unsigned char* image, bool wait )
         GrabResult grab = queue.getNext();
         if(grab.return_status) {
             DBGPRINT("GrabNext at least one frame available.");
-            const size_t buffer_size = videoin[0]->SizeBytes();
-            std::memcpy(image, grab.buffer.get(), buffer_size);
+            CopyFrame(image, grab.buffer.get());
             frame_properties = grab.frame_properties;
         }else{
             DBGPRINT("GrabNext returned false")
@@ -195,7 +202,7 @@ bool ThreadVideo::GrabNewest( unsigned char* image, bool wait )
         GrabResult grab = queue.getNewest();
         const bool success = grab.return_status;
         if(success) {
-            std::memcpy(image, grab.buffer.get(), videoin[0]->SizeBytes());
+            CopyFrame(image, grab.buffer.get());
             frame_properties = grab.frame_properties;
         }
         queue.returnOrAddUsedBuffer(std::move(grab));
@@ -208,6 +215,9 @@ bool ThreadVideo::GrabNewest( unsigned char* image, bool wait )
 void ThreadVideo::operator()()
 {
     DBGPRINT("Grab thread Started.")
+    // Only report when asked for more than a name, since every thread has one.
+    ApplyThreadPolicy(thread_policy, !thread_policy.cpus.empty() || thread_policy.scheduler != ThreadPolicy::Scheduler::Default);
+
     // Spinning thread attempting to read from videoin[0] as fast as possible
     // relying on the videoin[0] blocking grab.
     while(!quit_grab_thread) {
@@ -222,7 +232,7 @@ void ThreadVideo::operator()()
             }catch(const VideoException& e) {
                 // User doesn't have the opportunity to catch exceptions here.
                 std::string what = e.what();
-                pango_print_warn("ThreadVideo caught VideoException (%s)\n",  what.c_str());
+                pango_log_limited(LogLevel::Warn, 1000, "ThreadVideo caught VideoException (%s)\n",  what.c_str());
                 if (what.find("No such device") != std::string::npos) {
                   pango_print_warn("Device is gone, exiting thread.\n");
                   quit_grab_thread = true;
@@ -230,7 +240,7 @@ void ThreadVideo::operator()()
                 grab.return_status = false;
             }catch(const std::exception& e){
                 // User doesn't have the opportunity to catch exceptions here.
-                pango_print_warn("ThreadVideo caught exception (%s)\n", e.what());
+                pango_log_limited(LogLevel::Warn, 1000, "ThreadVideo caught exception (%s)\n", e.what());
                 grab.return_status = false;
             }
 
@@ -259,6 +269,27 @@ std::vector<VideoInterface*>& ThreadVideo::InputStreams()
     return videoin;
 }
 
+void ThreadVideo::CopyFrame(unsigned char* image, const unsigned char* buffer)
+{
+    if(custom_layout) {
+        // Other bytes of image may belong to someone else
+        CopyStreams(image, streams, buffer, videoin[0]->Streams());
+    }else{
+        std::memcpy(image, buffer, size_bytes);
+    }
+}
+
+bool ThreadVideo::SetStreamLayout(const std::vector<StreamInfo>& layout, size_t layout_size_bytes)
+{
+    if(!quit_grab_thread || !IsValidStreamLayout(streams, layout, layout_size_bytes)) {
+        return false;
+    }
+    streams = layout;
+    size_bytes = layout_size_bytes;
+    custom_layout = true;
+    return true;
+}
+
 PANGOLIN_REGISTER_FACTORY(ThreadVideo)
 {
     struct ThreadVideoFactory final : public TypedFactoryInterface<VideoInterface> {
@@ -274,15 +305,18 @@ PANGOLIN_REGISTER_FACTORY(ThreadVideo)
         {
             return {{
                 {"num_buffers", "30", "Size of the input queue/buffer for this thread"},
-                {"name","Unnamed","Name of the thread"}
+                {"name","Unnamed","Name of the thread"},
+                {"cpu","","CPUs to pin the grab thread to, e.g. 2 or 0+4-7"},
+                {"priority","default","Scheduling of the grab thread: fifo:N, rr:N, batch, idle or default"}
             }};
         }
         std::unique_ptr<VideoInterface> Open(const Uri& uri) override {
             ParamReader reader(Params(), uri);
             std::unique_ptr<VideoInterface> subvid = pangolin::OpenVideo(uri.url);
             const int num_buffers = reader.Get<int>("num_buffers");
-            const std::string name = reader.Get<std::string>("name");
-            return std::unique_ptr<VideoInterface>(new ThreadVideo(subvid, num_buffers, name));
+            ThreadPolicy policy = ThreadPolicy::FromParams(uri);
+            policy.name = reader.Get<std::string>("name");
+            return std::unique_ptr<VideoInterface>(new ThreadVideo(subvid, num_buffers, policy));
         }
     };
 
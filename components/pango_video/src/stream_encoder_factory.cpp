@@ -1,6 +1,8 @@
 #include <pangolin/video/stream_encoder_factory.h>
 
+#include <algorithm>
 #include <cctype>
+#include <sstream>
 #include <pangolin/utils/file_utils.h>
 #include <pangolin/utils/type_convert.h>
 
@@ -38,8 +40,33 @@ inline EncoderDetails EncoderDetailsFromString(const std::string& encoder_spec)
     return { encoder_name, NameToImageFileType(encoder_name), quality};
 }
 
+// Adaptive streams record the encoders they choose between as "auto:a,b,c"
+const std::string auto_prefix = "auto:";
+
+inline bool IsAutoSpec(const std::string& encoder_spec)
+{
+    return encoder_spec.compare(0, auto_prefix.size(), auto_prefix) == 0;
+}
+
+inline std::vector<std::string> AutoCandidates(const std::string& encoder_spec)
+{
+    return Split(encoder_spec.substr(auto_prefix.size()), ',');
+}
+
 ImageEncoderFunc StreamEncoderFactory::GetEncoder(const std::string& encoder_spec, const PixelFormat& fmt)
 {
+    if(encoder_spec == "raw") {
+        // Dimensions followed by packed rows
+        return [fmt](std::ostream& os, const Image<unsigned char>& img){
+            const uint32_t dims[2] = {(uint32_t)img.w, (uint32_t)img.h};
+            os.write(reinterpret_cast<const char*>(dims), sizeof(dims));
+            const size_t row_bytes = img.w * fmt.bpp / 8;
+            for(size_t row=0; row < img.h; ++row) {
+                os.write(reinterpret_cast<const char*>(img.RowPtr(row)), row_bytes);
+            }
+        };
+    }
+
     const EncoderDetails encdet = EncoderDetailsFromString(encoder_spec);
     if(encdet.file_type == ImageFileTypeUnknown)
         throw std::invalid_argument("Unsupported encoder format: " + encoder_spec);
@@ -51,6 +78,33 @@ ImageEncoderFunc StreamEncoderFactory::GetEncoder(const std::string& encoder_spe
 
 ImageDecoderFunc StreamEncoderFactory::GetDecoder(const std::string& encoder_spec, const PixelFormat& fmt)
 {
+    if(encoder_spec == "raw") {
+        return [fmt](std::istream& is){
+            uint32_t dims[2] = {0, 0};
+            is.read(reinterpret_cast<char*>(dims), sizeof(dims));
+            TypedImage img(dims[0], dims[1], fmt);
+            for(size_t row=0; row < img.h; ++row) {
+                is.read(reinterpret_cast<char*>(img.RowPtr(row)), img.w * fmt.bpp / 8);
+            }
+            return img;
+        };
+    }
+
+    if(IsAutoSpec(encoder_spec)) {
+        // Each image is preceded by the index of the encoder used
+        std::vector<ImageDecoderFunc> decoders;
+        for(const std::string& spec : AutoCandidates(encoder_spec)) {
+            decoders.push_back(GetDecoder(spec, fmt));
+        }
+        return [decoders](std::istream& is){
+            const int index = is.get();
+            if(index < 0 || (size_t)index >= decoders.size()) {
+                throw std::runtime_error("Unrecognised encoder index in stream.");
+            }
+            return decoders[index](is);
+        };
+    }
+
     const EncoderDetails encdet = EncoderDetailsFromString(encoder_spec);
     PANGO_ENSURE(encdet.file_type != ImageFileTypeUnknown);
 
@@ -59,4 +113,46 @@ ImageDecoderFunc StreamEncoderFactory::GetDecoder(const std::string& encoder_spe
     };
 }
 
+bool StreamEncoderFactory::IsLossless(const std::string& encoder_spec)
+{
+    if(IsAutoSpec(encoder_spec)) {
+        const auto specs = AutoCandidates(encoder_spec);
+        return std::all_of(specs.begin(), specs.end(), [this](const std::string& spec){ return IsLossless(spec); });
+    }
+
+    if(encoder_spec == "raw") {
+        return true;
+    }
+
+    // Anything else (jpg, exr, p12b, ...) may drop information
+    const EncoderDetails encdet = EncoderDetailsFromString(encoder_spec);
+    switch(encdet.file_type) {
+    case ImageFileTypePpm:
+    case ImageFileTypePng:
+    case ImageFileTypeZstd:
+    case ImageFileTypeLz4:
+        return true;
+    default:
+        return false;
+    }
+}
+
+std::string StreamEncoderFactory::DefaultLosslessEncoder(const PixelFormat& fmt)
+{
+    // Fastest first, skipping any Pangolin was built without
+    const size_t w = 8, h = 8;
+    std::vector<unsigned char> blank(w * h * fmt.bpp / 8, 0);
+    const Image<unsigned char> img(blank.data(), w, h, w * fmt.bpp / 8);
+
+    for(const std::string spec : {"lzf1", "zstd1", "png12"}) {
+        try {
+            std::ostringstream test;
+            GetEncoder(spec, fmt)(test, img);
+            return spec;
+        }catch(const std::exception&) {
+        }
+    }
+    return "";
+}
+
 }
@@ -81,6 +81,11 @@ int VideoOutput::WriteStreams(const unsigned char* data, const picojson::value&
     return recorder->WriteStreams(data, frame_properties);
 }
 
+int VideoOutput::WriteStreams(const std::vector<Image<unsigned char>>& images, const picojson::value& frame_properties)
+{
+    return recorder->WriteStreams(images, frame_properties);
+}
+
 bool VideoOutput::IsPipe() const
 {
     return recorder->IsPipe();
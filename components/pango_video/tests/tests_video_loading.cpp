@@ -1,7 +1,19 @@
 #define CATCH_CONFIG_MAIN
 #include <catch2/catch.hpp>
 
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
 #include <pangolin/video/video.h>
+#include <pangolin/video/drivers/images.h>
+#include <pangolin/video/drivers/pango.h>
+#include <pangolin/video/drivers/pango_video_output.h>
+#include <pangolin/video/adaptive_stream_encoder.h>
+#include <pangolin/video/stream_encoder_factory.h>
+#include <pangolin/image/image_io.h>
+#include <pangolin/log/packet_compression.h>
 #include <pangolin/factory/factory_registry.h>
 
 TEST_CASE( "Loading built in video driver" ) {
@@ -24,3 +36,549 @@ TEST_CASE( "Error when providing the wrong arguments" )
 {
     REQUIRE_THROWS_AS(pangolin::OpenVideo("test:[width=123,height=345,n=3,fmt=RGB24]//"), pangolin::FactoryRegistry::ParameterMismatchException);
 }
+
+TEST_CASE( "Pango video with delta frames decodes after seeking" )
+{
+    const std::string filename = "test_keyframe_interval.pango";
+    const size_t num_frames = 10;
+
+    auto input = pangolin::OpenVideo("test:[size=64x48,n=1,fmt=GRAY8]//");
+    std::vector<std::vector<unsigned char>> frames;
+    std::vector<unsigned char> frame(input->SizeBytes());
+    REQUIRE(input->GrabNext(frame.data()));
+
+    {
+        auto output = pangolin::OpenVideoOutput("pango:[encoder=png,keyframe_interval=4]//" + filename);
+        output->SetStreams(input->Streams());
+        for(size_t i=0; i < num_frames; ++i) {
+            // Mostly static scene with a few changing pixels
+            frame[(i*37) % frame.size()] += 1;
+            frame[(i*101) % frame.size()] ^= 0xff;
+            frames.push_back(frame);
+            output->WriteStreams(frame.data());
+        }
+    }
+
+    auto video = pangolin::OpenVideo(filename);
+    REQUIRE(video->SizeBytes() == frame.size());
+    auto playback = pangolin::FindFirstMatchingVideoInterface<pangolin::VideoPlaybackInterface>(*video);
+    REQUIRE(playback);
+    REQUIRE(playback->GetTotalFrames() == num_frames);
+
+    std::vector<unsigned char> image(video->SizeBytes());
+    for(size_t i=0; i < num_frames; ++i) {
+        REQUIRE(video->GrabNext(image.data()));
+        REQUIRE(image == frames[i]);
+    }
+
+    for(size_t i : {6, 2, 9, 4, 0}) {
+        REQUIRE(playback->Seek(i) == i);
+        REQUIRE(video->GrabNext(image.data()));
+        REQUIRE(image == frames[i]);
+    }
+
+    video.reset();
+    std::remove(filename.c_str());
+}
+
+// Truncate a pango file before its index, as if recording had stopped abruptly
+static void DropIndex(const std::string& filename)
+{
+    std::ifstream f(filename, std::ios::binary);
+    f.seekg(-(std::streamoff)sizeof(uint64_t), std::ios::end);
+    uint64_t index_pos = 0;
+    f.read(reinterpret_cast<char*>(&index_pos), sizeof(index_pos));
+    REQUIRE(index_pos > 0);
+    f.close();
+    std::filesystem::resize_file(filename, index_pos);
+}
+
+TEST_CASE( "Delta frames are compressed by default and decode from a rebuilt index" )
+{
+    const std::string filename = "test_keyframe_rebuilt.pango";
+    const size_t num_frames = 12;
+
+    auto input = pangolin::OpenVideo("test:[size=64x48,n=1,fmt=GRAY8]//");
+    std::vector<std::vector<unsigned char>> frames;
+    std::vector<unsigned char> frame(input->SizeBytes());
+    REQUIRE(input->GrabNext(frame.data()));
+
+    const std::string encoder = pangolin::StreamEncoderFactory::I().DefaultLosslessEncoder(input->Streams()[0].PixFormat());
+    {
+        // No encoder given, so deltas should still be compressed
+        auto output = pangolin::OpenVideoOutput("pango:[keyframe_interval=5]//" + filename);
+        output->SetStreams(input->Streams());
+        for(size_t i=0; i < num_frames; ++i) {
+            frame[(i*37) % frame.size()] += 1;
+            frames.push_back(frame);
+            output->WriteStreams(frame.data());
+        }
+    }
+    if(!encoder.empty()) {
+        REQUIRE(std::filesystem::file_size(filename) < num_frames * frame.size() / 2);
+    }
+
+    DropIndex(filename);
+
+    auto video = pangolin::OpenVideo(filename);
+    auto playback = pangolin::FindFirstMatchingVideoInterface<pangolin::VideoPlaybackInterface>(*video);
+    REQUIRE(playback);
+    REQUIRE(playback->GetTotalFrames() == num_frames);
+
+    std::vector<unsigned char> image(video->SizeBytes());
+    for(size_t i : {7, 3, 11, 5, 0, 9}) {
+        REQUIRE(playback->Seek(i) == i);
+        REQUIRE(video->GrabNext(image.data()));
+        REQUIRE(image == frames[i]);
+    }
+
+    video.reset();
+    std::remove(filename.c_str());
+}
+
+TEST_CASE( "Pango video seeks to the exact frame when capture times repeat" )
+{
+    const std::string filename = "test_repeated_times.pango";
+    const size_t num_frames = 8;
+
+    auto input = pangolin::OpenVideo("test:[size=32x24,n=1,fmt=GRAY8]//");
+    std::vector<unsigned char> frame(input->SizeBytes(), 0);
+    {
+        auto output = pangolin::OpenVideoOutput("pango://" + filename);
+        output->SetStreams(input->Streams());
+        for(size_t i=0; i < num_frames; ++i) {
+            // Pairs of frames share a capture time
+            frame[0] = (unsigned char)i;
+            picojson::value props;
+            props[PANGO_HOST_RECEPTION_TIME_US] = picojson::value(int64_t(1000000 + (i/2) * 100000));
+            output->WriteStreams(frame.data(), props);
+        }
+    }
+
+    auto video = pangolin::OpenVideo(filename);
+    auto playback = pangolin::FindFirstMatchingVideoInterface<pangolin::VideoPlaybackInterface>(*video);
+    REQUIRE(playback);
+
+    std::vector<unsigned char> image(video->SizeBytes());
+    for(size_t i : {5, 1, 7, 2, 3, 6}) {
+        REQUIRE(playback->Seek(i) == i);
+        REQUIRE(video->GrabNext(image.data()));
+        REQUIRE(playback->GetCurrentFrameId() == i);
+        REQUIRE(image[0] == i);
+    }
+
+    video.reset();
+    std::remove(filename.c_str());
+}
+
+TEST_CASE( "Segmented pango recordings play back as one video" )
+{
+    const std::string pattern = "test_segment_%03d.pango";
+    const size_t num_frames = 35;
+
+    auto input = pangolin::OpenVideo("test:[size=64x48,n=1,fmt=GRAY8]//");
+    std::vector<std::vector<unsigned char>> frames;
+    std::vector<unsigned char> frame(input->SizeBytes());
+    REQUIRE(input->GrabNext(frame.data()));
+
+    {
+        // 10 frames per second, so segments of 10 frames each
+        auto output = pangolin::OpenVideoOutput("pango:[encoder=png,keyframe_interval=4,segment_seconds=1]//" + pattern);
+        output->SetStreams(input->Streams());
+        for(size_t i=0; i < num_frames; ++i) {
+            frame[(i*37) % frame.size()] += 1;
+            frames.push_back(frame);
+            picojson::value props;
+            props[PANGO_HOST_RECEPTION_TIME_US] = picojson::value(int64_t(1000000 + i * 100000));
+            output->WriteStreams(frame.data(), props);
+        }
+    }
+
+    for(size_t s=0; s < 4; ++s) {
+        auto segment = pangolin::OpenVideo(pangolin::PangoSegmentFilename(pattern, s));
+        auto playback = pangolin::FindFirstMatchingVideoInterface<pangolin::VideoPlaybackInterface>(*segment);
+        REQUIRE(playback->GetTotalFrames() == (s < 3 ? 10 : 5));
+    }
+    REQUIRE(!pangolin::FileExists(pangolin::PangoSegmentFilename(pattern, 4)));
+
+    auto video = pangolin::OpenVideo("pango://" + pattern);
+    auto playback = pangolin::FindFirstMatchingVideoInterface<pangolin::VideoPlaybackInterface>(*video);
+    REQUIRE(playback);
+    REQUIRE(playback->GetTotalFrames() == num_frames);
+
+    std::vector<unsigned char> image(video->SizeBytes());
+    for(size_t i=0; i < num_frames; ++i) {
+        REQUIRE(video->GrabNext(image.data()));
+        REQUIRE(playback->GetCurrentFrameId() == i);
+        REQUIRE(image == frames[i]);
+    }
+    REQUIRE(!video->GrabNext(image.data()));
+
+    for(size_t i : {22, 3, 34, 10, 17, 0}) {
+        REQUIRE(playback->Seek(i) == i);
+        REQUIRE(video->GrabNext(image.data()));
+        REQUIRE(playback->GetCurrentFrameId() == i);
+        REQUIRE(image == frames[i]);
+    }
+    video.reset();
+
+    // Only the last segment was cut short, so only its index lacks keyframes
+    DropIndex(pangolin::PangoSegmentFilename(pattern, 3));
+    video = pangolin::OpenVideo("pango://" + pattern);
+    playback = pangolin::FindFirstMatchingVideoInterface<pangolin::VideoPlaybackInterface>(*video);
+    REQUIRE(playback->GetTotalFrames() == num_frames);
+    for(size_t i : {33, 22, 31, 34, 5}) {
+        REQUIRE(playback->Seek(i) == i);
+        REQUIRE(video->GrabNext(image.data()));
+        REQUIRE(image == frames[i]);
+    }
+
+    video.reset();
+    for(size_t s=0; s < 4; ++s) {
+        std::remove(pangolin::PangoSegmentFilename(pattern, s).c_str());
+    }
+}
+
+TEST_CASE( "Segmented recording continues in the current file if the next can't be opened" )
+{
+    const std::string pattern = "test_segment_fail_%03d.pango";
+    const size_t num_frames = 25;
+
+    // A directory where the second segment should go can't be opened for writing
+    std::filesystem::create_directory(pangolin::PangoSegmentFilename(pattern, 1));
+
+    auto input = pangolin::OpenVideo("test:[size=64x48,n=1,fmt=GRAY8]//");
+    std::vector<unsigned char> frame(input->SizeBytes());
+    {
+        auto output = pangolin::OpenVideoOutput("pango:[segment_seconds=1]//" + pattern);
+        output->SetStreams(input->Streams());
+        for(size_t i=0; i < num_frames; ++i) {
+            REQUIRE(input->GrabNext(frame.data()));
+            picojson::value props;
+            props[PANGO_HOST_RECEPTION_TIME_US] = picojson::value(int64_t(1000000 + i * 100000));
+            output->WriteStreams(frame.data(), props);
+        }
+    }
+    std::filesystem::remove(pangolin::PangoSegmentFilename(pattern, 1));
+
+    auto segment = pangolin::OpenVideo(pangolin::PangoSegmentFilename(pattern, 0));
+    auto playback = pangolin::FindFirstMatchingVideoInterface<pangolin::VideoPlaybackInterface>(*segment);
+    REQUIRE(playback->GetTotalFrames() == num_frames);
+
+    segment.reset();
+    std::remove(pangolin::PangoSegmentFilename(pattern, 0).c_str());
+}
+
+TEST_CASE( "Auto encoder picks within budget and records its choice per frame" )
+{
+    auto input = pangolin::OpenVideo("test:[size=64x48,n=1,fmt=GRAY8]//");
+    const pangolin::StreamInfo& si = input->Streams()[0];
+    std::vector<unsigned char> frame(input->SizeBytes());
+    REQUIRE(input->GrabNext(frame.data()));
+    std::fill(frame.begin(), frame.begin() + frame.size() / 2, 0);
+
+    auto encode_frames = [&](pangolin::AdaptiveStreamEncoder& encoder, int64_t interval_us){
+        for(int64_t i=0; i < 20; ++i) {
+            std::ostringstream os;
+            encoder.Encode(os, si.StreamImage(frame.data()), i * interval_us);
+        }
+    };
+
+    pangolin::AdaptiveEncoderSettings settings;
+    settings.candidates = {"raw", "png12", "jpg"};
+
+    // Lossy encoders are never candidates
+    pangolin::AdaptiveStreamEncoder unlimited(si, settings);
+    REQUIRE(unlimited.Spec() == "auto:raw,png12");
+
+    // With time to spare, the best compression wins
+    encode_frames(unlimited, 1000000);
+    REQUIRE(unlimited.Current() == "png12");
+
+    // If nothing keeps up, the fastest
+    settings.cpu_fraction = 1e-9;
+    pangolin::AdaptiveStreamEncoder limited(si, settings);
+    encode_frames(limited, 1000000);
+    REQUIRE(limited.Current() == "raw");
+
+    // Recordings decode whichever encoder each frame used
+    const std::string filename = "test_auto_encoder.pango";
+    std::vector<std::vector<unsigned char>> frames;
+    {
+        auto output = pangolin::OpenVideoOutput("pango:[encoder=auto,auto_encoders=raw+png12]//" + filename);
+        output->SetStreams(input->Streams());
+        for(size_t i=0; i < 30; ++i) {
+            frame[(i*37) % frame.size()] += 1;
+            frames.push_back(frame);
+            output->WriteStreams(frame.data());
+        }
+    }
+
+    auto video = pangolin::OpenVideo(filename);
+    std::vector<unsigned char> image(video->SizeBytes());
+    for(const auto& f : frames) {
+        REQUIRE(video->GrabNext(image.data()));
+        REQUIRE(image == f);
+    }
+
+    video.reset();
+    std::remove(filename.c_str());
+}
+
+TEST_CASE( "Merge decodes pango streams directly into its output" )
+{
+    const std::string filename = "test_merge_layout.pango";
+    const size_t num_frames = 3;
+
+    auto input = pangolin::OpenVideo("join://{test:[size=32x16,n=1,fmt=GRAY8]//}{test:[size=32x16,n=1,fmt=GRAY8]//}");
+    std::vector<std::vector<unsigned char>> frames;
+    {
+        auto output = pangolin::OpenVideoOutput("pango://" + filename);
+        output->SetStreams(input->Streams());
+        for(size_t i=0; i < num_frames; ++i) {
+            std::vector<unsigned char> frame(input->SizeBytes());
+            REQUIRE(input->GrabNext(frame.data()));
+            output->WriteStreams(frame.data());
+            frames.push_back(frame);
+        }
+    }
+
+    // Side by side, so each pango stream must be written with a wider pitch
+    auto merged = pangolin::OpenVideo("merge:[pos1=0x0,pos2=32x0]//" + filename);
+    REQUIRE(merged->Streams().size() == 1);
+    REQUIRE(merged->Streams()[0].Width() == 64);
+    REQUIRE(merged->Streams()[0].Height() == 16);
+
+    auto pango = pangolin::FindFirstMatchingVideoInterface<pangolin::PangoVideo>(*merged);
+    REQUIRE(pango);
+    REQUIRE(pango->Streams()[1].Pitch() == 64);
+    REQUIRE((size_t)pango->Streams()[1].Offset() == 32);
+
+    std::vector<unsigned char> image(merged->SizeBytes());
+    for(size_t i=0; i < num_frames; ++i) {
+        REQUIRE(merged->GrabNext(image.data()));
+        for(size_t y=0; y < 16; ++y) {
+            REQUIRE(std::equal(image.begin() + y*64, image.begin() + y*64 + 32, frames[i].begin() + y*32));
+            REQUIRE(std::equal(image.begin() + y*64 + 32, image.begin() + y*64 + 64, frames[i].begin() + 16*32 + y*32));
+        }
+    }
+
+    merged.reset();
+    std::remove(filename.c_str());
+}
+
+TEST_CASE( "Stream layouts with overlapping images are rejected" )
+{
+    const pangolin::PixelFormat fmt = pangolin::PixelFormatFromString("GRAY8");
+    const std::vector<pangolin::StreamInfo> streams = {
+        pangolin::StreamInfo(fmt, 32, 16, 32, (unsigned char*)0),
+        pangolin::StreamInfo(fmt, 32, 16, 32, (unsigned char*)(32*16))
+    };
+
+    // Stacked, side by side with a shared pitch, or packed back to back
+    REQUIRE(pangolin::IsValidStreamLayout(streams, streams, 32*32));
+    REQUIRE(pangolin::IsValidStreamLayout(streams, {
+        pangolin::StreamInfo(fmt, 32, 16, 64, (unsigned char*)0),
+        pangolin::StreamInfo(fmt, 32, 16, 64, (unsigned char*)32)
+    }, 64*16));
+
+    // Same region, a partial column overlap, and a row overlap
+    REQUIRE(!pangolin::IsValidStreamLayout(streams, {streams[0], streams[0]}, 32*16));
+    REQUIRE(!pangolin::IsValidStreamLayout(streams, {
+        pangolin::StreamInfo(fmt, 32, 16, 64, (unsigned char*)0),
+        pangolin::StreamInfo(fmt, 32, 16, 64, (unsigned char*)31)
+    }, 64*16));
+    REQUIRE(!pangolin::IsValidStreamLayout(streams, {
+        pangolin::StreamInfo(fmt, 32, 16, 32, (unsigned char*)0),
+        pangolin::StreamInfo(fmt, 32, 16, 32, (unsigned char*)(32*15))
+    }, 32*31));
+
+    // Different pitches are compared by their byte ranges
+    REQUIRE(!pangolin::IsValidStreamLayout(streams, {
+        pangolin::StreamInfo(fmt, 32, 16, 64, (unsigned char*)0),
+        pangolin::StreamInfo(fmt, 32, 16, 32, (unsigned char*)32)
+    }, 64*16));
+}
+
+TEST_CASE( "Pango video output writes pitched stream images" )
+{
+    const std::string filename = "test_pitched_images.pango";
+    const size_t w = 16, h = 8, pitch = 24;
+
+    for(const std::string encoder : {"", "[encoder=png]"}) {
+        const pangolin::PixelFormat fmt = pangolin::PixelFormatFromString("GRAY8");
+        std::vector<pangolin::StreamInfo> streams;
+        streams.emplace_back(fmt, w, h, w, (unsigned char*)0);
+        streams.emplace_back(fmt, w, h, w, (unsigned char*)(w*h));
+
+        // Each stream lives in its own, wider buffer
+        std::vector<std::vector<unsigned char>> buffers(2, std::vector<unsigned char>(pitch*h));
+        for(size_t s=0; s < buffers.size(); ++s) {
+            for(size_t i=0; i < buffers[s].size(); ++i) buffers[s][i] = (unsigned char)(i*(s+3));
+        }
+
+        {
+            auto output = pangolin::OpenVideoOutput("pango:" + encoder + "//" + filename);
+            output->SetStreams(streams);
+            std::vector<pangolin::Image<unsigned char>> images;
+            for(auto& b : buffers) images.emplace_back(b.data(), w, h, pitch);
+            output->WriteStreams(images);
+        }
+
+        auto video = pangolin::OpenVideo(filename);
+        REQUIRE(video->SizeBytes() == 2*w*h);
+        std::vector<unsigned char> image(video->SizeBytes());
+        REQUIRE(video->GrabNext(image.data()));
+        for(size_t s=0; s < 2; ++s) {
+            for(size_t y=0; y < h; ++y) {
+                REQUIRE(std::equal(buffers[s].begin() + y*pitch, buffers[s].begin() + y*pitch + w, image.begin() + s*w*h + y*w));
+            }
+        }
+        video.reset();
+        std::remove(filename.c_str());
+    }
+}
+
+TEST_CASE( "Pango video output writes frames encoded on other threads" )
+{
+    const std::string filename = "test_encoded_frames.pango";
+    const size_t num_frames = 6;
+    const size_t w = 32, h = 24;
+
+    const pangolin::PixelFormat fmt = pangolin::PixelFormatFromString("GRAY8");
+    std::vector<pangolin::StreamInfo> streams;
+    streams.emplace_back(fmt, w, h, w, (unsigned char*)0);
+    streams.emplace_back(fmt, w, h, w, (unsigned char*)(w*h));
+
+    for(const std::string encoder : {"", "[encoder=png]"}) {
+        std::vector<std::vector<unsigned char>> frames(num_frames, std::vector<unsigned char>(2*w*h));
+        for(size_t i=0; i < num_frames; ++i) {
+            for(size_t b=0; b < frames[i].size(); ++b) frames[i][b] = (unsigned char)(b*(i+1));
+        }
+
+        {
+            auto output = pangolin::OpenVideoOutput("pango:" + encoder + "//" + filename);
+            output->SetStreams(streams);
+            auto pango = dynamic_cast<pangolin::PangoVideoOutput*>(output.get());
+            REQUIRE(pango);
+            REQUIRE(pango->CanEncodeConcurrently());
+
+            std::vector<std::vector<unsigned char>> encoded(num_frames);
+            std::vector<std::thread> threads;
+            for(size_t i=0; i < num_frames; ++i) {
+                threads.emplace_back([&,i](){ pango->EncodeFrame(frames[i].data(), encoded[i]); });
+            }
+            for(auto& t : threads) t.join();
+            for(auto& e : encoded) pango->WriteEncodedFrame(e, picojson::value());
+        }
+
+        auto video = pangolin::OpenVideo(filename);
+        std::vector<unsigned char> image(video->SizeBytes());
+        for(size_t i=0; i < num_frames; ++i) {
+            REQUIRE(video->GrabNext(image.data()));
+            REQUIRE(image == frames[i]);
+        }
+        REQUIRE(!video->GrabNext(image.data()));
+        video.reset();
+        std::remove(filename.c_str());
+    }
+
+    auto output = pangolin::OpenVideoOutput("pango:[keyframe_interval=4]//" + filename);
+    output->SetStreams(streams);
+    REQUIRE(!dynamic_cast<pangolin::PangoVideoOutput&>(*output).CanEncodeConcurrently());
+    output.reset();
+    std::remove(filename.c_str());
+}
+
+TEST_CASE( "Pango video output compresses frames when asked by uri" )
+{
+    const std::string filename = "test_compressed_frames.pango";
+    const size_t num_frames = 10;
+
+    auto input = pangolin::OpenVideo("test:[size=32x24,n=1,fmt=GRAY8]//");
+    std::vector<unsigned char> frame(input->SizeBytes());
+
+    for(const std::string method : {"lz4", "zstd"}) {
+        for(const std::string batch : {"0", "2"}) {
+            const std::string uri = "pango:[compression=" + method + ",compression_batch_kb=" + batch + "]//" + filename;
+            if(!pangolin::PacketCompressionSupported(method)) {
+                REQUIRE_THROWS_AS(pangolin::OpenVideoOutput(uri), std::invalid_argument);
+                continue;
+            }
+
+            {
+                auto output = pangolin::OpenVideoOutput(uri);
+                output->SetStreams(input->Streams());
+                for(size_t i=0; i < num_frames; ++i) {
+                    std::fill(frame.begin(), frame.end(), (unsigned char)i);
+                    output->WriteStreams(frame.data());
+                }
+            }
+
+            auto video = pangolin::OpenVideo(filename);
+            auto playback = pangolin::FindFirstMatchingVideoInterface<pangolin::VideoPlaybackInterface>(*video);
+            REQUIRE(playback);
+            std::vector<unsigned char> image(video->SizeBytes());
+            for(size_t i : {0, 1, 7, 3, 9}) {
+                REQUIRE(playback->Seek(i) == i);
+                REQUIRE(video->GrabNext(image.data()));
+                REQUIRE(image == std::vector<unsigned char>(image.size(), (unsigned char)i));
+            }
+            video.reset();
+            std::remove(filename.c_str());
+        }
+    }
+}
+
+TEST_CASE( "Image sequence sizes streams from headers and caches its file list" )
+{
+    namespace fs = std::filesystem;
+    const fs::path dir = "test_images_manifest";
+    const fs::path cache_dir = "test_images_manifest_cache";
+    const size_t num_frames = 1100; // enough to be worth a manifest
+    fs::remove_all(dir);
+    fs::remove_all(cache_dir);
+    fs::create_directories(dir);
+
+    pangolin::ManagedImage<unsigned char> img(8, 4);
+    auto save_frame = [&](size_t i) {
+        img.Fill((unsigned char)i);
+        pangolin::SaveImage(img, pangolin::PixelFormatFromString("GRAY8"), (dir / ("frame_" + std::to_string(i) + ".pgm")).string());
+    };
+    for(size_t i=0; i < num_frames; ++i) save_frame(i);
+
+    // Manifests are only written for directories which have settled
+    const auto settled_time = fs::file_time_type::clock::now() - std::chrono::hours(1);
+    fs::last_write_time(dir, settled_time);
+
+    const std::string wildcard = (dir / "frame_*.pgm").string();
+    {
+        pangolin::ImagesVideo video(wildcard, cache_dir.string());
+        REQUIRE(video.GetTotalFrames() == num_frames);
+        REQUIRE(video.Streams().size() == 1);
+        REQUIRE(video.Streams()[0].PixFormat().format == "GRAY8");
+        REQUIRE(video.Streams()[0].Width() == 8);
+        REQUIRE(video.Streams()[0].Height() == 4);
+
+        // Natural ordering: frame_2 comes before frame_10
+        std::vector<unsigned char> image(video.SizeBytes());
+        for(size_t i=0; i < 12; ++i) {
+            REQUIRE(video.GrabNext(image.data()));
+            REQUIRE(image[0] == i);
+        }
+    }
+    REQUIRE(std::distance(fs::directory_iterator(cache_dir), fs::directory_iterator()) == 1);
+
+    // A file added without the directory time changing isn't seen, so the
+    // manifest was used rather than listing the directory
+    save_frame(num_frames);
+    fs::last_write_time(dir, settled_time);
+    REQUIRE(pangolin::ImagesVideo(wildcard, cache_dir.string()).GetTotalFrames() == num_frames);
+
+    // Any change to the directory time invalidates the manifest
+    fs::last_write_time(dir, settled_time + std::chrono::minutes(1));
+    REQUIRE(pangolin::ImagesVideo(wildcard, cache_dir.string()).GetTotalFrames() == num_frames + 1);
+
+    fs::remove_all(dir);
+    fs::remove_all(cache_dir);
+}
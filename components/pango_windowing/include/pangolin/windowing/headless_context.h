@@ -0,0 +1,58 @@
+/* This file is part of the Pangolin Project.
+ * http://github.com/stevenlovegrove/Pangolin
+ *
+ * Copyright (c) 2011 Steven Lovegrove, Richard Newcombe
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <memory>
+#include <pangolin/windowing/window.h>
+
+namespace pangolin
+{
+
+/// Offscreen OpenGL context with no window, for rendering from worker threads
+/// (e.g. with GlRenderTarget). Any number of contexts may exist, each current
+/// on at most one thread at a time.
+///
+/// Contexts created with \param share use the same buffers, textures and
+/// shaders as share, so geometry uploaded once can be drawn from every thread.
+/// Container objects such as framebuffers and vertex arrays are per context.
+class PANGOLIN_EXPORT HeadlessGlContext : public GlContextInterface
+{
+public:
+    /// Make this context current on the calling thread.
+    virtual void MakeCurrent() = 0;
+
+    /// Release this context from the calling thread.
+    virtual void RemoveCurrent() = 0;
+};
+
+/// Create a headless context via EGL, optionally sharing objects with \param share.
+/// Throws std::runtime_error if unavailable.
+PANGOLIN_EXPORT
+std::unique_ptr<HeadlessGlContext> CreateHeadlessGlContext(const HeadlessGlContext* share = nullptr);
+
+}
@@ -1,11 +1,30 @@
 #include <pangolin/windowing/window.h>
+#include <pangolin/windowing/headless_context.h>
 #include <pangolin/factory/factory_registry.h>
+#include <pangolin/gl/glinclude.h>
 #include <EGL/egl.h>
 
+#include <mutex>
+#include <stdexcept>
+
 namespace pangolin {
 
 namespace headless {
 
+// EGL display shared by every headless window and context in the process, so
+// that contexts may share objects. Terminated when the last user releases it.
+struct EGLDisplayRef {
+    EGLDisplayRef();
+
+    ~EGLDisplayRef();
+
+    static std::shared_ptr<EGLDisplayRef> Get();
+
+    EGLDisplay egl_display;
+    EGLConfig egl_config;
+    bool valid;
+};
+
 class EGLDisplayHL {
 public:
     EGLDisplayHL(const int width, const int height);
@@ -19,24 +38,23 @@ public:
     void removeCurrent();
 
 private:
+    std::shared_ptr<EGLDisplayRef> display;
     EGLSurface egl_surface;
     EGLContext egl_context;
     EGLDisplay egl_display;
-
-    static constexpr EGLint attribs[] = {
-        EGL_SURFACE_TYPE    , EGL_PBUFFER_BIT,
-        EGL_RENDERABLE_TYPE , EGL_OPENGL_BIT,
-        EGL_RED_SIZE        , 8,
-        EGL_GREEN_SIZE      , 8,
-        EGL_BLUE_SIZE       , 8,
-        EGL_ALPHA_SIZE      , 8,
-        EGL_DEPTH_SIZE      , 24,
-        EGL_STENCIL_SIZE    , 8,
-        EGL_NONE
-    };
 };
 
-constexpr EGLint EGLDisplayHL::attribs[];
+constexpr EGLint egl_attribs[] = {
+    EGL_SURFACE_TYPE    , EGL_PBUFFER_BIT,
+    EGL_RENDERABLE_TYPE , EGL_OPENGL_BIT,
+    EGL_RED_SIZE        , 8,
+    EGL_GREEN_SIZE      , 8,
+    EGL_BLUE_SIZE       , 8,
+    EGL_ALPHA_SIZE      , 8,
+    EGL_DEPTH_SIZE      , 24,
+    EGL_STENCIL_SIZE    , 8,
+    EGL_NONE
+};
 
 struct HeadlessWindow : public WindowInterface {
     HeadlessWindow(const int width, const int height);
@@ -60,37 +78,66 @@ struct HeadlessWindow : public WindowInterface {
     EGLDisplayHL display;
 };
 
-EGLDisplayHL::EGLDisplayHL(const int width, const int height) {
+EGLDisplayRef::EGLDisplayRef()
+    : egl_display(EGL_NO_DISPLAY), egl_config(nullptr), valid(false)
+{
     egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
     if(!egl_display) {
         std::cerr << "Failed to open EGL display" << std::endl;
+        return;
     }
 
     EGLint major, minor;
     if(eglInitialize(egl_display, &major, &minor)==EGL_FALSE) {
         std::cerr << "EGL init failed" << std::endl;
+        return;
     }
 
-    if(eglBindAPI(EGL_OPENGL_API)==EGL_FALSE) {
-        std::cerr << "EGL bind failed" << std::endl;
+    EGLint numConfigs = 0;
+    eglChooseConfig(egl_display, egl_attribs, &egl_config, 1, &numConfigs);
+    if(numConfigs < 1) {
+        std::cerr << "No matching EGL config" << std::endl;
+        return;
     }
 
-    EGLint count;
-    eglGetConfigs(egl_display, nullptr, 0, &count);
+    valid = true;
+}
 
-    std::vector<EGLConfig> egl_configs(count);
+EGLDisplayRef::~EGLDisplayRef() {
+    if(egl_display) eglTerminate(egl_display);
+}
 
-    EGLint numConfigs;
-    eglChooseConfig(egl_display, attribs, egl_configs.data(), count, &numConfigs);
+std::shared_ptr<EGLDisplayRef> EGLDisplayRef::Get() {
+    static std::mutex mutex;
+    static std::weak_ptr<EGLDisplayRef> shared;
 
-    egl_context = eglCreateContext(egl_display, egl_configs[0], EGL_NO_CONTEXT, nullptr);
+    std::lock_guard<std::mutex> l(mutex);
+    std::shared_ptr<EGLDisplayRef> display = shared.lock();
+    if(!display) {
+        display = std::make_shared<EGLDisplayRef>();
+        shared = display;
+    }
+    return display;
+}
+
+EGLDisplayHL::EGLDisplayHL(const int width, const int height)
+    : display(EGLDisplayRef::Get()), egl_surface(EGL_NO_SURFACE), egl_context(EGL_NO_CONTEXT),
+      egl_display(display->egl_display)
+{
+    if(!display->valid) return;
+
+    if(eglBindAPI(EGL_OPENGL_API)==EGL_FALSE) {
+        std::cerr << "EGL bind failed" << std::endl;
+    }
+
+    egl_context = eglCreateContext(egl_display, display->egl_config, EGL_NO_CONTEXT, nullptr);
 
     const EGLint pbufferAttribs[] = {
         EGL_WIDTH, width,
         EGL_HEIGHT, height,
         EGL_NONE,
     };
-    egl_surface = eglCreatePbufferSurface(egl_display, egl_configs[0],  pbufferAttribs);
+    egl_surface = eglCreatePbufferSurface(egl_display, display->egl_config,  pbufferAttribs);
     if (egl_surface == EGL_NO_SURFACE) {
         std::cerr << "Cannot create EGL surface" << std::endl;
     }
@@ -99,7 +146,6 @@ EGLDisplayHL::EGLDisplayHL(const int width, const int height) {
 EGLDisplayHL::~EGLDisplayHL() {
     if(egl_context) eglDestroyContext(egl_display, egl_context);
     if(egl_surface) eglDestroySurface(egl_display, egl_surface);
-    if(egl_display) eglTerminate(egl_display);
 }
 
 void EGLDisplayHL::swap() {
@@ -140,8 +186,85 @@ void HeadlessWindow::SwapBuffers() {
     MakeCurrent();
 }
 
+class EGLHeadlessContext : public HeadlessGlContext {
+public:
+    EGLHeadlessContext(const EGLHeadlessContext* share);
+
+    ~EGLHeadlessContext() override;
+
+    void MakeCurrent() override;
+
+    void RemoveCurrent() override;
+
+private:
+    std::shared_ptr<EGLDisplayRef> display;
+    EGLSurface egl_surface;
+    EGLContext egl_context;
+};
+
+EGLHeadlessContext::EGLHeadlessContext(const EGLHeadlessContext* share)
+    : display(EGLDisplayRef::Get()), egl_surface(EGL_NO_SURFACE), egl_context(EGL_NO_CONTEXT)
+{
+    if(!display->valid) {
+        throw std::runtime_error("Unable to initialise EGL display");
+    }
+
+    // The bound API is per thread and decides the type of context created
+    eglBindAPI(EGL_OPENGL_API);
+    egl_context = eglCreateContext(display->egl_display, display->egl_config,
+                                   share ? share->egl_context : EGL_NO_CONTEXT, nullptr);
+    if(egl_context == EGL_NO_CONTEXT) {
+        throw std::runtime_error("Unable to create EGL context");
+    }
+
+    // Rendering goes to framebuffer objects, but a surface is still needed
+    // where EGL_KHR_surfaceless_context is missing.
+    const EGLint pbufferAttribs[] = {
+        EGL_WIDTH, 1,
+        EGL_HEIGHT, 1,
+        EGL_NONE,
+    };
+    egl_surface = eglCreatePbufferSurface(display->egl_display, display->egl_config, pbufferAttribs);
+    if(egl_surface == EGL_NO_SURFACE) {
+        eglDestroyContext(display->egl_display, egl_context);
+        throw std::runtime_error("Unable to create EGL surface");
+    }
+}
+
+EGLHeadlessContext::~EGLHeadlessContext() {
+    if(eglGetCurrentContext() == egl_context) RemoveCurrent();
+    eglDestroySurface(display->egl_display, egl_surface);
+    eglDestroyContext(display->egl_display, egl_context);
+}
+
+void EGLHeadlessContext::MakeCurrent() {
+    eglBindAPI(EGL_OPENGL_API);
+    if(eglMakeCurrent(display->egl_display, egl_surface, egl_surface, egl_context)==EGL_FALSE) {
+        throw std::runtime_error("Unable to make EGL context current");
+    }
+
+#ifdef HAVE_GLEW
+    // Entry points are process wide, so resolve them once
+    static std::once_flag glew_init;
+    std::call_once(glew_init, [](){ glewInit(); });
+#endif
+}
+
+void EGLHeadlessContext::RemoveCurrent() {
+    eglMakeCurrent(display->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
 } // namespace headless
 
+std::unique_ptr<HeadlessGlContext> CreateHeadlessGlContext(const HeadlessGlContext* share)
+{
+    const headless::EGLHeadlessContext* egl_share = dynamic_cast<const headless::EGLHeadlessContext*>(share);
+    if(share && !egl_share) {
+        throw std::runtime_error("Headless contexts may only share with other headless contexts");
+    }
+    return std::unique_ptr<HeadlessGlContext>(new headless::EGLHeadlessContext(egl_share));
+}
+
 PANGOLIN_REGISTER_FACTORY(HeadlessWindow) {
 struct HeadlessWindowFactory : public TypedFactoryInterface<WindowInterface> {
     std::map<std::string,Precedence> Schemes() const override
@@ -1,7 +1,10 @@
 #include <pangolin/windowing/window.h>
+#include <pangolin/windowing/headless_context.h>
 #include <pangolin/factory/factory_registry.h>
 #include <pangolin/factory/RegisterFactoriesWindowInterface.h>
 
+#include <stdexcept>
+
 namespace pangolin
 {
 
@@ -11,4 +14,11 @@ std::unique_ptr<WindowInterface> ConstructWindow(const Uri& uri)
     return FactoryRegistry::I()->Construct<WindowInterface>(uri);
 }
 
+#ifndef HAVE_EGL
+std::unique_ptr<HeadlessGlContext> CreateHeadlessGlContext(const HeadlessGlContext*)
+{
+    throw std::runtime_error("Headless GL contexts require Pangolin to be built with EGL");
+}
+#endif
+
 }
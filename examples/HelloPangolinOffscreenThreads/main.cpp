@@ -0,0 +1,90 @@
+#include <pangolin/windowing/headless_context.h>
+#include <pangolin/gl/glrendertarget.h>
+#include <pangolin/gl/glvbo.h>
+#include <pangolin/gl/opengl_render_state.h>
+#include <pangolin/image/image_io.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Render many views of one scene in parallel, each worker thread with its own
+// headless context sharing the scene geometry, and save them as images.
+int main( int /*argc*/, char** /*argv*/ )
+{
+    static const int w = 640;
+    static const int h = 480;
+    static const int num_views = 64;
+    const int num_threads = std::max(1, (int)std::thread::hardware_concurrency());
+
+    // Upload geometry once into a root context which all workers share
+    std::unique_ptr<pangolin::HeadlessGlContext> root = pangolin::CreateHeadlessGlContext();
+    root->MakeCurrent();
+
+    std::vector<Eigen::Vector3f> points;
+    for(int i=0; i < 100000; ++i) {
+        const float t = i * 0.001f;
+        points.emplace_back(std::cos(10*t), std::sin(10*t), 0.02f*(t - 50.0f));
+    }
+    pangolin::GlBuffer vbo(pangolin::GlArrayBuffer, points);
+    glFinish();
+    root->RemoveCurrent();
+
+    std::vector<std::thread> workers;
+    for(int t=0; t < num_threads; ++t) {
+        workers.emplace_back([&, t](){
+            std::unique_ptr<pangolin::HeadlessGlContext> context = pangolin::CreateHeadlessGlContext(root.get());
+            context->MakeCurrent();
+            glEnable(GL_DEPTH_TEST);
+
+            // Alternate between two targets so that reading back one view
+            // overlaps with rendering the next
+            pangolin::GlRenderTarget target0(w,h), target1(w,h);
+            pangolin::GlRenderTarget* targets[2] = {&target0, &target1};
+            int saved_view[2] = {-1, -1};
+
+            auto save = [&](int i) {
+                if(targets[i]->ReadbackPending()) {
+                    pangolin::TypedImage img = targets[i]->FinishReadback();
+                    pangolin::SaveImage(img, "view_" + std::to_string(saved_view[i]) + ".png", false);
+                }
+            };
+
+            for(int view = t, i = 0; view < num_views; view += num_threads, i = 1-i) {
+                save(i);
+
+                const double angle = 2.0 * M_PI * view / num_views;
+                pangolin::OpenGlRenderState s_cam(
+                    pangolin::ProjectionMatrix(w,h,420,420,w/2,h/2,0.1,100),
+                    pangolin::ModelViewLookAt(3*std::cos(angle),3*std::sin(angle),1, 0,0,0, pangolin::AxisZ)
+                );
+
+                targets[i]->Bind();
+                glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                s_cam.Apply();
+                glColor3f(0.2f, 0.2f, 0.8f);
+                pangolin::RenderVbo(vbo);
+                targets[i]->Unbind();
+
+                targets[i]->StartReadback("RGBA32");
+                saved_view[i] = view;
+            }
+            save(0);
+            save(1);
+
+            context->RemoveCurrent();
+        });
+    }
+
+    for(std::thread& worker : workers) {
+        worker.join();
+    }
+
+    // Release shared objects from their owning context
+    root->MakeCurrent();
+    return 0;
+}
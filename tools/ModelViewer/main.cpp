@@ -1,5 +1,7 @@
 #include <thread>
 #include <future>
+#include <deque>
+#include <mutex>
 #include <queue>
 
 #include <pangolin/pangolin.h>
@@ -8,6 +10,7 @@
 #include <pangolin/gl/glvbo.h>
 
 #include <pangolin/utils/file_utils.h>
+#include <pangolin/utils/timer.h>
 
 #include <pangolin/geometry/geometry_ply.h>
 #include <pangolin/geometry/glgeometry.h>
@@ -42,6 +45,8 @@ int main( int argc, char** argv )
         { "show_z0", {"--z0"}, "Show Z=0 Plane", 0},
         { "cull_backfaces", {"--cull"}, "Enable backface culling", 0},
         { "spin", {"--spin"}, "Spin models around an axis {none, negx, x, negy, y, negz, z}", 1},
+        { "jobs", {"-j","--jobs"}, "Number of threads used to load models", 1},
+        { "upload_mb", {"--upload_mb"}, "Maximum model data to upload to the GPU per frame, in MB (default 32)", 1},
     }};
 
     argagg::parser_results args = argparser.parse(argc, argv);
@@ -89,15 +94,56 @@ int main( int argc, char** argv )
             .SetBounds(0.0, 1.0, 0.0, 1.0, -w/h)
             .SetHandler(&handler);
 
-    // Load Geometry asynchronously
-    std::vector<std::future<pangolin::Geometry>> geom_to_load;
-    for(const auto& filename : ExpandGlobOption(args["model"]))
-    {
-        geom_to_load.emplace_back( std::async(std::launch::async,[filename](){
-            return pangolin::LoadGeometry(filename);
-        }) );
+    // Parse models and decode their textures on a pool of worker threads
+    struct ParsedGeometry {
+        std::string filename;
+        pangolin::Geometry geom;
+        Eigen::AlignedBox3f aabb;
+        double parse_time_s;
+    };
+    const std::vector<std::string> model_files = ExpandGlobOption(args["model"]);
+    std::mutex parse_mutex;
+    std::queue<std::string> files_to_parse;
+    std::queue<ParsedGeometry> parsed_geom;
+    for(const auto& filename : model_files) files_to_parse.push(filename);
+
+    const size_t num_jobs = std::min<size_t>(model_files.size(), std::max(1, args["jobs"].as<int>(std::thread::hardware_concurrency())));
+    std::vector<std::thread> parse_workers;
+    for(size_t j=0; j < num_jobs; ++j) {
+        parse_workers.emplace_back([&](){
+            while(true) {
+                std::string filename;
+                {
+                    std::lock_guard<std::mutex> l(parse_mutex);
+                    if(files_to_parse.empty()) return;
+                    filename = files_to_parse.front();
+                    files_to_parse.pop();
+                }
+                try {
+                    const auto start = pangolin::TimeNow();
+                    ParsedGeometry parsed = {filename, pangolin::LoadGeometry(filename), {}, 0.0};
+                    parsed.aabb = pangolin::GetAxisAlignedBox(parsed.geom);
+                    parsed.parse_time_s = pangolin::TimeDiff_s(start, pangolin::TimeNow());
+                    std::lock_guard<std::mutex> l(parse_mutex);
+                    parsed_geom.push(std::move(parsed));
+                }catch(const std::exception& e) {
+                    std::cerr << "Unable to load '" << filename << "': " << e.what() << std::endl;
+                }
+            }
+        });
     }
 
+    // Parsed models are uploaded to the GPU over several frames
+    struct GeometryUpload {
+        std::string filename;
+        std::unique_ptr<pangolin::GlGeometryUploader> uploader;
+        std::shared_ptr<GlGeomRenderable> renderable;
+        double upload_time_s;
+        size_t frames;
+    };
+    std::deque<GeometryUpload> uploads;
+    const size_t upload_budget_bytes = size_t(args["upload_mb"].as<double>(32.0) * 1024 * 1024);
+
     // Render tree for holding object position
     RenderNode root;
     std::vector<std::shared_ptr<GlGeomRenderable>> renderables;
@@ -110,30 +156,54 @@ int main( int argc, char** argv )
         }
     };
 
-    // Pull one piece of loaded geometry onto the GPU if ready
+    // Make newly parsed geometry visible, and continue GPU uploads within this frame's budget
     Eigen::AlignedBox3f total_aabb;
-    auto LoadGeometryToGpu = [&]()
+    auto StreamGeometryToGpu = [&]()
     {
-        for(auto& future_geom : geom_to_load) {
-            if( future_geom.valid() && is_ready(future_geom) ) {
-                auto geom = future_geom.get();
-                auto aabb = pangolin::GetAxisAlignedBox(geom);
-                total_aabb.extend(aabb);
-                const Eigen::Vector3f center = total_aabb.center();
-                const Eigen::Vector3f view = center + Eigen::Vector3f(1.2, 0.8,1.2) * std::max( (total_aabb.max() - center).norm(), (center - total_aabb.min()).norm());
-                const auto mvm = pangolin::ModelViewLookAt(view[0], view[1], view[2], center[0], center[1], center[2], pangolin::AxisY);
-                const double far = 100.0*(total_aabb.max() - total_aabb.min()).norm();
-                const double near = far / 1e6;
-                const auto proj = pangolin::ProjectionMatrix(w, h, f, f, w/2.0, h/2.0, near, far );
-                s_cam.SetModelViewMatrix(mvm);
-                s_cam.SetProjectionMatrix(proj);
-
-                auto renderable = std::make_shared<GlGeomRenderable>(pangolin::ToGlGeometry(geom), aabb);
-                renderables.push_back(renderable);
-                RenderNode::Edge edge = { spin_transform, { renderable, {} } };
-                root.edges.emplace_back(std::move(edge));
-                break;
+        while(true) {
+            ParsedGeometry parsed;
+            {
+                std::lock_guard<std::mutex> l(parse_mutex);
+                if(parsed_geom.empty()) break;
+                parsed = std::move(parsed_geom.front());
+                parsed_geom.pop();
             }
+            std::cout << pangolin::FormatString("Parsed '%' in %s", parsed.filename, parsed.parse_time_s) << std::endl;
+
+            const auto& aabb = parsed.aabb;
+            total_aabb.extend(aabb);
+            const Eigen::Vector3f center = total_aabb.center();
+            const Eigen::Vector3f view = center + Eigen::Vector3f(1.2, 0.8,1.2) * std::max( (total_aabb.max() - center).norm(), (center - total_aabb.min()).norm());
+            const auto mvm = pangolin::ModelViewLookAt(view[0], view[1], view[2], center[0], center[1], center[2], pangolin::AxisY);
+            const double far = 100.0*(total_aabb.max() - total_aabb.min()).norm();
+            const double near = far / 1e6;
+            const auto proj = pangolin::ProjectionMatrix(w, h, f, f, w/2.0, h/2.0, near, far );
+            s_cam.SetModelViewMatrix(mvm);
+            s_cam.SetProjectionMatrix(proj);
+
+            auto renderable = std::make_shared<GlGeomRenderable>(pangolin::GlGeometry(), aabb);
+            renderables.push_back(renderable);
+            RenderNode::Edge edge = { spin_transform, { renderable, {} } };
+            root.edges.emplace_back(std::move(edge));
+
+            uploads.push_back({parsed.filename, std::make_unique<pangolin::GlGeometryUploader>(std::move(parsed.geom)), renderable, 0.0, 0});
+        }
+
+        // Oldest models first
+        size_t budget_bytes = upload_budget_bytes;
+        while(!uploads.empty() && budget_bytes > 0) {
+            GeometryUpload& upload = uploads.front();
+            const auto start = pangolin::TimeNow();
+            const size_t uploaded = upload.uploader->Upload(upload.renderable->glgeom, budget_bytes);
+            upload.upload_time_s += pangolin::TimeDiff_s(start, pangolin::TimeNow());
+            ++upload.frames;
+            budget_bytes -= std::min(uploaded, budget_bytes);
+
+            if(!upload.uploader->Done()) break;
+            std::cout << pangolin::FormatString("Uploaded '%' (% MB) in %s over % frames",
+                upload.filename, upload.uploader->TotalBytes() / (1024.0*1024.0), upload.upload_time_s, upload.frames
+            ) << std::endl;
+            uploads.pop_front();
         }
     };
 
@@ -211,7 +281,7 @@ int main( int argc, char** argv )
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // Load any pending geometry to the GPU.
-        LoadGeometryToGpu();
+        StreamGeometryToGpu();
 
 
         if(d_cam.IsShown()) {
@@ -276,5 +346,12 @@ int main( int argc, char** argv )
         pangolin::FinishFrame();
     }
 
+    // Don't start on any more models
+    {
+        std::lock_guard<std::mutex> l(parse_mutex);
+        files_to_parse = std::queue<std::string>();
+    }
+    for(auto& worker : parse_workers) worker.join();
+
     return 0;
 }
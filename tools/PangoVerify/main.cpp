@@ -0,0 +1,161 @@
+#include <pangolin/log/packetstream_reader.h>
+#include <pangolin/utils/argagg.hpp>
+#include <pangolin/utils/task_scheduler.h>
+
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// One packet as recorded in the file index
+struct IndexEntry
+{
+    pangolin::PacketStreamSourceId src;
+    size_t sequence_num;
+    std::streampos pos;
+};
+
+struct Damage
+{
+    pangolin::PacketStreamSourceId src;
+    size_t sequence_num;
+    std::streampos pos;
+    std::string reason;
+};
+
+// Returns an empty string if the packet read back intact
+std::string CheckPacket(pangolin::PacketStreamReader& reader, const IndexEntry& e)
+{
+    pangolin::Packet packet = reader.NextFrame();
+    if(packet.src != e.src || packet.sequence_num != e.sequence_num) {
+        return "packet does not match index";
+    }
+    if(packet.has_checksum) {
+        return packet.VerifyChecksum() ? "" : "checksum mismatch";
+    }
+
+    // Without a checksum we can only check the data is all there
+    std::vector<char> data(packet.size);
+    return packet.Stream().read(data.data(), data.size()) == data.size() ? "" : "truncated data";
+}
+
+// Verify entries [begin,end), which all lie after entries[begin].pos
+void VerifyRange(const std::string& filename, const std::vector<IndexEntry>& entries,
+                 size_t begin, size_t end, std::vector<Damage>& damage, std::mutex& damage_mutex)
+{
+    pangolin::PacketStreamReader reader(filename);
+    bool resync = true;
+
+    for(size_t i = begin; i < end; ++i) {
+        const IndexEntry& e = entries[i];
+        std::string reason;
+        try {
+            if(resync) {
+                if(reader.Seek(e.src, e.sequence_num) != e.sequence_num) {
+                    throw std::runtime_error("unable to seek to packet");
+                }
+                resync = false;
+            }
+            reason = CheckPacket(reader, e);
+        }catch(const std::exception& ex) {
+            reason = ex.what();
+        }
+
+        if(!reason.empty()) {
+            // Continue from the index rather than trusting the damaged region
+            resync = true;
+            std::lock_guard<std::mutex> l(damage_mutex);
+            damage.push_back({e.src, e.sequence_num, e.pos, reason});
+        }
+    }
+}
+
+}
+
+int main( int argc, char* argv[] )
+{
+    argagg::parser argparser = {{
+        { "help", {"-h", "--help"}, "shows this help! duh!", 0},
+        { "jobs", {"-j", "--jobs"}, "number of threads to verify with (default: number of cores)", 1},
+    }};
+
+    argagg::parser_results args = argparser.parse(argc, argv);
+    if( args["help"] || args.pos.size() != 1 ){
+        std::cerr << "Usage:\n";
+        std::cerr << "  PangoVerify [options] file.pango\n\n";
+        std::cerr << "Reads every packet listed in the file index, checking stored checksums,\n";
+        std::cerr << "and reports the ranges of packets which are damaged.\n\n";
+        std::cerr << "Options:\n";
+        std::cerr << argparser << std::endl;
+        return 0;
+    }
+
+    const std::string filename = args.pos[0];
+    const size_t num_jobs = std::max<size_t>(1, args["jobs"].as<size_t>(std::max(1u, std::thread::hardware_concurrency())));
+
+    std::vector<pangolin::PacketStreamSource> sources;
+    try{
+        // Opening rebuilds the index of an unterminated file first
+        pangolin::PacketStreamReader reader(filename);
+        sources = reader.Sources();
+    }catch(const std::exception& e) {
+        std::cerr << "Unable to open " << filename << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<IndexEntry> entries;
+    size_t num_checksummed = 0;
+    for(pangolin::PacketStreamSourceId src=0; src < sources.size(); ++src) {
+        const auto& index = sources[src].index;
+        for(size_t i=0; i < index.size(); ++i) {
+            entries.push_back({src, i, index[i].pos});
+        }
+        if(sources[src].checksum) num_checksummed += index.size();
+    }
+    std::sort(entries.begin(), entries.end(), [](const IndexEntry& a, const IndexEntry& b){
+        if(a.pos != b.pos) return a.pos < b.pos;
+        if(a.src != b.src) return a.src < b.src;
+        return a.sequence_num < b.sequence_num;
+    });
+
+    // Split into one run per job or so, without dividing a compressed group
+    std::vector<size_t> runs = {0};
+    const size_t run_length = std::max<size_t>(1, entries.size() / (4*num_jobs));
+    for(size_t i = run_length; i < entries.size(); ++i) {
+        if(i - runs.back() >= run_length && entries[i].pos != entries[i-1].pos) {
+            runs.push_back(i);
+        }
+    }
+    runs.push_back(entries.size());
+
+    std::vector<Damage> damage;
+    std::mutex damage_mutex;
+    pangolin::TaskScheduler scheduler(num_jobs - 1);
+    pangolin::ParallelFor(0, runs.size() - 1, 1, [&](size_t b, size_t e){
+        for(size_t r = b; r < e; ++r) {
+            VerifyRange(filename, entries, runs[r], runs[r+1], damage, damage_mutex);
+        }
+    }, scheduler);
+
+    // Merge consecutive damaged packets of a source into ranges
+    std::sort(damage.begin(), damage.end(), [](const Damage& a, const Damage& b){
+        return a.src < b.src || (a.src == b.src && a.sequence_num < b.sequence_num);
+    });
+    for(size_t i = 0; i < damage.size(); ) {
+        size_t j = i + 1;
+        while(j < damage.size() && damage[j].src == damage[i].src && damage[j].reason == damage[i].reason &&
+              damage[j].sequence_num == damage[j-1].sequence_num + 1) {
+            ++j;
+        }
+        std::cout << "Source " << damage[i].src << ": packets " << damage[i].sequence_num;
+        if(j - i > 1) std::cout << "-" << damage[j-1].sequence_num;
+        std::cout << " damaged (" << damage[i].reason << ") from byte " << damage[i].pos << std::endl;
+        i = j;
+    }
+
+    std::cout << filename << ": " << entries.size() << " packets in " << sources.size() << " sources, "
+              << num_checksummed << " with checksums, " << damage.size() << " damaged" << std::endl;
+    return damage.empty() ? 0 : 1;
+}
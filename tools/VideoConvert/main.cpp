@@ -4,6 +4,61 @@
 #include <pangolin/utils/argagg.hpp>
 #include <pangolin/image/pixel_format.h>
 #include <pangolin/video/video_help.h>
+#include <pangolin/video/drivers/pango_video_output.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Prints progress and throughput at most a few times per second
+struct ProgressReporter
+{
+    ProgressReporter(size_t total_frames, size_t frame_bytes)
+        : total_frames(total_frames), frame_bytes(frame_bytes),
+          start(Clock::now()), last_report(start)
+    {
+    }
+
+    void Update(size_t frames_complete, bool force = false)
+    {
+        const auto now = Clock::now();
+        if(!force && now - last_report < std::chrono::milliseconds(250)) {
+            return;
+        }
+        last_report = now;
+
+        const double secs = std::max(1e-6, std::chrono::duration<double>(now - start).count());
+        const double fps = frames_complete / secs;
+        const double mbps = fps * frame_bytes / (1024.0*1024.0);
+
+        std::cout << "Frames complete: " << frames_complete;
+        if(total_frames) std::cout << " / " << total_frames;
+        std::cout << " (" << std::fixed << std::setprecision(1) << fps << " fps, " << mbps << " MB/s)   \r";
+        std::cout.flush();
+    }
+
+    size_t total_frames;
+    size_t frame_bytes;
+    Clock::time_point start;
+    Clock::time_point last_report;
+};
+
+struct DecodedFrame
+{
+    // Encoded frame if the output can encode on the workers, else the raw frame
+    std::vector<unsigned char> buffer;
+    picojson::value properties;
+};
+
+}
 
 void VideoConvert(const std::string& input_uri, const std::string& output_uri)
 {
@@ -29,6 +84,9 @@ void VideoConvert(const std::string& input_uri, const std::string& output_uri)
     std::vector<unsigned char> buffer;
     buffer.resize(video.SizeBytes()+1);
 
+    ProgressReporter progress(playback ? playback->GetTotalFrames() : 0, video.SizeBytes());
+    size_t frames_complete = 0;
+
     // Record all frames
     video.Record();
 
@@ -38,17 +96,189 @@ void VideoConvert(const std::string& input_uri, const std::string& output_uri)
         if( !video.Grab(&buffer[0], images, video_wait, video_newest) ) {
             break;
         }
-        if( playback ) {
-            std::cout << "Frames complete: " << playback->GetCurrentFrameId() << " / " << playback->GetTotalFrames() << '\r';
-            std::cout.flush();
+        progress.Update(++frames_complete);
+    }
+    progress.Update(frames_complete, true);
+    std::cout << std::endl;
+}
+
+// Decode on num_jobs threads, each with its own reader seeking to blocks of
+// frames, whilst frames are written in order to the output on this thread.
+// Pango outputs whose frames encode independently are encoded on the decode
+// threads too. Other outputs encode as they are written, on this thread.
+void VideoConvertParallel(const std::string& input_uri, const std::string& output_uri, size_t num_jobs)
+{
+    const size_t block_frames = 16;
+
+    std::unique_ptr<pangolin::VideoInterface> video = pangolin::OpenVideo(input_uri);
+    pangolin::VideoPlaybackInterface* playback = pangolin::FindFirstMatchingVideoInterface<pangolin::VideoPlaybackInterface>(*video);
+    const size_t total_frames = playback ? playback->GetTotalFrames() : 0;
+
+    if(num_jobs <= 1 || total_frames == 0 || total_frames == std::numeric_limits<size_t>::max()) {
+        // No random access, so we can only convert sequentially
+        video.reset();
+        VideoConvert(input_uri, output_uri);
+        return;
+    }
+
+    const std::vector<pangolin::StreamInfo> streams = video->Streams();
+    const size_t frame_bytes = video->SizeBytes();
+    for(size_t s = 0; s < streams.size(); ++s)
+    {
+        const pangolin::StreamInfo& si = streams[s];
+        std::cout << "Stream " << s << ": " << si.Width() << " x " << si.Height()
+                  << " " << si.PixFormat().format << " (pitch: " << si.Pitch() << " bytes)" << std::endl;
+    }
+
+    pangolin::Uri uri_output = pangolin::ParseUri(output_uri);
+    if (uri_output.scheme == "file") {
+        uri_output.scheme = "pango";
+    }
+    std::unique_ptr<pangolin::VideoOutputInterface> recorder = pangolin::OpenVideoOutput(uri_output);
+    recorder->SetStreams(streams, input_uri, pangolin::GetVideoDeviceProperties(video.get()));
+    video.reset();
+
+    pangolin::PangoVideoOutput* encoder = dynamic_cast<pangolin::PangoVideoOutput*>(recorder.get());
+    if(encoder && !encoder->CanEncodeConcurrently()) {
+        encoder = nullptr;
+    }
+    std::cout << (encoder ? "Decoding and encoding with " : "Decoding with ") << num_jobs << " threads" << std::endl;
+
+    // Frames decoded but not yet written, keyed by frame id
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::map<size_t, DecodedFrame> decoded;
+    size_t next_block = 0;
+    size_t next_write = 0;
+    size_t end_frame = total_frames;
+    bool abort = false;
+    std::exception_ptr worker_error;
+
+    // Bound memory by only decoding a few blocks ahead of the writer
+    const size_t max_frames_ahead = 2 * num_jobs * block_frames;
+
+    auto worker = [&](){
+        try {
+            std::unique_ptr<pangolin::VideoInterface> reader = pangolin::OpenVideo(input_uri);
+            pangolin::VideoPlaybackInterface* reader_playback = pangolin::FindFirstMatchingVideoInterface<pangolin::VideoPlaybackInterface>(*reader);
+            PANGO_ENSURE(reader_playback);
+            reader->Start();
+            std::vector<unsigned char> raw(frame_bytes);
+
+            while(true) {
+                size_t begin;
+                {
+                    std::unique_lock<std::mutex> l(mutex);
+                    cond.wait(l, [&](){ return abort || next_block < next_write + max_frames_ahead; });
+                    begin = next_block;
+                    if(abort || begin >= end_frame) break;
+                    next_block += block_frames;
+                }
+
+                const size_t end = std::min(begin + block_frames, total_frames);
+                if(reader_playback->Seek(begin) != begin) {
+                    std::lock_guard<std::mutex> l(mutex);
+                    end_frame = std::min(end_frame, begin);
+                    cond.notify_all();
+                    break;
+                }
+
+                for(size_t f = begin; f < end; ++f) {
+                    DecodedFrame frame;
+
+                    // Drivers may seek to the first of several frames sharing
+                    // a timestamp, so skip forwards to the one we want.
+                    bool success;
+                    do {
+                        success = reader->GrabNext(raw.data(), true);
+                    } while(success && reader_playback->GetCurrentFrameId() < f);
+
+                    if(success) {
+                        const size_t id = reader_playback->GetCurrentFrameId();
+                        if(id != f) {
+                            throw std::runtime_error(pangolin::FormatString("Decoded frame % where % was expected.", id, f));
+                        }
+                        frame.properties = pangolin::GetVideoFrameProperties(reader.get());
+                        if(encoder) {
+                            encoder->EncodeFrame(raw.data(), frame.buffer);
+                        }else{
+                            frame.buffer = raw;
+                        }
+                    }
+
+                    std::lock_guard<std::mutex> l(mutex);
+                    if(!success) {
+                        end_frame = std::min(end_frame, f);
+                        cond.notify_all();
+                        break;
+                    }
+                    decoded[f] = std::move(frame);
+                    cond.notify_all();
+                }
+            }
+            reader->Stop();
+        } catch(...) {
+            std::lock_guard<std::mutex> l(mutex);
+            if(!worker_error) worker_error = std::current_exception();
+            abort = true;
+            cond.notify_all();
         }
-   }
+    };
+
+    std::vector<std::thread> workers;
+    for(size_t j=0; j < num_jobs; ++j) {
+        workers.emplace_back(worker);
+    }
+
+    ProgressReporter progress(total_frames, frame_bytes);
+
+    // Reassemble frames in order on this thread
+    while(true) {
+        DecodedFrame frame;
+        {
+            std::unique_lock<std::mutex> l(mutex);
+            cond.wait(l, [&](){ return abort || next_write >= end_frame || decoded.count(next_write); });
+            if(abort || next_write >= end_frame) break;
+            auto it = decoded.find(next_write);
+            frame = std::move(it->second);
+            decoded.erase(it);
+        }
+
+        if(encoder) {
+            encoder->WriteEncodedFrame(frame.buffer, frame.properties);
+        }else{
+            recorder->WriteStreams(frame.buffer.data(), frame.properties);
+        }
+
+        {
+            std::lock_guard<std::mutex> l(mutex);
+            ++next_write;
+            cond.notify_all();
+        }
+        progress.Update(next_write);
+    }
+    progress.Update(next_write, true);
+    std::cout << std::endl;
+
+    {
+        std::lock_guard<std::mutex> l(mutex);
+        abort = true;
+        cond.notify_all();
+    }
+    for(auto& t : workers) {
+        t.join();
+    }
+
+    if(worker_error) {
+        std::rethrow_exception(worker_error);
+    }
 }
 
 int main( int argc, char* argv[] )
 {
     argagg::parser argparser = {{
         { "help", {"-h", "--help"}, "shows this help! duh!", 0},
+        { "jobs", {"-j", "--jobs"}, "number of threads decoding seekable inputs, which also encode for pango outputs without keyframe_interval or encoder=auto. Other outputs, e.g. ffmpeg, encode on one thread (default: 1)", 1},
         { "scheme", {"-s", "--scheme"}, "filters the help message by scheme", 1},
         { "verbose", {"-v","--verbose"}, "verbose level in number, 0=list of schemes(default),1=scheme parameters,2=parameter details", 1}
     }};
@@ -59,6 +289,7 @@ int main( int argc, char* argv[] )
         std::cerr << "  VideoConvert [options] VideoInputUri\n\n";
         std::cerr << "Examples:\n";
         std::cerr << "  VideoConvert test:[size=160x120,n=1,fmt=RGB24]//   Show the 'test' video driver with 160x120 resolution, 1 stream, RGB format.\n";
+        std::cerr << "  VideoConvert -j 8 in.pango out.pango               Decode and encode a seekable input on 8 threads\n";
         std::cerr << "  VideoConvert --help -s image                       Find out how to use the 'image' video driver\n\n";
         std::cerr << "Options:\n";
         std::cerr << argparser << std::endl;
@@ -73,8 +304,9 @@ int main( int argc, char* argv[] )
 
     const std::string input_uri = std::string(args.pos[0]);
     const std::string output_uri = ( args.pos.size() > 1) ? std::string(args.pos[1]) : dflt_output_uri;
+    const size_t num_jobs = std::max<size_t>(1, args["jobs"].as<size_t>(1));
     try{
-        VideoConvert(input_uri, output_uri);
+        VideoConvertParallel(input_uri, output_uri, num_jobs);
     } catch (const pangolin::VideoException& e) {
         std::cout << e.what() << std::endl;
     }
@@ -48,7 +48,8 @@ int main( int argc, char* argv[] )
                 pkt.Stream().read(buffer.data(), buffer.size());
 
                 const picojson::value& new_frame_json = all_properties[pkt.src]["frame_properties"][pkt.sequence_num];
-                writer.WriteSourcePacket(pkt.src, buffer.data(), pkt.time, buffer.size(), new_frame_json);
+                const bool keyframe = reader.Sources()[pkt.src].index[pkt.sequence_num].keyframe;
+                writer.WriteSourcePacket(pkt.src, buffer.data(), pkt.time, buffer.size(), new_frame_json, keyframe);
                 std::cout << "Frames complete: " << pkt.sequence_num << " / " << reader.Sources()[pkt.src].index.size() << '\r';
                 std::cout.flush();
             }